@@ -48,5 +48,38 @@ static void DeserializeAndCheckBlockTest(benchmark::State& state)
     }
 }
 
+// A block of many small transactions, half of them with witness, so that the cost per
+// transaction of hashing them on deserialization shows.
+static void DeserializeLargeBlockTest(benchmark::State& state)
+{
+    static const int NUM_TRANSACTIONS = 20000;
+    CBlock block;
+    for (int i = 0; i < NUM_TRANSACTIONS; ++i) {
+        CMutableTransaction mtx;
+        mtx.nLockTime = i;
+        mtx.vin.resize(1);
+        mtx.vin[0].prevout = COutPoint(uint256(), i);
+        if (i % 2) mtx.vin[0].scriptWitness.stack.emplace_back(72, 0x30);
+        mtx.vout.resize(1);
+        mtx.vout[0].nValue = i;
+        mtx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+        block.vtx.push_back(MakeTransactionRef(std::move(mtx)));
+    }
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << block;
+    const size_t size = stream.size();
+    char a = '\0';
+    stream.write(&a, 1); // Prevent compaction
+
+    while (state.KeepRunning()) {
+        CBlock read;
+        stream >> read;
+        assert(read.vtx.size() == (size_t)NUM_TRANSACTIONS);
+        bool rewound = stream.Rewind(size);
+        assert(rewound);
+    }
+}
+
 BENCHMARK(DeserializeBlockTest, 130);
 BENCHMARK(DeserializeAndCheckBlockTest, 160);
+BENCHMARK(DeserializeLargeBlockTest, 2);
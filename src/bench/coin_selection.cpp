@@ -4,6 +4,8 @@
 
 #include <bench/bench.h>
 #include <interfaces/chain.h>
+#include <test/util.h>
+#include <wallet/coincontrol.h>
 #include <wallet/coinselection.h>
 #include <wallet/wallet.h>
 
@@ -59,6 +61,37 @@ static void CoinSelection(benchmark::State& state)
     }
 }
 
+// Selecting 500 coins in a wallet with 100k outputs worth 0.1 to 9.7 coins, as staking
+// rewards pile up: branch and bound first, then the knapsack solver, as CreateTransaction does.
+static void CoinSelectionLarge(benchmark::State& state)
+{
+    auto chain = interfaces::MakeChain();
+    const CWallet wallet(chain.get(), WalletLocation(), WalletDatabase::CreateDummy());
+    std::vector<std::unique_ptr<CWalletTx>> wtxs;
+    LOCK(wallet.cs_wallet);
+
+    std::vector<COutput> coins;
+    for (int i = 0; i < 100000; ++i) {
+        addCoin((1 + i % 97) * COIN / 10, wallet, wtxs);
+        coins.emplace_back(wtxs.back().get(), 0 /* iIn */, 6 * 24 /* nDepthIn */, true /* spendable */, true /* solvable */, true /* safe */);
+    }
+
+    const CCoinControl coin_control;
+    while (state.KeepRunning()) {
+        std::set<CInputCoin> setCoinsRet;
+        CAmount nValueRet = 0;
+        bool bnb_used;
+        CoinSelectionParams coin_selection_params(true, 34, 148, CFeeRate(0), 0);
+        if (!wallet.SelectCoins(coins, 500 * COIN + 12345, setCoinsRet, nValueRet, coin_control, coin_selection_params, bnb_used)) {
+            coin_selection_params.use_bnb = false;
+            nValueRet = 0;
+            bool success = wallet.SelectCoins(coins, 500 * COIN + 12345, setCoinsRet, nValueRet, coin_control, coin_selection_params, bnb_used);
+            assert(success);
+        }
+        assert(nValueRet >= 500 * COIN + 12345);
+    }
+}
+
 typedef std::set<CInputCoin> CoinSet;
 static auto testChain = interfaces::MakeChain();
 static const CWallet testWallet(testChain.get(), WalletLocation(), WalletDatabase::CreateDummy());
@@ -106,5 +139,26 @@ static void BnBExhaustion(benchmark::State& state)
     }
 }
 
+// List the coins of a wallet with 100k confirmed transactions, of which one in
+// ten has an unspent output, as every send does before selecting coins.
+static void AvailableCoinsLarge(benchmark::State& state)
+{
+    auto chain = interfaces::MakeChain();
+    CWallet wallet(chain.get(), WalletLocation(), WalletDatabase::CreateMock());
+    bool first_run;
+    if (wallet.LoadWallet(first_run) != DBErrors::LOAD_OK) assert(false);
+    const CAmount unspent = AddWalletHistory(wallet, 100000, 10);
+
+    auto locked_chain = chain->lock();
+    LOCK(wallet.cs_wallet);
+    std::vector<COutput> coins;
+    while (state.KeepRunning()) {
+        wallet.AvailableCoins(*locked_chain, coins);
+        assert(coins.size() == static_cast<size_t>(unspent / COIN));
+    }
+}
+
 BENCHMARK(CoinSelection, 650);
+BENCHMARK(CoinSelectionLarge, 10);
 BENCHMARK(BnBExhaustion, 650);
+BENCHMARK(AvailableCoinsLarge, 100);
@@ -59,6 +59,68 @@ static void SHA256D64_1024(benchmark::State& state)
     }
 }
 
+/* Random messages of sizes between min_size and max_size */
+static std::vector<std::vector<uint8_t>> MakeMessages(size_t count, size_t min_size, size_t max_size)
+{
+    FastRandomContext rng(true);
+    std::vector<std::vector<uint8_t>> messages(count);
+    for (auto& message : messages) {
+        message = rng.randbytes(min_size + rng.randrange(max_size - min_size + 1));
+    }
+    return messages;
+}
+
+static std::vector<Span<const unsigned char>> MakeSpans(const std::vector<std::vector<uint8_t>>& messages)
+{
+    std::vector<Span<const unsigned char>> spans;
+    for (const auto& message : messages) {
+        spans.push_back(MakeSpan(message));
+    }
+    return spans;
+}
+
+/* Transaction-like sizes */
+static void Hash_1024(benchmark::State& state)
+{
+    const auto messages = MakeMessages(1024, 150, 650);
+    std::vector<uint256> hashes(messages.size());
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < messages.size(); ++i) {
+            hashes[i] = Hash(messages[i].begin(), messages[i].end());
+        }
+    }
+}
+
+static void HashBatch_1024(benchmark::State& state)
+{
+    const auto messages = MakeMessages(1024, 150, 650);
+    const auto spans = MakeSpans(messages);
+    while (state.KeepRunning()) {
+        HashBatch(spans);
+    }
+}
+
+/* Compressed public keys, as hashed into key ids */
+static void Hash160_1024(benchmark::State& state)
+{
+    const auto messages = MakeMessages(1024, 33, 33);
+    std::vector<uint160> hashes(messages.size());
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < messages.size(); ++i) {
+            hashes[i] = Hash160(messages[i]);
+        }
+    }
+}
+
+static void Hash160Batch_1024(benchmark::State& state)
+{
+    const auto messages = MakeMessages(1024, 33, 33);
+    const auto spans = MakeSpans(messages);
+    while (state.KeepRunning()) {
+        Hash160Batch(spans);
+    }
+}
+
 static void SHA512(benchmark::State& state)
 {
     uint8_t hash[CSHA512::OUTPUT_SIZE];
@@ -100,5 +162,9 @@ BENCHMARK(SHA512, 330);
 BENCHMARK(SHA256_32b, 4700 * 1000);
 BENCHMARK(SipHash_32b, 40 * 1000 * 1000);
 BENCHMARK(SHA256D64_1024, 7400);
+BENCHMARK(Hash_1024, 1000);
+BENCHMARK(HashBatch_1024, 1000);
+BENCHMARK(Hash160_1024, 7400);
+BENCHMARK(Hash160Batch_1024, 7400);
 BENCHMARK(FastRandom_32bit, 110 * 1000 * 1000);
 BENCHMARK(FastRandom_1bit, 440 * 1000 * 1000);
@@ -3,7 +3,44 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <bench/bench.h>
+#include <bench/data.h>
 #include <blockfilter.h>
+#include <primitives/transaction.h>
+#include <streams.h>
+#include <version.h>
+
+/** Output scripts of the transactions of the bench block, as a basic filter would include them. */
+static GCSFilter::ElementSet BlockFilterElements()
+{
+    // The bench block has a Bitcoin header, so skip it and read the transactions only.
+    CDataStream stream(benchmark::data::block413567, SER_NETWORK, PROTOCOL_VERSION);
+    stream.ignore(80);
+    std::vector<CTransactionRef> vtx;
+    stream >> vtx;
+
+    GCSFilter::ElementSet elements;
+    for (const CTransactionRef& tx : vtx) {
+        for (const CTxOut& txout : tx->vout) {
+            const CScript& script = txout.scriptPubKey;
+            if (script.empty() || script[0] == OP_RETURN) continue;
+            elements.emplace(script.begin(), script.end());
+        }
+    }
+    return elements;
+}
+
+/** Elements that are not in the bench block, for MatchAny queries that decode the whole filter. */
+static GCSFilter::ElementSet QueryElements(size_t count)
+{
+    GCSFilter::ElementSet elements;
+    for (size_t i = 0; i < count; ++i) {
+        GCSFilter::Element element(25, 0xff);
+        element[0] = static_cast<unsigned char>(i);
+        element[1] = static_cast<unsigned char>(i >> 8);
+        elements.insert(std::move(element));
+    }
+    return elements;
+}
 
 static void ConstructGCSFilter(benchmark::State& state)
 {
@@ -39,5 +76,40 @@ static void MatchGCSFilter(benchmark::State& state)
     }
 }
 
+static void ConstructBlockGCSFilter(benchmark::State& state)
+{
+    const GCSFilter::ElementSet elements = BlockFilterElements();
+
+    uint64_t siphash_k0 = 0;
+    while (state.KeepRunning()) {
+        GCSFilter filter({siphash_k0, 0, BASIC_FILTER_P, BASIC_FILTER_M}, elements);
+
+        siphash_k0++;
+    }
+}
+
+static void DecodeBlockGCSFilter(benchmark::State& state)
+{
+    const GCSFilter filter({0, 0, BASIC_FILTER_P, BASIC_FILTER_M}, BlockFilterElements());
+
+    while (state.KeepRunning()) {
+        GCSFilter decoded(filter.GetParams(), filter.GetEncoded());
+        assert(decoded.GetN() == filter.GetN());
+    }
+}
+
+static void MatchAnyBlockGCSFilter(benchmark::State& state)
+{
+    const GCSFilter filter({0, 0, BASIC_FILTER_P, BASIC_FILTER_M}, BlockFilterElements());
+    const GCSFilter::ElementSet queries = QueryElements(100);
+
+    while (state.KeepRunning()) {
+        filter.MatchAny(queries);
+    }
+}
+
 BENCHMARK(ConstructGCSFilter, 1000);
 BENCHMARK(MatchGCSFilter, 50 * 1000);
+BENCHMARK(ConstructBlockGCSFilter, 200);
+BENCHMARK(DecodeBlockGCSFilter, 500);
+BENCHMARK(MatchAnyBlockGCSFilter, 500);
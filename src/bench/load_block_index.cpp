@@ -0,0 +1,113 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <key.h>
+#include <primitives/block.h>
+#include <txdb.h>
+#include <validation.h>
+
+#include <map>
+
+static const int NUM_BLOCKS = 1000000;
+static const int NUM_UNKNOWN_MINTERS = 100000;
+
+/**
+ * An in-memory block tree DB holding a synthetic regtest chain of num_blocks headers, written with
+ * their minters if with_minters is set, like by versions that store them.
+ */
+static std::unique_ptr<CBlockTreeDB> MakeBlockTree(int num_blocks, bool with_minters)
+{
+    auto blocktree = MakeUnique<CBlockTreeDB>(8 << 20, true /* fMemory */, true /* fWipe */);
+
+    // Any valid compact signature recovers to some key, so one is reused for every header.
+    CKey key;
+    key.MakeNewKey(true);
+    std::vector<unsigned char> sig;
+    bool signed_ok = key.SignCompact(uint256S("01"), sig);
+    assert(signed_ok);
+
+    static const int BATCH_SIZE = 10000;
+    std::vector<CBlockIndex> indexes(BATCH_SIZE + 1);
+    std::vector<uint256> hashes(BATCH_SIZE + 1);
+    std::vector<const CBlockIndex*> batch;
+    const CBlock& genesis = Params().GenesisBlock();
+    for (int height = 0; height < num_blocks; height += BATCH_SIZE) {
+        // Slot 0 holds the last entry of the previous batch, the parent of the first one.
+        if (height > 0) {
+            indexes[0] = indexes[BATCH_SIZE];
+            hashes[0] = hashes[BATCH_SIZE];
+            indexes[0].phashBlock = &hashes[0];
+        }
+        batch.clear();
+        for (int i = 1; i <= BATCH_SIZE && height + i - 1 < num_blocks; ++i) {
+            CBlockIndex& index = indexes[i];
+            index = CBlockIndex();
+            index.pprev = height + i > 1 ? &indexes[i - 1] : nullptr;
+            index.nHeight = index.height = height + i - 1;
+            index.nVersion = genesis.nVersion;
+            index.nTime = genesis.nTime + index.nHeight;
+            index.nBits = genesis.nBits;
+            index.nStatus = BLOCK_VALID_TREE;
+            if (index.nHeight > 0) {
+                index.hashMerkleRoot = GetRandHash();
+                index.sig.assign(sig.begin(), sig.end());
+                if (with_minters) {
+                    index.minter = key.GetPubKey().GetID();
+                }
+            }
+            hashes[i] = index.GetBlockHeader().GetHash();
+            index.phashBlock = &hashes[i];
+            batch.push_back(&index);
+        }
+        bool written = blocktree->WriteBatchSync({}, 0, batch);
+        assert(written);
+    }
+    return blocktree;
+}
+
+static void LoadBlockTree(benchmark::State& state, int num_blocks, bool with_minters)
+{
+    const std::unique_ptr<CBlockTreeDB> blocktree = MakeBlockTree(num_blocks, with_minters);
+
+    while (state.KeepRunning()) {
+        std::map<uint256, std::unique_ptr<CBlockIndex>> block_index;
+        auto insert_block_index = [&block_index](const uint256& hash) -> CBlockIndex* {
+            if (hash.IsNull()) return nullptr;
+            std::unique_ptr<CBlockIndex>& pindex = block_index[hash];
+            if (!pindex) {
+                pindex = MakeUnique<CBlockIndex>();
+                pindex->phashBlock = &block_index.find(hash)->first;
+            }
+            return pindex.get();
+        };
+        std::vector<CBlockIndex*> unknown_minters;
+        bool loaded = blocktree->LoadBlockIndexGuts(Params().GetConsensus(), insert_block_index, false /* skipSigCheck */, unknown_minters);
+        assert(loaded && block_index.size() == (size_t)num_blocks);
+        assert(unknown_minters.size() == (with_minters ? 0 : (size_t)num_blocks - 1));
+        // Not persisted, so that every iteration pays for the recovery.
+        ClearMinterKeyCache();
+        bool recovered = RecoverMinterKeys(unknown_minters);
+        assert(recovered);
+    }
+}
+
+// Startup with a 1M block index whose minters are stored along with it.
+static void LoadBlockIndexStoredMinters(benchmark::State& state)
+{
+    LoadBlockTree(state, NUM_BLOCKS, true);
+}
+
+// The one-time upgrade of an index written without minters, which recovers
+// them from the header signatures on the header signature threads.
+static void LoadBlockIndexRecoverMinters(benchmark::State& state)
+{
+    LoadBlockTree(state, NUM_UNKNOWN_MINTERS, false);
+}
+
+BENCHMARK(LoadBlockIndexStoredMinters, 1);
+BENCHMARK(LoadBlockIndexRecoverMinters, 1);
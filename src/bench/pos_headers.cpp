@@ -0,0 +1,120 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chainparams.h>
+#include <key.h>
+#include <pos.h>
+#include <pos_kernel.h>
+#include <primitives/block.h>
+#include <validation.h>
+
+static const size_t NUM_HEADERS = 100000;
+static const size_t NUM_MINTERS = 8;
+
+/** A chain of signed regtest headers, minted round-robin by a few masternode operators. */
+static const std::vector<CBlockHeader>& SignedHeaders()
+{
+    static std::vector<CBlockHeader> headers;
+    if (!headers.empty()) {
+        return headers;
+    }
+
+    std::vector<CKey> keys(NUM_MINTERS);
+    for (CKey& key : keys) {
+        key.MakeNewKey(true);
+    }
+
+    const CBlock& genesis = Params().GenesisBlock();
+    uint256 prev_hash = genesis.GetHash();
+    uint256 prev_stake_modifier = genesis.stakeModifier;
+    headers.reserve(NUM_HEADERS);
+    for (size_t i = 0; i < NUM_HEADERS; ++i) {
+        const CKey& key = keys[i % NUM_MINTERS];
+        CBlockHeader header;
+        header.nVersion = genesis.nVersion;
+        header.hashPrevBlock = prev_hash;
+        header.hashMerkleRoot = GetRandHash();
+        header.nTime = genesis.nTime + 30 * (i + 1);
+        header.nBits = genesis.nBits;
+        header.height = i + 1;
+        header.mintedBlocks = i / NUM_MINTERS + 1;
+        header.stakeModifier = pos::ComputeStakeModifier(prev_stake_modifier, key.GetPubKey().GetID());
+        bool signed_ok = key.SignCompact(header.GetHashToSign(), header.sig);
+        assert(signed_ok);
+
+        prev_hash = header.GetHash();
+        prev_stake_modifier = header.stakeModifier;
+        headers.push_back(std::move(header));
+    }
+    return headers;
+}
+
+/** The signature checks done for every header on its way into the block index. */
+static void CheckHeaders(const std::vector<CBlockHeader>& batch)
+{
+    CKeyID minter;
+    for (const CBlockHeader& header : batch) {
+        // CheckBlockHeader, then ContextualCheckBlockHeader and the CBlockIndex constructor.
+        assert(pos::CheckHeaderSignature(header));
+        assert(GetMinterKey(header, minter));
+        assert(GetMinterKey(header, minter));
+    }
+}
+
+static void SyncHeaders(benchmark::State& state, bool prefetch)
+{
+    const std::vector<CBlockHeader>& headers = SignedHeaders();
+
+    // Prefetching only covers batches connecting to the block index, so stand in for the
+    // entries AcceptBlockHeader would have added for the genesis and the end of each batch.
+    CBlockIndex connected;
+    std::vector<uint256> connected_hashes{Params().GenesisBlock().GetHash()};
+    for (size_t end = MAX_HEADERS_RESULTS; end < headers.size(); end += MAX_HEADERS_RESULTS) {
+        connected_hashes.push_back(headers[end - 1].GetHash());
+    }
+    {
+        LOCK(cs_main);
+        for (const uint256& hash : connected_hashes) {
+            BlockIndex().emplace(hash, &connected);
+        }
+    }
+
+    while (state.KeepRunning()) {
+        ClearMinterKeyCache();
+        for (size_t begin = 0; begin < headers.size(); begin += MAX_HEADERS_RESULTS) {
+            const size_t end = std::min<size_t>(begin + MAX_HEADERS_RESULTS, headers.size());
+            const std::vector<CBlockHeader> batch(headers.begin() + begin, headers.begin() + end);
+            if (prefetch) {
+                size_t prefetched = PrefetchMinterKeys(batch);
+                assert(prefetched == batch.size());
+            }
+            CheckHeaders(batch);
+        }
+    }
+    ClearMinterKeyCache();
+
+    LOCK(cs_main);
+    for (const uint256& hash : connected_hashes) {
+        BlockIndex().erase(hash);
+    }
+}
+
+// Check 100k headers in HEADERS message sized batches on the message handler
+// thread alone, recovering each signature once thanks to the minter key cache.
+static void PosHeadersSyncSequential(benchmark::State& state)
+{
+    SyncHeaders(state, false);
+}
+
+// Same, but recover the signatures of each batch on the script check threads
+// first, as ProcessNewBlockHeaders does.
+static void PosHeadersSyncParallel(benchmark::State& state)
+{
+    SyncHeaders(state, true);
+}
+
+BENCHMARK(PosHeadersSyncSequential, 1);
+BENCHMARK(PosHeadersSyncParallel, 1);
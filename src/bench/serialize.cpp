@@ -0,0 +1,151 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data.h>
+
+#include <clientversion.h>
+#include <masternodes/masternodes.h>
+#include <primitives/block.h>
+#include <streams.h>
+#include <uint256.h>
+#include <version.h>
+
+#include <map>
+
+// Serialization of the objects that dominate the network and the databases:
+// blocks and transactions on the wire, hash lists (locators, inventories)
+// and masternode records read from disk.
+
+static CBlock LoadBlock()
+{
+    // The header of the sample block is a Bitcoin one, only its transactions are reused.
+    SpanReader reader(SER_NETWORK, PROTOCOL_VERSION, MakeSpan(benchmark::data::block413567));
+    reader.ignore(80);
+    CBlock block;
+    reader >> block.vtx;
+    return block;
+}
+
+static void SerializeBlock(benchmark::State& state)
+{
+    const CBlock block = LoadBlock();
+    const size_t size = GetSerializeSize(block, PROTOCOL_VERSION);
+    while (state.KeepRunning()) {
+        std::vector<unsigned char> data;
+        CVectorWriter{SER_NETWORK, PROTOCOL_VERSION, data, 0, block};
+        assert(data.size() == size);
+    }
+}
+
+static void SerializeBlockTransactions(benchmark::State& state)
+{
+    const CBlock block = LoadBlock();
+    while (state.KeepRunning()) {
+        for (const auto& tx : block.vtx) {
+            CDataStream stream(SER_NETWORK, PROTOCOL_VERSION, tx);
+            assert(!stream.empty());
+        }
+    }
+}
+
+static void DeserializeBlockSpan(benchmark::State& state)
+{
+    std::vector<unsigned char> data;
+    CVectorWriter{SER_NETWORK, PROTOCOL_VERSION, data, 0, LoadBlock()};
+    while (state.KeepRunning()) {
+        CBlock block;
+        SpanReader{SER_NETWORK, PROTOCOL_VERSION, MakeSpan(data), block};
+        assert(!block.vtx.empty());
+    }
+}
+
+static std::vector<uint256> MakeHashes()
+{
+    std::vector<uint256> hashes(2000);
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        hashes[i].begin()[0] = i & 0xff;
+        hashes[i].begin()[1] = i >> 8;
+    }
+    return hashes;
+}
+
+static void SerializeHashes(benchmark::State& state)
+{
+    const std::vector<uint256> hashes = MakeHashes();
+    while (state.KeepRunning()) {
+        CDataStream stream(SER_NETWORK, PROTOCOL_VERSION, hashes);
+        assert(stream.size() == 3 + 32 * hashes.size());
+    }
+}
+
+static void DeserializeHashes(benchmark::State& state)
+{
+    const CDataStream stream(SER_NETWORK, PROTOCOL_VERSION, MakeHashes());
+    const std::vector<unsigned char> data(stream.begin(), stream.end());
+    while (state.KeepRunning()) {
+        std::vector<uint256> hashes;
+        SpanReader{SER_NETWORK, PROTOCOL_VERSION, MakeSpan(data), hashes};
+        assert(hashes.size() == 2000);
+    }
+}
+
+static std::vector<std::vector<unsigned char>> MakeMasternodeRecords()
+{
+    std::vector<std::vector<unsigned char>> records;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        CMasternode node;
+        node.mintedBlocks = i;
+        node.creationHeight = i;
+        records.emplace_back();
+        CVectorWriter{SER_DISK, CLIENT_VERSION, records.back(), 0, node};
+    }
+    return records;
+}
+
+/** As read by CDBWrapper from an obfuscated database: copied into a stream first. */
+static void DeserializeMasternodesCopy(benchmark::State& state)
+{
+    const auto records = MakeMasternodeRecords();
+    while (state.KeepRunning()) {
+        for (const auto& record : records) {
+            CMasternode node;
+            CDataStream stream(record, SER_DISK, CLIENT_VERSION);
+            stream >> node;
+        }
+    }
+}
+
+/** As read by CDBWrapper from a database that is not obfuscated: in place. */
+static void DeserializeMasternodesSpan(benchmark::State& state)
+{
+    const auto records = MakeMasternodeRecords();
+    while (state.KeepRunning()) {
+        for (const auto& record : records) {
+            CMasternode node;
+            SpanReader{SER_DISK, CLIENT_VERSION, MakeSpan(record), node};
+        }
+    }
+}
+
+static void SerializeMasternodeMap(benchmark::State& state)
+{
+    std::map<uint256, CMasternode> nodes;
+    for (const uint256& hash : MakeHashes()) {
+        nodes[hash].mintedBlocks = 1;
+    }
+    while (state.KeepRunning()) {
+        CDataStream stream(SER_DISK, CLIENT_VERSION, nodes);
+        assert(!stream.empty());
+    }
+}
+
+BENCHMARK(SerializeBlock, 300);
+BENCHMARK(SerializeBlockTransactions, 300);
+BENCHMARK(DeserializeBlockSpan, 130);
+BENCHMARK(SerializeHashes, 50 * 1000);
+BENCHMARK(DeserializeHashes, 50 * 1000);
+BENCHMARK(DeserializeMasternodesCopy, 200);
+BENCHMARK(DeserializeMasternodesSpan, 200);
+BENCHMARK(SerializeMasternodeMap, 300);
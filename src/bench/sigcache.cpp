@@ -0,0 +1,107 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data.h>
+
+#include <hash.h>
+#include <primitives/transaction.h>
+#include <pubkey.h>
+#include <script/sigcache.h>
+#include <streams.h>
+#include <version.h>
+
+struct SignatureCheck {
+    uint256 sighash;
+    std::vector<unsigned char> sig;
+    CPubKey pubkey;
+};
+
+/**
+ * Signature checks of the bench block: one for each input that carries a (signature, public key)
+ * pair in its scriptSig or witness, with a per-input stand-in for the signature hash since the
+ * spent outputs are not available.
+ */
+static std::vector<SignatureCheck> BlockSignatureChecks()
+{
+    // The bench block has a Bitcoin header, so skip it and read the transactions only.
+    CDataStream stream(benchmark::data::block413567, SER_NETWORK, PROTOCOL_VERSION);
+    stream.ignore(80);
+    std::vector<CTransactionRef> vtx;
+    stream >> vtx;
+
+    std::vector<SignatureCheck> checks;
+    for (const CTransactionRef& tx : vtx) {
+        for (uint32_t i = 0; i < tx->vin.size(); ++i) {
+            const CTxIn& txin = tx->vin[i];
+            std::vector<std::vector<unsigned char>> pushes = txin.scriptWitness.stack;
+            if (pushes.empty()) {
+                CScript::const_iterator pc = txin.scriptSig.begin();
+                opcodetype opcode;
+                std::vector<unsigned char> data;
+                while (txin.scriptSig.GetOp(pc, opcode, data)) {
+                    pushes.push_back(data);
+                }
+            }
+            if (pushes.size() != 2 || pushes[0].empty()) continue;
+
+            SignatureCheck check;
+            check.sighash = (CHashWriter(SER_GETHASH, 0) << tx->GetHash() << i).GetHash();
+            check.sig = pushes[0];
+            check.pubkey.Set(pushes[1].begin(), pushes[1].end());
+            if (!check.pubkey.IsValid()) continue;
+            checks.push_back(std::move(check));
+        }
+    }
+    return checks;
+}
+
+static std::vector<uint256> ComputeEntries(const std::vector<SignatureCheck>& checks)
+{
+    std::vector<uint256> entries(checks.size());
+    for (size_t i = 0; i < checks.size(); ++i) {
+        ComputeSignatureCacheEntry(entries[i], checks[i].sighash, checks[i].sig, checks[i].pubkey);
+    }
+    return entries;
+}
+
+// Look up every signature of the block in a cache that holds none of them, as
+// when a block arrives with transactions that were not in the mempool.
+static void SigCacheColdLookup(benchmark::State& state)
+{
+    InitSignatureCache();
+    const std::vector<SignatureCheck> checks = BlockSignatureChecks();
+
+    while (state.KeepRunning()) {
+        for (const SignatureCheck& check : checks) {
+            uint256 entry;
+            ComputeSignatureCacheEntry(entry, check.sighash, check.sig, check.pubkey);
+            bool found = SignatureCacheContains(entry, false);
+            assert(!found);
+        }
+    }
+}
+
+// Look up every signature of the block in a cache that holds all of them, as
+// when the block's transactions were all accepted to the mempool.
+static void SigCacheWarmLookup(benchmark::State& state)
+{
+    InitSignatureCache();
+    const std::vector<SignatureCheck> checks = BlockSignatureChecks();
+    for (const uint256& entry : ComputeEntries(checks)) {
+        SignatureCacheInsert(entry);
+    }
+
+    while (state.KeepRunning()) {
+        for (const SignatureCheck& check : checks) {
+            uint256 entry;
+            ComputeSignatureCacheEntry(entry, check.sighash, check.sig, check.pubkey);
+            bool found = SignatureCacheContains(entry, false);
+            assert(found);
+        }
+    }
+}
+
+BENCHMARK(SigCacheColdLookup, 100);
+BENCHMARK(SigCacheWarmLookup, 100);
@@ -105,4 +105,78 @@ static void VerifyScriptBench(benchmark::State& state)
     }
 }
 
+/** Signature checker for signatures found in the signature cache, isolating the script overhead. */
+class CachedSignatureChecker : public MutableTransactionSignatureChecker
+{
+public:
+    using MutableTransactionSignatureChecker::MutableTransactionSignatureChecker;
+
+    bool CheckSig(const std::vector<unsigned char>& scriptSig, const std::vector<unsigned char>& vchPubKey, const CScript& scriptCode, SigVersion sigversion) const override
+    {
+        return true;
+    }
+};
+
+enum class KeyHashTemplate { P2PKH, P2WPKH, P2SH_P2WPKH };
+
+// Verify a spend of one of the single key templates, either checking the
+// signature or, to measure the script handling alone, with a checker that
+// treats every signature as cached.
+static void VerifyKeyHashScript(benchmark::State& state, KeyHashTemplate type, bool cached)
+{
+    const unsigned int flags = SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC | SCRIPT_VERIFY_DERSIG | SCRIPT_VERIFY_LOW_S |
+                               SCRIPT_VERIFY_NULLFAIL | SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_CLEANSTACK;
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    const std::vector<unsigned char> pubkeyHash = ToByteVector(pubkey.GetID());
+    const CScript keyHashScript = CScript() << OP_DUP << OP_HASH160 << pubkeyHash << OP_EQUALVERIFY << OP_CHECKSIG;
+    const CScript witnessProgram = CScript() << 0 << pubkeyHash;
+
+    CScript scriptPubKey;
+    switch (type) {
+    case KeyHashTemplate::P2PKH: scriptPubKey = keyHashScript; break;
+    case KeyHashTemplate::P2WPKH: scriptPubKey = witnessProgram; break;
+    case KeyHashTemplate::P2SH_P2WPKH: scriptPubKey = GetScriptForDestination(ScriptHash(witnessProgram)); break;
+    }
+    const CMutableTransaction txCredit = BuildCreditingTransaction(scriptPubKey);
+    CMutableTransaction txSpend = BuildSpendingTransaction(CScript(), txCredit);
+
+    const SigVersion sigversion = type == KeyHashTemplate::P2PKH ? SigVersion::BASE : SigVersion::WITNESS_V0;
+    std::vector<unsigned char> sig;
+    key.Sign(SignatureHash(keyHashScript, txSpend, 0, SIGHASH_ALL, txCredit.vout[0].nValue, sigversion), sig);
+    sig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+    if (type == KeyHashTemplate::P2PKH) {
+        txSpend.vin[0].scriptSig = CScript() << sig << ToByteVector(pubkey);
+    } else {
+        txSpend.vin[0].scriptWitness.stack = {sig, ToByteVector(pubkey)};
+        if (type == KeyHashTemplate::P2SH_P2WPKH) {
+            txSpend.vin[0].scriptSig = CScript() << ToByteVector(witnessProgram);
+        }
+    }
+
+    const CTxIn& txin = txSpend.vin[0];
+    const CAmount amount = txCredit.vout[0].nValue;
+    while (state.KeepRunning()) {
+        ScriptError err;
+        bool success = cached ?
+            VerifyScript(txin.scriptSig, scriptPubKey, &txin.scriptWitness, flags, CachedSignatureChecker(&txSpend, 0, amount), &err) :
+            VerifyScript(txin.scriptSig, scriptPubKey, &txin.scriptWitness, flags, MutableTransactionSignatureChecker(&txSpend, 0, amount), &err);
+        assert(err == SCRIPT_ERR_OK);
+        assert(success);
+    }
+}
+
+static void VerifyScriptP2PKH(benchmark::State& state) { VerifyKeyHashScript(state, KeyHashTemplate::P2PKH, false); }
+static void VerifyScriptP2SHP2WPKH(benchmark::State& state) { VerifyKeyHashScript(state, KeyHashTemplate::P2SH_P2WPKH, false); }
+static void VerifyScriptP2PKHCachedSig(benchmark::State& state) { VerifyKeyHashScript(state, KeyHashTemplate::P2PKH, true); }
+static void VerifyScriptP2WPKHCachedSig(benchmark::State& state) { VerifyKeyHashScript(state, KeyHashTemplate::P2WPKH, true); }
+static void VerifyScriptP2SHP2WPKHCachedSig(benchmark::State& state) { VerifyKeyHashScript(state, KeyHashTemplate::P2SH_P2WPKH, true); }
+
 BENCHMARK(VerifyScriptBench, 6300);
+BENCHMARK(VerifyScriptP2PKH, 6300);
+BENCHMARK(VerifyScriptP2SHP2WPKH, 6300);
+BENCHMARK(VerifyScriptP2PKHCachedSig, 1000000);
+BENCHMARK(VerifyScriptP2WPKHCachedSig, 1000000);
+BENCHMARK(VerifyScriptP2SHP2WPKHCachedSig, 1000000);
@@ -41,12 +41,39 @@ static void WalletBalance(benchmark::State& state, const bool set_dirty, const b
     }
 }
 
+// A wallet with 100k confirmed transactions, of which one in ten has an unspent output.
+static void WalletBalanceLarge(benchmark::State& state, const bool set_dirty, const bool mempool_update)
+{
+    std::unique_ptr<interfaces::Chain> chain = interfaces::MakeChain();
+    CWallet wallet{chain.get(), WalletLocation(), WalletDatabase::CreateMock()};
+    {
+        bool first_run;
+        if (wallet.LoadWallet(first_run) != DBErrors::LOAD_OK) assert(false);
+    }
+    const CAmount unspent = AddWalletHistory(wallet, 100000, 10);
+    const CTransactionRef some_tx = WITH_LOCK(wallet.cs_wallet, return wallet.mapWallet.begin()->second.tx);
+
+    while (state.KeepRunning()) {
+        if (set_dirty) wallet.MarkDirty();
+        // A mempool notification invalidates the balance, but not the per-transaction caches.
+        if (mempool_update) wallet.TransactionRemovedFromMempool(some_tx);
+        const auto bal = wallet.GetBalance();
+        assert(bal.m_mine_trusted == unspent);
+    }
+}
+
 static void WalletBalanceDirty(benchmark::State& state) { WalletBalance(state, /* set_dirty */ true, /* add_watchonly */ true, /* add_mine */ true); }
 static void WalletBalanceClean(benchmark::State& state) { WalletBalance(state, /* set_dirty */ false, /* add_watchonly */ true, /* add_mine */ true); }
 static void WalletBalanceMine(benchmark::State& state) { WalletBalance(state, /* set_dirty */ false, /* add_watchonly */ false, /* add_mine */ true); }
 static void WalletBalanceWatch(benchmark::State& state) { WalletBalance(state, /* set_dirty */ false, /* add_watchonly */ true, /* add_mine */ false); }
+static void WalletBalanceLargeDirty(benchmark::State& state) { WalletBalanceLarge(state, /* set_dirty */ true, /* mempool_update */ false); }
+static void WalletBalanceLargeMempool(benchmark::State& state) { WalletBalanceLarge(state, /* set_dirty */ false, /* mempool_update */ true); }
+static void WalletBalanceLargeClean(benchmark::State& state) { WalletBalanceLarge(state, /* set_dirty */ false, /* mempool_update */ false); }
 
 BENCHMARK(WalletBalanceDirty, 2500);
 BENCHMARK(WalletBalanceClean, 8000);
 BENCHMARK(WalletBalanceMine, 16000);
 BENCHMARK(WalletBalanceWatch, 8000);
+BENCHMARK(WalletBalanceLargeDirty, 10);
+BENCHMARK(WalletBalanceLargeMempool, 500);
+BENCHMARK(WalletBalanceLargeClean, 100000);
@@ -0,0 +1,25 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <interfaces/chain.h>
+#include <wallet/wallet.h>
+
+// Filling the keypool of a new HD wallet with 10k external and 10k internal keys.
+static void WalletKeyPoolTopUp(benchmark::State& state)
+{
+    std::unique_ptr<interfaces::Chain> chain = interfaces::MakeChain();
+    while (state.KeepRunning()) {
+        CWallet wallet{chain.get(), WalletLocation(), WalletDatabase::CreateMock()};
+        bool first_run;
+        if (wallet.LoadWallet(first_run) != DBErrors::LOAD_OK) assert(false);
+        LOCK(wallet.cs_wallet);
+        wallet.SetMinVersion(FEATURE_LATEST);
+        wallet.SetHDSeed(wallet.GenerateNewSeed());
+        if (!wallet.TopUpKeyPool(10000)) assert(false);
+        assert(wallet.GetKeyPoolSize() == 20000);
+    }
+}
+
+BENCHMARK(WalletKeyPoolTopUp, 1);
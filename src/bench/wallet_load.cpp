@@ -0,0 +1,49 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <interfaces/chain.h>
+#include <key.h>
+#include <test/util.h>
+#include <util/system.h>
+#include <wallet/wallet.h>
+#include <wallet/walletdb.h>
+
+// Loading a wallet file with 50k transactions and 2k keys, as large
+// masternode operator wallets have.
+static void WalletLoadLarge(benchmark::State& state)
+{
+    const fs::path path = GetDataDir() / "wallet_load";
+    fs::create_directories(path);
+    std::unique_ptr<interfaces::Chain> chain = interfaces::MakeChain();
+    {
+        CWallet wallet{chain.get(), WalletLocation(), WalletDatabase::Create(path)};
+        bool first_run;
+        if (wallet.LoadWallet(first_run) != DBErrors::LOAD_OK) assert(false);
+        AddWalletHistory(wallet, 50000, 10);
+        LOCK(wallet.cs_wallet);
+        for (int i = 0; i < 2000; ++i) {
+            CKey key;
+            key.MakeNewKey(true);
+            if (!wallet.AddKeyPubKey(key, key.GetPubKey())) assert(false);
+        }
+        WalletBatch batch{wallet.GetDBHandle()};
+        batch.TxnBegin();
+        for (const auto& entry : wallet.mapWallet) {
+            if (!batch.WriteTx(entry.second)) assert(false);
+        }
+        batch.TxnCommit();
+        wallet.Flush(true);
+    }
+
+    while (state.KeepRunning()) {
+        CWallet wallet{chain.get(), WalletLocation(), WalletDatabase::Create(path)};
+        bool first_run;
+        if (wallet.LoadWallet(first_run) != DBErrors::LOAD_OK) assert(false);
+        assert(WITH_LOCK(wallet.cs_wallet, return wallet.mapWallet.size()) == 50000);
+        wallet.Flush(true);
+    }
+}
+
+BENCHMARK(WalletLoadLarge, 5);
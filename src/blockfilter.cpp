@@ -6,6 +6,7 @@
 #include <sstream>
 
 #include <blockfilter.h>
+#include <crypto/common.h>
 #include <crypto/siphash.h>
 #include <hash.h>
 #include <primitives/transaction.h>
@@ -22,36 +23,188 @@ static const std::map<BlockFilterType, std::string> g_filter_types = {
     {BlockFilterType::BASIC, "basic"},
 };
 
-template <typename OStream>
-static void GolombRiceEncode(BitStreamWriter<OStream>& bitwriter, uint8_t P, uint64_t x)
+/// Filters with at least this many elements are sorted with a radix sort instead of std::sort.
+static constexpr size_t RADIX_SORT_MIN_ELEMENTS = 512;
+
+/// Number of bits sorted per radix sort pass.
+static constexpr int RADIX_BITS = 11;
+
+/// Number of leading one bits of every byte value, used to decode short unary quotients.
+static const uint8_t LEADING_ONES[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 7, 8,
+};
+
+/**
+ * Golomb-Rice encoder writing to a byte vector. Bits are gathered in a 64-bit accumulator and
+ * appended a whole byte at a time, most significant bit first, so the output is identical to
+ * encoding through BitStreamWriter.
+ */
+class GolombRiceWriter
 {
-    // Write quotient as unary-encoded: q 1's followed by one 0.
-    uint64_t q = x >> P;
-    while (q > 0) {
-        int nbits = q <= 64 ? static_cast<int>(q) : 64;
-        bitwriter.Write(~0ULL, nbits);
-        q -= nbits;
+private:
+    std::vector<unsigned char>& m_out;
+
+    /// Pending bits, right-aligned. Only the low m_nbits bits are meaningful.
+    uint64_t m_acc{0};
+
+    /// Number of pending bits, always less than 8 between calls.
+    int m_nbits{0};
+
+    /** Append the nbits least significant bits of data, where nbits is at most 32. */
+    void WriteBits(uint64_t data, int nbits)
+    {
+        m_acc = (m_acc << nbits) | (data & ((uint64_t{1} << nbits) - 1));
+        m_nbits += nbits;
+        while (m_nbits >= 8) {
+            m_nbits -= 8;
+            m_out.push_back(static_cast<unsigned char>(m_acc >> m_nbits));
+        }
     }
-    bitwriter.Write(0, 1);
 
-    // Write the remainder in P bits. Since the remainder is just the bottom
-    // P bits of x, there is no need to mask first.
-    bitwriter.Write(x, P);
-}
+public:
+    explicit GolombRiceWriter(std::vector<unsigned char>& out) : m_out(out) {}
 
-template <typename IStream>
-static uint64_t GolombRiceDecode(BitStreamReader<IStream>& bitreader, uint8_t P)
+    ~GolombRiceWriter()
+    {
+        Flush();
+    }
+
+    void Encode(uint8_t P, uint64_t x)
+    {
+        if (P > 64) {
+            throw std::out_of_range("nbits must be between 0 and 64");
+        }
+
+        // Write quotient as unary-encoded: q 1's followed by one 0.
+        uint64_t q = x >> P;
+        while (q >= 32) {
+            WriteBits(~0ULL, 32);
+            q -= 32;
+        }
+        WriteBits(((uint64_t{1} << q) - 1) << 1, static_cast<int>(q) + 1);
+
+        // Write the remainder in P bits.
+        if (P > 32) {
+            WriteBits(x >> 32, P - 32);
+            WriteBits(x, 32);
+        } else {
+            WriteBits(x, P);
+        }
+    }
+
+    /** Write any pending bits, padding with 0's to the next byte boundary. */
+    void Flush()
+    {
+        if (m_nbits == 0) {
+            return;
+        }
+        m_out.push_back(static_cast<unsigned char>(m_acc << (8 - m_nbits)));
+        m_nbits = 0;
+    }
+};
+
+/**
+ * Golomb-Rice decoder reading from a byte range. Up to 64 bits are buffered in a left-aligned
+ * window, so that short unary quotients are decoded with a single table lookup instead of one
+ * read per bit. Reading past the end throws std::ios_base::failure like BitStreamReader does.
+ */
+class GolombRiceReader
 {
-    // Read unary-encoded quotient: q 1's followed by one 0.
-    uint64_t q = 0;
-    while (bitreader.Read(1) == 1) {
-        ++q;
+private:
+    const unsigned char* const m_begin;
+    const unsigned char* m_pos;
+    const unsigned char* const m_end;
+
+    /// Unread bits, left-aligned. Bits past m_nbits are zero.
+    uint64_t m_window{0};
+
+    /// Number of unread bits in m_window.
+    int m_nbits{0};
+
+    void Refill()
+    {
+        while (m_nbits <= 56 && m_pos != m_end) {
+            m_window |= static_cast<uint64_t>(*m_pos++) << (56 - m_nbits);
+            m_nbits += 8;
+        }
     }
 
-    uint64_t r = bitreader.Read(P);
+    void Consume(int nbits)
+    {
+        m_window = nbits < 64 ? m_window << nbits : 0;
+        m_nbits -= nbits;
+    }
 
-    return (q << P) + r;
-}
+    /** Read nbits bits, where nbits is at most 32, as an integer. */
+    uint64_t ReadBits(int nbits)
+    {
+        if (nbits == 0) {
+            return 0;
+        }
+        if (m_nbits < nbits) {
+            Refill();
+            if (m_nbits < nbits) {
+                throw std::ios_base::failure("GolombRiceReader::ReadBits(): end of data");
+            }
+        }
+        uint64_t data = m_window >> (64 - nbits);
+        Consume(nbits);
+        return data;
+    }
+
+    static int LeadingOnes(uint64_t window)
+    {
+        // Quotients are nearly always below 8, so the top byte almost always decides.
+        int ones = LEADING_ONES[window >> 56];
+        return ones < 8 ? ones : 64 - static_cast<int>(CountBits(~window));
+    }
+
+public:
+    GolombRiceReader(const std::vector<unsigned char>& data, size_t pos)
+        : m_begin(data.data() + pos), m_pos(m_begin), m_end(data.data() + data.size())
+    {}
+
+    uint64_t Decode(uint8_t P)
+    {
+        if (P > 64) {
+            throw std::out_of_range("nbits must be between 0 and 64");
+        }
+
+        // Read unary-encoded quotient: q 1's followed by one 0.
+        uint64_t q = 0;
+        while (true) {
+            Refill();
+            if (m_nbits == 0) {
+                throw std::ios_base::failure("GolombRiceReader::Decode(): end of data");
+            }
+            int ones = LeadingOnes(m_window);
+            if (ones < m_nbits) {
+                q += ones;
+                Consume(ones + 1);
+                break;
+            }
+            q += m_nbits;
+            Consume(m_nbits);
+        }
+
+        uint64_t r = P > 32 ? (ReadBits(P - 32) << 32) | ReadBits(32) : ReadBits(P);
+
+        return (q << P) + r;
+    }
+
+    /** Number of bytes of which at least one bit has been decoded. */
+    size_t BytesRead() const
+    {
+        return (m_pos - m_begin) - m_nbits / 8;
+    }
+};
 
 // Map a value x that is uniformly distributed in the range [0, 2^64) to a
 // value uniformly distributed in [0, n) by returning the upper 64 bits of
@@ -84,6 +237,32 @@ static uint64_t MapIntoRange(uint64_t x, uint64_t n)
 #endif
 }
 
+/** Sort values in the range [0, F) with a least significant digit radix sort. */
+static void RadixSort(std::vector<uint64_t>& values, uint64_t F)
+{
+    constexpr size_t radix_size = size_t{1} << RADIX_BITS;
+    const int value_bits = static_cast<int>(CountBits(F - 1));
+
+    std::vector<uint64_t> scratch(values.size());
+    std::vector<size_t> offsets(radix_size);
+    for (int shift = 0; shift < value_bits; shift += RADIX_BITS) {
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (uint64_t value : values) {
+            ++offsets[(value >> shift) & (radix_size - 1)];
+        }
+        size_t sum = 0;
+        for (size_t& offset : offsets) {
+            size_t count = offset;
+            offset = sum;
+            sum += count;
+        }
+        for (uint64_t value : values) {
+            scratch[offsets[(value >> shift) & (radix_size - 1)]++] = value;
+        }
+        values.swap(scratch);
+    }
+}
+
 uint64_t GCSFilter::HashToRange(const Element& element) const
 {
     uint64_t hash = CSipHasher(m_params.m_siphash_k0, m_params.m_siphash_k1)
@@ -94,12 +273,20 @@ uint64_t GCSFilter::HashToRange(const Element& element) const
 
 std::vector<uint64_t> GCSFilter::BuildHashedSet(const ElementSet& elements) const
 {
+    // Key the hasher once and hash every element with a copy of it.
+    const CSipHasher hasher(m_params.m_siphash_k0, m_params.m_siphash_k1);
+
     std::vector<uint64_t> hashed_elements;
     hashed_elements.reserve(elements.size());
     for (const Element& element : elements) {
-        hashed_elements.push_back(HashToRange(element));
+        uint64_t hash = CSipHasher(hasher).Write(element.data(), element.size()).Finalize();
+        hashed_elements.push_back(MapIntoRange(hash, m_F));
+    }
+    if (hashed_elements.size() < RADIX_SORT_MIN_ELEMENTS) {
+        std::sort(hashed_elements.begin(), hashed_elements.end());
+    } else {
+        RadixSort(hashed_elements, m_F);
     }
-    std::sort(hashed_elements.begin(), hashed_elements.end());
     return hashed_elements;
 }
 
@@ -121,11 +308,11 @@ GCSFilter::GCSFilter(const Params& params, std::vector<unsigned char> encoded_fi
 
     // Verify that the encoded filter contains exactly N elements. If it has too much or too little
     // data, a std::ios_base::failure exception will be raised.
-    BitStreamReader<VectorReader> bitreader(stream);
+    GolombRiceReader reader(m_encoded, m_encoded.size() - stream.size());
     for (uint64_t i = 0; i < m_N; ++i) {
-        GolombRiceDecode(bitreader, m_params.m_P);
+        reader.Decode(m_params.m_P);
     }
-    if (!stream.empty()) {
+    if (reader.BytesRead() != stream.size()) {
         throw std::ios_base::failure("encoded_filter contains excess data");
     }
 }
@@ -148,16 +335,18 @@ GCSFilter::GCSFilter(const Params& params, const ElementSet& elements)
         return;
     }
 
-    BitStreamWriter<CVectorWriter> bitwriter(stream);
+    // Each delta takes P bits of remainder and, on average, under 3 bits of unary quotient.
+    m_encoded.reserve(m_encoded.size() + (static_cast<uint64_t>(m_N) * (m_params.m_P + 3) + 7) / 8);
+    GolombRiceWriter writer(m_encoded);
 
     uint64_t last_value = 0;
     for (uint64_t value : BuildHashedSet(elements)) {
         uint64_t delta = value - last_value;
-        GolombRiceEncode(bitwriter, m_params.m_P, delta);
+        writer.Encode(m_params.m_P, delta);
         last_value = value;
     }
 
-    bitwriter.Flush();
+    writer.Flush();
 }
 
 bool GCSFilter::MatchInternal(const uint64_t* element_hashes, size_t size) const
@@ -168,12 +357,12 @@ bool GCSFilter::MatchInternal(const uint64_t* element_hashes, size_t size) const
     uint64_t N = ReadCompactSize(stream);
     assert(N == m_N);
 
-    BitStreamReader<VectorReader> bitreader(stream);
+    GolombRiceReader reader(m_encoded, m_encoded.size() - stream.size());
 
     uint64_t value = 0;
     size_t hashes_index = 0;
     for (uint32_t i = 0; i < m_N; ++i) {
-        uint64_t delta = GolombRiceDecode(bitreader, m_params.m_P);
+        uint64_t delta = reader.Decode(m_params.m_P);
         value += delta;
 
         while (true) {
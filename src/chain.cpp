@@ -5,6 +5,8 @@
 
 #include <chain.h>
 
+#include <memusage.h>
+
 /**
  * CChain implementation
  */
@@ -169,3 +171,24 @@ const CBlockIndex* LastCommonAncestor(const CBlockIndex* pa, const CBlockIndex*
     assert(pa == pb);
     return pa;
 }
+
+CBlockIndex* CBlockIndexArena::Allocate()
+{
+    if (m_size == m_chunks.size() * CHUNK_SIZE) {
+        m_chunks.emplace_back(new CBlockIndex[CHUNK_SIZE]);
+    }
+    CBlockIndex* pindex = &m_chunks.back()[m_size % CHUNK_SIZE];
+    ++m_size;
+    return pindex;
+}
+
+void CBlockIndexArena::Clear()
+{
+    m_chunks.clear();
+    m_size = 0;
+}
+
+size_t CBlockIndexArena::DynamicMemoryUsage() const
+{
+    return m_chunks.size() * memusage::MallocUsage(CHUNK_SIZE * sizeof(CBlockIndex)) + memusage::DynamicUsage(m_chunks);
+}
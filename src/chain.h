@@ -9,11 +9,13 @@
 #include <arith_uint256.h>
 #include <consensus/params.h>
 #include <flatfile.h>
+#include <prevector.h>
 #include <primitives/block.h>
 #include <streams.h>
 #include <tinyformat.h>
 #include <uint256.h>
 
+#include <memory>
 #include <vector>
 #include <boost/optional.hpp>
 
@@ -187,8 +189,8 @@ public:
     uint64_t height;
     uint64_t mintedBlocks;
     uint256 stakeModifier; // hash modifier for proof-of-stake
-    std::vector<unsigned char> sig;
-    CKeyID minter; // memory only
+    prevector<CPubKey::COMPACT_SIGNATURE_SIZE, unsigned char> sig; // inline, saves a heap allocation per entry
+    CKeyID minter; // stored apart from CDiskBlockIndex, see CBlockTreeDB::LoadBlockIndexGuts
 
     //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
     int32_t nSequenceId;
@@ -229,6 +231,13 @@ public:
     }
 
     explicit CBlockIndex(const CBlockHeader& block)
+        : CBlockIndex(block, CKeyID())
+    {
+        block.ExtractMinterKey(minter);
+    }
+
+    /** Use an already recovered minter key instead of recovering it from the signature. */
+    CBlockIndex(const CBlockHeader& block, const CKeyID& minterKey)
     {
         SetNull();
 
@@ -239,8 +248,8 @@ public:
         height         = block.height;
         mintedBlocks   = block.mintedBlocks;
         stakeModifier  = block.stakeModifier;
-        sig            = block.sig;
-        block.ExtractMinterKey(minter);
+        sig.assign(block.sig.begin(), block.sig.end());
+        minter         = minterKey;
     }
 
     FlatFilePos GetBlockPos() const {
@@ -273,7 +282,7 @@ public:
         block.stakeModifier   = stakeModifier;
         block.height         = height;
         block.mintedBlocks   = mintedBlocks;
-        block.sig            = sig;
+        block.sig.assign(sig.begin(), sig.end());
         return block;
     }
 
@@ -419,7 +428,7 @@ public:
         block.stakeModifier   = stakeModifier;
         block.height          = height;
         block.mintedBlocks    = mintedBlocks;
-        block.sig             = sig;
+        block.sig.assign(sig.begin(), sig.end());
 
         return block.GetHash();
     }
@@ -436,6 +445,38 @@ public:
     }
 };
 
+/**
+ * Allocates block index entries in contiguous chunks rather than one heap
+ * allocation per entry. Entries are never freed one at a time: the whole
+ * arena is released by Clear(), as the block index is only ever unloaded
+ * as a whole.
+ */
+class CBlockIndexArena
+{
+public:
+    //! Number of entries per chunk
+    static constexpr size_t CHUNK_SIZE = 4096;
+
+    CBlockIndexArena() = default;
+    CBlockIndexArena(const CBlockIndexArena&) = delete;
+    CBlockIndexArena& operator=(const CBlockIndexArena&) = delete;
+
+    //! Return a new, null block index entry owned by the arena
+    CBlockIndex* Allocate();
+
+    //! Free all entries. Pointers handed out before are invalidated.
+    void Clear();
+
+    //! Number of entries handed out
+    size_t Size() const { return m_size; }
+
+    size_t DynamicMemoryUsage() const;
+
+private:
+    std::vector<std::unique_ptr<CBlockIndex[]>> m_chunks;
+    size_t m_size = 0;
+};
+
 /** An in-memory indexed chain of blocks. */
 class CChain {
 private:
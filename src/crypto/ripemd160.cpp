@@ -14,11 +14,11 @@ namespace
 /// Internal RIPEMD-160 implementation.
 namespace ripemd160
 {
-uint32_t inline f1(uint32_t x, uint32_t y, uint32_t z) { return x ^ y ^ z; }
-uint32_t inline f2(uint32_t x, uint32_t y, uint32_t z) { return (x & y) | (~x & z); }
-uint32_t inline f3(uint32_t x, uint32_t y, uint32_t z) { return (x | ~y) ^ z; }
-uint32_t inline f4(uint32_t x, uint32_t y, uint32_t z) { return (x & z) | (y & ~z); }
-uint32_t inline f5(uint32_t x, uint32_t y, uint32_t z) { return x ^ (y | ~z); }
+template<typename W> W inline f1(W x, W y, W z) { return x ^ y ^ z; }
+template<typename W> W inline f2(W x, W y, W z) { return (x & y) | (~x & z); }
+template<typename W> W inline f3(W x, W y, W z) { return (x | ~y) ^ z; }
+template<typename W> W inline f4(W x, W y, W z) { return (x & z) | (y & ~z); }
+template<typename W> W inline f5(W x, W y, W z) { return x ^ (y | ~z); }
 
 /** Initialize RIPEMD-160 state. */
 void inline Initialize(uint32_t* s)
@@ -30,35 +30,60 @@ void inline Initialize(uint32_t* s)
     s[4] = 0xC3D2E1F0ul;
 }
 
-uint32_t inline rol(uint32_t x, int i) { return (x << i) | (x >> (32 - i)); }
+template<typename W> W inline rol(W x, int i) { return (x << i) | (x >> (32 - i)); }
 
-void inline Round(uint32_t& a, uint32_t b, uint32_t& c, uint32_t d, uint32_t e, uint32_t f, uint32_t x, uint32_t k, int r)
+template<typename W> void inline Round(W& a, W b, W& c, W d, W e, W f, W x, uint32_t k, int r)
 {
     a = rol(a + f + x + k, r) + e;
     c = rol(c, 10);
 }
 
-void inline R11(uint32_t& a, uint32_t b, uint32_t& c, uint32_t d, uint32_t e, uint32_t x, int r) { Round(a, b, c, d, e, f1(b, c, d), x, 0, r); }
-void inline R21(uint32_t& a, uint32_t b, uint32_t& c, uint32_t d, uint32_t e, uint32_t x, int r) { Round(a, b, c, d, e, f2(b, c, d), x, 0x5A827999ul, r); }
-void inline R31(uint32_t& a, uint32_t b, uint32_t& c, uint32_t d, uint32_t e, uint32_t x, int r) { Round(a, b, c, d, e, f3(b, c, d), x, 0x6ED9EBA1ul, r); }
-void inline R41(uint32_t& a, uint32_t b, uint32_t& c, uint32_t d, uint32_t e, uint32_t x, int r) { Round(a, b, c, d, e, f4(b, c, d), x, 0x8F1BBCDCul, r); }
-void inline R51(uint32_t& a, uint32_t b, uint32_t& c, uint32_t d, uint32_t e, uint32_t x, int r) { Round(a, b, c, d, e, f5(b, c, d), x, 0xA953FD4Eul, r); }
+template<typename W> void inline R11(W& a, W b, W& c, W d, W e, W x, int r) { Round(a, b, c, d, e, f1(b, c, d), x, 0, r); }
+template<typename W> void inline R21(W& a, W b, W& c, W d, W e, W x, int r) { Round(a, b, c, d, e, f2(b, c, d), x, 0x5A827999ul, r); }
+template<typename W> void inline R31(W& a, W b, W& c, W d, W e, W x, int r) { Round(a, b, c, d, e, f3(b, c, d), x, 0x6ED9EBA1ul, r); }
+template<typename W> void inline R41(W& a, W b, W& c, W d, W e, W x, int r) { Round(a, b, c, d, e, f4(b, c, d), x, 0x8F1BBCDCul, r); }
+template<typename W> void inline R51(W& a, W b, W& c, W d, W e, W x, int r) { Round(a, b, c, d, e, f5(b, c, d), x, 0xA953FD4Eul, r); }
 
-void inline R12(uint32_t& a, uint32_t b, uint32_t& c, uint32_t d, uint32_t e, uint32_t x, int r) { Round(a, b, c, d, e, f5(b, c, d), x, 0x50A28BE6ul, r); }
-void inline R22(uint32_t& a, uint32_t b, uint32_t& c, uint32_t d, uint32_t e, uint32_t x, int r) { Round(a, b, c, d, e, f4(b, c, d), x, 0x5C4DD124ul, r); }
-void inline R32(uint32_t& a, uint32_t b, uint32_t& c, uint32_t d, uint32_t e, uint32_t x, int r) { Round(a, b, c, d, e, f3(b, c, d), x, 0x6D703EF3ul, r); }
-void inline R42(uint32_t& a, uint32_t b, uint32_t& c, uint32_t d, uint32_t e, uint32_t x, int r) { Round(a, b, c, d, e, f2(b, c, d), x, 0x7A6D76E9ul, r); }
-void inline R52(uint32_t& a, uint32_t b, uint32_t& c, uint32_t d, uint32_t e, uint32_t x, int r) { Round(a, b, c, d, e, f1(b, c, d), x, 0, r); }
+template<typename W> void inline R12(W& a, W b, W& c, W d, W e, W x, int r) { Round(a, b, c, d, e, f5(b, c, d), x, 0x50A28BE6ul, r); }
+template<typename W> void inline R22(W& a, W b, W& c, W d, W e, W x, int r) { Round(a, b, c, d, e, f4(b, c, d), x, 0x5C4DD124ul, r); }
+template<typename W> void inline R32(W& a, W b, W& c, W d, W e, W x, int r) { Round(a, b, c, d, e, f3(b, c, d), x, 0x6D703EF3ul, r); }
+template<typename W> void inline R42(W& a, W b, W& c, W d, W e, W x, int r) { Round(a, b, c, d, e, f2(b, c, d), x, 0x7A6D76E9ul, r); }
+template<typename W> void inline R52(W& a, W b, W& c, W d, W e, W x, int r) { Round(a, b, c, d, e, f1(b, c, d), x, 0, r); }
 
-/** Perform a RIPEMD-160 transformation, processing a 64-byte chunk. */
-void Transform(uint32_t* s, const unsigned char* chunk)
+/**
+ * Four words, one from each of four independent messages. Transforming them
+ * in lockstep gives the compiler four-wide operations; with GCC and Clang they
+ * are held in a vector type, which is what gets them into SIMD registers.
+ */
+struct Lanes4
+{
+#if defined(__GNUC__)
+    typedef uint32_t Vec __attribute__((vector_size(16)));
+    Vec v;
+#else
+    uint32_t v[4];
+#endif
+
+    static Lanes4 Broadcast(uint32_t x) { Lanes4 r; for (int i = 0; i < 4; ++i) r.v[i] = x; return r; }
+};
+
+Lanes4 inline operator+(Lanes4 x, Lanes4 y) { for (int i = 0; i < 4; ++i) x.v[i] += y.v[i]; return x; }
+Lanes4 inline operator+(Lanes4 x, uint32_t y) { for (int i = 0; i < 4; ++i) x.v[i] += y; return x; }
+Lanes4 inline operator^(Lanes4 x, Lanes4 y) { for (int i = 0; i < 4; ++i) x.v[i] ^= y.v[i]; return x; }
+Lanes4 inline operator&(Lanes4 x, Lanes4 y) { for (int i = 0; i < 4; ++i) x.v[i] &= y.v[i]; return x; }
+Lanes4 inline operator|(Lanes4 x, Lanes4 y) { for (int i = 0; i < 4; ++i) x.v[i] |= y.v[i]; return x; }
+Lanes4 inline operator~(Lanes4 x) { for (int i = 0; i < 4; ++i) x.v[i] = ~x.v[i]; return x; }
+Lanes4 inline operator<<(Lanes4 x, int n) { for (int i = 0; i < 4; ++i) x.v[i] <<= n; return x; }
+Lanes4 inline operator>>(Lanes4 x, int n) { for (int i = 0; i < 4; ++i) x.v[i] >>= n; return x; }
+
+/** Perform a RIPEMD-160 transformation of the 16 words of a chunk, a word being uint32_t or Lanes4. */
+template<typename W>
+void TransformWords(W* s, const W* w)
 {
-    uint32_t a1 = s[0], b1 = s[1], c1 = s[2], d1 = s[3], e1 = s[4];
-    uint32_t a2 = a1, b2 = b1, c2 = c1, d2 = d1, e2 = e1;
-    uint32_t w0 = ReadLE32(chunk + 0), w1 = ReadLE32(chunk + 4), w2 = ReadLE32(chunk + 8), w3 = ReadLE32(chunk + 12);
-    uint32_t w4 = ReadLE32(chunk + 16), w5 = ReadLE32(chunk + 20), w6 = ReadLE32(chunk + 24), w7 = ReadLE32(chunk + 28);
-    uint32_t w8 = ReadLE32(chunk + 32), w9 = ReadLE32(chunk + 36), w10 = ReadLE32(chunk + 40), w11 = ReadLE32(chunk + 44);
-    uint32_t w12 = ReadLE32(chunk + 48), w13 = ReadLE32(chunk + 52), w14 = ReadLE32(chunk + 56), w15 = ReadLE32(chunk + 60);
+    W a1 = s[0], b1 = s[1], c1 = s[2], d1 = s[3], e1 = s[4];
+    W a2 = a1, b2 = b1, c2 = c1, d2 = d1, e2 = e1;
+    W w0 = w[0], w1 = w[1], w2 = w[2], w3 = w[3], w4 = w[4], w5 = w[5], w6 = w[6], w7 = w[7];
+    W w8 = w[8], w9 = w[9], w10 = w[10], w11 = w[11], w12 = w[12], w13 = w[13], w14 = w[14], w15 = w[15];
 
     R11(a1, b1, c1, d1, e1, w0, 11);
     R12(a2, b2, c2, d2, e2, w5, 8);
@@ -225,7 +250,7 @@ void Transform(uint32_t* s, const unsigned char* chunk)
     R51(b1, c1, d1, e1, a1, w13, 6);
     R52(b2, c2, d2, e2, a2, w11, 11);
 
-    uint32_t t = s[0];
+    W t = s[0];
     s[0] = s[1] + c1 + d2;
     s[1] = s[2] + d1 + e2;
     s[2] = s[3] + e1 + a2;
@@ -233,6 +258,44 @@ void Transform(uint32_t* s, const unsigned char* chunk)
     s[4] = t + b1 + c2;
 }
 
+/** Perform a RIPEMD-160 transformation, processing a 64-byte chunk. */
+void Transform(uint32_t* s, const unsigned char* chunk)
+{
+    uint32_t w[16];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = ReadLE32(chunk + 4 * i);
+    }
+    TransformWords(s, w);
+}
+
+/** Hash four 32-byte blobs at once, which fit a single chunk with their padding. */
+void Transform32_4way(unsigned char* out, const unsigned char* in)
+{
+    uint32_t init[5];
+    Initialize(init);
+    Lanes4 s[5];
+    for (int i = 0; i < 5; ++i) {
+        s[i] = Lanes4::Broadcast(init[i]);
+    }
+    Lanes4 w[16];
+    for (int i = 0; i < 8; ++i) {
+        for (int lane = 0; lane < 4; ++lane) {
+            w[i].v[lane] = ReadLE32(in + 32 * lane + 4 * i);
+        }
+    }
+    w[8] = Lanes4::Broadcast(0x80);
+    for (int i = 9; i < 16; ++i) {
+        w[i] = Lanes4::Broadcast(0);
+    }
+    w[14] = Lanes4::Broadcast(32 << 3);
+    TransformWords(s, w);
+    for (int lane = 0; lane < 4; ++lane) {
+        for (int i = 0; i < 5; ++i) {
+            WriteLE32(out + 20 * lane + 4 * i, s[i].v[lane]);
+        }
+    }
+}
+
 } // namespace ripemd160
 
 } // namespace
@@ -290,3 +353,19 @@ CRIPEMD160& CRIPEMD160::Reset()
     ripemd160::Initialize(s);
     return *this;
 }
+
+void RIPEMD160_32(unsigned char* out, const unsigned char* in, size_t blocks)
+{
+    while (blocks >= 4) {
+        ripemd160::Transform32_4way(out, in);
+        out += 80;
+        in += 128;
+        blocks -= 4;
+    }
+    while (blocks) {
+        CRIPEMD160().Write(in, 32).Finalize(out);
+        out += 20;
+        in += 32;
+        --blocks;
+    }
+}
@@ -24,11 +24,21 @@ namespace sha256d64_sse41
 void Transform_4way(unsigned char* out, const unsigned char* in);
 }
 
+namespace sha256_sse41
+{
+void Transform_4way(uint32_t* s, const unsigned char* const* chunks);
+}
+
 namespace sha256d64_avx2
 {
 void Transform_8way(unsigned char* out, const unsigned char* in);
 }
 
+namespace sha256_avx2
+{
+void Transform_8way(uint32_t* s, const unsigned char* const* chunks);
+}
+
 namespace sha256d64_shani
 {
 void Transform_2way(unsigned char* out, const unsigned char* in);
@@ -37,6 +47,7 @@ void Transform_2way(unsigned char* out, const unsigned char* in);
 namespace sha256_shani
 {
 void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks);
+void Transform_2way(uint32_t* s, const unsigned char* const* chunks);
 }
 
 // Internal implementation code.
@@ -416,6 +427,8 @@ void TransformD64(unsigned char* out, const unsigned char* in)
 
 typedef void (*TransformType)(uint32_t*, const unsigned char*, size_t);
 typedef void (*TransformD64Type)(unsigned char*, const unsigned char*);
+/** Transform one chunk per lane, with the states of the lanes one after the other. */
+typedef void (*TransformMultiType)(uint32_t*, const unsigned char* const*);
 
 template<TransformType tr>
 void TransformD64Wrapper(unsigned char* out, const unsigned char* in)
@@ -461,6 +474,10 @@ TransformD64Type TransformD64 = sha256::TransformD64;
 TransformD64Type TransformD64_2way = nullptr;
 TransformD64Type TransformD64_4way = nullptr;
 TransformD64Type TransformD64_8way = nullptr;
+TransformMultiType TransformMulti = nullptr;
+size_t TransformMultiLanes = 0;
+
+static const size_t MAX_MULTI_LANES = 8;
 
 bool SelfTest() {
     // Input state (equal to the initial SHA256 state)
@@ -544,6 +561,20 @@ bool SelfTest() {
         if (!std::equal(out, out + 256, result_d64)) return false;
     }
 
+    // Test TransformMulti, if available: lane i transforms block i from the state after the i first.
+    if (TransformMulti) {
+        uint32_t states[8 * MAX_MULTI_LANES];
+        const unsigned char* chunks[MAX_MULTI_LANES];
+        for (size_t lane = 0; lane < TransformMultiLanes; ++lane) {
+            std::copy(result[lane], result[lane] + 8, states + 8 * lane);
+            chunks[lane] = data + 1 + 64 * lane;
+        }
+        TransformMulti(states, chunks);
+        for (size_t lane = 0; lane < TransformMultiLanes; ++lane) {
+            if (!std::equal(states + 8 * lane, states + 8 * lane + 8, result[lane + 1])) return false;
+        }
+    }
+
     return true;
 }
 
@@ -608,6 +639,8 @@ std::string SHA256AutoDetect()
         Transform = sha256_shani::Transform;
         TransformD64 = TransformD64Wrapper<sha256_shani::Transform>;
         TransformD64_2way = sha256d64_shani::Transform_2way;
+        TransformMulti = sha256_shani::Transform_2way;
+        TransformMultiLanes = 2;
         ret = "shani(1way,2way)";
         have_sse4 = false; // Disable SSE4/AVX2;
         have_avx2 = false;
@@ -622,6 +655,8 @@ std::string SHA256AutoDetect()
 #endif
 #if defined(ENABLE_SSE41) && !defined(BUILD_DEFI_INTERNAL)
         TransformD64_4way = sha256d64_sse41::Transform_4way;
+        TransformMulti = sha256_sse41::Transform_4way;
+        TransformMultiLanes = 4;
         ret += ",sse41(4way)";
 #endif
     }
@@ -629,6 +664,8 @@ std::string SHA256AutoDetect()
 #if defined(ENABLE_AVX2) && !defined(BUILD_DEFI_INTERNAL)
     if (have_avx2 && have_avx && enabled_avx) {
         TransformD64_8way = sha256d64_avx2::Transform_8way;
+        TransformMulti = sha256_avx2::Transform_8way;
+        TransformMultiLanes = 8;
         ret += ",avx2(8way)";
     }
 #endif
@@ -728,3 +765,133 @@ void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks)
         --blocks;
     }
 }
+
+namespace {
+
+/** A message hashed in a lane of TransformMulti: its full blocks, then one or two padding blocks. */
+struct MultiLane
+{
+    const unsigned char* data;
+    size_t index;
+    size_t full_blocks;
+    size_t blocks;
+    size_t next;
+    unsigned char tail[128];
+
+    void Start(size_t index_in, const unsigned char* data_in, size_t size, uint32_t* s)
+    {
+        index = index_in;
+        data = data_in;
+        full_blocks = size / 64;
+        const size_t rest = size % 64;
+        const size_t tail_size = rest + 9 <= 64 ? 64 : 128;
+        if (rest) memcpy(tail, data + 64 * full_blocks, rest);
+        memset(tail + rest, 0, tail_size - rest);
+        tail[rest] = 0x80;
+        WriteBE64(tail + tail_size - 8, (uint64_t)size << 3);
+        blocks = full_blocks + tail_size / 64;
+        next = 0;
+        sha256::Initialize(s);
+    }
+
+    const unsigned char* Chunk() const
+    {
+        return next < full_blocks ? data + 64 * next : tail + 64 * (next - full_blocks);
+    }
+
+    /** Transform the remaining blocks alone. */
+    void Finish(uint32_t* s)
+    {
+        if (next < full_blocks) {
+            Transform(s, Chunk(), full_blocks - next);
+            next = full_blocks;
+        }
+        Transform(s, Chunk(), blocks - next);
+        next = blocks;
+    }
+};
+
+void WriteState(unsigned char* out, const uint32_t* s)
+{
+    for (int i = 0; i < 8; ++i) {
+        WriteBE32(out + 4 * i, s[i]);
+    }
+}
+
+/**
+ * Hash the messages returned by get(i, data, size) for i < count, a message per
+ * lane of TransformMulti. A lane moves to the next message as soon as its
+ * message is done, so that messages of different lengths keep all lanes busy.
+ * A message is read entirely before its hash is written.
+ */
+template<typename GetMessage>
+void SHA256MultiImpl(unsigned char* out, size_t count, GetMessage get)
+{
+    const unsigned char* data;
+    size_t size;
+    const size_t lanes = TransformMulti ? TransformMultiLanes : 0;
+    if (count < 2 || lanes == 0) {
+        for (size_t i = 0; i < count; ++i) {
+            get(i, data, size);
+            CSHA256().Write(data, size).Finalize(out + 32 * i);
+        }
+        return;
+    }
+
+    static const unsigned char idle_chunk[64] = {};
+    MultiLane lane[MAX_MULTI_LANES];
+    bool busy[MAX_MULTI_LANES] = {};
+    uint32_t states[8 * MAX_MULTI_LANES];
+    const unsigned char* chunks[MAX_MULTI_LANES];
+    size_t next_message = 0;
+    size_t active = 0;
+    auto start = [&](size_t l) {
+        busy[l] = next_message < count;
+        if (busy[l]) {
+            get(next_message, data, size);
+            lane[l].Start(next_message++, data, size, states + 8 * l);
+        }
+        return busy[l];
+    };
+    for (size_t l = 0; l < lanes; ++l) {
+        if (start(l)) ++active;
+    }
+
+    // Once most lanes run idle, the last messages are cheaper to finish alone.
+    while (active > 1 && active * 4 > lanes) {
+        for (size_t l = 0; l < lanes; ++l) {
+            chunks[l] = busy[l] ? lane[l].Chunk() : idle_chunk;
+        }
+        TransformMulti(states, chunks);
+        for (size_t l = 0; l < lanes; ++l) {
+            if (!busy[l] || ++lane[l].next < lane[l].blocks) continue;
+            WriteState(out + 32 * lane[l].index, states + 8 * l);
+            if (!start(l)) --active;
+        }
+    }
+    for (size_t l = 0; l < lanes; ++l) {
+        if (!busy[l]) continue;
+        lane[l].Finish(states + 8 * l);
+        WriteState(out + 32 * lane[l].index, states + 8 * l);
+    }
+}
+
+} // namespace
+
+void SHA256Multi(unsigned char* out, const unsigned char* const* inputs, const size_t* sizes, size_t count)
+{
+    SHA256MultiImpl(out, count, [&](size_t i, const unsigned char*& data, size_t& size) {
+        data = inputs[i];
+        size = sizes[i];
+    });
+}
+
+void SHA256DMulti(unsigned char* out, const unsigned char* const* inputs, const size_t* sizes, size_t count)
+{
+    SHA256Multi(out, inputs, sizes, count);
+    // Messages are read before their hash is written, so the second pass can run in place.
+    SHA256MultiImpl(out, count, [&](size_t i, const unsigned char*& data, size_t& size) {
+        data = out + 32 * i;
+        size = 32;
+    });
+}
@@ -38,4 +38,15 @@ std::string SHA256AutoDetect();
  */
 void SHA256D64(unsigned char* output, const unsigned char* input, size_t blocks);
 
+/** Compute the SHA256's of multiple messages of any length, interleaved on the
+ *  multi-buffer implementation when one is available.
+ *  output:  pointer to a count*32 byte output buffer
+ *  inputs:  pointers to the count messages
+ *  sizes:   the sizes of the count messages
+ */
+void SHA256Multi(unsigned char* output, const unsigned char* const* inputs, const size_t* sizes, size_t count);
+
+/** Compute the double-SHA256's of multiple messages of any length, like SHA256Multi. */
+void SHA256DMulti(unsigned char* output, const unsigned char* const* inputs, const size_t* sizes, size_t count);
+
 #endif // DEFI_CRYPTO_SHA256_H
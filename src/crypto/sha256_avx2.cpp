@@ -321,4 +321,97 @@ void Transform_8way(unsigned char* out, const unsigned char* in)
 
 }
 
+namespace sha256_avx2 {
+namespace {
+
+using namespace sha256d64_avx2;
+
+/** Word i of the state of every lane, in lane order. */
+__m256i inline LoadWord(const uint32_t* s, int i) {
+    return _mm256_set_epi32(
+        s[56 + i],
+        s[48 + i],
+        s[40 + i],
+        s[32 + i],
+        s[24 + i],
+        s[16 + i],
+        s[8 + i],
+        s[i]
+    );
+}
+
+void inline StoreWord(uint32_t* s, int i, __m256i v) {
+    uint32_t words[8];
+    _mm256_storeu_si256((__m256i*)words, v);
+    for (int lane = 0; lane < 8; ++lane) {
+        s[8 * lane + i] = words[lane];
+    }
+}
+
+/** Message word i of the chunk of every lane, in lane order. */
+__m256i inline ReadWord(const unsigned char* const* chunks, int i) {
+    return _mm256_set_epi32(
+        ReadBE32(chunks[7] + 4 * i),
+        ReadBE32(chunks[6] + 4 * i),
+        ReadBE32(chunks[5] + 4 * i),
+        ReadBE32(chunks[4] + 4 * i),
+        ReadBE32(chunks[3] + 4 * i),
+        ReadBE32(chunks[2] + 4 * i),
+        ReadBE32(chunks[1] + 4 * i),
+        ReadBE32(chunks[0] + 4 * i)
+    );
+}
+
+/** Message schedule word i, expanded in place for i >= 16. */
+__m256i inline ScheduleWord(__m256i* w, int i) {
+    if (i < 16) return w[i];
+    return Inc(w[i & 15], sigma1(w[(i - 2) & 15]), w[(i - 7) & 15], sigma0(w[(i - 15) & 15]));
+}
+
+const uint32_t ROUND_CONSTANTS[64] = {
+    0x428a2f98ul, 0x71374491ul, 0xb5c0fbcful, 0xe9b5dba5ul, 0x3956c25bul, 0x59f111f1ul, 0x923f82a4ul, 0xab1c5ed5ul,
+    0xd807aa98ul, 0x12835b01ul, 0x243185beul, 0x550c7dc3ul, 0x72be5d74ul, 0x80deb1feul, 0x9bdc06a7ul, 0xc19bf174ul,
+    0xe49b69c1ul, 0xefbe4786ul, 0x0fc19dc6ul, 0x240ca1ccul, 0x2de92c6ful, 0x4a7484aaul, 0x5cb0a9dcul, 0x76f988daul,
+    0x983e5152ul, 0xa831c66dul, 0xb00327c8ul, 0xbf597fc7ul, 0xc6e00bf3ul, 0xd5a79147ul, 0x06ca6351ul, 0x14292967ul,
+    0x27b70a85ul, 0x2e1b2138ul, 0x4d2c6dfcul, 0x53380d13ul, 0x650a7354ul, 0x766a0abbul, 0x81c2c92eul, 0x92722c85ul,
+    0xa2bfe8a1ul, 0xa81a664bul, 0xc24b8b70ul, 0xc76c51a3ul, 0xd192e819ul, 0xd6990624ul, 0xf40e3585ul, 0x106aa070ul,
+    0x19a4c116ul, 0x1e376c08ul, 0x2748774cul, 0x34b0bcb5ul, 0x391c0cb3ul, 0x4ed8aa4aul, 0x5b9cca4ful, 0x682e6ff3ul,
+    0x748f82eeul, 0x78a5636ful, 0x84c87814ul, 0x8cc70208ul, 0x90befffaul, 0xa4506cebul, 0xbef9a3f7ul, 0xc67178f2ul,
+};
+
+}
+
+void Transform_8way(uint32_t* s, const unsigned char* const* chunks)
+{
+    __m256i a = LoadWord(s, 0), b = LoadWord(s, 1), c = LoadWord(s, 2), d = LoadWord(s, 3);
+    __m256i e = LoadWord(s, 4), f = LoadWord(s, 5), g = LoadWord(s, 6), h = LoadWord(s, 7);
+    const __m256i a0 = a, b0 = b, c0 = c, d0 = d, e0 = e, f0 = f, g0 = g, h0 = h;
+
+    __m256i w[16];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = ReadWord(chunks, i);
+    }
+    for (int i = 0; i < 64; i += 8) {
+        Round(a, b, c, d, e, f, g, h, Add(K(ROUND_CONSTANTS[i]), ScheduleWord(w, i)));
+        Round(h, a, b, c, d, e, f, g, Add(K(ROUND_CONSTANTS[i + 1]), ScheduleWord(w, i + 1)));
+        Round(g, h, a, b, c, d, e, f, Add(K(ROUND_CONSTANTS[i + 2]), ScheduleWord(w, i + 2)));
+        Round(f, g, h, a, b, c, d, e, Add(K(ROUND_CONSTANTS[i + 3]), ScheduleWord(w, i + 3)));
+        Round(e, f, g, h, a, b, c, d, Add(K(ROUND_CONSTANTS[i + 4]), ScheduleWord(w, i + 4)));
+        Round(d, e, f, g, h, a, b, c, Add(K(ROUND_CONSTANTS[i + 5]), ScheduleWord(w, i + 5)));
+        Round(c, d, e, f, g, h, a, b, Add(K(ROUND_CONSTANTS[i + 6]), ScheduleWord(w, i + 6)));
+        Round(b, c, d, e, f, g, h, a, Add(K(ROUND_CONSTANTS[i + 7]), ScheduleWord(w, i + 7)));
+    }
+
+    StoreWord(s, 0, Add(a, a0));
+    StoreWord(s, 1, Add(b, b0));
+    StoreWord(s, 2, Add(c, c0));
+    StoreWord(s, 3, Add(d, d0));
+    StoreWord(s, 4, Add(e, e0));
+    StoreWord(s, 5, Add(f, f0));
+    StoreWord(s, 6, Add(g, g0));
+    StoreWord(s, 7, Add(h, h0));
+}
+
+}
+
 #endif
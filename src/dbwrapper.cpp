@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <random.h>
+#include <util/tracing.h>
 
 #include <leveldb/cache.h>
 #include <leveldb/env.h>
@@ -163,6 +164,7 @@ CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bo
         LogPrintf("Wrote new obfuscate key for %s: %s\n", path.string(), HexStr(obfuscate_key));
     }
 
+    m_obfuscated = std::any_of(obfuscate_key.begin(), obfuscate_key.end(), [](unsigned char c) { return c != 0; });
     LogPrintf("Using obfuscation key for %s: %s\n", path.string(), HexStr(obfuscate_key));
 }
 
@@ -182,6 +184,9 @@ CDBWrapper::~CDBWrapper()
 
 bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
 {
+    TRACE_SPAN(span, "CDBWrapper::WriteBatch", "leveldb");
+    span.Tag("bytes", batch.SizeEstimate());
+    span.Tag("sync", fSync);
     const bool log_memory = LogAcceptCategory(BCLog::LEVELDB);
     double mem_before = 0;
     if (log_memory) {
@@ -255,4 +260,9 @@ const std::vector<unsigned char>& GetObfuscateKey(const CDBWrapper &w)
     return w.obfuscate_key;
 }
 
+bool IsObfuscated(const CDBWrapper &w)
+{
+    return w.m_obfuscated;
+}
+
 } // namespace dbwrapper_private
@@ -41,6 +41,11 @@ void HandleError(const leveldb::Status& status);
  */
 const std::vector<unsigned char>& GetObfuscateKey(const CDBWrapper &w);
 
+/** Whether the values of the database are XOR-obfuscated with a non-zero key.
+ * Values of a database that is not are deserialized in place.
+ */
+bool IsObfuscated(const CDBWrapper &w);
+
 };
 
 /** Batch of changes queued to be written to a CDBWrapper */
@@ -147,7 +152,7 @@ public:
     template<typename K> bool GetKey(K& key) {
         leveldb::Slice slKey = piter->key();
         try {
-            CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+            SpanReader ssKey(SER_DISK, CLIENT_VERSION, MakeUCharSpan(slKey));
             ssKey >> key;
         } catch (const std::exception&) {
             return false;
@@ -158,6 +163,11 @@ public:
     template<typename V> bool GetValue(V& value) {
         leveldb::Slice slValue = piter->value();
         try {
+            if (!dbwrapper_private::IsObfuscated(parent)) {
+                SpanReader ssValue(SER_DISK, CLIENT_VERSION, MakeUCharSpan(slValue));
+                ssValue >> value;
+                return true;
+            }
             CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
             ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
             ssValue >> value;
@@ -176,6 +186,7 @@ public:
 class CDBWrapper
 {
     friend const std::vector<unsigned char>& dbwrapper_private::GetObfuscateKey(const CDBWrapper &w);
+    friend bool dbwrapper_private::IsObfuscated(const CDBWrapper &w);
 private:
     //! custom environment this database is using (may be nullptr in case of default environment)
     leveldb::Env* penv;
@@ -204,6 +215,9 @@ private:
     //! a key used for optional XOR-obfuscation of the database
     std::vector<unsigned char> obfuscate_key;
 
+    //! whether obfuscate_key is not all zeros
+    bool m_obfuscated{false};
+
     //! the key under which the obfuscation key is stored
     static const std::string OBFUSCATE_KEY_KEY;
 
@@ -244,6 +258,11 @@ public:
             dbwrapper_private::HandleError(status);
         }
         try {
+            if (!m_obfuscated) {
+                SpanReader ssValue(SER_DISK, CLIENT_VERSION, MakeUCharSpan(strValue));
+                ssValue >> value;
+                return true;
+            }
             CDataStream ssValue(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
             ssValue.Xor(obfuscate_key);
             ssValue >> value;
@@ -7,6 +7,47 @@
 #include <crypto/hmac_sha512.h>
 
 
+namespace {
+
+/** The pointers and sizes of a batch of messages, as taken by SHA256Multi. */
+struct BatchInputs
+{
+    std::vector<const unsigned char*> data;
+    std::vector<size_t> sizes;
+
+    explicit BatchInputs(const std::vector<Span<const unsigned char>>& inputs)
+    {
+        data.reserve(inputs.size());
+        sizes.reserve(inputs.size());
+        for (const auto& input : inputs) {
+            data.push_back(input.data());
+            sizes.push_back(input.size());
+        }
+    }
+};
+
+} // namespace
+
+std::vector<uint256> HashBatch(const std::vector<Span<const unsigned char>>& inputs)
+{
+    const BatchInputs batch(inputs);
+    std::vector<uint256> result(inputs.size());
+    static_assert(sizeof(uint256) == CSHA256::OUTPUT_SIZE, "uint256 results are written back to back");
+    SHA256DMulti(result.empty() ? nullptr : result[0].begin(), batch.data.data(), batch.sizes.data(), inputs.size());
+    return result;
+}
+
+std::vector<uint160> Hash160Batch(const std::vector<Span<const unsigned char>>& inputs)
+{
+    const BatchInputs batch(inputs);
+    std::vector<unsigned char> sha(CSHA256::OUTPUT_SIZE * inputs.size());
+    SHA256Multi(sha.data(), batch.data.data(), batch.sizes.data(), inputs.size());
+    std::vector<uint160> result(inputs.size());
+    static_assert(sizeof(uint160) == CRIPEMD160::OUTPUT_SIZE, "uint160 results are written back to back");
+    RIPEMD160_32(result.empty() ? nullptr : result[0].begin(), sha.data(), inputs.size());
+    return result;
+}
+
 inline uint32_t ROTL32(uint32_t x, int8_t r)
 {
     return (x << r) | (x >> (32 - r));
@@ -200,6 +200,12 @@ uint256 SerializeHash(const T& obj, int nType=SER_GETHASH, int nVersion=PROTOCOL
     return ss.GetHash();
 }
 
+/** Compute the 256-bit hashes of several messages at once, interleaving them where the CPU allows. */
+std::vector<uint256> HashBatch(const std::vector<Span<const unsigned char>>& inputs);
+
+/** Compute the 160-bit hashes of several messages at once, like HashBatch. */
+std::vector<uint160> Hash160Batch(const std::vector<Span<const unsigned char>>& inputs);
+
 unsigned int MurmurHash3(unsigned int nHashSeed, const std::vector<unsigned char>& vDataToHash);
 
 void BIP32Hash(const ChainCode &chainCode, unsigned int nChild, unsigned char header, const unsigned char data[32], unsigned char output[64]);
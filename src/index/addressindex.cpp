@@ -0,0 +1,282 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <hash.h>
+#include <index/addressindex.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+/* The index database stores two kinds of records:
+ *
+ * Keys for the address index have the type [DB_ADDRESSINDEX, CAddressIndexKey] and map to the
+ * amount (CAmount) added to (outputs) or removed from (spends) the address. The address type and
+ * hash come first and the height is big-endian, so all changes of one address, optionally limited
+ * to a height range, are a single contiguous range scan.
+ * Keys for the spent index have the type [DB_SPENTINDEX, COutPoint] and map to CSpentIndexValue.
+ *
+ * On reorg, the records of the disconnected blocks are recomputed from the blocks and their undo
+ * data, which remain on disk, and erased.
+ */
+constexpr char DB_ADDRESSINDEX = 'a';
+constexpr char DB_SPENTINDEX = 'p';
+
+std::unique_ptr<AddressIndex> g_addressindex;
+
+namespace {
+
+class AddressIndexKeyVisitor : public boost::static_visitor<bool>
+{
+private:
+    AddressIndexType& m_type;
+    uint160& m_hash;
+
+public:
+    AddressIndexKeyVisitor(AddressIndexType& type, uint160& hash) : m_type(type), m_hash(hash) {}
+
+    bool operator()(const CNoDestination& dest) const { return false; }
+    bool operator()(const WitnessUnknown& dest) const { return false; }
+
+    bool operator()(const PKHash& dest) const
+    {
+        m_type = AddressIndexType::PUBKEYHASH;
+        m_hash = dest;
+        return true;
+    }
+
+    bool operator()(const ScriptHash& dest) const
+    {
+        m_type = AddressIndexType::SCRIPTHASH;
+        m_hash = dest;
+        return true;
+    }
+
+    bool operator()(const WitnessV0KeyHash& dest) const
+    {
+        m_type = AddressIndexType::WITNESS_V0_KEYHASH;
+        m_hash = dest;
+        return true;
+    }
+
+    bool operator()(const WitnessV0ScriptHash& dest) const
+    {
+        m_type = AddressIndexType::WITNESS_V0_SCRIPTHASH;
+        m_hash = Hash160(dest.begin(), dest.end());
+        return true;
+    }
+};
+
+/** Address index and spent index records produced by a single block. */
+struct BlockRecords : public BaseIndex::PreparedBlock {
+    std::vector<std::pair<CAddressIndexKey, CAmount>> address_entries;
+    std::vector<std::pair<COutPoint, CSpentIndexValue>> spent_entries;
+};
+
+bool ExtractAddressIndexKey(const CScript& script, AddressIndexType& type, uint160& hash)
+{
+    CTxDestination dest;
+    return ExtractDestination(script, dest) && GetAddressIndexKey(dest, type, hash);
+}
+
+bool CollectBlockRecords(const CBlock& block, const CBlockIndex* pindex, BlockRecords& records)
+{
+    CBlockUndo block_undo;
+    if (pindex->nHeight > 0 && !UndoReadFromDisk(block_undo, pindex)) {
+        return false;
+    }
+    if (pindex->nHeight > 0 && block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: undo data of block %s does not match its transactions",
+                     __func__, pindex->GetBlockHash().ToString());
+    }
+
+    const int height = pindex->nHeight;
+    AddressIndexType type;
+    uint160 hash;
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txid = tx.GetHash();
+
+        if (i > 0 && !tx.IsCoinBase()) {
+            const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+            if (tx_undo.vprevout.size() != tx.vin.size()) {
+                return error("%s: undo data of tx %s does not match its inputs",
+                             __func__, txid.ToString());
+            }
+            for (uint32_t j = 0; j < tx.vin.size(); ++j) {
+                const CTxOut& prevout = tx_undo.vprevout[j].out;
+
+                CSpentIndexValue spent;
+                spent.txid = txid;
+                spent.input_index = j;
+                spent.height = height;
+                spent.amount = prevout.nValue;
+                if (ExtractAddressIndexKey(prevout.scriptPubKey, type, hash)) {
+                    spent.type = type;
+                    spent.hash = hash;
+                    records.address_entries.emplace_back(CAddressIndexKey(type, hash, height, txid, j, true),
+                                                         -prevout.nValue);
+                }
+                records.spent_entries.emplace_back(tx.vin[j].prevout, spent);
+            }
+        }
+
+        for (uint32_t j = 0; j < tx.vout.size(); ++j) {
+            const CTxOut& out = tx.vout[j];
+            if (ExtractAddressIndexKey(out.scriptPubKey, type, hash)) {
+                records.address_entries.emplace_back(CAddressIndexKey(type, hash, height, txid, j, false),
+                                                     out.nValue);
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool GetAddressIndexKey(const CTxDestination& dest, AddressIndexType& type, uint160& hash)
+{
+    return boost::apply_visitor(AddressIndexKeyVisitor(type, hash), dest);
+}
+
+/**
+ * Access to the address index database (indexes/addressindex/)
+ */
+class AddressIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Write the records of a connected block to the DB.
+    bool WriteRecords(const BlockRecords& records);
+
+    /// Erase the records of a disconnected block from the DB.
+    bool EraseRecords(const BlockRecords& records);
+
+    bool ReadAddressEntries(AddressIndexType type, const uint160& hash, int start_height, int end_height,
+                            std::vector<std::pair<CAddressIndexKey, CAmount>>& entries);
+
+    bool ReadSpent(const COutPoint& outpoint, CSpentIndexValue& value) const;
+};
+
+AddressIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool AddressIndex::DB::WriteRecords(const BlockRecords& records)
+{
+    CDBBatch batch(*this);
+    for (const auto& entry : records.address_entries) {
+        batch.Write(std::make_pair(DB_ADDRESSINDEX, entry.first), entry.second);
+    }
+    for (const auto& entry : records.spent_entries) {
+        batch.Write(std::make_pair(DB_SPENTINDEX, entry.first), entry.second);
+    }
+    return WriteBatch(batch);
+}
+
+bool AddressIndex::DB::EraseRecords(const BlockRecords& records)
+{
+    CDBBatch batch(*this);
+    for (const auto& entry : records.address_entries) {
+        batch.Erase(std::make_pair(DB_ADDRESSINDEX, entry.first));
+    }
+    for (const auto& entry : records.spent_entries) {
+        batch.Erase(std::make_pair(DB_SPENTINDEX, entry.first));
+    }
+    return WriteBatch(batch);
+}
+
+bool AddressIndex::DB::ReadAddressEntries(AddressIndexType type, const uint160& hash, int start_height, int end_height,
+                                          std::vector<std::pair<CAddressIndexKey, CAmount>>& entries)
+{
+    std::unique_ptr<CDBIterator> db_it(NewIterator());
+    db_it->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(type, hash, std::max(start_height, 0), uint256(), 0, false)));
+
+    std::pair<char, CAddressIndexKey> key;
+    for (; db_it->Valid(); db_it->Next()) {
+        if (!db_it->GetKey(key) || key.first != DB_ADDRESSINDEX ||
+            key.second.type != type || key.second.hash != hash) {
+            break;
+        }
+        if (end_height > 0 && key.second.height > end_height) {
+            break;
+        }
+
+        CAmount amount;
+        if (!db_it->GetValue(amount)) {
+            return error("%s: unable to read value in addressindex at height %d",
+                         __func__, key.second.height);
+        }
+        entries.emplace_back(key.second, amount);
+    }
+    return true;
+}
+
+bool AddressIndex::DB::ReadSpent(const COutPoint& outpoint, CSpentIndexValue& value) const
+{
+    return Read(std::make_pair(DB_SPENTINDEX, outpoint), value);
+}
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<AddressIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+AddressIndex::~AddressIndex() {}
+
+std::unique_ptr<BaseIndex::PreparedBlock> AddressIndex::PrepareBlock(const CBlock& block, const CBlockIndex* pindex) const
+{
+    auto records = MakeUnique<BlockRecords>();
+    if (!CollectBlockRecords(block, pindex, *records)) {
+        return nullptr;
+    }
+    return records;
+}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    return WritePreparedBlock(block, pindex, PrepareBlock(block, pindex));
+}
+
+bool AddressIndex::WritePreparedBlock(const CBlock& block, const CBlockIndex* pindex,
+                                      std::unique_ptr<PreparedBlock> prepared)
+{
+    // A missing result means PrepareBlock failed to read the undo data.
+    if (!prepared) return false;
+    return m_db->WriteRecords(static_cast<const BlockRecords&>(*prepared));
+}
+
+bool AddressIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    const auto& consensus_params = Params().GetConsensus();
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        BlockRecords records;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            return error("%s: Failed to read block %s from disk",
+                         __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!CollectBlockRecords(block, pindex, records) || !m_db->EraseRecords(records)) {
+            return error("%s: Failed to erase records of block %s from %s",
+                         __func__, pindex->GetBlockHash().ToString(), GetName());
+        }
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB& AddressIndex::GetDB() const { return *m_db; }
+
+bool AddressIndex::FindAddressEntries(AddressIndexType type, const uint160& hash, int start_height, int end_height,
+                                      std::vector<std::pair<CAddressIndexKey, CAmount>>& entries) const
+{
+    return m_db->ReadAddressEntries(type, hash, start_height, end_height, entries);
+}
+
+bool AddressIndex::FindSpent(const COutPoint& outpoint, CSpentIndexValue& value) const
+{
+    return m_db->ReadSpent(outpoint, value);
+}
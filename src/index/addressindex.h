@@ -0,0 +1,159 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_INDEX_ADDRESSINDEX_H
+#define DEFI_INDEX_ADDRESSINDEX_H
+
+#include <amount.h>
+#include <chain.h>
+#include <index/base.h>
+#include <script/standard.h>
+#include <serialize.h>
+#include <uint256.h>
+
+/** Address kinds that can be looked up in the address index. */
+enum class AddressIndexType : uint8_t {
+    UNKNOWN = 0,
+    PUBKEYHASH = 1,
+    SCRIPTHASH = 2,
+    WITNESS_V0_KEYHASH = 3,
+    WITNESS_V0_SCRIPTHASH = 4,
+};
+
+/**
+ * Map a destination to the (type, hash) pair the address index is keyed by. P2WSH programs are
+ * reduced to their Hash160 so that every key has the same fixed width. Returns false for
+ * destinations that are not indexed.
+ */
+bool GetAddressIndexKey(const CTxDestination& dest, AddressIndexType& type, uint160& hash);
+
+/**
+ * One balance change of an address: either an output paying to it (spending == false) or an input
+ * spending one of its outputs (spending == true). The height is serialized big-endian so that all
+ * entries of an address are range-scannable in chain order.
+ */
+struct CAddressIndexKey {
+    AddressIndexType type;
+    uint160 hash;
+    int height;
+    uint256 txid;
+    uint32_t index;
+    bool spending;
+
+    CAddressIndexKey() : type(AddressIndexType::UNKNOWN), height(0), index(0), spending(false) {}
+    CAddressIndexKey(AddressIndexType type_in, const uint160& hash_in, int height_in,
+                     const uint256& txid_in, uint32_t index_in, bool spending_in) :
+        type(type_in), hash(hash_in), height(height_in), txid(txid_in), index(index_in), spending(spending_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, static_cast<uint8_t>(type));
+        hash.Serialize(s);
+        ser_writedata32be(s, height);
+        txid.Serialize(s);
+        ser_writedata32be(s, index);
+        ser_writedata8(s, spending);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        type = static_cast<AddressIndexType>(ser_readdata8(s));
+        hash.Unserialize(s);
+        height = ser_readdata32be(s);
+        txid.Unserialize(s);
+        index = ser_readdata32be(s);
+        spending = ser_readdata8(s) != 0;
+    }
+};
+
+/** Record of the input that spent an outpoint, together with the address it paid to. */
+struct CSpentIndexValue {
+    uint256 txid;
+    uint32_t input_index;
+    int height;
+    CAmount amount;
+    AddressIndexType type;
+    uint160 hash;
+
+    CSpentIndexValue() : input_index(0), height(0), amount(0), type(AddressIndexType::UNKNOWN) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        txid.Serialize(s);
+        ser_writedata32(s, input_index);
+        ser_writedata32(s, height);
+        ser_writedata64(s, amount);
+        ser_writedata8(s, static_cast<uint8_t>(type));
+        hash.Serialize(s);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        txid.Unserialize(s);
+        input_index = ser_readdata32(s);
+        height = ser_readdata32(s);
+        amount = ser_readdata64(s);
+        type = static_cast<AddressIndexType>(ser_readdata8(s));
+        hash.Unserialize(s);
+    }
+};
+
+/**
+ * AddressIndex records, for every standard address, each output paying to it and each input
+ * spending from it (the address index), and for every spent outpoint the input that spent it (the
+ * spent index). Both are written to the same LevelDB database, so that balances, histories and
+ * spending transactions can be answered without scanning blocks.
+ */
+class AddressIndex final : public BaseIndex
+{
+    friend struct AddressIndexTest;
+
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    /// Reads the block undo data and collects the records of the block.
+    std::unique_ptr<PreparedBlock> PrepareBlock(const CBlock& block, const CBlockIndex* pindex) const override;
+
+    bool WritePreparedBlock(const CBlock& block, const CBlockIndex* pindex,
+                            std::unique_ptr<PreparedBlock> prepared) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AddressIndex() override;
+
+    /// Look up all balance changes of an address, ordered by height.
+    ///
+    /// @param[in]   type, hash  The address, as returned by GetAddressIndexKey.
+    /// @param[in]   start_height, end_height  Inclusive height range; end_height <= 0 means no limit.
+    /// @param[out]  entries  Pairs of index key and amount (negative for spends).
+    bool FindAddressEntries(AddressIndexType type, const uint160& hash, int start_height, int end_height,
+                            std::vector<std::pair<CAddressIndexKey, CAmount>>& entries) const;
+
+    /// Look up the input that spent an outpoint. Returns false if the outpoint is unspent or unknown.
+    bool FindSpent(const COutPoint& outpoint, CSpentIndexValue& value) const;
+};
+
+/// The global address index, used by the address RPCs. May be null.
+extern std::unique_ptr<AddressIndex> g_addressindex;
+
+#endif // DEFI_INDEX_ADDRESSINDEX_H
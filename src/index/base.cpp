@@ -11,6 +11,9 @@
 #include <validation.h>
 #include <warnings.h>
 
+#include <atomic>
+#include <functional>
+
 constexpr char DB_BEST_BLOCK = 'B';
 
 constexpr int64_t SYNC_LOG_INTERVAL = 30; // seconds
@@ -85,11 +88,30 @@ static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev) EXCLUSIV
     return ::ChainActive().Next(::ChainActive().FindFork(pindex_prev));
 }
 
+static int GetSyncThreadCount()
+{
+    int n_threads = gArgs.GetArg("-indexsyncthreads", DEFAULT_INDEX_SYNC_THREADS);
+    if (n_threads <= 0) {
+        n_threads += GetNumCores();
+    }
+    return std::max(1, std::min(n_threads, MAX_INDEX_SYNC_THREADS));
+}
+
 void BaseIndex::ThreadSync()
 {
     const CBlockIndex* pindex = m_best_block_index.load();
     if (!m_synced) {
         auto& consensus_params = Params().GetConsensus();
+        const int n_threads = GetSyncThreadCount();
+        const size_t batch_size = n_threads * INDEX_SYNC_BLOCKS_PER_THREAD;
+
+        struct SyncItem {
+            const CBlockIndex* pindex;
+            bool read_ok{false};
+            CBlock block;
+            std::unique_ptr<PreparedBlock> prepared;
+        };
+        std::vector<SyncItem> batch;
 
         int64_t last_log_time = 0;
         int64_t last_locator_write_time = 0;
@@ -103,6 +125,7 @@ void BaseIndex::ThreadSync()
                 return;
             }
 
+            batch.clear();
             {
                 LOCK(cs_main);
                 const CBlockIndex* pindex_next = NextSyncBlock(pindex);
@@ -118,34 +141,54 @@ void BaseIndex::ThreadSync()
                                __func__, GetName());
                     return;
                 }
-                pindex = pindex_next;
+                // Blocks reorganized out of the active chain after this point are handled by
+                // Rewind at the start of the next batch, as for a single block.
+                for (; pindex_next && batch.size() < batch_size; pindex_next = ::ChainActive().Next(pindex_next)) {
+                    batch.emplace_back();
+                    batch.back().pindex = pindex_next;
+                }
             }
 
-            int64_t current_time = GetTime();
-            if (last_log_time + SYNC_LOG_INTERVAL < current_time) {
-                LogPrintf("Syncing %s with block chain from height %d\n",
-                          GetName(), pindex->nHeight);
-                last_log_time = current_time;
-            }
+            const int64_t batch_start_time = GetTimeMicros();
+            ParallelFor(batch.size(), n_threads, [&](size_t i) {
+                SyncItem& item = batch[i];
+                item.read_ok = ReadBlockFromDisk(item.block, item.pindex, consensus_params);
+                if (item.read_ok) {
+                    item.prepared = PrepareBlock(item.block, item.pindex);
+                }
+            });
 
-            if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time) {
-                m_best_block_index = pindex;
-                last_locator_write_time = current_time;
-                // No need to handle errors in Commit. See rationale above.
-                Commit();
-            }
+            for (SyncItem& item : batch) {
+                if (m_interrupt) break;
 
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
-                FatalError("%s: Failed to read block %s from disk",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
-            }
-            if (!WriteBlock(block, pindex)) {
-                FatalError("%s: Failed to write block %s to index database",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
+                if (!item.read_ok) {
+                    FatalError("%s: Failed to read block %s from disk",
+                               __func__, item.pindex->GetBlockHash().ToString());
+                    return;
+                }
+                if (!WritePreparedBlock(item.block, item.pindex, std::move(item.prepared))) {
+                    FatalError("%s: Failed to write block %s to index database",
+                               __func__, item.pindex->GetBlockHash().ToString());
+                    return;
+                }
+                pindex = item.pindex;
+                ++m_sync_blocks;
+
+                int64_t current_time = GetTime();
+                if (last_log_time + SYNC_LOG_INTERVAL < current_time) {
+                    LogPrintf("Syncing %s with block chain from height %d\n",
+                              GetName(), pindex->nHeight);
+                    last_log_time = current_time;
+                }
+
+                if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL < current_time) {
+                    m_best_block_index = pindex;
+                    last_locator_write_time = current_time;
+                    // No need to handle errors in Commit. See rationale above.
+                    Commit();
+                }
             }
+            m_sync_time_micros += GetTimeMicros() - batch_start_time;
         }
     }
 
@@ -303,7 +346,10 @@ void BaseIndex::Start()
 {
     // Need to register this ValidationInterface before running Init(), so that
     // callbacks are not missed if Init sets m_synced to true.
-    RegisterValidationInterface(this);
+    ValidationInterfaceQueueOptions options;
+    options.name = GetName();
+    options.max_size = GetValidationQueueSize();
+    RegisterValidationInterface(this, options);
     if (!Init()) {
         FatalError("%s: %s failed to initialize", __func__, GetName());
         return;
@@ -321,3 +367,17 @@ void BaseIndex::Stop()
         m_thread_sync.join();
     }
 }
+
+IndexSummary BaseIndex::GetSummary() const
+{
+    IndexSummary summary{};
+    summary.name = GetName();
+    summary.synced = m_synced;
+    const CBlockIndex* best_block_index = m_best_block_index.load();
+    summary.best_block_height = best_block_index ? best_block_index->nHeight : 0;
+    const int64_t sync_time_micros = m_sync_time_micros.load();
+    if (sync_time_micros > 0) {
+        summary.sync_blocks_per_second = m_sync_blocks.load() * 1000000.0 / sync_time_micros;
+    }
+    return summary;
+}
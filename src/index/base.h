@@ -14,6 +14,21 @@
 
 class CBlockIndex;
 
+/** Maximum number of threads used to read and prepare blocks during index sync */
+static const int MAX_INDEX_SYNC_THREADS = 16;
+/** -indexsyncthreads default (0 = auto, one per core) */
+static const int DEFAULT_INDEX_SYNC_THREADS = 0;
+/** Number of blocks handed to each sync thread per batch */
+static const int INDEX_SYNC_BLOCKS_PER_THREAD = 16;
+
+struct IndexSummary {
+    std::string name;
+    bool synced{false};
+    int best_block_height{0};
+    /// Average number of blocks indexed per second by the background sync.
+    double sync_blocks_per_second{0};
+};
+
 /**
  * Base class for indices of blockchain data. This implements
  * CValidationInterface and ensures blocks are indexed sequentially according
@@ -21,6 +36,12 @@ class CBlockIndex;
  */
 class BaseIndex : public CValidationInterface
 {
+public:
+    /// Result of PrepareBlock, passed on to WritePreparedBlock.
+    struct PreparedBlock {
+        virtual ~PreparedBlock() {}
+    };
+
 protected:
     class DB : public CDBWrapper
     {
@@ -47,11 +68,19 @@ private:
     std::thread m_thread_sync;
     CThreadInterrupt m_interrupt;
 
+    /// Blocks written and microseconds spent by the background sync, for throughput reporting.
+    std::atomic<int64_t> m_sync_blocks{0};
+    std::atomic<int64_t> m_sync_time_micros{0};
+
     /// Sync the index with the block index starting from the current best block.
     /// Intended to be run in its own thread, m_thread_sync, and can be
     /// interrupted with m_interrupt. Once the index gets in sync, the m_synced
     /// flag is set and the BlockConnected ValidationInterface callback takes
     /// over and the sync thread exits.
+    ///
+    /// Blocks are processed in batches: worker threads read each block of the
+    /// batch from disk and run PrepareBlock on it in parallel, then the sync
+    /// thread calls WritePreparedBlock on them in height order.
     void ThreadSync();
 
     /// Write the current index state (eg. chain block locator and subclass-specific items) to disk.
@@ -76,6 +105,16 @@ protected:
     /// Write update index entries for a newly connected block.
     virtual bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) { return true; }
 
+    /// Optional first half of WriteBlock for per-block work that does not depend on the index
+    /// state (eg. reading undo data or building filters). During sync this is called on worker
+    /// threads, concurrently and out of height order, so it must not touch the index database.
+    virtual std::unique_ptr<PreparedBlock> PrepareBlock(const CBlock& block, const CBlockIndex* pindex) const { return nullptr; }
+
+    /// Second half of WriteBlock, called in height order with the result of PrepareBlock. The
+    /// default ignores it and calls WriteBlock.
+    virtual bool WritePreparedBlock(const CBlock& block, const CBlockIndex* pindex,
+                                    std::unique_ptr<PreparedBlock> prepared) { return WriteBlock(block, pindex); }
+
     /// Virtual method called internally by Commit that can be overridden to atomically
     /// commit more index state.
     virtual bool CommitInternal(CDBBatch& batch);
@@ -108,6 +147,9 @@ public:
 
     /// Stops the instance from staying in sync with blockchain updates.
     void Stop();
+
+    /// Get a summary of the index and its state.
+    IndexSummary GetSummary() const;
 };
 
 #endif // DEFI_INDEX_BASE_H
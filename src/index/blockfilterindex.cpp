@@ -146,18 +146,13 @@ bool BlockFilterIndex::CommitInternal(CDBBatch& batch)
     return BaseIndex::CommitInternal(batch);
 }
 
-bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos& pos, BlockFilter& filter) const
+static bool ReadFilterFromFile(CAutoFile& filein, BlockFilterType filter_type, BlockFilter& filter)
 {
-    CAutoFile filein(m_filter_fileseq->Open(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return false;
-    }
-
     uint256 block_hash;
     std::vector<unsigned char> encoded_filter;
     try {
         filein >> block_hash >> encoded_filter;
-        filter = BlockFilter(GetFilterType(), block_hash, std::move(encoded_filter));
+        filter = BlockFilter(filter_type, block_hash, std::move(encoded_filter));
     }
     catch (const std::exception& e) {
         return error("%s: Failed to deserialize block filter from disk: %s", __func__, e.what());
@@ -166,6 +161,16 @@ bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos& pos, BlockFilter& f
     return true;
 }
 
+bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos& pos, BlockFilter& filter) const
+{
+    CAutoFile filein(m_filter_fileseq->Open(pos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        return false;
+    }
+
+    return ReadFilterFromFile(filein, GetFilterType(), filter);
+}
+
 size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos& pos, const BlockFilter& filter)
 {
     assert(filter.GetFilterType() == GetFilterType());
@@ -212,16 +217,41 @@ size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos& pos, const BlockFilter&
     return data_size;
 }
 
-bool BlockFilterIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+namespace {
+
+struct PreparedFilter : public BaseIndex::PreparedBlock {
+    BlockFilter filter;
+};
+
+} // namespace
+
+std::unique_ptr<BaseIndex::PreparedBlock> BlockFilterIndex::PrepareBlock(const CBlock& block, const CBlockIndex* pindex) const
 {
     CBlockUndo block_undo;
+    if (pindex->nHeight > 0 && !UndoReadFromDisk(block_undo, pindex)) {
+        return nullptr;
+    }
+
+    auto prepared = MakeUnique<PreparedFilter>();
+    prepared->filter = BlockFilter(m_filter_type, block, block_undo);
+    return prepared;
+}
+
+bool BlockFilterIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    return WritePreparedBlock(block, pindex, PrepareBlock(block, pindex));
+}
+
+bool BlockFilterIndex::WritePreparedBlock(const CBlock& block, const CBlockIndex* pindex,
+                                          std::unique_ptr<PreparedBlock> prepared)
+{
+    // A missing result means PrepareBlock failed to read the undo data.
+    if (!prepared) return false;
+    const BlockFilter& filter = static_cast<const PreparedFilter&>(*prepared).filter;
+
     uint256 prev_header;
 
     if (pindex->nHeight > 0) {
-        if (!UndoReadFromDisk(block_undo, pindex)) {
-            return false;
-        }
-
         std::pair<uint256, DBVal> read_out;
         if (!m_db->Read(DBHeightKey(pindex->nHeight - 1), read_out)) {
             return false;
@@ -236,8 +266,6 @@ bool BlockFilterIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex
         prev_header = read_out.second.header;
     }
 
-    BlockFilter filter(m_filter_type, block, block_undo);
-
     size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
     if (bytes_written == 0) return false;
 
@@ -387,13 +415,31 @@ bool BlockFilterIndex::LookupFilter(const CBlockIndex* block_index, BlockFilter&
     return ReadFilterFromDisk(entry.pos, filter_out);
 }
 
-bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out) const
+bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out)
 {
+    LOCK(m_cs_headers_cache);
+
+    bool is_checkpoint = block_index->nHeight % CFCHECKPT_INTERVAL == 0;
+
+    if (is_checkpoint) {
+        // Try to find the block in the headers cache if this is a checkpoint height.
+        auto header = m_headers_cache.find(block_index->GetBlockHash());
+        if (header != m_headers_cache.end()) {
+            header_out = header->second;
+            return true;
+        }
+    }
+
     DBVal entry;
     if (!LookupOne(*m_db, block_index, entry)) {
         return false;
     }
 
+    if (is_checkpoint && m_headers_cache.size() < CF_HEADERS_CACHE_MAX_SZ) {
+        // Headers are keyed by block hash, so an entry stays valid across reorgs.
+        m_headers_cache.emplace(block_index->GetBlockHash(), entry.header);
+    }
+
     header_out = entry.header;
     return true;
 }
@@ -407,12 +453,25 @@ bool BlockFilterIndex::LookupFilterRange(int start_height, const CBlockIndex* st
     }
 
     filters_out.resize(entries.size());
-    auto filter_pos_it = filters_out.begin();
-    for (const auto& entry : entries) {
-        if (!ReadFilterFromDisk(entry.pos, *filter_pos_it)) {
+
+    // Filters of consecutive blocks are written back to back, so keep the flat file open across
+    // entries and only seek when a filter does not start where the previous one ended.
+    std::unique_ptr<CAutoFile> filein;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const FlatFilePos& pos = entries[i].pos;
+        if (i == 0 || pos.nFile != entries[i - 1].pos.nFile) {
+            filein = MakeUnique<CAutoFile>(m_filter_fileseq->Open(pos, true), SER_DISK, CLIENT_VERSION);
+            if (filein->IsNull()) {
+                return false;
+            }
+        } else if (std::ftell(filein->Get()) != static_cast<long>(pos.nPos) &&
+                   std::fseek(filein->Get(), pos.nPos, SEEK_SET) != 0) {
+            return error("%s: Unable to seek to position %u of filter file %d", __func__, pos.nPos, pos.nFile);
+        }
+
+        if (!ReadFilterFromFile(*filein, GetFilterType(), filters_out[i])) {
             return false;
         }
-        ++filter_pos_it;
     }
 
     return true;
@@ -7,8 +7,23 @@
 
 #include <blockfilter.h>
 #include <chain.h>
+#include <crypto/common.h>
 #include <flatfile.h>
 #include <index/base.h>
+#include <sync.h>
+
+#include <unordered_map>
+
+/** Interval between compact filter checkpoints. See BIP 157. */
+static constexpr int CFCHECKPT_INTERVAL = 1000;
+
+/** Max number of checkpoint filter headers cached per filter type. */
+static constexpr size_t CF_HEADERS_CACHE_MAX_SZ = 2000;
+
+struct FilterHeaderHasher
+{
+    size_t operator()(const uint256& hash) const { return ReadLE64(hash.begin()); }
+};
 
 /**
  * BlockFilterIndex is used to store and retrieve block filters, hashes, and headers for a range of
@@ -27,6 +42,14 @@ private:
     FlatFilePos m_next_filter_pos;
     std::unique_ptr<FlatFileSeq> m_filter_fileseq;
 
+    Mutex m_cs_headers_cache;
+    /** Cache of block hash to filter header at checkpoint heights. It saves the database read of
+     *  each checkpoint header for getcfcheckpt, and of the previous header for getcfheaders
+     *  requests starting right after a checkpoint; the filter hashes of getcfheaders are still
+     *  read from the database. Misses, and headers arriving once the cache is full, fall back to
+     *  the database as well. */
+    std::unordered_map<uint256, uint256, FilterHeaderHasher> m_headers_cache GUARDED_BY(m_cs_headers_cache);
+
     bool ReadFilterFromDisk(const FlatFilePos& pos, BlockFilter& filter) const;
     size_t WriteFilterToDisk(FlatFilePos& pos, const BlockFilter& filter);
 
@@ -37,6 +60,13 @@ protected:
 
     bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
 
+    /// Reads the block undo data and builds the filter.
+    std::unique_ptr<PreparedBlock> PrepareBlock(const CBlock& block, const CBlockIndex* pindex) const override;
+
+    /// Chains the filter header to the previous one and writes the filter.
+    bool WritePreparedBlock(const CBlock& block, const CBlockIndex* pindex,
+                            std::unique_ptr<PreparedBlock> prepared) override;
+
     bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
 
     BaseIndex::DB& GetDB() const override { return *m_db; }
@@ -53,10 +83,11 @@ public:
     /** Get a single filter by block. */
     bool LookupFilter(const CBlockIndex* block_index, BlockFilter& filter_out) const;
 
-    /** Get a single filter header by block. */
-    bool LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out) const;
+    /** Get a single filter header by block. Headers at checkpoint heights are cached. */
+    bool LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out);
 
-    /** Get a range of filters between two heights on a chain. */
+    /** Get a range of filters between two heights on a chain. The filters are read with one
+     *  index range scan and sequential flat file reads. */
     bool LookupFilterRange(int start_height, const CBlockIndex* stop_index,
                            std::vector<BlockFilter>& filters_out) const;
 
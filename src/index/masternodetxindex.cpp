@@ -0,0 +1,318 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <index/masternodetxindex.h>
+#include <masternodes/masternodes.h>
+#include <streams.h>
+#include <util/system.h>
+#include <validation.h>
+#include <version.h>
+
+#include <functional>
+#include <set>
+
+/* The index database stores every recorded transaction twice:
+ *
+ * Keys for the id index have the type [DB_MN_ID, uint256, uint32 height (BE), uint32 txn (BE),
+ * uint8 kind], where the uint256 is the masternode id or, for anchor rewards, the BTC tx hash of
+ * the anchor. Keys for the address index have the type [DB_MN_ADDRESS, CKeyID, uint32 height (BE),
+ * uint32 txn (BE), uint8 kind], where the CKeyID is an owner, operator or anchor reward address.
+ * Both map to the txid of the transaction. Heights and positions are big-endian so that the
+ * entries of one key are iterated in chain order; the kind tells apart the records of a tx that
+ * touches the same key twice, e.g. a resignation spending its own collateral.
+ *
+ * Masternode creations and resignations are only recorded if consensus applied them, i.e. if the
+ * masternodes view holds the masternode created or resigned by the tx at that height. A spend of
+ * output 1 is recorded as a collateral spend if the spent tx is an indexed masternode creation of
+ * an earlier block or of the same one.
+ */
+constexpr char DB_MN_ID = 'm';
+constexpr char DB_MN_ADDRESS = 'o';
+
+std::unique_ptr<MasternodeTxIndex> g_masternodetxindex;
+
+namespace {
+
+template <char Prefix, typename Id>
+struct DBKey {
+    Id id;
+    int height;
+    uint32_t txn;
+    MasternodeTxKind kind;
+
+    DBKey() : height(0), txn(0), kind(static_cast<MasternodeTxKind>(0)) {}
+    DBKey(const Id& id_in, int height_in, uint32_t txn_in, MasternodeTxKind kind_in = static_cast<MasternodeTxKind>(0)) :
+        id(id_in), height(height_in), txn(txn_in), kind(kind_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, Prefix);
+        id.Serialize(s);
+        ser_writedata32be(s, height);
+        ser_writedata32be(s, txn);
+        ser_writedata8(s, static_cast<uint8_t>(kind));
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != Prefix) {
+            throw std::ios_base::failure("Invalid format for masternode tx index DB key");
+        }
+        id.Unserialize(s);
+        height = ser_readdata32be(s);
+        txn = ser_readdata32be(s);
+        kind = static_cast<MasternodeTxKind>(ser_readdata8(s));
+    }
+};
+
+using DBIdKey = DBKey<DB_MN_ID, uint256>;
+using DBAddressKey = DBKey<DB_MN_ADDRESS, CKeyID>;
+
+/** Index records produced by a single block. */
+struct BlockRecords {
+    std::vector<std::pair<DBIdKey, uint256>> by_id;
+    std::vector<std::pair<DBAddressKey, uint256>> by_address;
+};
+
+template <typename Key>
+bool ReadEntries(CDBWrapper& db, const Key& start, size_t limit, std::vector<CMasternodeTxIndexEntry>& entries)
+{
+    std::unique_ptr<CDBIterator> db_it(db.NewIterator());
+    Key key;
+    for (db_it->Seek(start); db_it->Valid() && entries.size() < limit; db_it->Next()) {
+        // GetKey fails on a prefix mismatch, which ends the scan.
+        if (!db_it->GetKey(key) || key.id != start.id) {
+            break;
+        }
+        uint256 txid;
+        if (!db_it->GetValue(txid)) {
+            return error("%s: unable to read value in masternodetxindex at height %d",
+                         __func__, key.height);
+        }
+        entries.push_back({key.height, key.txn, txid, key.kind});
+    }
+    return true;
+}
+
+} // namespace
+
+std::string MasternodeTxKindName(MasternodeTxKind kind)
+{
+    switch (kind) {
+    case MasternodeTxKind::CreateMasternode: return "CreateMasternode";
+    case MasternodeTxKind::ResignMasternode: return "ResignMasternode";
+    case MasternodeTxKind::CollateralSpend: return "CollateralSpend";
+    case MasternodeTxKind::CriminalBan: return "CriminalBan";
+    case MasternodeTxKind::AnchorReward: return "AnchorReward";
+    } // no default case, so the compiler can warn about missing cases
+    return "Unknown";
+}
+
+/**
+ * Access to the masternode tx index database (indexes/masternodetxindex/)
+ */
+class MasternodeTxIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Whether txid is an indexed masternode creation tx.
+    bool IsMasternodeCreation(const uint256& txid);
+
+    /// Write the records of a connected block to the DB.
+    bool WriteRecords(const BlockRecords& records);
+
+    /// Erase the records of a disconnected block from the DB.
+    bool EraseRecords(const BlockRecords& records);
+};
+
+MasternodeTxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "masternodetxindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool MasternodeTxIndex::DB::IsMasternodeCreation(const uint256& txid)
+{
+    // The creation tx is the first entry of the masternode id, which is its txid.
+    std::vector<CMasternodeTxIndexEntry> entries;
+    return ReadEntries(*this, DBIdKey(txid, 0, 0), 1, entries) && !entries.empty() &&
+           entries.front().kind == MasternodeTxKind::CreateMasternode && entries.front().txid == txid;
+}
+
+bool MasternodeTxIndex::DB::WriteRecords(const BlockRecords& records)
+{
+    CDBBatch batch(*this);
+    for (const auto& record : records.by_id) {
+        batch.Write(record.first, record.second);
+    }
+    for (const auto& record : records.by_address) {
+        batch.Write(record.first, record.second);
+    }
+    return WriteBatch(batch);
+}
+
+bool MasternodeTxIndex::DB::EraseRecords(const BlockRecords& records)
+{
+    CDBBatch batch(*this);
+    for (const auto& record : records.by_id) {
+        batch.Erase(record.first);
+    }
+    for (const auto& record : records.by_address) {
+        batch.Erase(record.first);
+    }
+    return WriteBatch(batch);
+}
+
+using IsCreationFn = std::function<bool(const uint256&)>;
+using IsAppliedFn = std::function<bool(const uint256& txid, const uint256& id, MasternodesTxType type)>;
+
+static void CollectBlockRecords(const IsCreationFn& is_mn_creation, const IsAppliedFn& is_applied,
+                                const CBlock& block, int height, BlockRecords& records)
+{
+    // Creations of this block are not in the DB yet, but their collateral may already be spent.
+    std::set<uint256> created;
+    for (uint32_t txn = 0; txn < block.vtx.size(); ++txn) {
+        const CTransaction& tx = *block.vtx[txn];
+        const uint256& txid = tx.GetHash();
+        std::vector<unsigned char> metadata;
+
+        auto add_id = [&](const uint256& id, MasternodeTxKind kind) {
+            records.by_id.emplace_back(DBIdKey(id, height, txn, kind), txid);
+        };
+        auto add_address = [&](const CKeyID& address, MasternodeTxKind kind) {
+            if (!address.IsNull()) {
+                records.by_address.emplace_back(DBAddressKey(address, height, txn, kind), txid);
+            }
+        };
+
+        try {
+            if (tx.IsCoinBase()) {
+                if (CMasternodesView::ExtractCriminalProofFromTx(tx, metadata)) {
+                    CBlockHeader header, conflict_header;
+                    uint256 mnid;
+                    CDataStream ss(metadata, SER_NETWORK, PROTOCOL_VERSION);
+                    ss >> header >> conflict_header >> mnid;
+                    add_id(mnid, MasternodeTxKind::CriminalBan);
+                }
+                continue;
+            }
+
+            switch (GuessMasternodeTxType(tx, metadata)) {
+            case MasternodesTxType::CreateMasternode: {
+                if (tx.vout.size() < 2 || !is_applied(txid, txid, MasternodesTxType::CreateMasternode)) break;
+                CMasternode node(tx, height, metadata);
+                created.insert(txid);
+                add_id(txid, MasternodeTxKind::CreateMasternode);
+                add_address(node.ownerAuthAddress, MasternodeTxKind::CreateMasternode);
+                if (node.operatorAuthAddress != node.ownerAuthAddress) {
+                    add_address(node.operatorAuthAddress, MasternodeTxKind::CreateMasternode);
+                }
+                break;
+            }
+            case MasternodesTxType::ResignMasternode:
+                if (metadata.size() == sizeof(uint256)) {
+                    const uint256 mnid(metadata);
+                    if (is_applied(txid, mnid, MasternodesTxType::ResignMasternode)) {
+                        add_id(mnid, MasternodeTxKind::ResignMasternode);
+                    }
+                }
+                break;
+            default:
+                if (CMasternodesView::ExtractAnchorRewardFromTx(tx, metadata)) {
+                    uint256 btc_tx_hash;
+                    uint32_t anchor_height, prev_anchor_height;
+                    CKeyID reward_key_id;
+                    CDataStream ss(metadata, SER_NETWORK, PROTOCOL_VERSION);
+                    ss >> btc_tx_hash >> anchor_height >> prev_anchor_height >> reward_key_id;
+                    add_id(btc_tx_hash, MasternodeTxKind::AnchorReward);
+                    add_address(reward_key_id, MasternodeTxKind::AnchorReward);
+                }
+                break;
+            }
+        } catch (const std::exception& e) {
+            // Malformed metadata is skipped by consensus as well, so it is not indexed either.
+            LogPrint(BCLog::DB, "%s: skipping malformed metadata of tx %s: %s\n",
+                     __func__, txid.ToString(), e.what());
+        }
+
+        for (const CTxIn& txin : tx.vin) {
+            if (txin.prevout.n == 1 && (created.count(txin.prevout.hash) || is_mn_creation(txin.prevout.hash))) {
+                add_id(txin.prevout.hash, MasternodeTxKind::CollateralSpend);
+            }
+        }
+    }
+}
+
+MasternodeTxIndex::MasternodeTxIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<MasternodeTxIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+MasternodeTxIndex::~MasternodeTxIndex() {}
+
+bool MasternodeTxIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // The masternodes view has already connected this block, so a creation or resignation was
+    // applied by consensus iff the view has the masternode created or resigned by it at this height.
+    const int height = pindex->nHeight;
+    auto is_applied = [height](const uint256& txid, const uint256& id, MasternodesTxType type) {
+        LOCK(cs_main);
+        const CMasternode* node = pmasternodesview->ExistMasternode(id);
+        if (!node) return false;
+        if (type == MasternodesTxType::CreateMasternode) return node->creationHeight == height;
+        return node->resignTx == txid && node->resignHeight == height;
+    };
+
+    BlockRecords records;
+    CollectBlockRecords(std::bind(&DB::IsMasternodeCreation, m_db.get(), std::placeholders::_1), is_applied,
+                        block, pindex->nHeight, records);
+    if (records.by_id.empty() && records.by_address.empty()) {
+        return true;
+    }
+    return m_db->WriteRecords(records);
+}
+
+bool MasternodeTxIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // The masternodes view may have undone these blocks already, so every record a block could
+    // have produced is erased; erasing keys that were never written is harmless. Blocks are
+    // disconnected from the tip down, so creation records are still present when the collateral
+    // spends referring to them are recomputed.
+    auto any_applied = [](const uint256&, const uint256&, MasternodesTxType) { return true; };
+    const auto& consensus_params = Params().GetConsensus();
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            return error("%s: Failed to read block %s from disk",
+                         __func__, pindex->GetBlockHash().ToString());
+        }
+        BlockRecords records;
+        CollectBlockRecords(std::bind(&DB::IsMasternodeCreation, m_db.get(), std::placeholders::_1), any_applied,
+                            block, pindex->nHeight, records);
+        if (!m_db->EraseRecords(records)) {
+            return error("%s: Failed to erase records of block %s from %s",
+                         __func__, pindex->GetBlockHash().ToString(), GetName());
+        }
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB& MasternodeTxIndex::GetDB() const { return *m_db; }
+
+bool MasternodeTxIndex::FindTxs(const uint256& id, int start_height, uint32_t start_txn, size_t limit,
+                                std::vector<CMasternodeTxIndexEntry>& entries) const
+{
+    return ReadEntries(*m_db, DBIdKey(id, start_height, start_txn), limit, entries);
+}
+
+bool MasternodeTxIndex::FindTxs(const CKeyID& address, int start_height, uint32_t start_txn, size_t limit,
+                                std::vector<CMasternodeTxIndexEntry>& entries) const
+{
+    return ReadEntries(*m_db, DBAddressKey(address, start_height, start_txn), limit, entries);
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_INDEX_MASTERNODETXINDEX_H
+#define DEFI_INDEX_MASTERNODETXINDEX_H
+
+#include <chain.h>
+#include <index/base.h>
+#include <pubkey.h>
+#include <uint256.h>
+
+/** Kind of DeFi transaction recorded in the masternode tx index. */
+enum class MasternodeTxKind : uint8_t {
+    CreateMasternode = 'C',
+    ResignMasternode = 'R',
+    CollateralSpend = 'S',
+    CriminalBan = 'B',
+    AnchorReward = 'A',
+};
+
+/** Human readable name of a MasternodeTxKind, used by the RPC interface. */
+std::string MasternodeTxKindName(MasternodeTxKind kind);
+
+/** A DeFi transaction touching a masternode, an address or an anchor. */
+struct CMasternodeTxIndexEntry {
+    int height;
+    uint32_t txn;
+    uint256 txid;
+    MasternodeTxKind kind;
+};
+
+/**
+ * MasternodeTxIndex records every masternode related DeFi transaction (masternode creation and
+ * resignation as applied by consensus, collateral spends, criminal bans and anchor rewards) keyed
+ * both by the masternode id (or the anchor's BTC tx hash) and by the owner, operator or reward
+ * address involved. Entries of one key are ordered by height and position in the block, so they
+ * can be listed page by page.
+ */
+class MasternodeTxIndex final : public BaseIndex
+{
+    friend struct MasternodeTxIndexTest;
+
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "masternodetxindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit MasternodeTxIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~MasternodeTxIndex() override;
+
+    /// Look up transactions by masternode id or anchor BTC tx hash, starting at the given
+    /// (height, txn) position inclusive and returning at most limit entries.
+    bool FindTxs(const uint256& id, int start_height, uint32_t start_txn, size_t limit,
+                 std::vector<CMasternodeTxIndexEntry>& entries) const;
+
+    /// Look up transactions by owner, operator or reward address. Same paging rules as above.
+    bool FindTxs(const CKeyID& address, int start_height, uint32_t start_txn, size_t limit,
+                 std::vector<CMasternodeTxIndexEntry>& entries) const;
+};
+
+/// The global masternode tx index, used by the listmasternodetxs RPC. May be null.
+extern std::unique_ptr<MasternodeTxIndex> g_masternodetxindex;
+
+#endif // DEFI_INDEX_MASTERNODETXINDEX_H
@@ -162,7 +162,10 @@ public:
     explicit NotificationsHandlerImpl(Chain& chain, Chain::Notifications& notifications)
         : m_chain(chain), m_notifications(&notifications)
     {
-        RegisterValidationInterface(this);
+        ValidationInterfaceQueueOptions options;
+        options.name = "wallet";
+        options.max_size = GetValidationQueueSize();
+        RegisterValidationInterface(this, options);
     }
     ~NotificationsHandlerImpl() override { disconnect(); }
     void disconnect() override
@@ -270,6 +273,30 @@ public:
         }
         return true;
     }
+    void findBlocks(const std::vector<uint256>& hashes, std::vector<CBlock>& blocks, int n_threads) override
+    {
+        // The positions are looked up first, as the reading threads cannot take cs_main if the
+        // caller holds it.
+        std::vector<FlatFilePos> positions(hashes.size());
+        {
+            LOCK(cs_main);
+            for (size_t i = 0; i < hashes.size(); ++i) {
+                const CBlockIndex* index = LookupBlockIndex(hashes[i]);
+                if (index && (index->nStatus & BLOCK_HAVE_DATA)) {
+                    positions[i] = index->GetBlockPos();
+                }
+            }
+        }
+        const Consensus::Params& params = Params().GetConsensus();
+        blocks.assign(hashes.size(), CBlock());
+        ParallelFor(hashes.size(), n_threads, [&](size_t i) {
+            if (hashes[i] == params.hashGenesisBlock) {
+                blocks[i] = Params().GenesisBlock();
+            } else if (positions[i].IsNull() || !ReadBlockFromDisk(blocks[i], positions[i], params) || blocks[i].GetHash() != hashes[i]) {
+                blocks[i].SetNull();
+            }
+        });
+    }
     void findCoins(std::map<COutPoint, Coin>& coins) override { return FindCoins(coins); }
     bool mnCanSpend(const uint256 & nodeId, int height) const override
     {
@@ -141,6 +141,11 @@ public:
         int64_t* time = nullptr,
         int64_t* max_time = nullptr) = 0;
 
+    //! Read the blocks of the given hashes on n_threads threads, setting those
+    //! that are unknown or have no data to null, like findBlock. Unlike
+    //! findBlock, can be called with the chain lock held.
+    virtual void findBlocks(const std::vector<uint256>& hashes, std::vector<CBlock>& blocks, int n_threads) = 0;
+
     //! Look up unspent output information. Returns coins in the mempool and in
     //! the current chain UTXO set. Iterates through all the keys in the map and
     //! populates the values.
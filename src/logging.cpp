@@ -3,10 +3,16 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#if defined(HAVE_CONFIG_H)
+#include <config/defi-config.h>
+#endif
+
 #include <logging.h>
 #include <util/threadnames.h>
 #include <util/time.h>
 
+#include <algorithm>
+#include <chrono>
 #include <mutex>
 
 const char * const DEFAULT_DEBUGLOGFILE = "debug.log";
@@ -39,6 +45,89 @@ static int FileWriteStr(const std::string &str, FILE *fp)
     return fwrite(str.data(), 1, str.size(), fp);
 }
 
+namespace BCLog {
+
+/** Maximum number of messages a thread can have queued, further ones are dropped. */
+static const size_t LOG_QUEUE_SIZE = 1024;
+/** How often the writer thread wakes up to write out the queued messages. */
+static const std::chrono::milliseconds LOG_WRITE_INTERVAL{10};
+
+struct LogRecord {
+    uint64_t seq;
+    int64_t time_micros;
+    //! Only set with -logthreadnames.
+    std::string thread_name;
+    std::string msg;
+    //! Formats msg on the writer thread, if set.
+    std::function<std::string()> format;
+};
+
+/** Single producer, single consumer ring of the messages of one thread. The consumer holds Logger::m_cs. */
+class LogQueue
+{
+public:
+    LogQueue() : m_records(LOG_QUEUE_SIZE) {}
+
+    //! Whether a running thread uses the queue. Guarded by Logger::m_queues_mutex.
+    bool m_in_use{true};
+
+    /** Returns the number of queued messages, or 0 if the queue was full and the record was left alone. */
+    size_t Push(LogRecord& record)
+    {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint64_t size = tail - m_head.load(std::memory_order_acquire);
+        if (size == m_records.size()) return 0;
+        m_records[tail % m_records.size()] = std::move(record);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return size + 1;
+    }
+
+    void AddDropped() { m_dropped.fetch_add(1, std::memory_order_relaxed); }
+
+    void Drain(std::vector<LogRecord>& records)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        const uint64_t tail = m_tail.load(std::memory_order_acquire);
+        for (uint64_t i = head; i < tail; ++i) {
+            records.push_back(std::move(m_records[i % m_records.size()]));
+        }
+        m_head.store(tail, std::memory_order_release);
+    }
+
+    bool Empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    uint64_t TakeDropped() { return m_dropped.exchange(0, std::memory_order_relaxed); }
+
+private:
+    std::vector<LogRecord> m_records;
+    std::atomic<uint64_t> m_head{0};
+    std::atomic<uint64_t> m_tail{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+} // namespace BCLog
+
+#if defined(HAVE_THREAD_LOCAL)
+namespace {
+/** Releases the queue of the current thread when it exits. */
+struct LogQueueOwner {
+    BCLog::LogQueue* queue{nullptr};
+    std::mutex* queues_mutex{nullptr};
+
+    ~LogQueueOwner()
+    {
+        if (!queue) return;
+        std::lock_guard<std::mutex> lock(*queues_mutex);
+        queue->m_in_use = false;
+    }
+};
+thread_local LogQueueOwner g_log_queue;
+} // namespace
+#endif
+
 bool BCLog::Logger::StartLogging()
 {
     std::lock_guard<std::mutex> scoped_lock(m_cs);
@@ -75,8 +164,54 @@ bool BCLog::Logger::StartLogging()
     return true;
 }
 
+void BCLog::Logger::StartAsyncWriter()
+{
+#if defined(HAVE_THREAD_LOCAL)
+    if (m_writer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_writer_mutex);
+        m_writer_stop = false;
+    }
+    m_writer = std::thread(&BCLog::Logger::WriterThread, this);
+    m_async = true;
+#endif
+}
+
+void BCLog::Logger::StopAsyncWriter()
+{
+    if (!m_writer.joinable()) return;
+    m_async = false;
+    {
+        std::lock_guard<std::mutex> lock(m_writer_mutex);
+        m_writer_stop = true;
+    }
+    m_writer_cond.notify_one();
+    m_writer.join();
+    Flush();
+}
+
+void BCLog::Logger::WriterThread()
+{
+    util::ThreadRename("logwriter");
+    std::unique_lock<std::mutex> lock(m_writer_mutex);
+    while (!m_writer_stop) {
+        m_writer_cond.wait_for(lock, LOG_WRITE_INTERVAL);
+        lock.unlock();
+        Flush();
+        lock.lock();
+    }
+}
+
+void BCLog::Logger::Flush()
+{
+    if (!m_have_queues.load(std::memory_order_acquire)) return;
+    std::lock_guard<std::mutex> scoped_lock(m_cs);
+    DrainQueues();
+}
+
 void BCLog::Logger::DisconnectTestLogger()
 {
+    StopAsyncWriter();
     std::lock_guard<std::mutex> scoped_lock(m_cs);
     m_buffering = true;
     if (m_fileout != nullptr) fclose(m_fileout);
@@ -200,7 +335,7 @@ std::vector<CLogCategoryActive> ListActiveLogCategories()
     return ret;
 }
 
-std::string BCLog::Logger::LogTimestampStr(const std::string& str)
+std::string BCLog::Logger::LogTimestampStr(const std::string& str, int64_t nTimeMicros)
 {
     std::string strStamped;
 
@@ -208,7 +343,6 @@ std::string BCLog::Logger::LogTimestampStr(const std::string& str)
         return str;
 
     if (m_started_new_line) {
-        int64_t nTimeMicros = GetTimeMicros();
         strStamped = FormatISO8601DateTime(nTimeMicros/1000000);
         if (m_log_time_micros) {
             strStamped.pop_back();
@@ -227,14 +361,34 @@ std::string BCLog::Logger::LogTimestampStr(const std::string& str)
 
 void BCLog::Logger::LogPrintStr(const std::string& str)
 {
+    if (m_async.load(std::memory_order_relaxed)) {
+        PushAsync(str, nullptr);
+        return;
+    }
     std::lock_guard<std::mutex> scoped_lock(m_cs);
+    // Messages queued before asynchronous logging stopped come first.
+    if (m_have_queues.load(std::memory_order_acquire)) DrainQueues();
+    WriteMessage(str, m_log_threadnames ? util::ThreadGetInternalName() : std::string(), GetTimeMicros());
+}
+
+void BCLog::Logger::LogPrintDeferred(std::function<std::string()> format)
+{
+    if (m_async.load(std::memory_order_relaxed)) {
+        PushAsync(std::string(), std::move(format));
+        return;
+    }
+    LogPrintStr(format());
+}
+
+void BCLog::Logger::WriteMessage(const std::string& str, const std::string& thread_name, int64_t time_micros)
+{
     std::string str_prefixed = str;
 
     if (m_log_threadnames && m_started_new_line) {
-        str_prefixed.insert(0, "[" + util::ThreadGetInternalName() + "] ");
+        str_prefixed.insert(0, "[" + thread_name + "] ");
     }
 
-    str_prefixed = LogTimestampStr(str_prefixed);
+    str_prefixed = LogTimestampStr(str_prefixed, time_micros);
 
     m_started_new_line = !str.empty() && str[str.size()-1] == '\n';
 
@@ -243,7 +397,15 @@ void BCLog::Logger::LogPrintStr(const std::string& str)
         m_msgs_before_open.push_back(str_prefixed);
         return;
     }
+    if (m_batch) {
+        *m_batch += str_prefixed;
+        return;
+    }
+    WriteOut(str_prefixed);
+}
 
+void BCLog::Logger::WriteOut(const std::string& str_prefixed)
+{
     if (m_print_to_console) {
         // print to console
         fwrite(str_prefixed.data(), 1, str_prefixed.size(), stdout);
@@ -266,6 +428,162 @@ void BCLog::Logger::LogPrintStr(const std::string& str)
     }
 }
 
+BCLog::LogQueue& BCLog::Logger::GetThreadQueue()
+{
+#if defined(HAVE_THREAD_LOCAL)
+    if (g_log_queue.queue) return *g_log_queue.queue;
+    std::lock_guard<std::mutex> lock(m_queues_mutex);
+    LogQueue* queue = nullptr;
+    for (LogQueue* unused : m_queues) {
+        if (!unused->m_in_use && unused->Empty()) {
+            queue = unused;
+            queue->m_in_use = true;
+            break;
+        }
+    }
+    if (!queue) {
+        queue = new LogQueue();
+        m_queues.push_back(queue);
+        m_have_queues = true;
+    }
+    g_log_queue.queue = queue;
+    g_log_queue.queues_mutex = &m_queues_mutex;
+    return *queue;
+#else
+    // StartAsyncWriter() does not enable asynchronous mode without thread_local.
+    abort();
+#endif
+}
+
+void BCLog::Logger::PushAsync(std::string str, std::function<std::string()> format)
+{
+    LogRecord record;
+    record.seq = m_next_seq.fetch_add(1, std::memory_order_relaxed);
+    record.time_micros = GetTimeMicros();
+    if (m_log_threadnames) record.thread_name = util::ThreadGetInternalName();
+    record.msg = std::move(str);
+    record.format = std::move(format);
+
+    LogQueue& queue = GetThreadQueue();
+    size_t queued = queue.Push(record);
+    if (queued == 0) {
+        // The writer fell behind. Write the backlog from this thread unless that means waiting for the writer.
+        std::unique_lock<std::mutex> lock(m_cs, std::try_to_lock);
+        if (lock.owns_lock()) {
+            DrainQueues();
+            queued = queue.Push(record);
+        }
+        if (queued == 0) queue.AddDropped();
+    } else if (queued == LOG_QUEUE_SIZE / 2) {
+        m_writer_cond.notify_one();
+    }
+}
+
+void BCLog::Logger::DrainQueues()
+{
+    std::vector<LogQueue*> queues;
+    {
+        std::lock_guard<std::mutex> lock(m_queues_mutex);
+        queues = m_queues;
+    }
+    std::vector<LogRecord> records;
+    uint64_t dropped = 0;
+    for (LogQueue* queue : queues) {
+        queue->Drain(records);
+        dropped += queue->TakeDropped();
+    }
+    if (records.empty() && !dropped) return;
+    std::sort(records.begin(), records.end(), [](const LogRecord& a, const LogRecord& b) { return a.seq < b.seq; });
+
+    // Written out at once, rather than with one unbuffered write per message.
+    std::string batch;
+    m_batch = &batch;
+    for (const LogRecord& record : records) {
+        WriteMessage(record.format ? record.format() : record.msg, record.thread_name, record.time_micros);
+    }
+    if (dropped) {
+        if (!m_started_new_line) WriteMessage("\n", std::string(), GetTimeMicros());
+        WriteMessage(strprintf("Dropped %u log messages, the queue of a thread was full\n", dropped), std::string(), GetTimeMicros());
+    }
+    m_batch = nullptr;
+    if (!batch.empty()) WriteOut(batch);
+}
+
+namespace {
+/** Messages logged by one log statement in the current minute, see Logger::RateLimitAllows(). */
+struct LogSite {
+    enum : int { EMPTY = 0, CLAIMED = 1, READY = 2 };
+    std::atomic<int> state;
+    const char* file;
+    int line;
+    std::atomic<int64_t> minute;
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> suppressed;
+};
+
+/** Open addressing table keyed by the source location, zero initialized like the lock sites in sync.cpp. */
+static const size_t LOG_SITES = 4096;
+LogSite g_log_sites[LOG_SITES];
+
+LogSite* GetLogSite(const char* file, int line)
+{
+    size_t slot = (reinterpret_cast<uintptr_t>(file) * 31 + static_cast<unsigned>(line)) * 0x9E3779B97F4A7C15ULL >> 20;
+    for (size_t probe = 0; probe < LOG_SITES; ++probe, ++slot) {
+        LogSite& site = g_log_sites[slot % LOG_SITES];
+        int state = site.state.load(std::memory_order_acquire);
+        if (state == LogSite::EMPTY) {
+            if (site.state.compare_exchange_strong(state, LogSite::CLAIMED, std::memory_order_acquire)) {
+                site.file = file;
+                site.line = line;
+                site.state.store(LogSite::READY, std::memory_order_release);
+                return &site;
+            }
+        }
+        // Another thread is filling in this slot, which only takes a few stores.
+        while (state == LogSite::CLAIMED) {
+            std::this_thread::yield();
+            state = site.state.load(std::memory_order_acquire);
+        }
+        if (site.file == file && site.line == line) return &site;
+    }
+    return nullptr;
+}
+
+std::string SuppressedSummary(const LogSite& site, uint32_t suppressed)
+{
+    return strprintf("Suppressed %u messages logged at %s:%d after reaching -logratelimit\n", suppressed, site.file, site.line);
+}
+} // namespace
+
+bool BCLog::Logger::RateLimitAllows(const char* file, int line)
+{
+    const unsigned int limit = m_rate_limit.load(std::memory_order_relaxed);
+    if (limit == 0) return true;
+    LogSite* site = GetLogSite(file, line);
+    if (!site) return true;
+
+    const int64_t minute = GetTimeMicros() / (60 * 1000000);
+    int64_t site_minute = site->minute.load(std::memory_order_relaxed);
+    if (site_minute != minute && site->minute.compare_exchange_strong(site_minute, minute, std::memory_order_relaxed)) {
+        site->count.store(0, std::memory_order_relaxed);
+        const uint32_t suppressed = site->suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed) LogPrintStr(SuppressedSummary(*site, suppressed));
+    }
+    if (site->count.fetch_add(1, std::memory_order_relaxed) < limit) return true;
+    site->suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void BCLog::Logger::LogSuppressed()
+{
+    for (LogSite& site : g_log_sites) {
+        if (site.state.load(std::memory_order_acquire) != LogSite::READY) continue;
+        // Taking the count makes it the only summary of these messages.
+        const uint32_t suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed) LogPrintStr(SuppressedSummary(site, suppressed));
+    }
+}
+
 void BCLog::Logger::ShrinkDebugFile()
 {
     // Amount of debug.log to save at end when shrinking (must fit in memory)
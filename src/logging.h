@@ -10,16 +10,22 @@
 #include <tinyformat.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS        = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
 static const bool DEFAULT_LOGTHREADNAMES = false;
+static const bool DEFAULT_LOGASYNC = false;
+static const unsigned int DEFAULT_LOGRATELIMIT = 0;
 extern const char * const DEFAULT_DEBUGLOGFILE;
 
 extern bool fLogIPs;
@@ -58,13 +64,36 @@ namespace BCLog {
         ALL         = ~(uint32_t)0,
     };
 
+    /** Messages logged by one thread in asynchronous mode, see Logger::StartAsyncWriter(). */
+    class LogQueue;
+
     class Logger
     {
     private:
         mutable std::mutex m_cs;                   // Can not use Mutex from sync.h because in debug mode it would cause a deadlock when a potential deadlock was detected
         FILE* m_fileout = nullptr;                 // GUARDED_BY(m_cs)
         std::list<std::string> m_msgs_before_open; // GUARDED_BY(m_cs)
-        bool m_buffering{true};                    //!< Buffer messages before logging can be started. GUARDED_BY(m_cs)
+        std::atomic<bool> m_buffering{true};       //!< Buffer messages before logging can be started. Written under m_cs.
+
+        /**
+         * Asynchronous mode: threads append to their own LogQueue without
+         * taking m_cs, and the writer thread formats and writes the messages.
+         * Queues are never freed, like the logger, and are reused once the
+         * thread that used one has exited and it was drained.
+         */
+        std::atomic<bool> m_async{false};
+        std::mutex m_queues_mutex;
+        std::vector<LogQueue*> m_queues;           // GUARDED_BY(m_queues_mutex)
+        std::atomic<bool> m_have_queues{false};
+        //! Orders the messages of all queues.
+        std::atomic<uint64_t> m_next_seq{0};
+        std::thread m_writer;
+        std::mutex m_writer_mutex;
+        std::condition_variable m_writer_cond;
+        bool m_writer_stop{false};                 // GUARDED_BY(m_writer_mutex)
+
+        /** Log at most this many messages per minute from each call site, 0 for no limit. */
+        std::atomic<unsigned int> m_rate_limit{DEFAULT_LOGRATELIMIT};
 
         /**
          * m_started_new_line is a state variable that will suppress printing of
@@ -76,7 +105,17 @@ namespace BCLog {
         /** Log categories bitfield. */
         std::atomic<uint32_t> m_categories{0};
 
-        std::string LogTimestampStr(const std::string& str);
+        std::string LogTimestampStr(const std::string& str, int64_t time_micros);
+        /** Add the thread name and timestamp to a message and write it out. */
+        void WriteMessage(const std::string& str, const std::string& thread_name, int64_t time_micros); // EXCLUSIVE_LOCKS_REQUIRED(m_cs)
+        void WriteOut(const std::string& str_prefixed); // EXCLUSIVE_LOCKS_REQUIRED(m_cs)
+        //! Collects the output of WriteMessage() while draining the queues. GUARDED_BY(m_cs)
+        std::string* m_batch{nullptr};
+        LogQueue& GetThreadQueue();
+        void PushAsync(std::string str, std::function<std::string()> format);
+        /** Write out all queued messages in the order they were logged. */
+        void DrainQueues(); // EXCLUSIVE_LOCKS_REQUIRED(m_cs)
+        void WriterThread();
 
     public:
         bool m_print_to_console = false;
@@ -91,16 +130,37 @@ namespace BCLog {
 
         /** Send a string to the log output */
         void LogPrintStr(const std::string& str);
+        /** Send a message to the log output that is formatted by the writer thread in asynchronous mode */
+        void LogPrintDeferred(std::function<std::string()> format);
 
         /** Returns whether logs will be written to any output */
         bool Enabled() const
         {
-            std::lock_guard<std::mutex> scoped_lock(m_cs);
+            // The outputs are only configured before logging starts.
             return m_buffering || m_print_to_console || m_print_to_file;
         }
 
+        bool Async() const { return m_async.load(std::memory_order_relaxed); }
+
+        /**
+         * Returns whether the log statement at this source location may log,
+         * or it exceeded the rate limit. The summary of the suppressed messages
+         * is logged when the site logs again after the minute ended, or by
+         * LogSuppressed().
+         */
+        bool RateLimitAllows(const char* file, int line);
+        /** Log the summaries of all messages suppressed so far, e.g. periodically and at shutdown */
+        void LogSuppressed();
+        void SetRateLimit(unsigned int messages_per_minute) { m_rate_limit = messages_per_minute; }
+
         /** Start logging (and flush all buffered messages) */
         bool StartLogging();
+        /** Hand writing the log over to a background thread, after StartLogging() */
+        void StartAsyncWriter();
+        /** Write out all queued messages and return to synchronous logging */
+        void StopAsyncWriter();
+        /** Write out all queued messages, e.g. before the process may be terminated */
+        void Flush();
         /** Only for testing */
         void DisconnectTestLogger();
 
@@ -141,27 +201,109 @@ bool GetLogCategory(BCLog::LogFlags& flag, const std::string& str);
 // unconditionally log to debug.log! It should not be the case that an inbound
 // peer can fill up a user's disk with debug.log entries.
 
+namespace logging_detail {
+/**
+ * How a LogPrintf argument is kept until the writer thread formats it. Only
+ * values that can be copied cheaply and safely are, C strings are copied into
+ * strings as they may not outlive the call. Messages with any other argument
+ * are formatted by the logging thread.
+ */
+template <typename T, typename Enable = void>
+struct DeferredArg : std::false_type {};
+template <typename T>
+struct DeferredArg<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type> : std::true_type {
+    using type = T;
+};
+template <>
+struct DeferredArg<std::string> : std::true_type {
+    using type = std::string;
+};
+template <>
+struct DeferredArg<const char*> : std::true_type {
+    using type = std::string;
+};
+template <>
+struct DeferredArg<char*> : std::true_type {
+    using type = std::string;
+};
+
+template <typename... Args>
+struct AllDeferrable : std::true_type {};
+template <typename T, typename... Args>
+struct AllDeferrable<T, Args...> : std::integral_constant<bool, DeferredArg<typename std::decay<T>::type>::value && AllDeferrable<Args...>::value> {};
+
 template <typename... Args>
-static inline void LogPrintf(const char* fmt, const Args&... args)
+std::string FormatLogMessage(const char* fmt, const Args&... args)
 {
-    if (LogInstance().Enabled()) {
-        std::string log_msg;
-        try {
-            log_msg = tfm::format(fmt, args...);
-        } catch (tinyformat::format_error& fmterr) {
-            /* Original format string will have newline so don't add one here */
-            log_msg = "Error \"" + std::string(fmterr.what()) + "\" while formatting log message: " + fmt;
-        }
-        LogInstance().LogPrintStr(log_msg);
+    try {
+        return tfm::format(fmt, args...);
+    } catch (tinyformat::format_error& fmterr) {
+        /* Original format string will have newline so don't add one here */
+        return "Error \"" + std::string(fmterr.what()) + "\" while formatting log message: " + fmt;
     }
 }
 
 template <typename... Args>
-static inline void LogPrint(const BCLog::LogFlags& category, const Args&... args)
+void LogPrintfDeferrable(std::true_type deferrable, const char* fmt, const Args&... args)
+{
+    if (LogInstance().Async()) {
+        // The format string is a literal, so only the arguments need to be kept.
+        LogInstance().LogPrintDeferred(std::bind(&FormatLogMessage<typename DeferredArg<typename std::decay<Args>::type>::type...>,
+            fmt, typename DeferredArg<typename std::decay<Args>::type>::type(args)...));
+        return;
+    }
+    LogInstance().LogPrintStr(FormatLogMessage(fmt, args...));
+}
+
+template <typename... Args>
+void LogPrintfDeferrable(std::false_type deferrable, const char* fmt, const Args&... args)
+{
+    LogInstance().LogPrintStr(FormatLogMessage(fmt, args...));
+}
+} // namespace logging_detail
+
+/** Log a message from the log statement at file:line, which identifies it for rate limiting. The format string must be a literal. */
+template <typename... Args>
+static inline void LogPrintfAt(const char* file, int line, const char* fmt, const Args&... args)
 {
-    if (LogAcceptCategory((category))) {
-        LogPrintf(args...);
+    if (LogInstance().Enabled() && LogInstance().RateLimitAllows(file, line)) {
+        logging_detail::LogPrintfDeferrable(logging_detail::AllDeferrable<Args...>(), fmt, args...);
     }
 }
 
+#if defined(__clang__)
+#if __has_builtin(__builtin_FILE) && __has_builtin(__builtin_LINE)
+#define HAVE_BUILTIN_FILE_LINE 1
+#endif
+#elif defined(__GNUC__)
+#define HAVE_BUILTIN_FILE_LINE 1
+#endif
+
+/**
+ * The format string of a function that logs on behalf of its caller, like
+ * error(), with the source location of that caller. Converting a literal at
+ * the call fills in the location where the compiler supports it, otherwise all
+ * callers share one.
+ */
+struct CallerLogFormat {
+#ifdef HAVE_BUILTIN_FILE_LINE
+    CallerLogFormat(const char* fmt_in, const char* file_in = __builtin_FILE(), int line_in = __builtin_LINE()) : fmt(fmt_in), file(file_in), line(line_in) {}
+#else
+    CallerLogFormat(const char* fmt_in, const char* file_in = __FILE__, int line_in = __LINE__) : fmt(fmt_in), file(file_in), line(line_in) {}
+#endif
+
+    const char* fmt;
+    const char* file;
+    int line;
+};
+
+#define LogPrintf(...) LogPrintfAt(__FILE__, __LINE__, __VA_ARGS__)
+
+#define LogPrint(category, ...)                     \
+    do {                                            \
+        if (LogAcceptCategory((category))) {        \
+            LogPrintf(__VA_ARGS__);                 \
+        }                                           \
+    } while (0)
+
 #endif // DEFI_LOGGING_H
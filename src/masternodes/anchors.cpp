@@ -6,12 +6,15 @@
 
 #include <chainparams.h>
 #include <consensus/validation.h>
+#include <hash.h>
 #include <key.h>
 #include <logging.h>
+#include <metrics.h>
 #include <streams.h>
 #include <script/standard.h>
 #include <spv/spv_wrapper.h>
 #include <util/system.h>
+#include <util/tracing.h>
 #include <util/validation.h>
 #include <validation.h>
 
@@ -26,9 +29,18 @@ std::unique_ptr<CAnchorAwaitingConfirms> panchorAwaitingConfirms;
 template <typename TContainer>
 bool CheckSigs(uint256 const & sigHash, TContainer const & sigs, std::set<CKeyID> const & keys)
 {
+    // Recover all signers first, so that their key IDs are hashed in one batch
+    std::vector<CPubKey> pubkeys(sigs.size());
+    std::vector<Span<const unsigned char>> serialized;
+    serialized.reserve(sigs.size());
     for (auto const & sig : sigs) {
-        CPubKey pubkey;
-        if (!pubkey.RecoverCompact(sigHash, sig) || keys.find(pubkey.GetID()) == keys.end())
+        CPubKey & pubkey = pubkeys[serialized.size()];
+        if (!pubkey.RecoverCompact(sigHash, sig))
+            return false;
+        serialized.emplace_back(pubkey.begin(), pubkey.size());
+    }
+    for (uint160 const & id : Hash160Batch(serialized)) {
+        if (keys.find(CKeyID(id)) == keys.end())
             return false;
     }
     return true;
@@ -441,6 +453,7 @@ void CAnchorIndex::CheckActiveAnchor(bool forced)
 {
     // we should avoid slow operations on exit, especially ActivateBestChain
     if (ShutdownRequested()) return;
+    TRACE_SPAN(span, "CheckActiveAnchor", "anchor");
 
     bool topChanged{false};
     {
@@ -448,10 +461,15 @@ void CAnchorIndex::CheckActiveAnchor(bool forced)
         uint32_t const tmp = spv::pspv ? spv::pspv->GetLastBlockHeight() : 0;
         LOCK(cs_main);
         spvLastHeight = tmp;
+        metrics::spv_height.Set(spvLastHeight);
         topChanged = panchors->ActivateBestAnchor(forced);
 
+        auto const active = panchors->GetActiveAnchor();
+        metrics::anchor_height.Set(active ? active->anchor.height : 0);
+        metrics::anchor_confirmations.Set(active ? GetAnchorConfirmations(active) : 0);
+
         // prune auths older than anchor with 6 confirmations. Warning! This constant are using for start confirming reward too!
-        auto it = panchors->GetActiveAnchor();
+        auto it = active;
         for (; it && GetAnchorConfirmations(it) < 6; it = panchors->GetAnchorByBtcTx(it->anchor.previousAnchor))
             ;
         if (it)
@@ -480,6 +498,7 @@ void CAnchorIndex::UpdateLastHeight(uint32_t height)
 {
     AssertLockHeld(cs_main);
     spvLastHeight = height;
+    metrics::spv_height.Set(spvLastHeight);
 }
 
 // selects "best" of two anchors at the equal btc height (prevs must be checked before)
@@ -504,6 +523,7 @@ CAnchorIndex::AnchorRec const * BestOfTwo(CAnchorIndex::AnchorRec const * a1, CA
 bool CAnchorIndex::ActivateBestAnchor(bool forced)
 {
     AssertLockHeld(cs_main);
+    TRACE_SPAN(span, "ActivateBestAnchor", "anchor");
 
     if (!possibleReActivation && !forced)
         return false;
@@ -581,6 +601,8 @@ bool CAnchorIndex::DbErase(uint256 const & hash)
 bool ValidateAnchor(const CAnchor & anchor, bool noThrow)
 {
     AssertLockHeld(cs_main);
+    TRACE_SPAN(span, "ValidateAnchor", "anchor");
+    span.Tag("height", anchor.height);
     try {
         // common: check heights and prevs
         if (!anchor.previousAnchor.IsNull()) {
@@ -6,6 +6,7 @@
 #include <masternodes/anchors.h>
 
 #include <chainparams.h>
+#include <crypto/sha256.h>
 #include <net_processing.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
@@ -237,6 +238,32 @@ bool CMasternodesView::IsAnchorInvolved(const uint256 & nodeId, int height) cons
     return false;
 }
 
+static std::vector<size_t> CountByState(CMasternodes const & nodes, int height)
+{
+    std::vector<size_t> counts(CMasternode::UNKNOWN, 0);
+    for (auto const & pair : nodes) {
+        // empty records are deleted masternodes, see ExistMasternode
+        if (pair.second == CMasternode()) {
+            continue;
+        }
+        auto const state = pair.second.GetState(height);
+        if (state != CMasternode::UNKNOWN) {
+            ++counts[state];
+        }
+    }
+    return counts;
+}
+
+std::vector<size_t> CMasternodesView::CountMasternodesByState(int height) const
+{
+    return CountByState(allNodes, height);
+}
+
+std::vector<size_t> CMasternodesViewCache::CountMasternodesByState(int height) const
+{
+    return CountByState(GetMasternodes(), height);
+}
+
 CMasternodesView::CMnBlocksUndo::mapped_type const & CMasternodesView::GetBlockUndo(CMnBlocksUndo::key_type key) const
 {
     static CMnBlocksUndo::mapped_type const Empty = {};
@@ -407,15 +434,23 @@ CMasternodesView::CTeam CMasternodesView::CalcNextTeam(uint256 stakeModifier, co
     if (!masternodes) {
         masternodes = &allNodes;    /// @todo formally this is wrong!
     }
+    // The priority of a node is the hash of its id and the stake modifier, 64 bytes, hashed for all nodes at once.
+    std::vector<CKeyID> operators;
+    std::vector<unsigned char> blocks;
     for (auto && it = masternodes->begin(); it != masternodes->end(); ++it) {
         CMasternode const & node = it->second;
 
         if(!node.IsActive())
             continue;
 
-        CDataStream ss{SER_GETHASH, PROTOCOL_VERSION};
-        ss << it->first << stakeModifier;
-        priorityMN.insert(std::make_pair(UintToArith256(Hash(ss.begin(), ss.end())), node.operatorAuthAddress));
+        operators.push_back(node.operatorAuthAddress);
+        blocks.insert(blocks.end(), it->first.begin(), it->first.end());
+        blocks.insert(blocks.end(), stakeModifier.begin(), stakeModifier.end());
+    }
+    std::vector<uint256> priorities(operators.size());
+    SHA256D64(priorities.empty() ? nullptr : priorities[0].begin(), blocks.data(), operators.size());
+    for (size_t i = 0; i < operators.size(); ++i) {
+        priorityMN.insert(std::make_pair(UintToArith256(priorities[i]), operators[i]));
     }
 
     CMasternodesView::CTeam newTeam;
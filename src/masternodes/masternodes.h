@@ -14,6 +14,7 @@
 #include <map>
 #include <set>
 #include <stdint.h>
+#include <vector>
 #include <iostream>
 
 #include <primitives/block.h>
@@ -149,6 +150,23 @@ public:
     friend bool operator!=(CDoubleSignFact const & a, CDoubleSignFact const & b);
 };
 
+/** A masternode created, resigned or banned by a connected block */
+struct CMasternodeEvent
+{
+    enum Type {
+        CREATED,
+        RESIGNED,
+        BANNED,
+    };
+
+    Type type;
+    uint256 nodeId;
+    //! The creation, resignation or criminal detention transaction
+    uint256 txid;
+    //! The masternode as the block left it
+    CMasternode node;
+};
+
 typedef std::map<uint256, CMasternode> CMasternodes;  // nodeId -> masternode object,
 typedef std::map<CKeyID, uint256> CMasternodesByAuth; // for two indexes, owner->nodeId, operator->nodeId
 
@@ -239,6 +257,9 @@ public:
         return allNodes;
     }
 
+    //! Number of masternodes in each state at the given height, indexed by CMasternode::State
+    virtual std::vector<size_t> CountMasternodesByState(int height) const;
+
     //! Initial load of all data
     virtual bool Load() { assert(false); }
     virtual bool Flush() { assert(false); }
@@ -343,6 +364,8 @@ public:
         return result;
     }
 
+    std::vector<size_t> CountMasternodesByState(int height) const override;
+
     RewardTxHash GetRewardForAnchor(AnchorTxHash const &btcTxHash) const override
     {
         auto it = rewards.find(btcTxHash);
@@ -6,6 +6,8 @@
 
 #include <chainparams.h>
 #include <core_io.h>
+#include <index/masternodetxindex.h>
+#include <key_io.h>
 #include <consensus/validation.h>
 #include <net.h>
 #include <rpc/client.h>
@@ -444,6 +446,120 @@ UniValue listcriminalproofs(const JSONRPCRequest& request)
     return ret;
 }
 
+UniValue listmasternodetxs(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"listmasternodetxs",
+        "\nReturns DeFi transactions involving a masternode, an owner/operator/reward address or an anchor, ordered by height.\n"
+        "Requires -masternodetxindex.\n",
+        {
+            {"key", RPCArg::Type::STR, RPCArg::Optional::NO, "Masternode id, anchor BTC tx hash, or owner/operator/reward address"},
+            {"pagination", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED_NAMED_ARG, "",
+                {
+                    {"height", RPCArg::Type::NUM, /* default */ "0", "Height to start listing from"},
+                    {"txn", RPCArg::Type::NUM, /* default */ "0", "Position in the block at 'height' to start listing from"},
+                    {"limit", RPCArg::Type::NUM, /* default */ "100", "Maximum number of transactions to return"},
+                },
+            },
+        },
+        RPCResult{
+            "{\n"
+            "  \"txs\": [{\"txid\", \"type\", \"height\", \"txn\"},...]  (array) Transactions in chain order\n"
+            "  \"next\": {\"height\", \"txn\"}                        (object, optional) Pagination start of the next page, if any\n"
+            "}\n"
+        },
+        RPCExamples{
+            HelpExampleCli("listmasternodetxs", "\"mn_id\" '{\"height\":0,\"limit\":10}'")
+            + HelpExampleRpc("listmasternodetxs", "\"mn_id\", {\"height\":0,\"limit\":10}")
+        },
+    }.Check(request);
+
+    RPCTypeCheck(request.params, { UniValue::VSTR, UniValue::VOBJ }, true);
+
+    if (!g_masternodetxindex)
+    {
+        throw JSONRPCError(RPC_MISC_ERROR, "Masternode tx index is not enabled. Use -masternodetxindex to enable it.");
+    }
+
+    int height = 0;
+    int txn = 0;
+    int limit = 100;
+    if (!request.params[1].isNull())
+    {
+        UniValue const & pagination = request.params[1].get_obj();
+        RPCTypeCheckObj(pagination,
+            {
+                {"height", UniValueType(UniValue::VNUM)},
+                {"txn", UniValueType(UniValue::VNUM)},
+                {"limit", UniValueType(UniValue::VNUM)},
+            }, true, true);
+        if (!pagination["height"].isNull()) height = pagination["height"].get_int();
+        if (!pagination["txn"].isNull()) txn = pagination["txn"].get_int();
+        if (!pagination["limit"].isNull()) limit = pagination["limit"].get_int();
+    }
+    if (height < 0 || txn < 0 || limit <= 0)
+    {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid pagination");
+    }
+
+    if (!g_masternodetxindex->BlockUntilSyncedToCurrentChain())
+    {
+        throw JSONRPCError(RPC_MISC_ERROR, "Masternode tx index is still in the process of being built.");
+    }
+
+    // One entry more than requested tells where the next page starts
+    std::string const key = request.params[0].get_str();
+    std::vector<CMasternodeTxIndexEntry> entries;
+    bool found;
+    if (IsHex(key) && key.size() == 64)
+    {
+        found = g_masternodetxindex->FindTxs(ParseHashV(request.params[0], "key"), height, txn, limit + 1, entries);
+    }
+    else
+    {
+        CTxDestination dest = DecodeDestination(key);
+        CKeyID address;
+        if (dest.which() == 1)
+        {
+            address = CKeyID(*boost::get<PKHash>(&dest));
+        }
+        else if (dest.which() == 4)
+        {
+            address = CKeyID(*boost::get<WitnessV0KeyHash>(&dest));
+        }
+        else
+        {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Key must be a 64 character hex hash or a P2PKH/P2WPKH address");
+        }
+        found = g_masternodetxindex->FindTxs(address, height, txn, limit + 1, entries);
+    }
+    if (!found)
+    {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read masternode tx index");
+    }
+
+    UniValue txs(UniValue::VARR);
+    for (size_t i = 0; i < entries.size() && i < (size_t)limit; ++i)
+    {
+        UniValue tx(UniValue::VOBJ);
+        tx.pushKV("txid", entries[i].txid.GetHex());
+        tx.pushKV("type", MasternodeTxKindName(entries[i].kind));
+        tx.pushKV("height", entries[i].height);
+        tx.pushKV("txn", (uint64_t)entries[i].txn);
+        txs.push_back(tx);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("txs", txs);
+    if (entries.size() > (size_t)limit)
+    {
+        UniValue next(UniValue::VOBJ);
+        next.pushKV("height", entries.back().height);
+        next.pushKV("txn", (uint64_t)entries.back().txn);
+        ret.pushKV("next", next);
+    }
+    return ret;
+}
+
 
 static const CRPCCommand commands[] =
 { //  category          name                        actor (function)            params
@@ -452,6 +568,7 @@ static const CRPCCommand commands[] =
   { "masternodes",      "resignmasternode",         &resignmasternode,          { "inputs", "mn_id" }  },
   { "masternodes",      "listmasternodes",          &listmasternodes,           { "list", "verbose" } },
   { "masternodes",      "listcriminalproofs",       &listcriminalproofs,        { } },
+  { "masternodes",      "listmasternodetxs",        &listmasternodetxs,         { "key", "pagination" } },
 };
 
 void RegisterMasternodesRPCCommands(CRPCTable &tableRPC)
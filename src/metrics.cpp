@@ -0,0 +1,185 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <metrics.h>
+
+#include <httpserver.h>
+#include <rpc/protocol.h>
+#include <tinyformat.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <mutex>
+#include <string.h>
+#include <vector>
+
+namespace metrics {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    //! In registration order, which is the rendering order of the names.
+    std::vector<const Metric*> metrics;
+};
+
+Registry& GetRegistry()
+{
+    // Never destroyed, metrics with static storage unregister during static destruction.
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+const char* TypeName(Type type)
+{
+    switch (type) {
+    case Type::COUNTER: return "counter";
+    case Type::GAUGE: return "gauge";
+    case Type::HISTOGRAM: return "histogram";
+    }
+    assert(false);
+}
+
+/** A sample line, with the labels of the series and an optional extra label. */
+void RenderSample(std::string& out, const Metric& metric, const char* suffix, const std::string& extra_label, const std::string& value)
+{
+    out += metric.m_name;
+    out += suffix;
+    if (metric.m_labels || !extra_label.empty()) {
+        out += '{';
+        if (metric.m_labels) out += metric.m_labels;
+        if (metric.m_labels && !extra_label.empty()) out += ',';
+        out += extra_label;
+        out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+
+std::string FormatSeconds(int64_t micros)
+{
+    return strprintf("%g", micros / 1e6);
+}
+
+bool MetricsHandler(HTTPRequest* req, const std::string&)
+{
+    if (req->GetRequestMethod() != HTTPRequest::GET) {
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_BAD_METHOD, "Only GET is supported\r\n");
+        return false;
+    }
+    req->WriteHeader("Content-Type", "text/plain; version=0.0.4");
+    req->WriteReply(HTTP_OK, Render());
+    return true;
+}
+
+} // namespace
+
+Metric::Metric(const char* name, const char* help, Type type, const char* labels) : m_name(name), m_help(help), m_type(type), m_labels(labels)
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.metrics.push_back(this);
+}
+
+Metric::~Metric()
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.metrics.erase(std::find(registry.metrics.begin(), registry.metrics.end(), this));
+}
+
+void Counter::Render(std::string& out) const
+{
+    RenderSample(out, *this, "", "", std::to_string(Value()));
+}
+
+void Gauge::Render(std::string& out) const
+{
+    RenderSample(out, *this, "", "", std::to_string(Value()));
+}
+
+const int64_t DurationHistogram::BUCKET_BOUNDS[BUCKETS] = {
+    1000, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 5000000, 10000000, 30000000, 60000000,
+};
+
+void DurationHistogram::Observe(int64_t micros)
+{
+    const size_t bucket = std::lower_bound(BUCKET_BOUNDS, BUCKET_BOUNDS + BUCKETS, micros) - BUCKET_BOUNDS;
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_sum_micros.fetch_add(micros, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DurationHistogram::Render(std::string& out) const
+{
+    // The buckets and the count are read one by one, so a concurrent Observe
+    // may be missing from some of them. Clamp to keep the buckets cumulative.
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        cumulative += m_buckets[i].load(std::memory_order_relaxed);
+        RenderSample(out, *this, "_bucket", strprintf("le=\"%s\"", FormatSeconds(BUCKET_BOUNDS[i])), std::to_string(cumulative));
+    }
+    cumulative += m_buckets[BUCKETS].load(std::memory_order_relaxed);
+    const uint64_t count = std::max(cumulative, Count());
+    RenderSample(out, *this, "_bucket", "le=\"+Inf\"", std::to_string(count));
+    RenderSample(out, *this, "_sum", "", strprintf("%.6f", m_sum_micros.load(std::memory_order_relaxed) / 1e6));
+    RenderSample(out, *this, "_count", "", std::to_string(count));
+}
+
+std::string Render()
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::string out;
+    std::vector<const Metric*> rendered;
+    for (const Metric* first : registry.metrics) {
+        if (std::find(rendered.begin(), rendered.end(), first) != rendered.end()) continue;
+        out += strprintf("# HELP %s %s\n# TYPE %s %s\n", first->m_name, first->m_help, first->m_name, TypeName(first->m_type));
+        // All the series of a name go under its HELP and TYPE lines.
+        for (const Metric* metric : registry.metrics) {
+            if (strcmp(metric->m_name, first->m_name) != 0) continue;
+            metric->Render(out);
+            rendered.push_back(metric);
+        }
+    }
+    return out;
+}
+
+DurationHistogram block_connect{"defi_block_connect_seconds", "Time to connect a block to the tip, including flushing it"};
+Gauge tip_height{"defi_tip_height", "Height of the active chain tip"};
+Gauge mempool_transactions{"defi_mempool_transactions", "Number of transactions in the mempool"};
+Gauge mempool_bytes{"defi_mempool_bytes", "Sum of the virtual sizes of the mempool transactions"};
+Gauge peers_inbound{"defi_peers", "Number of connected peers", "direction=\"inbound\""};
+Gauge peers_outbound{"defi_peers", "Number of connected peers", "direction=\"outbound\""};
+Gauge coins_cache_usage{"defi_coins_cache_usage_bytes", "Memory usage of the UTXO cache, as of the last flush check"};
+Gauge masternodes[MASTERNODE_STATES] = {
+    {"defi_masternodes", "Number of masternodes by state at the tip", "state=\"PRE_ENABLED\""},
+    {"defi_masternodes", "Number of masternodes by state at the tip", "state=\"ENABLED\""},
+    {"defi_masternodes", "Number of masternodes by state at the tip", "state=\"PRE_RESIGNED\""},
+    {"defi_masternodes", "Number of masternodes by state at the tip", "state=\"RESIGNED\""},
+    {"defi_masternodes", "Number of masternodes by state at the tip", "state=\"PRE_BANNED\""},
+    {"defi_masternodes", "Number of masternodes by state at the tip", "state=\"BANNED\""},
+};
+Gauge anchor_height{"defi_anchor_height", "DeFi height anchored by the active anchor, 0 without one"};
+Gauge anchor_confirmations{"defi_anchor_confirmations", "Bitcoin confirmations of the active anchor"};
+Gauge spv_height{"defi_spv_height", "Height of the last Bitcoin block seen by the SPV client"};
+
+void StartMetrics()
+{
+    RegisterHTTPHandler("/metrics", true, MetricsHandler);
+    g_enabled = true;
+}
+
+void StopMetrics()
+{
+    g_enabled = false;
+    UnregisterHTTPHandler("/metrics", true);
+}
+
+} // namespace metrics
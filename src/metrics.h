@@ -0,0 +1,130 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_METRICS_H
+#define DEFI_METRICS_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/**
+ * Node metrics in the Prometheus text exposition format, served at /metrics.
+ *
+ * Every metric is a set of relaxed atomics written by the code that owns the
+ * value (block connection, the mempool, the connection manager...), so that
+ * keeping them current costs a store on the hot path and a scrape never takes
+ * a node lock.
+ */
+namespace metrics {
+
+static const bool DEFAULT_METRICS_ENABLE = false;
+
+/** Whether the metrics are served. Metrics that are costly to compute are only updated while they are. */
+extern std::atomic<bool> g_enabled;
+
+enum class Type { COUNTER, GAUGE, HISTOGRAM };
+
+/** A time series, registered for rendering for as long as it lives. */
+class Metric
+{
+public:
+    /** The name, help and labels (e.g. state="ENABLED") must be string literals. */
+    Metric(const char* name, const char* help, Type type, const char* labels = nullptr);
+    virtual ~Metric();
+
+    Metric(const Metric&) = delete;
+    Metric& operator=(const Metric&) = delete;
+
+    const char* const m_name;
+    const char* const m_help;
+    const Type m_type;
+    const char* const m_labels;
+
+    /** Append the sample lines of this series. */
+    virtual void Render(std::string& out) const = 0;
+};
+
+class Counter : public Metric
+{
+public:
+    Counter(const char* name, const char* help, const char* labels = nullptr) : Metric(name, help, Type::COUNTER, labels) {}
+
+    void Inc(uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t Value() const { return m_value.load(std::memory_order_relaxed); }
+
+    void Render(std::string& out) const override;
+
+private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+class Gauge : public Metric
+{
+public:
+    Gauge(const char* name, const char* help, const char* labels = nullptr) : Metric(name, help, Type::GAUGE, labels) {}
+
+    void Set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    void Add(int64_t n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t Value() const { return m_value.load(std::memory_order_relaxed); }
+
+    void Render(std::string& out) const override;
+
+private:
+    std::atomic<int64_t> m_value{0};
+};
+
+/** Durations bucketed by fixed upper bounds, rendered in seconds. */
+class DurationHistogram : public Metric
+{
+public:
+    static const size_t BUCKETS = 14;
+    //! Upper bounds of the buckets in microseconds, from 1ms to 60s.
+    static const int64_t BUCKET_BOUNDS[BUCKETS];
+
+    DurationHistogram(const char* name, const char* help, const char* labels = nullptr) : Metric(name, help, Type::HISTOGRAM, labels) {}
+
+    void Observe(int64_t micros);
+    uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+
+    void Render(std::string& out) const override;
+
+private:
+    //! Non-cumulative, summed up while rendering.
+    std::atomic<uint64_t> m_buckets[BUCKETS + 1] = {};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<int64_t> m_sum_micros{0};
+};
+
+/** The samples of all live metrics, with the HELP and TYPE lines of each name. */
+std::string Render();
+
+/** Number of CMasternode::State values, one masternodes gauge each. */
+static const size_t MASTERNODE_STATES = 6;
+
+extern DurationHistogram block_connect;
+extern Gauge tip_height;
+extern Gauge mempool_transactions;
+extern Gauge mempool_bytes;
+extern Gauge peers_inbound;
+extern Gauge peers_outbound;
+extern Gauge coins_cache_usage;
+extern Gauge masternodes[MASTERNODE_STATES];
+extern Gauge anchor_height;
+extern Gauge anchor_confirmations;
+extern Gauge spv_height;
+
+/** Serve the metrics at /metrics on the HTTP server.
+ * Precondition; HTTP has been started.
+ */
+void StartMetrics();
+/** Stop serving the metrics.
+ * Precondition; HTTP has been stopped.
+ */
+void StopMetrics();
+
+} // namespace metrics
+
+#endif // DEFI_METRICS_H
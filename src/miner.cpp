@@ -24,6 +24,7 @@
 #include <script/standard.h>
 #include <util/moneystr.h>
 #include <util/system.h>
+#include <util/tracing.h>
 #include <util/validation.h>
 
 #include <algorithm>
@@ -545,7 +546,11 @@ void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned
 }
 
 namespace pos {
+    /** Number of coinstake times whose kernels are hashed together while searching. */
+    static const int64_t KERNEL_SEARCH_BATCH = 64;
+
     Staker::Status Staker::stake(CChainParams chainparams, const ThreadStaker::Args& args) {
+        TRACE_SPAN(span, "Staker::stake", "staking");
         if (!chainparams.GetConsensus().pos.allowMintingWithoutPeers) {
             if(!g_connman)
                 throw std::runtime_error("Error: Peer-to-peer functionality missing or disabled");
@@ -621,17 +626,25 @@ namespace pos {
             pblock->mintedBlocks = mintedBlocks + 1;
             pblock->stakeModifier = pos::ComputeStakeModifier(tip->stakeModifier, args.minterKey.GetPubKey().GetID());
 
+            // The kernels of consecutive times are hashed in batches, newest first
             bool found = false;
-            for (uint32_t t = 0; t < nSearchInterval; t++) {
+            std::vector<int64_t> times;
+            for (int64_t t = 0; t < nSearchInterval && !found; t += KERNEL_SEARCH_BATCH) {
                 boost::this_thread::interruption_point();
 
-                pblock->nTime = ((uint32_t)coinstakeTime - t);
-
-                if (pos::CheckKernelHash(pblock->stakeModifier, pblock->nBits,  (int64_t) pblock->nTime, chainparams.GetConsensus(), args.masternodeID).hashOk) {
-                    LogPrint(BCLog::STAKING, "MakeStake: kernel found\n");
-
-                    found = true;
-                    break;
+                times.clear();
+                for (int64_t i = t; i < std::min<int64_t>(t + KERNEL_SEARCH_BATCH, nSearchInterval); i++) {
+                    times.push_back((uint32_t)coinstakeTime - (uint32_t)i);
+                }
+                const std::vector<uint256> hashes = pos::CalcKernelHashes(pblock->stakeModifier, times, args.masternodeID, chainparams.GetConsensus());
+                for (size_t i = 0; i < hashes.size(); i++) {
+                    if (pos::CheckKernelHash(hashes[i], pblock->nBits).hashOk) {
+                        LogPrint(BCLog::STAKING, "MakeStake: kernel found\n");
+
+                        pblock->nTime = times[i];
+                        found = true;
+                        break;
+                    }
                 }
             }
 
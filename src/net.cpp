@@ -15,6 +15,7 @@
 #include <consensus/consensus.h>
 #include <crypto/common.h>
 #include <crypto/sha256.h>
+#include <metrics.h>
 #include <netbase.h>
 #include <net_permissions.h>
 #include <primitives/transaction.h>
@@ -1060,10 +1061,16 @@ void CConnman::DisconnectNodes()
 void CConnman::NotifyNumConnectionsChanged()
 {
     size_t vNodesSize;
+    size_t nInbound = 0;
     {
         LOCK(cs_vNodes);
         vNodesSize = vNodes.size();
+        for (const CNode* pnode : vNodes) {
+            if (pnode->fInbound) nInbound++;
+        }
     }
+    metrics::peers_inbound.Set(nInbound);
+    metrics::peers_outbound.Set(vNodesSize - nInbound);
     if(vNodesSize != nPrevNodeCount) {
         nPrevNodeCount = vNodesSize;
         if(clientInterface)
@@ -2277,7 +2284,7 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     threadMessageHandler = std::thread(&TraceThread<std::function<void()> >, "msghand", std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this)));
 
     // Dump network addresses
-    scheduler.scheduleEvery(std::bind(&CConnman::DumpAddresses, this), DUMP_PEERS_INTERVAL * 1000);
+    scheduler.scheduleEvery(std::bind(&CConnman::DumpAddresses, this), DUMP_PEERS_INTERVAL * 1000, "maintenance");
 
     return true;
 }
@@ -0,0 +1 @@
+#define BUILD_SUFFIX 1da6984-dirty
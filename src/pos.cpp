@@ -8,6 +8,7 @@
 #include <logging.h>
 #include <masternodes/masternodes.h>
 #include <sync.h>
+#include <validation.h>
 
 extern RecursiveMutex cs_main;
 
@@ -19,7 +20,7 @@ bool CheckStakeModifier(const CBlockIndex* pindexPrev, const CBlockHeader& block
 
     /// @todo is it possible to pass minter key here, or we really need to extract it srom sig???
     CKeyID key;
-    if (!blockHeader.ExtractMinterKey(key)) {
+    if (!GetMinterKey(blockHeader, key)) {
         LogPrintf("CheckStakeModifier: Can't extract minter key\n");
         return false;
     }
@@ -37,8 +38,8 @@ bool CheckHeaderSignature(const CBlockHeader& blockHeader) {
         return false;
     }
 
-    CPubKey recoveredPubKey{};
-    if (!recoveredPubKey.RecoverCompact(blockHeader.GetHashToSign(), blockHeader.sig)) {
+    CKeyID minter;
+    if (!GetMinterKey(blockHeader, minter)) {
         LogPrintf("CheckBlockSignature: Bad Block - malformed signature\n");
         return false;
     }
@@ -53,7 +54,7 @@ bool ContextualCheckProofOfStake(const CBlockHeader& blockHeader, const Consensu
     }
 
     CKeyID minter;
-    if (!blockHeader.ExtractMinterKey(minter)) {
+    if (!GetMinterKey(blockHeader, minter)) {
         return false;
     }
     uint256 masternodeID;
@@ -1,6 +1,7 @@
 #include <pos_kernel.h>
 #include <amount.h>
 #include <arith_uint256.h>
+#include <hash.h>
 #include <key.h>
 
 extern CAmount GetMnCollateralAmount(); // from masternodes.h
@@ -13,14 +14,31 @@ namespace pos {
         return Hash(ss.begin(), ss.end());
     }
 
+    std::vector<uint256>
+    CalcKernelHashes(const uint256& stakeModifier, const std::vector<int64_t>& coinstakeTimes, const uint256& masternodeID, const Consensus::Params& params) {
+        // Serialize all kernels back to back, they only differ by their time
+        CDataStream ss(SER_GETHASH, 0);
+        std::vector<size_t> ends;
+        for (int64_t coinstakeTime : coinstakeTimes) {
+            ss << stakeModifier << coinstakeTime << GetMnCollateralAmount() << masternodeID;
+            ends.push_back(ss.size());
+        }
+        std::vector<Span<const unsigned char>> kernels;
+        size_t begin = 0;
+        for (size_t end : ends) {
+            kernels.emplace_back(reinterpret_cast<const unsigned char*>(ss.data()) + begin, end - begin);
+            begin = end;
+        }
+        return HashBatch(kernels);
+    }
+
     CheckKernelHashRes
-    CheckKernelHash(uint256 stakeModifier, uint32_t nBits, int64_t coinstakeTime, const Consensus::Params& params, uint256 masternodeID) {
+    CheckKernelHash(const uint256& hash, uint32_t nBits) {
         // Base target
         arith_uint256 targetProofOfStake;
         targetProofOfStake.SetCompact(nBits);
 
-        const arith_uint256 hashProofOfStake = UintToArith256(
-                CalcKernelHash(stakeModifier, coinstakeTime, masternodeID, params));
+        const arith_uint256 hashProofOfStake = UintToArith256(hash);
 
         // Now check if proof-of-stake hash meets target protocol
         if ((hashProofOfStake / (uint64_t) GetMnCollateralAmount()) > targetProofOfStake) {
@@ -30,6 +48,11 @@ namespace pos {
         return {true, hashProofOfStake};
     }
 
+    CheckKernelHashRes
+    CheckKernelHash(uint256 stakeModifier, uint32_t nBits, int64_t coinstakeTime, const Consensus::Params& params, uint256 masternodeID) {
+        return CheckKernelHash(CalcKernelHash(stakeModifier, coinstakeTime, masternodeID, params), nBits);
+    }
+
     uint256 ComputeStakeModifier(uint256 prevStakeModifier, const CKeyID& key) {
         // Calculate hash
         CDataStream ss(SER_GETHASH, 0);
@@ -7,6 +7,8 @@
 #include <streams.h>
 #include <amount.h>
 
+#include <vector>
+
 class CWallet;
 
 class COutPoint;
@@ -32,6 +34,14 @@ namespace pos {
     uint256
     CalcKernelHash(uint256 stakeModifier, int64_t coinstakeTime, uint256 masternodeID, const Consensus::Params& params);
 
+/// Calculate the PoS kernel hashes of several coinstake times at once
+    std::vector<uint256>
+    CalcKernelHashes(const uint256& stakeModifier, const std::vector<int64_t>& coinstakeTimes, const uint256& masternodeID, const Consensus::Params& params);
+
+/// Check whether a kernel hash, as returned by CalcKernelHash, meets hash target
+    CheckKernelHashRes
+    CheckKernelHash(const uint256& hash, uint32_t nBits);
+
 /// Check whether stake kernel meets hash target
 /// Sets hashProofOfStake, hashOk is true of the kernel meets hash target
     CheckKernelHashRes
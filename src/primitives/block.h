@@ -120,7 +120,7 @@ public:
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {
         READWRITEAS(CBlockHeader, *this);
-        READWRITE(vtx);
+        SerializeTransactions(s, ser_action);
     }
 
     void SetNull()
@@ -147,6 +147,22 @@ public:
     }
 
     std::string ToString() const;
+
+private:
+    template <typename Stream>
+    void SerializeTransactions(Stream& s, CSerActionSerialize) const
+    {
+        s << vtx;
+    }
+
+    template <typename Stream>
+    void SerializeTransactions(Stream& s, CSerActionUnserialize)
+    {
+        // Read them whole first, to hash all the txids and wtxids as a batch.
+        std::vector<CMutableTransaction> txs;
+        s >> txs;
+        vtx = MakeTransactionRefs(std::move(txs));
+    }
 };
 
 /** Describes a place in the block chain to another node such that if the
@@ -6,6 +6,7 @@
 #include <primitives/transaction.h>
 
 #include <hash.h>
+#include <streams.h>
 #include <tinyformat.h>
 #include <util/strencodings.h>
 
@@ -79,6 +80,58 @@ uint256 CTransaction::ComputeWitnessHash() const
 CTransaction::CTransaction() : vin(), vout(), nVersion(CTransaction::CURRENT_VERSION), nLockTime(0), hash{}, m_witness_hash{} {}
 CTransaction::CTransaction(const CMutableTransaction& tx) : vin(tx.vin), vout(tx.vout), nVersion(tx.nVersion), nLockTime(tx.nLockTime), hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()} {}
 CTransaction::CTransaction(CMutableTransaction&& tx) : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion), nLockTime(tx.nLockTime), hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()} {}
+CTransaction::CTransaction(CMutableTransaction&& tx, const uint256& hashIn, const uint256& witnessHashIn) : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion), nLockTime(tx.nLockTime), hash{hashIn}, m_witness_hash{witnessHashIn} {}
+
+std::vector<CTransactionRef> MakeTransactionRefs(std::vector<CMutableTransaction>&& txs)
+{
+    // Serialize every transaction the way its hashes commit to it, into one buffer:
+    // without witness for the txid, and with it for the wtxid if it has any. The sizes
+    // come first, so that the buffer is allocated once however many transactions there are.
+    std::vector<std::pair<size_t, size_t>> ranges;
+    ranges.reserve(txs.size());
+    std::vector<size_t> witness_index(txs.size());
+    size_t total = 0;
+    for (const CMutableTransaction& tx : txs) {
+        const size_t size = ::GetSerializeSize(tx, SERIALIZE_TRANSACTION_NO_WITNESS);
+        ranges.emplace_back(total, size);
+        total += size;
+    }
+    for (size_t i = 0; i < txs.size(); ++i) {
+        witness_index[i] = i;
+        if (txs[i].HasWitness()) {
+            const size_t size = ::GetSerializeSize(txs[i], 0);
+            witness_index[i] = ranges.size();
+            ranges.emplace_back(total, size);
+            total += size;
+        }
+    }
+
+    std::vector<unsigned char> data;
+    data.reserve(total);
+    CVectorWriter no_witness{SER_GETHASH, SERIALIZE_TRANSACTION_NO_WITNESS, data, 0};
+    for (const CMutableTransaction& tx : txs) {
+        no_witness << tx;
+    }
+    CVectorWriter witness{SER_GETHASH, 0, data, data.size()};
+    for (const CMutableTransaction& tx : txs) {
+        if (tx.HasWitness()) witness << tx;
+    }
+    assert(data.size() == total);
+
+    std::vector<Span<const unsigned char>> inputs;
+    inputs.reserve(ranges.size());
+    for (const auto& range : ranges) {
+        inputs.emplace_back(data.data() + range.first, range.second);
+    }
+    const std::vector<uint256> hashes = HashBatch(inputs);
+
+    std::vector<CTransactionRef> result;
+    result.reserve(txs.size());
+    for (size_t i = 0; i < txs.size(); ++i) {
+        result.push_back(std::make_shared<const CTransaction>(std::move(txs[i]), hashes[i], hashes[witness_index[i]]));
+    }
+    return result;
+}
 
 CAmount CTransaction::GetValueOut() const
 {
@@ -311,6 +311,8 @@ public:
     /** Convert a CMutableTransaction into a CTransaction. */
     explicit CTransaction(const CMutableTransaction &tx);
     CTransaction(CMutableTransaction &&tx);
+    /** Convert a CMutableTransaction whose hash and witness hash are already known. */
+    CTransaction(CMutableTransaction &&tx, const uint256& hashIn, const uint256& witnessHashIn);
 
     template <typename Stream>
     inline void Serialize(Stream& s) const {
@@ -423,4 +425,7 @@ typedef std::shared_ptr<const CTransaction> CTransactionRef;
 static inline CTransactionRef MakeTransactionRef() { return std::make_shared<const CTransaction>(); }
 template <typename Tx> static inline CTransactionRef MakeTransactionRef(Tx&& txIn) { return std::make_shared<const CTransaction>(std::forward<Tx>(txIn)); }
 
+/** Convert the transactions of a block, hashing them as a batch. */
+std::vector<CTransactionRef> MakeTransactionRefs(std::vector<CMutableTransaction>&& txs);
+
 #endif // DEFI_PRIMITIVES_TRANSACTION_H
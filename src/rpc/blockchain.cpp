@@ -134,7 +134,7 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
     result.pushKV("height", blockindex->nHeight);
 
     CKeyID minter;
-    block.ExtractMinterKey(minter);
+    GetMinterKey(block, minter);
     result.pushKV("minter", minter.ToString());
     result.pushKV("mintedBlocks", blockindex->mintedBlocks);
     result.pushKV("stakeModifier", blockindex->stakeModifier.ToString());
@@ -357,6 +357,48 @@ static UniValue syncwithvalidationinterfacequeue(const JSONRPCRequest& request)
     return NullUniValue;
 }
 
+static UniValue getvalidationqueueinfo(const JSONRPCRequest& request)
+{
+            RPCHelpMan{"getvalidationqueueinfo",
+                "\nReturns the state of the queues that deliver validation notifications to the wallets, indexes and other subscribers.\n",
+                {},
+                RPCResult{
+            "[\n"
+            "  {\n"
+            "    \"name\": \"xxxx\",          (string) The queue name, \"shared\" for the subscribers without a queue of their own\n"
+            "    \"lossy\": true|false,     (boolean) Whether notifications are dropped when the queue is full\n"
+            "    \"max_size\": n,           (numeric) The number of pending notifications above which the queue is full\n"
+            "    \"pending\": n,            (numeric) The number of pending notifications\n"
+            "    \"peak\": n,               (numeric) The most notifications ever pending at once\n"
+            "    \"processed\": n,          (numeric) The number of notifications processed\n"
+            "    \"dropped\": n,            (numeric) The number of notifications dropped\n"
+            "    \"wait_time\": n,          (numeric) The total time in seconds block connection waited for the queue\n"
+            "  },\n"
+            "  ...\n"
+            "]\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getvalidationqueueinfo", "")
+            + HelpExampleRpc("getvalidationqueueinfo", "")
+                },
+            }.Check(request);
+
+    UniValue ret(UniValue::VARR);
+    for (const ValidationInterfaceQueueStats& stats : GetMainSignals().GetQueueStats()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("name", stats.name);
+        obj.pushKV("lossy", stats.lossy);
+        obj.pushKV("max_size", (uint64_t)stats.max_size);
+        obj.pushKV("pending", (uint64_t)stats.pending);
+        obj.pushKV("peak", (uint64_t)stats.peak);
+        obj.pushKV("processed", stats.processed);
+        obj.pushKV("dropped", stats.dropped);
+        obj.pushKV("wait_time", stats.wait_micros / 1e6);
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
 static UniValue getdifficulty(const JSONRPCRequest& request)
 {
             RPCHelpMan{"getdifficulty",
@@ -2271,6 +2313,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "preciousblock",          &preciousblock,          {"blockhash"} },
     { "blockchain",         "scantxoutset",           &scantxoutset,           {"action", "scanobjects"} },
     { "blockchain",         "getblockfilter",         &getblockfilter,         {"blockhash", "filtertype"} },
+    { "blockchain",         "getvalidationqueueinfo", &getvalidationqueueinfo, {} },
 
     /* Not shown in help */
     { "hidden",             "invalidateblock",        &invalidateblock,        {"blockhash"} },
@@ -28,6 +28,11 @@ public:
 static const CRPCConvertParam vRPCConvertParams[] =
 {
     { "setmocktime", 0, "timestamp" },
+    { "getaddressbalance", 0, "addresses" },
+    { "getaddresstxids", 0, "addresses" },
+    { "getaddresstxids", 1, "start" },
+    { "getaddresstxids", 2, "end" },
+    { "getspentinfo", 1, "index" },
     { "utxoupdatepsbt", 1, "descriptors" },
     { "generatetoaddress", 0, "nblocks" },
     { "generatetoaddress", 2, "maxtries" },
@@ -148,6 +153,11 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "getmempoolancestors", 1, "verbose" },
     { "getmempooldescendants", 1, "verbose" },
     { "bumpfee", 1, "options" },
+    { "dumptrace", 0, "reset" },
+    { "dumptrace", 1, "enable" },
+    { "getlockstats", 0, "count" },
+    { "getlockstats", 1, "reset" },
+    { "getlockstats", 2, "enable" },
     { "logging", 0, "include" },
     { "logging", 1, "exclude" },
     { "disconnectnode", 1, "nodeid" },
@@ -175,6 +185,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "resignmasternode", 1, "mn_id" },
     { "listmasternodes", 0, "list" },
     { "listmasternodes", 1, "verbose" },
+    { "listmasternodetxs", 1, "pagination" },
 
     { "spv_sendrawtx", 0, "rawtx" },
     { "spv_createanchor", 0, "inputs" },
@@ -4,17 +4,28 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <core_io.h>
 #include <crypto/ripemd160.h>
 #include <httpserver.h>
+#include <index/addressindex.h>
+#include <index/blockfilterindex.h>
+#include <index/masternodetxindex.h>
+#include <index/txindex.h>
+#include <key_io.h>
 #include <outputtype.h>
+#include <policy/feerate.h>
 #include <rpc/blockchain.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <script/descriptor.h>
+#include <sync.h>
 #include <util/system.h>
 #include <util/strencodings.h>
+#include <util/tracing.h>
 #include <util/validation.h>
+#include <validation.h>
 
+#include <set>
 #include <stdint.h>
 #include <tuple>
 #ifdef HAVE_MALLOC_INFO
@@ -379,6 +390,15 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCBlockIndexMemoryInfo()
+{
+    LOCK(cs_main);
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("entries", uint64_t(::BlockIndex().size()));
+    obj.pushKV("usage", uint64_t(BlockIndexMemoryUsage()));
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -420,6 +440,10 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"blockindex\": {           (json object) Information about the block index\n"
+            "    \"entries\": xxxxx,       (numeric) Number of block index entries\n"
+            "    \"usage\": xxxxx,         (numeric) Number of bytes used by the entries and their lookup map\n"
             "  }\n"
             "}\n"
                     },
@@ -437,6 +461,7 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("blockindex", RPCBlockIndexMemoryInfo());
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -449,6 +474,177 @@ static UniValue getmemoryinfo(const JSONRPCRequest& request)
     }
 }
 
+static UniValue LockDurationToJSON(uint64_t total, uint64_t max, const std::vector<uint64_t>& histogram)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("total", total);
+    obj.pushKV("max", max);
+    UniValue buckets(UniValue::VARR);
+    for (uint64_t count : histogram) {
+        buckets.push_back(count);
+    }
+    obj.pushKV("histogram", buckets);
+    return obj;
+}
+
+static UniValue getlockstats(const JSONRPCRequest& request)
+{
+            RPCHelpMan{"getlockstats",
+                "Returns wait and hold times of the locks taken at each source location, most waited for first.\n"
+                "Locks are only profiled while enabled, see -lockstats.\n"
+                "Durations are in microseconds. Histogram bucket i counts the durations below 2^i microseconds,\n"
+                "the last bucket all longer ones. Hold times of locks used to wait on a condition include the waiting.\n",
+                {
+                    {"count", RPCArg::Type::NUM, /* default */ "20", "The number of lock sites to return, 0 for all"},
+                    {"reset", RPCArg::Type::BOOL, /* default */ "false", "Reset the statistics after returning them"},
+                    {"enable", RPCArg::Type::BOOL, RPCArg::Optional::OMITTED_NAMED_ARG, "Turn lock profiling on or off"},
+                },
+                RPCResult{
+            "{\n"
+            "  \"enabled\": true|false,       (boolean) Whether locks are being profiled\n"
+            "  \"sites\": [                   (json array)\n"
+            "    {\n"
+            "      \"lock\": \"name\",          (string) The lock as written at the site, e.g. cs_main\n"
+            "      \"site\": \"file:line\",     (string) The source location taking the lock\n"
+            "      \"acquired\": n,           (numeric) Number of times the lock was taken\n"
+            "      \"contended\": n,          (numeric) Number of times the lock was held by another thread\n"
+            "      \"try_failed\": n,         (numeric) Number of failed TRY_LOCK attempts\n"
+            "      \"wait\": {                (json object) Time spent waiting for the lock\n"
+            "        \"total\": n,            (numeric) Sum of all waits\n"
+            "        \"max\": n,              (numeric) The longest wait\n"
+            "        \"histogram\": [n,...]   (json array) Number of waits per duration bucket\n"
+            "      },\n"
+            "      \"hold\": {...}            (json object) Time the lock was held, same fields as wait\n"
+            "    },\n"
+            "    ...\n"
+            "  ]\n"
+            "}\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getlockstats", "")
+            + HelpExampleCli("getlockstats", "0 true")
+            + HelpExampleRpc("getlockstats", "10, false, true")
+                },
+            }.Check(request);
+
+    RPCTypeCheck(request.params, {UniValue::VNUM, UniValue::VBOOL, UniValue::VBOOL});
+    const int count = request.params[0].isNull() ? 20 : request.params[0].get_int();
+    if (count < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "count must not be negative");
+    }
+    const bool reset = !request.params[1].isNull() && request.params[1].get_bool();
+
+    std::vector<LockSiteStats> stats = GetLockStats();
+    if (reset) ResetLockStats();
+    if (!request.params[2].isNull()) {
+        g_lock_stats_enabled = request.params[2].get_bool();
+    }
+
+    std::sort(stats.begin(), stats.end(), [](const LockSiteStats& a, const LockSiteStats& b) {
+        return std::tie(b.wait_total_micros, b.hold_total_micros) < std::tie(a.wait_total_micros, a.hold_total_micros);
+    });
+    if (count > 0 && stats.size() > (size_t)count) stats.resize(count);
+
+    UniValue sites(UniValue::VARR);
+    for (const LockSiteStats& site : stats) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("lock", site.name);
+        obj.pushKV("site", strprintf("%s:%d", site.file, site.line));
+        obj.pushKV("acquired", site.acquired);
+        obj.pushKV("contended", site.contended);
+        obj.pushKV("try_failed", site.try_failed);
+        obj.pushKV("wait", LockDurationToJSON(site.wait_total_micros, site.wait_max_micros, site.wait_histogram));
+        obj.pushKV("hold", LockDurationToJSON(site.hold_total_micros, site.hold_max_micros, site.hold_histogram));
+        sites.push_back(obj);
+    }
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("enabled", g_lock_stats_enabled.load());
+    result.pushKV("sites", sites);
+    return result;
+}
+
+static UniValue dumptrace(const JSONRPCRequest& request)
+{
+            RPCHelpMan{"dumptrace",
+                "Returns the buffered tracing spans in Chrome trace event format, to be saved to a file and\n"
+                "opened in chrome://tracing or Perfetto. Spans are only recorded while tracing is enabled, see -tracing.\n"
+                "Each thread keeps its last " + std::to_string(tracing::TRACE_BUFFER_SPANS) + " spans.\n",
+                {
+                    {"reset", RPCArg::Type::BOOL, /* default */ "false", "Discard the spans after returning them"},
+                    {"enable", RPCArg::Type::BOOL, RPCArg::Optional::OMITTED_NAMED_ARG, "Turn tracing on or off"},
+                },
+                RPCResult{
+            "{\n"
+            "  \"enabled\": true|false,       (boolean) Whether spans are being recorded\n"
+            "  \"displayTimeUnit\": \"ms\",\n"
+            "  \"traceEvents\": [             (json array) Thread names and complete events\n"
+            "    {\n"
+            "      \"name\": \"name\",          (string) The span, e.g. ConnectBlock\n"
+            "      \"cat\": \"category\",       (string) The subsystem, e.g. validation\n"
+            "      \"ph\": \"X\",               (string) \"X\" for a span, \"M\" for thread name metadata\n"
+            "      \"ts\": n,                 (numeric) Start in microseconds on a monotonic clock\n"
+            "      \"dur\": n,                (numeric) Duration in microseconds\n"
+            "      \"pid\": n,                (numeric) Always 0\n"
+            "      \"tid\": n,                (numeric) Thread index\n"
+            "      \"args\": {...}            (json object) Tags of the span, e.g. the block height\n"
+            "    },\n"
+            "    ...\n"
+            "  ]\n"
+            "}\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("dumptrace", "false true")
+            + HelpExampleCli("dumptrace", "true")
+            + HelpExampleRpc("dumptrace", "true")
+                },
+            }.Check(request);
+
+    RPCTypeCheck(request.params, {UniValue::VBOOL, UniValue::VBOOL});
+    const bool reset = !request.params[0].isNull() && request.params[0].get_bool();
+
+    const std::vector<tracing::ThreadTrace> traces = tracing::Collect();
+    if (reset) tracing::Reset();
+    if (!request.params[1].isNull()) {
+        tracing::g_enabled = request.params[1].get_bool();
+    }
+
+    UniValue events(UniValue::VARR);
+    for (const tracing::ThreadTrace& trace : traces) {
+        UniValue thread_name(UniValue::VOBJ);
+        thread_name.pushKV("name", "thread_name");
+        thread_name.pushKV("ph", "M");
+        thread_name.pushKV("pid", 0);
+        thread_name.pushKV("tid", (uint64_t)trace.thread_id);
+        UniValue thread_args(UniValue::VOBJ);
+        thread_args.pushKV("name", trace.thread_name.empty() ? strprintf("thread %u", trace.thread_id) : trace.thread_name);
+        thread_name.pushKV("args", thread_args);
+        events.push_back(thread_name);
+
+        for (const tracing::SpanRecord& span : trace.spans) {
+            UniValue event(UniValue::VOBJ);
+            event.pushKV("name", span.name);
+            event.pushKV("cat", span.category);
+            event.pushKV("ph", "X");
+            event.pushKV("ts", span.start_micros);
+            event.pushKV("dur", span.duration_micros);
+            event.pushKV("pid", 0);
+            event.pushKV("tid", (uint64_t)trace.thread_id);
+            UniValue args(UniValue::VOBJ);
+            for (int i = 0; i < tracing::MAX_SPAN_TAGS && span.tag_keys[i]; ++i) {
+                args.pushKV(span.tag_keys[i], span.tag_values[i]);
+            }
+            if (span.label_key) args.pushKV(span.label_key, std::string(span.label));
+            event.pushKV("args", args);
+            events.push_back(event);
+        }
+    }
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("enabled", tracing::g_enabled.load());
+    result.pushKV("displayTimeUnit", "ms");
+    result.pushKV("traceEvents", events);
+    return result;
+}
+
 static void EnableOrDisableLogCategories(UniValue cats, bool enable) {
     cats = cats.get_array();
     for (unsigned int i = 0; i < cats.size(); ++i) {
@@ -552,12 +748,234 @@ static UniValue echo(const JSONRPCRequest& request)
     return request.params;
 }
 
+static UniValue SummaryToJSON(const IndexSummary&& summary, std::string index_name)
+{
+    UniValue ret_summary(UniValue::VOBJ);
+    if (!index_name.empty() && index_name != summary.name) return ret_summary;
+
+    UniValue entry(UniValue::VOBJ);
+    entry.pushKV("synced", summary.synced);
+    entry.pushKV("best_block_height", summary.best_block_height);
+    entry.pushKV("sync_blocks_per_second", summary.sync_blocks_per_second);
+
+    ret_summary.pushKV(summary.name, entry);
+    return ret_summary;
+}
+
+static UniValue getindexinfo(const JSONRPCRequest& request)
+{
+            RPCHelpMan{"getindexinfo",
+                "\nReturns the status of one or all available indices currently running in the node.\n",
+                {
+                    {"index_name", RPCArg::Type::STR, RPCArg::Optional::OMITTED_NAMED_ARG, "Filter results for an index with a specific name."},
+                },
+                RPCResult{
+            "{\n"
+            "  \"name\" : {                      (json object) The name of the index\n"
+            "    \"synced\" : true|false,        (boolean) Whether the index is synced or not\n"
+            "    \"best_block_height\" : n,      (numeric) The block height to which the index is synced\n"
+            "    \"sync_blocks_per_second\" : x, (numeric) Average throughput of the background sync\n"
+            "  },\n"
+            "  ...\n"
+            "}\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getindexinfo", "")
+            + HelpExampleRpc("getindexinfo", "")
+            + HelpExampleCli("getindexinfo", "txindex")
+            + HelpExampleRpc("getindexinfo", "txindex")
+                },
+            }.Check(request);
+
+    UniValue result(UniValue::VOBJ);
+    const std::string index_name = request.params[0].isNull() ? "" : request.params[0].get_str();
+
+    if (g_txindex) {
+        result.pushKVs(SummaryToJSON(g_txindex->GetSummary(), index_name));
+    }
+    if (g_addressindex) {
+        result.pushKVs(SummaryToJSON(g_addressindex->GetSummary(), index_name));
+    }
+    if (g_masternodetxindex) {
+        result.pushKVs(SummaryToJSON(g_masternodetxindex->GetSummary(), index_name));
+    }
+    ForEachBlockFilterIndex([&result, &index_name](const BlockFilterIndex& index) {
+        result.pushKVs(SummaryToJSON(index.GetSummary(), index_name));
+    });
+
+    return result;
+}
+
+static AddressIndex& EnsureAddressIndex()
+{
+    if (!g_addressindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index is not enabled. Use -addressindex to enable it.");
+    }
+    if (!g_addressindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index is still in the process of being built.");
+    }
+    return *g_addressindex;
+}
+
+static std::vector<std::pair<AddressIndexType, uint160>> ParseIndexedAddresses(const UniValue& param)
+{
+    std::vector<std::pair<AddressIndexType, uint160>> addresses;
+    for (const UniValue& address : param.get_array().getValues()) {
+        CTxDestination dest = DecodeDestination(address.get_str());
+        AddressIndexType type;
+        uint160 hash;
+        if (!IsValidDestination(dest) || !GetAddressIndexKey(dest, type, hash)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid or unsupported address: " + address.get_str());
+        }
+        addresses.emplace_back(type, hash);
+    }
+    return addresses;
+}
+
+static UniValue getaddressbalance(const JSONRPCRequest& request)
+{
+            RPCHelpMan{"getaddressbalance",
+                "\nReturns the balance of the given addresses. Requires -addressindex.\n",
+                {
+                    {"addresses", RPCArg::Type::ARR, RPCArg::Optional::NO, "The defi addresses",
+                        {
+                            {"address", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "A defi address"},
+                        },
+                    },
+                },
+                RPCResult{
+            "{\n"
+            "  \"balance\" : x.xxx,     (numeric) The current balance in " + CURRENCY_UNIT + "\n"
+            "  \"received\" : x.xxx,    (numeric) The total amount received in " + CURRENCY_UNIT + ", including change\n"
+            "}\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getaddressbalance", "'[\"mfWxJ45yp2SFn7UciZyNpvDKrzbhyfKrY8\"]'")
+            + HelpExampleRpc("getaddressbalance", "[\"mfWxJ45yp2SFn7UciZyNpvDKrzbhyfKrY8\"]")
+                },
+            }.Check(request);
+
+    AddressIndex& index = EnsureAddressIndex();
+
+    CAmount balance = 0;
+    CAmount received = 0;
+    for (const auto& address : ParseIndexedAddresses(request.params[0])) {
+        std::vector<std::pair<CAddressIndexKey, CAmount>> entries;
+        if (!index.FindAddressEntries(address.first, address.second, 0, 0, entries)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read address index");
+        }
+        for (const auto& entry : entries) {
+            if (entry.second > 0) received += entry.second;
+            balance += entry.second;
+        }
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("balance", ValueFromAmount(balance));
+    result.pushKV("received", ValueFromAmount(received));
+    return result;
+}
+
+static UniValue getaddresstxids(const JSONRPCRequest& request)
+{
+            RPCHelpMan{"getaddresstxids",
+                "\nReturns the ids of all transactions touching the given addresses, ordered by height. Requires -addressindex.\n",
+                {
+                    {"addresses", RPCArg::Type::ARR, RPCArg::Optional::NO, "The defi addresses",
+                        {
+                            {"address", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "A defi address"},
+                        },
+                    },
+                    {"start", RPCArg::Type::NUM, /* default */ "0", "The first block height to include"},
+                    {"end", RPCArg::Type::NUM, /* default */ "0", "The last block height to include, 0 for the chain tip"},
+                },
+                RPCResult{
+            "[\n"
+            "  \"txid\"     (string) The transaction id\n"
+            "  ,...\n"
+            "]\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getaddresstxids", "'[\"mfWxJ45yp2SFn7UciZyNpvDKrzbhyfKrY8\"]' 100 200")
+            + HelpExampleRpc("getaddresstxids", "[\"mfWxJ45yp2SFn7UciZyNpvDKrzbhyfKrY8\"], 100, 200")
+                },
+            }.Check(request);
+
+    AddressIndex& index = EnsureAddressIndex();
+
+    int start = request.params[1].isNull() ? 0 : request.params[1].get_int();
+    int end = request.params[2].isNull() ? 0 : request.params[2].get_int();
+    if (start < 0 || end < 0 || (end > 0 && start > end)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid height range");
+    }
+
+    std::set<std::pair<int, uint256>> txids;
+    for (const auto& address : ParseIndexedAddresses(request.params[0])) {
+        std::vector<std::pair<CAddressIndexKey, CAmount>> entries;
+        if (!index.FindAddressEntries(address.first, address.second, start, end, entries)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read address index");
+        }
+        for (const auto& entry : entries) {
+            txids.emplace(entry.first.height, entry.first.txid);
+        }
+    }
+
+    UniValue result(UniValue::VARR);
+    uint256 last;
+    for (const auto& txid : txids) {
+        // The same tx may both spend from and pay to an address; entries of one tx share a height.
+        if (txid.second == last) continue;
+        result.push_back(txid.second.GetHex());
+        last = txid.second;
+    }
+    return result;
+}
+
+static UniValue getspentinfo(const JSONRPCRequest& request)
+{
+            RPCHelpMan{"getspentinfo",
+                "\nReturns the transaction input that spent the given output. Requires -addressindex.\n",
+                {
+                    {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The transaction id"},
+                    {"index", RPCArg::Type::NUM, RPCArg::Optional::NO, "The output number"},
+                },
+                RPCResult{
+            "{\n"
+            "  \"txid\" : \"txid\",    (string) The id of the spending transaction\n"
+            "  \"index\" : n,        (numeric) The input number of the spending transaction\n"
+            "  \"height\" : n,       (numeric) The height of the block containing the spending transaction\n"
+            "}\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getspentinfo", "\"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\" 0")
+            + HelpExampleRpc("getspentinfo", "\"0437cd7f8525ceed2324359c2d0ba26006d92d856a9c20fa0241106ee5a597c9\", 0")
+                },
+            }.Check(request);
+
+    AddressIndex& index = EnsureAddressIndex();
+
+    COutPoint outpoint(ParseHashV(request.params[0], "txid"), request.params[1].get_int());
+    CSpentIndexValue spent;
+    if (!index.FindSpent(outpoint, spent)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unable to get spent info");
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("txid", spent.txid.GetHex());
+    result.pushKV("index", (int)spent.input_index);
+    result.pushKV("height", spent.height);
+    return result;
+}
+
 // clang-format off
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
     { "control",            "getmemoryinfo",          &getmemoryinfo,          {"mode"} },
+    { "control",            "getlockstats",           &getlockstats,           {"count", "reset", "enable"} },
+    { "control",            "dumptrace",              &dumptrace,              {"reset", "enable"} },
     { "control",            "logging",                &logging,                {"include", "exclude"}},
+    { "util",               "getindexinfo",           &getindexinfo,           {"index_name"} },
     { "util",               "validateaddress",        &validateaddress,        {"address"} },
     { "util",               "createmultisig",         &createmultisig,         {"nrequired","keys","address_type"} },
     { "util",               "deriveaddresses",        &deriveaddresses,        {"descriptor", "range"} },
@@ -565,6 +983,10 @@ static const CRPCCommand commands[] =
     { "util",               "verifymessage",          &verifymessage,          {"address","signature","message"} },
     { "util",               "signmessagewithprivkey", &signmessagewithprivkey, {"privkey","message"} },
 
+    { "addressindex",       "getaddressbalance",      &getaddressbalance,      {"addresses"} },
+    { "addressindex",       "getaddresstxids",        &getaddresstxids,        {"addresses", "start", "end"} },
+    { "addressindex",       "getspentinfo",           &getspentinfo,           {"txid", "index"} },
+
     /* Not shown in help */
     { "hidden",             "setmocktime",            &setmocktime,            {"timestamp"}},
     { "hidden",             "echo",                   &echo,                   {"arg0","arg1","arg2","arg3","arg4","arg5","arg6","arg7","arg8","arg9"}},
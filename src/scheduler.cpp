@@ -7,10 +7,22 @@
 #include <random.h>
 #include <reverselock.h>
 
+#include <algorithm>
 #include <assert.h>
+#include <limits>
 #include <utility>
 
-CScheduler::CScheduler() : nThreadsServicingQueue(0), stopRequested(false), stopWhenEmpty(false)
+static int64_t ToTick(const boost::chrono::system_clock::time_point& t)
+{
+    return boost::chrono::duration_cast<boost::chrono::milliseconds>(t.time_since_epoch()).count();
+}
+
+static boost::chrono::system_clock::time_point FromTick(int64_t tick)
+{
+    return boost::chrono::system_clock::time_point(boost::chrono::milliseconds(tick));
+}
+
+CScheduler::CScheduler() : wheelTick(ToTick(boost::chrono::system_clock::now())), nThreadsServicingQueue(0), stopRequested(false), stopWhenEmpty(false)
 {
 }
 
@@ -29,6 +41,115 @@ static boost::system_time toPosixTime(const boost::chrono::system_clock::time_po
 }
 #endif
 
+void CScheduler::insertTask(Task task)
+{
+    const int64_t tick = ToTick(task.time);
+    if (tick <= wheelTick) {
+        const auto key = std::make_pair(task.time, task.sequence);
+        readyTasks.emplace(key, std::move(task));
+        return;
+    }
+    ++wheelSize;
+    // The lowest level whose span covers the task. Its slot is reached, and
+    // the task moved a level down, no earlier than the tick of the slot.
+    const int64_t delta = tick - wheelTick;
+    for (int level = 0; level < WHEEL_LEVELS; ++level) {
+        if (delta < (int64_t{1} << (WHEEL_SLOT_BITS * (level + 1)))) {
+            wheel[level][(tick >> (WHEEL_SLOT_BITS * level)) & (WHEEL_SLOTS - 1)].push_back(std::move(task));
+            ++wheelLevelSize[level];
+            return;
+        }
+    }
+    wheelOverflow.push_back(std::move(task));
+}
+
+void CScheduler::expireTick(int64_t tick)
+{
+    std::vector<Task> tasks;
+    if ((tick & ((int64_t{1} << (WHEEL_SLOT_BITS * WHEEL_LEVELS)) - 1)) == 0) {
+        tasks.swap(wheelOverflow);
+        wheelSize -= tasks.size();
+        for (Task& task : tasks) {
+            insertTask(std::move(task));
+        }
+        tasks.clear();
+    }
+    // Cascade the slots of the upper levels starting at this tick, the highest first.
+    for (int level = WHEEL_LEVELS - 1; level > 0; --level) {
+        const int shift = WHEEL_SLOT_BITS * level;
+        if ((tick & ((int64_t{1} << shift) - 1)) != 0) continue;
+        tasks.swap(wheel[level][(tick >> shift) & (WHEEL_SLOTS - 1)]);
+        wheelLevelSize[level] -= tasks.size();
+        wheelSize -= tasks.size();
+        for (Task& task : tasks) {
+            insertTask(std::move(task));
+        }
+        tasks.clear();
+    }
+    tasks.swap(wheel[0][tick & (WHEEL_SLOTS - 1)]);
+    wheelLevelSize[0] -= tasks.size();
+    wheelSize -= tasks.size();
+    for (Task& task : tasks) {
+        const auto key = std::make_pair(task.time, task.sequence);
+        readyTasks.emplace(key, std::move(task));
+    }
+}
+
+void CScheduler::advanceWheel(int64_t tick)
+{
+    if (wheelSize == 0) {
+        wheelTick = std::max(wheelTick, tick);
+        return;
+    }
+    while (wheelTick < tick) {
+        // While the lowest levels are empty nothing happens until the next
+        // slot of the level above them, so skip straight to it.
+        int64_t next = wheelTick + 1;
+        for (int level = 0; level < WHEEL_LEVELS && wheelLevelSize[level] == 0; ++level) {
+            const int shift = WHEEL_SLOT_BITS * (level + 1);
+            next = ((wheelTick >> shift) + 1) << shift;
+        }
+        wheelTick = std::min(next, tick);
+        expireTick(wheelTick);
+    }
+}
+
+int64_t CScheduler::nextWheelEvent() const
+{
+    int64_t next = std::numeric_limits<int64_t>::max();
+    for (int level = 0; level < WHEEL_LEVELS; ++level) {
+        if (wheelLevelSize[level] == 0) continue;
+        const int shift = WHEEL_SLOT_BITS * level;
+        const int64_t base = wheelTick >> shift;
+        for (int64_t i = 1; i <= WHEEL_SLOTS; ++i) {
+            if (!wheel[level][(base + i) & (WHEEL_SLOTS - 1)].empty()) {
+                next = std::min(next, (base + i) << shift);
+                break;
+            }
+        }
+    }
+    if (!wheelOverflow.empty()) {
+        const int shift = WHEEL_SLOT_BITS * WHEEL_LEVELS;
+        next = std::min(next, ((wheelTick >> shift) + 1) << shift);
+    }
+    return next;
+}
+
+std::map<std::pair<boost::chrono::system_clock::time_point, uint64_t>, CScheduler::Task>::iterator CScheduler::nextRunnableTask(boost::chrono::system_clock::time_point now, boost::chrono::system_clock::time_point& wake)
+{
+    for (auto it = readyTasks.begin(); it != readyTasks.end(); ++it) {
+        if (it->first.first > now) {
+            wake = std::min(wake, it->first.first);
+            break;
+        }
+        const TaskClass& task_class = *it->second.task_class;
+        if (task_class.max_running == 0 || task_class.running < task_class.max_running) {
+            return it;
+        }
+    }
+    return readyTasks.end();
+}
+
 void CScheduler::serviceQueue()
 {
     boost::unique_lock<boost::mutex> lock(newTaskMutex);
@@ -39,47 +160,70 @@ void CScheduler::serviceQueue()
     // is called.
     while (!shouldStop()) {
         try {
-            if (!shouldStop() && taskQueue.empty()) {
+            if (!shouldStop() && empty()) {
                 reverse_lock<boost::unique_lock<boost::mutex> > rlock(lock);
                 // Use this chance to get more entropy
                 RandAddSeedSleep();
             }
-            while (!shouldStop() && taskQueue.empty()) {
+            while (!shouldStop() && empty()) {
                 // Wait until there is something to do.
                 newTaskScheduled.wait(lock);
             }
+            if (shouldStop())
+                continue;
 
-            // Wait until either there is a new task, or until
-            // the time of the first item on the queue:
-
+            const boost::chrono::system_clock::time_point now = boost::chrono::system_clock::now();
+            advanceWheel(ToTick(now));
+            boost::chrono::system_clock::time_point wake = boost::chrono::system_clock::time_point::max();
+            auto it = nextRunnableTask(now, wake);
+            if (it == readyTasks.end()) {
+                // Wait until either there is a new task, a task of a class at
+                // its limit finished, or the next due task or wheel slot.
+                const int64_t next_tick = nextWheelEvent();
+                if (next_tick != std::numeric_limits<int64_t>::max()) {
+                    wake = std::min(wake, FromTick(next_tick));
+                }
+                if (wake == boost::chrono::system_clock::time_point::max()) {
+                    newTaskScheduled.wait(lock);
+                } else {
 // wait_until needs boost 1.50 or later; older versions have timed_wait:
 #if BOOST_VERSION < 105000
-            while (!shouldStop() && !taskQueue.empty() &&
-                   newTaskScheduled.timed_wait(lock, toPosixTime(taskQueue.begin()->first))) {
-                // Keep waiting until timeout
-            }
+                    newTaskScheduled.timed_wait(lock, toPosixTime(wake));
 #else
-            // Some boost versions have a conflicting overload of wait_until that returns void.
-            // Explicitly use a template here to avoid hitting that overload.
-            while (!shouldStop() && !taskQueue.empty()) {
-                boost::chrono::system_clock::time_point timeToWaitFor = taskQueue.begin()->first;
-                if (newTaskScheduled.wait_until<>(lock, timeToWaitFor) == boost::cv_status::timeout)
-                    break; // Exit loop after timeout, it means we reached the time of the event
-            }
+                    // Some boost versions have a conflicting overload of wait_until that returns void.
+                    // Explicitly use a template here to avoid hitting that overload.
+                    newTaskScheduled.wait_until<>(lock, wake);
 #endif
-            // If there are multiple threads, the queue can empty while we're waiting (another
-            // thread may service the task we were waiting on).
-            if (shouldStop() || taskQueue.empty())
+                }
                 continue;
+            }
 
-            Function f = taskQueue.begin()->second;
-            taskQueue.erase(taskQueue.begin());
-
-            {
+            Task task = std::move(it->second);
+            readyTasks.erase(it);
+            TaskClass& task_class = *task.task_class;
+            ++task_class.running;
+            const boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+            try {
                 // Unlock before calling f, so it can reschedule itself or another task
                 // without deadlocking:
                 reverse_lock<boost::unique_lock<boost::mutex> > rlock(lock);
-                f();
+                task.f();
+            } catch (...) {
+                --task_class.running;
+                throw;
+            }
+            --task_class.running;
+
+            TaskClassStats& stats = task_class.stats;
+            const int64_t run_micros = boost::chrono::duration_cast<boost::chrono::microseconds>(boost::chrono::steady_clock::now() - start).count();
+            const int64_t delay_micros = boost::chrono::duration_cast<boost::chrono::microseconds>(now - task.time).count();
+            ++stats.runs;
+            stats.run_micros_total += run_micros;
+            stats.run_micros_max = std::max(stats.run_micros_max, run_micros);
+            stats.delay_micros_max = std::max(stats.delay_micros_max, delay_micros);
+            if (task_class.max_running != 0) {
+                // Threads may be waiting for a task of this class to finish.
+                newTaskScheduled.notify_all();
             }
         } catch (...) {
             --nThreadsServicingQueue;
@@ -102,39 +246,75 @@ void CScheduler::stop(bool drain)
     newTaskScheduled.notify_all();
 }
 
-void CScheduler::schedule(CScheduler::Function f, boost::chrono::system_clock::time_point t)
+void CScheduler::schedule(CScheduler::Function f, boost::chrono::system_clock::time_point t, const std::string& task_class)
 {
     {
         boost::unique_lock<boost::mutex> lock(newTaskMutex);
-        taskQueue.insert(std::make_pair(t, f));
+        insertTask(Task{t, nextSequence++, std::move(f), &taskClasses[task_class]});
     }
     newTaskScheduled.notify_one();
 }
 
-void CScheduler::scheduleFromNow(CScheduler::Function f, int64_t deltaMilliSeconds)
+void CScheduler::scheduleFromNow(CScheduler::Function f, int64_t deltaMilliSeconds, const std::string& task_class)
 {
-    schedule(f, boost::chrono::system_clock::now() + boost::chrono::milliseconds(deltaMilliSeconds));
+    schedule(f, boost::chrono::system_clock::now() + boost::chrono::milliseconds(deltaMilliSeconds), task_class);
 }
 
-static void Repeat(CScheduler* s, CScheduler::Function f, int64_t deltaMilliSeconds)
+static void Repeat(CScheduler* s, CScheduler::Function f, int64_t deltaMilliSeconds, const std::string& task_class)
 {
     f();
-    s->scheduleFromNow(std::bind(&Repeat, s, f, deltaMilliSeconds), deltaMilliSeconds);
+    s->scheduleFromNow(std::bind(&Repeat, s, f, deltaMilliSeconds, task_class), deltaMilliSeconds, task_class);
+}
+
+void CScheduler::scheduleEvery(CScheduler::Function f, int64_t deltaMilliSeconds, const std::string& task_class)
+{
+    scheduleFromNow(std::bind(&Repeat, this, f, deltaMilliSeconds, task_class), deltaMilliSeconds, task_class);
+}
+
+void CScheduler::SetTaskClassConcurrency(const std::string& task_class, int max_running)
+{
+    {
+        boost::unique_lock<boost::mutex> lock(newTaskMutex);
+        taskClasses[task_class].max_running = max_running;
+    }
+    newTaskScheduled.notify_all();
 }
 
-void CScheduler::scheduleEvery(CScheduler::Function f, int64_t deltaMilliSeconds)
+std::vector<CScheduler::TaskClassStats> CScheduler::GetTaskClassStats() const
 {
-    scheduleFromNow(std::bind(&Repeat, this, f, deltaMilliSeconds), deltaMilliSeconds);
+    boost::unique_lock<boost::mutex> lock(newTaskMutex);
+    std::vector<TaskClassStats> result;
+    for (const auto& entry : taskClasses) {
+        result.push_back(entry.second.stats);
+        result.back().name = entry.first;
+    }
+    return result;
 }
 
 size_t CScheduler::getQueueInfo(boost::chrono::system_clock::time_point &first,
                              boost::chrono::system_clock::time_point &last) const
 {
     boost::unique_lock<boost::mutex> lock(newTaskMutex);
-    size_t result = taskQueue.size();
-    if (!taskQueue.empty()) {
-        first = taskQueue.begin()->first;
-        last = taskQueue.rbegin()->first;
+    size_t result = readyTasks.size() + wheelSize;
+    if (result == 0) return result;
+    first = boost::chrono::system_clock::time_point::max();
+    last = boost::chrono::system_clock::time_point::min();
+    auto update = [&](const Task& task) {
+        first = std::min(first, task.time);
+        last = std::max(last, task.time);
+    };
+    for (const auto& entry : readyTasks) {
+        update(entry.second);
+    }
+    for (const auto& level : wheel) {
+        for (const auto& slot : level) {
+            for (const Task& task : slot) {
+                update(task);
+            }
+        }
+    }
+    for (const Task& task : wheelOverflow) {
+        update(task);
     }
     return result;
 }
@@ -154,7 +334,7 @@ void SingleThreadedSchedulerClient::MaybeScheduleProcessQueue() {
         if (m_are_callbacks_running) return;
         if (m_callbacks_pending.empty()) return;
     }
-    m_pscheduler->schedule(std::bind(&SingleThreadedSchedulerClient::ProcessQueue, this));
+    m_pscheduler->schedule(std::bind(&SingleThreadedSchedulerClient::ProcessQueue, this), boost::chrono::system_clock::now(), m_task_class);
 }
 
 void SingleThreadedSchedulerClient::ProcessQueue() {
@@ -13,6 +13,8 @@
 #include <boost/chrono/chrono.hpp>
 #include <boost/thread.hpp>
 #include <map>
+#include <string>
+#include <vector>
 
 #include <sync.h>
 
@@ -33,6 +35,19 @@
 // delete t;
 // delete s; // Must be done after thread is interrupted/joined.
 //
+// Any number of threads may run serviceQueue. Tasks belong to a named class
+// ("" by default) and SetTaskClassConcurrency bounds how many of them run at
+// once, so that slow maintenance jobs can not hold up every thread.
+//
+// Pending tasks are kept in a hierarchical timer wheel of 1ms ticks, so that
+// scheduling and expiring a task costs O(1) however many are pending.
+//
+
+// One thread by default: the node's tasks (stale tip checks, wallet
+// rebroadcasts, dumps) were written to run serialized with the validation
+// interface callbacks, and only opt-in setups run them concurrently.
+static const int DEFAULT_SCHEDULER_THREADS = 1;
+static const int MAX_SCHEDULER_THREADS = 16;
 
 class CScheduler
 {
@@ -43,17 +58,34 @@ public:
     typedef std::function<void()> Function;
 
     // Call func at/after time t
-    void schedule(Function f, boost::chrono::system_clock::time_point t=boost::chrono::system_clock::now());
+    void schedule(Function f, boost::chrono::system_clock::time_point t=boost::chrono::system_clock::now(), const std::string& task_class="");
 
     // Convenience method: call f once deltaMilliSeconds from now
-    void scheduleFromNow(Function f, int64_t deltaMilliSeconds);
+    void scheduleFromNow(Function f, int64_t deltaMilliSeconds, const std::string& task_class="");
 
     // Another convenience method: call f approximately
     // every deltaMilliSeconds forever, starting deltaMilliSeconds from now.
     // To be more precise: every time f is finished, it
     // is rescheduled to run deltaMilliSeconds later. If you
     // need more accurate scheduling, don't use this method.
-    void scheduleEvery(Function f, int64_t deltaMilliSeconds);
+    void scheduleEvery(Function f, int64_t deltaMilliSeconds, const std::string& task_class="");
+
+    // Run at most max_running tasks of the class at the same time,
+    // 0 (the default) for no limit
+    void SetTaskClassConcurrency(const std::string& task_class, int max_running);
+
+    struct TaskClassStats {
+        std::string name;
+        uint64_t runs;
+        //! Time spent running the tasks of the class
+        int64_t run_micros_total;
+        int64_t run_micros_max;
+        //! Worst time between a task being due and starting to run
+        int64_t delay_micros_max;
+    };
+
+    // Returns the statistics of every task class that was used, by name
+    std::vector<TaskClassStats> GetTaskClassStats() const;
 
     // To keep things as simple as possible, there is no unschedule.
 
@@ -75,13 +107,50 @@ public:
     bool AreThreadsServicingQueue() const;
 
 private:
-    std::multimap<boost::chrono::system_clock::time_point, Function> taskQueue;
+    struct TaskClass {
+        int max_running{0};
+        int running{0};
+        TaskClassStats stats{};
+    };
+
+    struct Task {
+        boost::chrono::system_clock::time_point time;
+        //! Order of scheduling, to run tasks due at the same time first come first served
+        uint64_t sequence;
+        Function f;
+        TaskClass* task_class;
+    };
+
+    static const int WHEEL_LEVELS = 4;
+    static const int WHEEL_SLOT_BITS = 6;
+    static const int64_t WHEEL_SLOTS = 1 << WHEEL_SLOT_BITS;
+
+    //! Tasks of ticks that were reached, by (time, sequence). Some may be up to 1ms early still
+    std::map<std::pair<boost::chrono::system_clock::time_point, uint64_t>, Task> readyTasks;
+    //! Level n slots hold the tasks due within WHEEL_SLOTS^(n+1) ticks, from the tick they were scheduled at
+    std::vector<Task> wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+    size_t wheelLevelSize[WHEEL_LEVELS] = {};
+    //! Tasks beyond the range of the wheel, placed back into it when the last level wraps around
+    std::vector<Task> wheelOverflow;
+    size_t wheelSize{0};
+    //! Last tick that the wheel was advanced to, in milliseconds since the epoch
+    int64_t wheelTick;
+    uint64_t nextSequence{0};
+    std::map<std::string, TaskClass> taskClasses;
+
     boost::condition_variable newTaskScheduled;
     mutable boost::mutex newTaskMutex;
     int nThreadsServicingQueue;
     bool stopRequested;
     bool stopWhenEmpty;
-    bool shouldStop() const { return stopRequested || (stopWhenEmpty && taskQueue.empty()); }
+    bool empty() const { return readyTasks.empty() && wheelSize == 0; }
+    bool shouldStop() const { return stopRequested || (stopWhenEmpty && empty()); }
+
+    void insertTask(Task task);
+    void advanceWheel(int64_t tick);
+    void expireTick(int64_t tick);
+    int64_t nextWheelEvent() const;
+    std::map<std::pair<boost::chrono::system_clock::time_point, uint64_t>, Task>::iterator nextRunnableTask(boost::chrono::system_clock::time_point now, boost::chrono::system_clock::time_point& wake);
 };
 
 /**
@@ -97,6 +166,7 @@ private:
 class SingleThreadedSchedulerClient {
 private:
     CScheduler *m_pscheduler;
+    const std::string m_task_class;
 
     CCriticalSection m_cs_callbacks_pending;
     std::list<std::function<void ()>> m_callbacks_pending GUARDED_BY(m_cs_callbacks_pending);
@@ -106,7 +176,7 @@ private:
     void ProcessQueue();
 
 public:
-    explicit SingleThreadedSchedulerClient(CScheduler *pschedulerIn) : m_pscheduler(pschedulerIn) {}
+    explicit SingleThreadedSchedulerClient(CScheduler *pschedulerIn, std::string task_class="") : m_pscheduler(pschedulerIn), m_task_class(std::move(task_class)) {}
 
     /**
      * Add a callback to be executed. Callbacks are executed serially
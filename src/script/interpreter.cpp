@@ -1469,6 +1469,141 @@ static bool VerifyWitnessProgram(const CScriptWitness& witness, int witversion,
     return true;
 }
 
+/*
+ * Fast paths for the single key templates P2PKH, P2WPKH and P2SH-P2WPKH, which are what nearly all
+ * inputs spend, masternode collaterals included. They check exactly the conditions the interpreter
+ * checks for these scripts, but without building a stack. Once a spend is recognized up to its
+ * signature check, they report its result with the error the interpreter would give. Inputs they
+ * do not fully recognize, and cheap structural failures, are left to the interpreter.
+ */
+namespace {
+
+enum class StandardScriptResult
+{
+    SUCCESS,
+    FAILURE,    //!< serror is set
+    UNHANDLED,  //!< left to the interpreter
+};
+
+/** CastToBool for a witness program, without copying it into a valtype. */
+bool ProgramIsTrue(CScript::const_iterator begin, CScript::const_iterator end)
+{
+    for (auto it = begin; it != end; ++it) {
+        if (*it != 0) {
+            return it != end - 1 || *it != 0x80;
+        }
+    }
+    return false;
+}
+
+/** Read a direct push of 2 to 75 bytes, which is always a minimal push. */
+bool ReadDirectPush(const CScript& script, CScript::const_iterator& pc, valtype& data)
+{
+    if (pc == script.end()) {
+        return false;
+    }
+    const unsigned int size = *pc;
+    if (size < 2 || size >= OP_PUSHDATA1 || static_cast<size_t>(script.end() - pc) <= size) {
+        return false;
+    }
+    data.assign(pc + 1, pc + 1 + size);
+    pc += 1 + size;
+    return true;
+}
+
+/** OP_DUP OP_HASH160 <keyhash> OP_EQUALVERIFY OP_CHECKSIG, run on a stack of sig and pubkey. */
+StandardScriptResult CheckKeyHashSpend(const valtype& sig, const valtype& pubkey, CScript::const_iterator keyhash, const CScript& scriptCode,
+                                       unsigned int flags, const BaseSignatureChecker& checker, SigVersion sigversion, ScriptError* serror)
+{
+    if (sig.size() > MAX_SCRIPT_ELEMENT_SIZE || pubkey.size() > MAX_SCRIPT_ELEMENT_SIZE) {
+        return StandardScriptResult::UNHANDLED;
+    }
+    unsigned char hash[CHash160::OUTPUT_SIZE];
+    CHash160().Write(pubkey.data(), pubkey.size()).Finalize(hash);
+    if (!std::equal(hash, hash + sizeof(hash), keyhash)) {
+        return StandardScriptResult::UNHANDLED;
+    }
+    if (!CheckSignatureEncoding(sig, flags, serror) || !CheckPubKeyEncoding(pubkey, flags, sigversion, serror)) {
+        return StandardScriptResult::FAILURE;
+    }
+    if (!checker.CheckSig(sig, pubkey, scriptCode, sigversion)) {
+        // OP_CHECKSIG fails the script under NULLFAIL, otherwise it leaves false as the only stack item.
+        set_error(serror, (flags & SCRIPT_VERIFY_NULLFAIL) && !sig.empty() ? SCRIPT_ERR_SIG_NULLFAIL : SCRIPT_ERR_EVAL_FALSE);
+        return StandardScriptResult::FAILURE;
+    }
+    return StandardScriptResult::SUCCESS;
+}
+
+bool IsPayToPubKeyHash(const CScript& script)
+{
+    return script.size() == 25 && script[0] == OP_DUP && script[1] == OP_HASH160 && script[2] == 20 &&
+           script[23] == OP_EQUALVERIFY && script[24] == OP_CHECKSIG;
+}
+
+bool IsPayToWitnessPubKeyHash(CScript::const_iterator begin, CScript::const_iterator end)
+{
+    return end - begin == 22 && begin[0] == OP_0 && begin[1] == WITNESS_V0_KEYHASH_SIZE;
+}
+
+/** Verify a P2WPKH spend whose 22 byte program starts at program, as VerifyWitnessProgram does. */
+StandardScriptResult VerifyWitnessKeyHash(const CScriptWitness& witness, CScript::const_iterator program, unsigned int flags,
+                                          const BaseSignatureChecker& checker, ScriptError* serror)
+{
+    if (witness.stack.size() != 2 || !ProgramIsTrue(program + 2, program + 22)) {
+        return StandardScriptResult::UNHANDLED;
+    }
+    CScript scriptCode;
+    scriptCode << OP_DUP << OP_HASH160;
+    scriptCode.insert(scriptCode.end(), program + 1, program + 22);
+    scriptCode << OP_EQUALVERIFY << OP_CHECKSIG;
+    return CheckKeyHashSpend(witness.stack[0], witness.stack[1], program + 2, scriptCode, flags, checker, SigVersion::WITNESS_V0, serror);
+}
+
+StandardScriptResult VerifyStandardScript(const CScript& scriptSig, const CScript& scriptPubKey, const CScriptWitness& witness,
+                                          unsigned int flags, const BaseSignatureChecker& checker, ScriptError* serror)
+{
+    if (IsPayToPubKeyHash(scriptPubKey)) {
+        if ((flags & SCRIPT_VERIFY_WITNESS) && !witness.IsNull()) {
+            return StandardScriptResult::UNHANDLED;
+        }
+        CScript::const_iterator pc = scriptSig.begin();
+        valtype sig, pubkey;
+        if (!ReadDirectPush(scriptSig, pc, sig) || !ReadDirectPush(scriptSig, pc, pubkey) || pc != scriptSig.end()) {
+            return StandardScriptResult::UNHANDLED;
+        }
+        // FindAndDelete of the signature push could only match the push of the key hash itself.
+        if (sig.size() == 20 && std::equal(sig.begin(), sig.end(), scriptPubKey.begin() + 3)) {
+            return StandardScriptResult::UNHANDLED;
+        }
+        return CheckKeyHashSpend(sig, pubkey, scriptPubKey.begin() + 3, scriptPubKey, flags, checker, SigVersion::BASE, serror);
+    }
+
+    if (!(flags & SCRIPT_VERIFY_WITNESS) || !(flags & SCRIPT_VERIFY_P2SH)) {
+        return StandardScriptResult::UNHANDLED;
+    }
+    if (IsPayToWitnessPubKeyHash(scriptPubKey.begin(), scriptPubKey.end())) {
+        if (!scriptSig.empty()) {
+            return StandardScriptResult::UNHANDLED;
+        }
+        return VerifyWitnessKeyHash(witness, scriptPubKey.begin(), flags, checker, serror);
+    }
+    if (scriptPubKey.IsPayToScriptHash()) {
+        // The scriptSig must be exactly the push of a P2WPKH redeem script matching the script hash.
+        if (scriptSig.size() != 23 || scriptSig[0] != 22 || !IsPayToWitnessPubKeyHash(scriptSig.begin() + 1, scriptSig.end())) {
+            return StandardScriptResult::UNHANDLED;
+        }
+        unsigned char hash[CHash160::OUTPUT_SIZE];
+        CHash160().Write(&scriptSig[1], 22).Finalize(hash);
+        if (!std::equal(hash, hash + sizeof(hash), scriptPubKey.begin() + 2)) {
+            return StandardScriptResult::UNHANDLED;
+        }
+        return VerifyWitnessKeyHash(witness, scriptSig.begin() + 1, flags, checker, serror);
+    }
+    return StandardScriptResult::UNHANDLED;
+}
+
+} // namespace
+
 bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, const CScriptWitness* witness, unsigned int flags, const BaseSignatureChecker& checker, ScriptError* serror)
 {
     static const CScriptWitness emptyWitness;
@@ -1477,6 +1612,16 @@ bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, const C
     }
     bool hadWitness = false;
 
+    switch (VerifyStandardScript(scriptSig, scriptPubKey, *witness, flags, checker, serror)) {
+    case StandardScriptResult::SUCCESS:
+        return set_success(serror);
+    case StandardScriptResult::FAILURE:
+        // serror is set
+        return false;
+    case StandardScriptResult::UNHANDLED:
+        break;
+    }
+
     set_error(serror, SCRIPT_ERR_UNKNOWN_ERROR);
 
     if ((flags & SCRIPT_VERIFY_SIGPUSHONLY) != 0 && !scriptSig.IsPushOnly()) {
@@ -13,48 +13,79 @@
 #include <cuckoocache.h>
 #include <boost/thread.hpp>
 
+#include <array>
+
 namespace {
 /**
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
  * twice for every transaction (once when accepted into memory pool, and
  * again when accepted into the block chain)
+ *
+ * The cache is split into SIG_CACHE_SHARDS shards, each with its own lock, so
+ * that script check threads inserting and looking up entries during block
+ * validation rarely wait on each other. Lookups only take shared locks and
+ * CuckooCache marks erasures with atomic flags, so concurrent lookups in the
+ * same shard do not serialize either.
  */
 class CSignatureCache
 {
 private:
-     //! Entries are SHA256(nonce || signature hash || public key || signature):
-    uint256 nonce;
+    //! Entries are SHA256(nonce || nonce || signature hash || public key || signature).
+    //! The 64-byte salt fills the first SHA256 block, so its midstate is computed once.
+    CSHA256 m_salted_hasher;
     typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
-    map_type setValid;
-    boost::shared_mutex cs_sigcache;
+
+    struct Shard {
+        map_type setValid;
+        boost::shared_mutex cs_sigcache;
+    };
+    std::array<Shard, SIG_CACHE_SHARDS> m_shards;
+
+    static size_t ShardIndex(const uint256& entry)
+    {
+        // SignatureCacheHasher maps its hashes into the table by their high
+        // bits, so pick the shard by the low bits of the first one.
+        return entry.begin()[0] % SIG_CACHE_SHARDS;
+    }
 
 public:
     CSignatureCache()
     {
+        uint256 nonce;
         GetRandBytes(nonce.begin(), 32);
+        m_salted_hasher.Write(nonce.begin(), 32);
+        m_salted_hasher.Write(nonce.begin(), 32);
     }
 
     void
     ComputeEntry(uint256& entry, const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey)
     {
-        CSHA256().Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(&pubkey[0], pubkey.size()).Write(&vchSig[0], vchSig.size()).Finalize(entry.begin());
+        CSHA256(m_salted_hasher).Write(hash.begin(), 32).Write(&pubkey[0], pubkey.size()).Write(&vchSig[0], vchSig.size()).Finalize(entry.begin());
     }
 
     bool
     Get(const uint256& entry, const bool erase)
     {
-        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
-        return setValid.contains(entry, erase);
+        Shard& shard = m_shards[ShardIndex(entry)];
+        boost::shared_lock<boost::shared_mutex> lock(shard.cs_sigcache);
+        return shard.setValid.contains(entry, erase);
     }
 
-    void Set(uint256& entry)
+    void Set(const uint256& entry)
     {
-        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
-        setValid.insert(entry);
+        Shard& shard = m_shards[ShardIndex(entry)];
+        boost::unique_lock<boost::shared_mutex> lock(shard.cs_sigcache);
+        shard.setValid.insert(entry);
     }
-    uint32_t setup_bytes(size_t n)
+
+    size_t setup_bytes(size_t n)
     {
-        return setValid.setup_bytes(n);
+        size_t elems = 0;
+        for (Shard& shard : m_shards) {
+            boost::unique_lock<boost::shared_mutex> lock(shard.cs_sigcache);
+            elems += shard.setValid.setup_bytes(n / SIG_CACHE_SHARDS);
+        }
+        return elems;
     }
 };
 
@@ -79,6 +110,21 @@ void InitSignatureCache()
             (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, nElems);
 }
 
+void ComputeSignatureCacheEntry(uint256& entry, const uint256& sighash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey)
+{
+    signatureCache.ComputeEntry(entry, sighash, vchSig, pubkey);
+}
+
+bool SignatureCacheContains(const uint256& entry, bool erase)
+{
+    return signatureCache.Get(entry, erase);
+}
+
+void SignatureCacheInsert(const uint256& entry)
+{
+    signatureCache.Set(entry);
+}
+
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
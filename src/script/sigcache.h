@@ -16,6 +16,8 @@
 static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 32;
 // Maximum sig cache size allowed
 static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
+// Number of independently locked shards the signature cache is split into
+static const size_t SIG_CACHE_SHARDS = 16;
 
 class CPubKey;
 
@@ -46,11 +48,20 @@ private:
     bool store;
 
 public:
-    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn), store(storeIn) {}
+    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, const PrecomputedTransactionData& txdataIn) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn), store(storeIn) {}
 
     bool VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const override;
 };
 
 void InitSignatureCache();
 
+/** Compute the signature cache entry for a signature check. */
+void ComputeSignatureCacheEntry(uint256& entry, const uint256& sighash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey);
+
+/** Look up a signature cache entry, marking it for erasure if erase is set and it is found. */
+bool SignatureCacheContains(const uint256& entry, bool erase);
+
+/** Add a verified signature check to the signature cache. */
+void SignatureCacheInsert(const uint256& entry);
+
 #endif // DEFI_SCRIPT_SIGCACHE_H
@@ -18,6 +18,7 @@
 #include <stdint.h>
 #include <string>
 #include <string.h>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -238,6 +239,31 @@ template<typename Stream> inline void Unserialize(Stream& s, Span<unsigned char>
 template<typename Stream> inline void Serialize(Stream& s, bool a)    { char f=a; ser_writedata8(s, f); }
 template<typename Stream> inline void Unserialize(Stream& s, bool& a) { char f=ser_readdata8(s); a=f; }
 
+/**
+ * Types whose in-memory representation is their serialization, so that
+ * vectors and prevectors of them are written and read as a single blob.
+ * Multi-byte integers qualify on little-endian hosts only.
+ */
+template<typename T> struct is_raw_serializable : std::false_type {};
+template<> struct is_raw_serializable<char> : std::true_type {};
+template<> struct is_raw_serializable<signed char> : std::true_type {};
+template<> struct is_raw_serializable<unsigned char> : std::true_type {};
+#ifndef WORDS_BIGENDIAN
+template<> struct is_raw_serializable<int16_t> : std::true_type {};
+template<> struct is_raw_serializable<uint16_t> : std::true_type {};
+template<> struct is_raw_serializable<int32_t> : std::true_type {};
+template<> struct is_raw_serializable<uint32_t> : std::true_type {};
+template<> struct is_raw_serializable<int64_t> : std::true_type {};
+template<> struct is_raw_serializable<uint64_t> : std::true_type {};
+#endif
+
+/** Dispatch tag of the blob (un)serialization of vectors and prevectors. */
+struct RawElements {};
+
+/** RawElements for raw serializable element types, a T otherwise. */
+template<typename T>
+using ElementsTag = typename std::conditional<is_raw_serializable<T>::value, RawElements, T>::type;
+
 
 
 
@@ -541,24 +567,24 @@ template<typename Stream, typename C> void Unserialize(Stream& is, std::basic_st
 
 /**
  * prevector
- * prevectors of unsigned char are a special case and are intended to be serialized as a single opaque blob.
+ * prevectors of raw serializable types are a special case and are serialized as a single opaque blob.
  */
-template<typename Stream, unsigned int N, typename T> void Serialize_impl(Stream& os, const prevector<N, T>& v, const unsigned char&);
+template<typename Stream, unsigned int N, typename T> void Serialize_impl(Stream& os, const prevector<N, T>& v, const RawElements&);
 template<typename Stream, unsigned int N, typename T, typename V> void Serialize_impl(Stream& os, const prevector<N, T>& v, const V&);
 template<typename Stream, unsigned int N, typename T> inline void Serialize(Stream& os, const prevector<N, T>& v);
-template<typename Stream, unsigned int N, typename T> void Unserialize_impl(Stream& is, prevector<N, T>& v, const unsigned char&);
+template<typename Stream, unsigned int N, typename T> void Unserialize_impl(Stream& is, prevector<N, T>& v, const RawElements&);
 template<typename Stream, unsigned int N, typename T, typename V> void Unserialize_impl(Stream& is, prevector<N, T>& v, const V&);
 template<typename Stream, unsigned int N, typename T> inline void Unserialize(Stream& is, prevector<N, T>& v);
 
 /**
  * vector
- * vectors of unsigned char are a special case and are intended to be serialized as a single opaque blob.
+ * vectors of raw serializable types are a special case and are serialized as a single opaque blob.
  */
-template<typename Stream, typename T, typename A> void Serialize_impl(Stream& os, const std::vector<T, A>& v, const unsigned char&);
+template<typename Stream, typename T, typename A> void Serialize_impl(Stream& os, const std::vector<T, A>& v, const RawElements&);
 template<typename Stream, typename T, typename A> void Serialize_impl(Stream& os, const std::vector<T, A>& v, const bool&);
 template<typename Stream, typename T, typename A, typename V> void Serialize_impl(Stream& os, const std::vector<T, A>& v, const V&);
 template<typename Stream, typename T, typename A> inline void Serialize(Stream& os, const std::vector<T, A>& v);
-template<typename Stream, typename T, typename A> void Unserialize_impl(Stream& is, std::vector<T, A>& v, const unsigned char&);
+template<typename Stream, typename T, typename A> void Unserialize_impl(Stream& is, std::vector<T, A>& v, const RawElements&);
 template<typename Stream, typename T, typename A, typename V> void Unserialize_impl(Stream& is, std::vector<T, A>& v, const V&);
 template<typename Stream, typename T, typename A> inline void Unserialize(Stream& is, std::vector<T, A>& v);
 
@@ -639,7 +665,7 @@ void Unserialize(Stream& is, std::basic_string<C>& str)
  * prevector
  */
 template<typename Stream, unsigned int N, typename T>
-void Serialize_impl(Stream& os, const prevector<N, T>& v, const unsigned char&)
+void Serialize_impl(Stream& os, const prevector<N, T>& v, const RawElements&)
 {
     WriteCompactSize(os, v.size());
     if (!v.empty())
@@ -657,12 +683,12 @@ void Serialize_impl(Stream& os, const prevector<N, T>& v, const V&)
 template<typename Stream, unsigned int N, typename T>
 inline void Serialize(Stream& os, const prevector<N, T>& v)
 {
-    Serialize_impl(os, v, T());
+    Serialize_impl(os, v, ElementsTag<T>());
 }
 
 
 template<typename Stream, unsigned int N, typename T>
-void Unserialize_impl(Stream& is, prevector<N, T>& v, const unsigned char&)
+void Unserialize_impl(Stream& is, prevector<N, T>& v, const RawElements&)
 {
     // Limit size per read so bogus size value won't cause out of memory
     v.clear();
@@ -698,7 +724,7 @@ void Unserialize_impl(Stream& is, prevector<N, T>& v, const V&)
 template<typename Stream, unsigned int N, typename T>
 inline void Unserialize(Stream& is, prevector<N, T>& v)
 {
-    Unserialize_impl(is, v, T());
+    Unserialize_impl(is, v, ElementsTag<T>());
 }
 
 
@@ -707,7 +733,7 @@ inline void Unserialize(Stream& is, prevector<N, T>& v)
  * vector
  */
 template<typename Stream, typename T, typename A>
-void Serialize_impl(Stream& os, const std::vector<T, A>& v, const unsigned char&)
+void Serialize_impl(Stream& os, const std::vector<T, A>& v, const RawElements&)
 {
     WriteCompactSize(os, v.size());
     if (!v.empty())
@@ -737,12 +763,12 @@ void Serialize_impl(Stream& os, const std::vector<T, A>& v, const V&)
 template<typename Stream, typename T, typename A>
 inline void Serialize(Stream& os, const std::vector<T, A>& v)
 {
-    Serialize_impl(os, v, T());
+    Serialize_impl(os, v, ElementsTag<T>());
 }
 
 
 template<typename Stream, typename T, typename A>
-void Unserialize_impl(Stream& is, std::vector<T, A>& v, const unsigned char&)
+void Unserialize_impl(Stream& is, std::vector<T, A>& v, const RawElements&)
 {
     // Limit size per read so bogus size value won't cause out of memory
     v.clear();
@@ -778,7 +804,7 @@ void Unserialize_impl(Stream& is, std::vector<T, A>& v, const V&)
 template<typename Stream, typename T, typename A>
 inline void Unserialize(Stream& is, std::vector<T, A>& v)
 {
-    Unserialize_impl(is, v, T());
+    Unserialize_impl(is, v, ElementsTag<T>());
 }
 
 
@@ -926,8 +952,9 @@ protected:
     size_t nSize;
 
     const int nVersion;
+    const int nType;
 public:
-    explicit CSizeComputer(int nVersionIn) : nSize(0), nVersion(nVersionIn) {}
+    explicit CSizeComputer(int nVersionIn, int nTypeIn = 0) : nSize(0), nVersion(nVersionIn), nType(nTypeIn) {}
 
     void write(const char *psz, size_t _nSize)
     {
@@ -952,6 +979,7 @@ public:
     }
 
     int GetVersion() const { return nVersion; }
+    int GetType() const { return nType; }
 };
 
 template<typename Stream>
@@ -24,6 +24,10 @@ public:
     constexpr Span(C* data, std::ptrdiff_t size) noexcept : m_data(data), m_size(size) {}
     constexpr Span(C* data, C* end) noexcept : m_data(data), m_size(end - data) {}
 
+    /** Implicit conversion of spans between compatible types, e.g. to a span of const elements. */
+    template <typename O, typename std::enable_if<std::is_convertible<O (*)[], C (*)[]>::value, int>::type = 0>
+    constexpr Span(const Span<O>& other) noexcept : m_data(other.data()), m_size(other.size()) {}
+
     constexpr C* data() const noexcept { return m_data; }
     constexpr C* begin() const noexcept { return m_data; }
     constexpr C* end() const noexcept { return m_data + m_size; }
@@ -57,4 +61,8 @@ constexpr Span<A> MakeSpan(A (&a)[N]) { return Span<A>(a, N); }
 template<typename V>
 constexpr Span<typename std::remove_pointer<decltype(std::declval<V>().data())>::type> MakeSpan(V& v) { return Span<typename std::remove_pointer<decltype(std::declval<V>().data())>::type>(v.data(), v.size()); }
 
+/** Create a span of the bytes of a container of chars exposing data() and size(), such as a std::string. */
+template<typename V>
+inline Span<const unsigned char> MakeUCharSpan(const V& v) { return Span<const unsigned char>(reinterpret_cast<const unsigned char*>(v.data()), v.size()); }
+
 #endif
@@ -8,6 +8,7 @@
 
 #include <support/allocators/zeroafterfree.h>
 #include <serialize.h>
+#include <span.h>
 
 #include <algorithm>
 #include <assert.h>
@@ -91,6 +92,14 @@ class CVectorWriter
     template <typename... Args>
     CVectorWriter(int nTypeIn, int nVersionIn, std::vector<unsigned char>& vchDataIn, size_t nPosIn, Args&&... args) : CVectorWriter(nTypeIn, nVersionIn, vchDataIn, nPosIn)
     {
+        // Size the items first, so that the vector grows at most once. Growth stays geometric, as
+        // callers may append to the same vector over and over.
+        CSizeComputer sizer(nVersion, nType);
+        ::SerializeMany(sizer, args...);
+        const size_t needed = nPos + sizer.size();
+        if (needed > vchData.capacity()) {
+            vchData.reserve(std::max(vchData.capacity() * 2, needed));
+        }
         ::SerializeMany(*this, std::forward<Args>(args)...);
     }
     void write(const char* pch, size_t nSize)
@@ -195,6 +204,74 @@ public:
     }
 };
 
+/** Minimal stream for reading from a span of bytes without copying them.
+ *
+ * The referenced bytes must outlive the reader, which makes it fit for
+ * read-only paths such as deserializing a database value in place.
+ */
+class SpanReader
+{
+private:
+    const int m_type;
+    const int m_version;
+    Span<const unsigned char> m_data;
+
+public:
+
+    /**
+     * @param[in]  type Serialization Type
+     * @param[in]  version Serialization Version (including any flags)
+     * @param[in]  data Referenced bytes to read from
+     */
+    SpanReader(int type, int version, Span<const unsigned char> data)
+        : m_type(type), m_version(version), m_data(data) {}
+
+    /**
+     * (other params same as above)
+     * @param[in]  args  A list of items to deserialize.
+     */
+    template <typename... Args>
+    SpanReader(int type, int version, Span<const unsigned char> data, Args&&... args)
+        : SpanReader(type, version, data)
+    {
+        ::UnserializeMany(*this, std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    SpanReader& operator>>(T&& obj)
+    {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+
+    int GetVersion() const { return m_version; }
+    int GetType() const { return m_type; }
+
+    size_t size() const { return m_data.size(); }
+    bool empty() const { return m_data.size() == 0; }
+
+    void read(char* dst, size_t n)
+    {
+        if (n == 0) {
+            return;
+        }
+        if (n > size()) {
+            throw std::ios_base::failure("SpanReader::read(): end of data");
+        }
+        memcpy(dst, m_data.data(), n);
+        m_data = m_data.subspan(n);
+    }
+
+    void ignore(size_t n)
+    {
+        if (n > size()) {
+            throw std::ios_base::failure("SpanReader::ignore(): end of data");
+        }
+        m_data = m_data.subspan(n);
+    }
+};
+
 /** Double ended buffer combining vector and stream-like interfaces.
  *
  * >> and << read and write unformatted data using the above serialization templates.
@@ -255,6 +332,9 @@ public:
     CDataStream(int nTypeIn, int nVersionIn, Args&&... args)
     {
         Init(nTypeIn, nVersionIn);
+        CSizeComputer sizer(nVersion, nType);
+        ::SerializeMany(sizer, args...);
+        vch.reserve(sizer.size());
         ::SerializeMany(*this, std::forward<Args>(args)...);
     }
 
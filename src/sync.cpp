@@ -9,6 +9,7 @@
 #include <sync.h>
 #include <tinyformat.h>
 
+#include <crypto/common.h>
 #include <logging.h>
 #include <util/strencodings.h>
 #include <util/threadnames.h>
@@ -18,6 +19,7 @@
 #include <map>
 #include <memory>
 #include <set>
+#include <tuple>
 
 #ifdef DEBUG_LOCKCONTENTION
 #if !defined(HAVE_THREAD_LOCAL)
@@ -30,6 +32,144 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+std::atomic<bool> g_lock_stats_enabled{DEFAULT_LOCK_STATS};
+
+/**
+ * Counters of one LOCK site. Sites live in a fixed open addressing table keyed
+ * by the __FILE__ pointer and line, so that recording never allocates or takes
+ * a lock itself. The table has static storage and is zero initialized, which
+ * makes it usable by locks taken during static initialization.
+ */
+struct LockSite {
+    enum : int { EMPTY = 0, CLAIMED = 1, READY = 2 };
+    std::atomic<int> state;
+    const char* name;
+    const char* file;
+    int line;
+    std::atomic<uint64_t> acquired;
+    std::atomic<uint64_t> contended;
+    std::atomic<uint64_t> try_failed;
+    std::atomic<uint64_t> wait_total;
+    std::atomic<uint64_t> wait_max;
+    std::atomic<uint64_t> hold_total;
+    std::atomic<uint64_t> hold_max;
+    std::atomic<uint64_t> wait_histogram[LOCK_STATS_HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> hold_histogram[LOCK_STATS_HISTOGRAM_BUCKETS];
+};
+
+/** Comfortably more than the number of LOCK sites, which are counted once per translation unit. */
+static const size_t LOCK_SITES = 4096;
+static LockSite g_lock_sites[LOCK_SITES];
+
+LockSite* GetLockSite(const char* pszName, const char* pszFile, int nLine)
+{
+    size_t slot = (reinterpret_cast<uintptr_t>(pszFile) * 31 + static_cast<unsigned>(nLine)) * 0x9E3779B97F4A7C15ULL >> 20;
+    for (size_t probe = 0; probe < LOCK_SITES; ++probe, ++slot) {
+        LockSite& site = g_lock_sites[slot % LOCK_SITES];
+        int state = site.state.load(std::memory_order_acquire);
+        if (state == LockSite::EMPTY) {
+            if (site.state.compare_exchange_strong(state, LockSite::CLAIMED, std::memory_order_acquire)) {
+                site.name = pszName;
+                site.file = pszFile;
+                site.line = nLine;
+                site.state.store(LockSite::READY, std::memory_order_release);
+                return &site;
+            }
+        }
+        // Another thread is filling in this slot, which only takes a few stores.
+        while (state == LockSite::CLAIMED) {
+            std::this_thread::yield();
+            state = site.state.load(std::memory_order_acquire);
+        }
+        if (site.file == pszFile && site.line == nLine) return &site;
+    }
+    return nullptr;
+}
+
+static void RecordDuration(std::atomic<uint64_t>& total, std::atomic<uint64_t>& max, std::atomic<uint64_t>* histogram, int64_t micros)
+{
+    const uint64_t duration = micros > 0 ? micros : 0;
+    total.fetch_add(duration, std::memory_order_relaxed);
+    uint64_t prev_max = max.load(std::memory_order_relaxed);
+    while (duration > prev_max && !max.compare_exchange_weak(prev_max, duration, std::memory_order_relaxed)) {}
+    const uint64_t bucket = std::min<uint64_t>(CountBits(duration), LOCK_STATS_HISTOGRAM_BUCKETS - 1);
+    histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void RecordLockAcquired(LockSite* site, bool contended, int64_t wait_micros)
+{
+    if (!site) return;
+    site->acquired.fetch_add(1, std::memory_order_relaxed);
+    if (contended) site->contended.fetch_add(1, std::memory_order_relaxed);
+    RecordDuration(site->wait_total, site->wait_max, site->wait_histogram, wait_micros);
+}
+
+void RecordLockHeld(LockSite* site, int64_t hold_micros)
+{
+    if (!site) return;
+    RecordDuration(site->hold_total, site->hold_max, site->hold_histogram, hold_micros);
+}
+
+void RecordLockTryFailed(LockSite* site)
+{
+    if (!site) return;
+    site->try_failed.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<LockSiteStats> GetLockStats()
+{
+    // A site in a header has one slot per translation unit, merge them.
+    std::map<std::tuple<std::string, int, std::string>, LockSiteStats> merged;
+    for (const LockSite& site : g_lock_sites) {
+        if (site.state.load(std::memory_order_acquire) != LockSite::READY) continue;
+        const uint64_t acquired = site.acquired.load(std::memory_order_relaxed);
+        const uint64_t try_failed = site.try_failed.load(std::memory_order_relaxed);
+        if (acquired == 0 && try_failed == 0) continue;
+
+        LockSiteStats& stats = merged[std::make_tuple(std::string(site.file), site.line, std::string(site.name))];
+        if (stats.wait_histogram.empty()) {
+            stats = LockSiteStats{site.name, site.file, site.line, 0, 0, 0, 0, 0, 0, 0,
+                std::vector<uint64_t>(LOCK_STATS_HISTOGRAM_BUCKETS), std::vector<uint64_t>(LOCK_STATS_HISTOGRAM_BUCKETS)};
+        }
+        stats.acquired += acquired;
+        stats.contended += site.contended.load(std::memory_order_relaxed);
+        stats.try_failed += try_failed;
+        stats.wait_total_micros += site.wait_total.load(std::memory_order_relaxed);
+        stats.wait_max_micros = std::max<uint64_t>(stats.wait_max_micros, site.wait_max.load(std::memory_order_relaxed));
+        stats.hold_total_micros += site.hold_total.load(std::memory_order_relaxed);
+        stats.hold_max_micros = std::max<uint64_t>(stats.hold_max_micros, site.hold_max.load(std::memory_order_relaxed));
+        for (int i = 0; i < LOCK_STATS_HISTOGRAM_BUCKETS; ++i) {
+            stats.wait_histogram[i] += site.wait_histogram[i].load(std::memory_order_relaxed);
+            stats.hold_histogram[i] += site.hold_histogram[i].load(std::memory_order_relaxed);
+        }
+    }
+    std::vector<LockSiteStats> result;
+    result.reserve(merged.size());
+    for (auto& entry : merged) {
+        result.push_back(std::move(entry.second));
+    }
+    return result;
+}
+
+void ResetLockStats()
+{
+    // Locks released concurrently may still add to the counters being cleared.
+    for (LockSite& site : g_lock_sites) {
+        if (site.state.load(std::memory_order_acquire) != LockSite::READY) continue;
+        site.acquired.store(0, std::memory_order_relaxed);
+        site.contended.store(0, std::memory_order_relaxed);
+        site.try_failed.store(0, std::memory_order_relaxed);
+        site.wait_total.store(0, std::memory_order_relaxed);
+        site.wait_max.store(0, std::memory_order_relaxed);
+        site.hold_total.store(0, std::memory_order_relaxed);
+        site.hold_max.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < LOCK_STATS_HISTOGRAM_BUCKETS; ++i) {
+            site.wait_histogram[i].store(0, std::memory_order_relaxed);
+            site.hold_histogram[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
 #ifdef DEBUG_LOCKORDER
 //
 // Early deadlock detection.
@@ -7,10 +7,15 @@
 #define DEFI_SYNC_H
 
 #include <threadsafety.h>
+#include <util/time.h>
 
+#include <atomic>
 #include <condition_variable>
+#include <stdint.h>
+#include <string>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 
 ////////////////////////////////////////////////
@@ -114,14 +119,74 @@ typedef AnnotatedMixin<std::mutex> Mutex;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+/**
+ * Lock profiling: when enabled (-lockstats), every LOCK, LOCK2, TRY_LOCK and
+ * WAIT_LOCK records how long it waited for and held the mutex, aggregated per
+ * source location. When disabled a lock only pays for one relaxed load.
+ */
+static const bool DEFAULT_LOCK_STATS = false;
+/** Histogram bucket i counts durations below 2^i microseconds, the last one everything longer. */
+static const int LOCK_STATS_HISTOGRAM_BUCKETS = 20;
+
+struct LockSite;
+
+struct LockSiteStats {
+    std::string name;
+    std::string file;
+    int line;
+    uint64_t acquired;
+    uint64_t contended;
+    uint64_t try_failed;
+    uint64_t wait_total_micros;
+    uint64_t wait_max_micros;
+    uint64_t hold_total_micros;
+    uint64_t hold_max_micros;
+    std::vector<uint64_t> wait_histogram;
+    std::vector<uint64_t> hold_histogram;
+};
+
+extern std::atomic<bool> g_lock_stats_enabled;
+
+LockSite* GetLockSite(const char* pszName, const char* pszFile, int nLine);
+void RecordLockAcquired(LockSite* site, bool contended, int64_t wait_micros);
+void RecordLockHeld(LockSite* site, int64_t hold_micros);
+void RecordLockTryFailed(LockSite* site);
+/** Statistics of every lock site that was used since the last reset. */
+std::vector<LockSiteStats> GetLockStats();
+void ResetLockStats();
+
 /** Wrapper around std::unique_lock style lock for Mutex. */
 template <typename Mutex, typename Base = typename Mutex::UniqueLock>
 class SCOPED_LOCKABLE UniqueLock : public Base
 {
 private:
+    //! Site and acquisition time of a profiled lock, see g_lock_stats_enabled.
+    LockSite* m_lock_site{nullptr};
+    int64_t m_locked_micros{0};
+
+    void EnterProfiled(const char* pszName, const char* pszFile, int nLine)
+    {
+        m_lock_site = GetLockSite(pszName, pszFile, nLine);
+        int64_t wait_start = 0;
+        const bool contended = !Base::try_lock();
+        if (contended) {
+#ifdef DEBUG_LOCKCONTENTION
+            PrintLockContention(pszName, pszFile, nLine);
+#endif
+            wait_start = GetSteadyMicros();
+            Base::lock();
+        }
+        m_locked_micros = GetSteadyMicros();
+        RecordLockAcquired(m_lock_site, contended, contended ? m_locked_micros - wait_start : 0);
+    }
+
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(Base::mutex()));
+        if (g_lock_stats_enabled.load(std::memory_order_relaxed)) {
+            EnterProfiled(pszName, pszFile, nLine);
+            return;
+        }
 #ifdef DEBUG_LOCKCONTENTION
         if (!Base::try_lock()) {
             PrintLockContention(pszName, pszFile, nLine);
@@ -138,6 +203,15 @@ private:
         Base::try_lock();
         if (!Base::owns_lock())
             LeaveCritical();
+        if (g_lock_stats_enabled.load(std::memory_order_relaxed)) {
+            m_lock_site = GetLockSite(pszName, pszFile, nLine);
+            if (Base::owns_lock()) {
+                m_locked_micros = GetSteadyMicros();
+                RecordLockAcquired(m_lock_site, false, 0);
+            } else {
+                RecordLockTryFailed(m_lock_site);
+            }
+        }
         return Base::owns_lock();
     }
 
@@ -163,8 +237,11 @@ public:
 
     ~UniqueLock() UNLOCK_FUNCTION()
     {
-        if (Base::owns_lock())
+        if (Base::owns_lock()) {
+            // Includes any time spent waiting on a condition variable with this lock.
+            if (m_lock_site) RecordLockHeld(m_lock_site, GetSteadyMicros() - m_locked_micros);
             LeaveCritical();
+        }
     }
 
     operator bool()
@@ -0,0 +1,219 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <dbwrapper.h>
+#include <index/addressindex.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+#include <streams.h>
+#include <test/setup_common.h>
+#include <util/strencodings.h>
+#include <util/system.h>
+#include <util/time.h>
+#include <validation.h>
+#include <version.h>
+
+#include <boost/test/unit_test.hpp>
+
+struct AddressIndexTest {
+    static bool WriteBlock(AddressIndex& index, const CBlock& block, const CBlockIndex* pindex)
+    {
+        return index.WriteBlock(block, pindex);
+    }
+    static bool Rewind(AddressIndex& index, const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+    {
+        return index.Rewind(current_tip, new_tip);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(addressindex_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(addressindex_key_from_destination)
+{
+    AddressIndexType type;
+    uint160 hash;
+
+    const uint160 key_hash = uint160(ParseHex("0102030405060708090a0b0c0d0e0f1011121314"));
+    BOOST_CHECK(GetAddressIndexKey(PKHash(key_hash), type, hash));
+    BOOST_CHECK(type == AddressIndexType::PUBKEYHASH);
+    BOOST_CHECK(hash == key_hash);
+
+    BOOST_CHECK(GetAddressIndexKey(ScriptHash(key_hash), type, hash));
+    BOOST_CHECK(type == AddressIndexType::SCRIPTHASH);
+
+    BOOST_CHECK(GetAddressIndexKey(WitnessV0KeyHash(key_hash), type, hash));
+    BOOST_CHECK(type == AddressIndexType::WITNESS_V0_KEYHASH);
+
+    const uint256 script_hash = InsecureRand256();
+    BOOST_CHECK(GetAddressIndexKey(WitnessV0ScriptHash(script_hash), type, hash));
+    BOOST_CHECK(type == AddressIndexType::WITNESS_V0_SCRIPTHASH);
+    BOOST_CHECK(hash == Hash160(script_hash.begin(), script_hash.end()));
+
+    BOOST_CHECK(!GetAddressIndexKey(CNoDestination(), type, hash));
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_key_roundtrip)
+{
+    CAddressIndexKey key(AddressIndexType::SCRIPTHASH, uint160(std::vector<unsigned char>(20, 0xaa)), 123456, InsecureRand256(), 7, true);
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << key;
+    BOOST_CHECK_EQUAL(ss.size(), 1 + 20 + 4 + 32 + 4 + 1);
+
+    CAddressIndexKey out;
+    ss >> out;
+    BOOST_CHECK(out.type == key.type);
+    BOOST_CHECK(out.hash == key.hash);
+    BOOST_CHECK_EQUAL(out.height, key.height);
+    BOOST_CHECK(out.txid == key.txid);
+    BOOST_CHECK_EQUAL(out.index, key.index);
+    BOOST_CHECK_EQUAL(out.spending, key.spending);
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_key_height_order)
+{
+    // Entries of one address must iterate in height order, so the height has to be big-endian.
+    CDBWrapper dbw(GetDataDir() / "addressindex_key_height_order", 1 << 20, true, false, false);
+    const uint160 hash = uint160(std::vector<unsigned char>(20, 0xbb));
+    const uint160 other = uint160(std::vector<unsigned char>(20, 0xcc));
+    for (int height : {1000, 1, 256, 70000}) {
+        BOOST_CHECK(dbw.Write(std::make_pair('a', CAddressIndexKey(AddressIndexType::PUBKEYHASH, hash, height, uint256(), 0, false)), CAmount(height)));
+    }
+    BOOST_CHECK(dbw.Write(std::make_pair('a', CAddressIndexKey(AddressIndexType::PUBKEYHASH, other, 2, uint256(), 0, false)), CAmount(2)));
+
+    std::unique_ptr<CDBIterator> it(dbw.NewIterator());
+    it->Seek(std::make_pair('a', CAddressIndexKey(AddressIndexType::PUBKEYHASH, hash, 200, uint256(), 0, false)));
+
+    std::vector<int> heights;
+    std::pair<char, CAddressIndexKey> key;
+    for (; it->Valid() && it->GetKey(key) && key.second.hash == hash; it->Next()) {
+        heights.push_back(key.second.height);
+    }
+    BOOST_CHECK(heights == std::vector<int>({256, 1000, 70000}));
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_write_and_rewind, TestChain100Setup)
+{
+    const uint256 masternodeID = testMasternodeKeys.begin()->first;
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    // Spend the first coinbase to a P2PKH output of the same key.
+    const CTransactionRef& coinbase = m_coinbase_txns[0];
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(coinbase->GetHash(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = coinbase->vout[0].nValue - 1000;
+    spend.vout[0].scriptPubKey = GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()));
+    std::vector<unsigned char> sig;
+    const uint256 sighash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_REQUIRE(coinbaseKey.Sign(sighash, sig));
+    sig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << sig;
+
+    const CBlock spend_block = CreateAndProcessBlock({spend}, coinbase_script, masternodeID);
+    const CBlockIndex* tip;
+    {
+        LOCK(cs_main);
+        tip = ::ChainActive().Tip();
+    }
+    BOOST_REQUIRE(tip->GetBlockHash() == spend_block.GetHash());
+
+    AddressIndex index(1 << 20, true);
+    for (int height = 0; height <= tip->nHeight; ++height) {
+        const CBlockIndex* pindex = tip->GetAncestor(height);
+        CBlock block;
+        BOOST_REQUIRE(ReadBlockFromDisk(block, pindex, Params().GetConsensus()));
+        BOOST_REQUIRE(AddressIndexTest::WriteBlock(index, block, pindex));
+    }
+
+    AddressIndexType type;
+    uint160 hash;
+    BOOST_REQUIRE(GetAddressIndexKey(PKHash(coinbaseKey.GetPubKey()), type, hash));
+
+    // Every coinbase output since genesis, the spend of the first one and the new P2PKH output are
+    // recorded.
+    std::vector<std::pair<CAddressIndexKey, CAmount>> entries;
+    BOOST_REQUIRE(index.FindAddressEntries(type, hash, 1, 0, entries));
+    CAmount balance = 0;
+    size_t received = 0, spent = 0;
+    for (const auto& entry : entries) {
+        balance += entry.second;
+        if (entry.first.spending) {
+            ++spent;
+            BOOST_CHECK(entry.first.txid == spend.GetHash());
+            BOOST_CHECK_EQUAL(entry.first.height, tip->nHeight);
+            BOOST_CHECK_EQUAL(entry.second, -coinbase->vout[0].nValue);
+        } else {
+            ++received;
+        }
+    }
+    BOOST_CHECK_EQUAL(spent, 1U);
+    BOOST_CHECK_EQUAL(received, m_coinbase_txns.size() + 2);
+
+    CAmount expected_balance = spend.vout[0].nValue + spend_block.vtx[0]->vout[0].nValue;
+    for (const auto& tx : m_coinbase_txns) {
+        if (tx != coinbase) expected_balance += tx->vout[0].nValue;
+    }
+    BOOST_CHECK_EQUAL(balance, expected_balance);
+
+    CSpentIndexValue value;
+    BOOST_REQUIRE(index.FindSpent(spend.vin[0].prevout, value));
+    BOOST_CHECK(value.txid == spend.GetHash());
+    BOOST_CHECK_EQUAL(value.input_index, 0U);
+    BOOST_CHECK_EQUAL(value.height, tip->nHeight);
+    BOOST_CHECK_EQUAL(value.amount, coinbase->vout[0].nValue);
+    BOOST_CHECK(value.type == type);
+    BOOST_CHECK(value.hash == hash);
+
+    // Rewinding the spending block erases its records and leaves the earlier ones.
+    BOOST_REQUIRE(AddressIndexTest::Rewind(index, tip, tip->pprev));
+    BOOST_CHECK(!index.FindSpent(spend.vin[0].prevout, value));
+
+    entries.clear();
+    BOOST_REQUIRE(index.FindAddressEntries(type, hash, tip->nHeight, tip->nHeight, entries));
+    BOOST_CHECK(entries.empty());
+    entries.clear();
+    BOOST_REQUIRE(index.FindAddressEntries(type, hash, 1, 0, entries));
+    BOOST_CHECK_EQUAL(entries.size(), m_coinbase_txns.size());
+    for (const auto& entry : entries) {
+        BOOST_CHECK(!entry.first.spending);
+        BOOST_CHECK(entry.first.height < tip->nHeight);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_parallel_sync, TestChain100Setup)
+{
+    // Sync in batches prepared on several threads; records must be written in chain order as usual.
+    gArgs.ForceSetArg("-indexsyncthreads", "4");
+    AddressIndex index(1 << 20, true);
+    BOOST_CHECK(!index.BlockUntilSyncedToCurrentChain());
+    index.Start();
+
+    constexpr int64_t timeout_ms = 10 * 1000;
+    const int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    AddressIndexType type;
+    uint160 hash;
+    BOOST_REQUIRE(GetAddressIndexKey(PKHash(coinbaseKey.GetPubKey()), type, hash));
+    std::vector<std::pair<CAddressIndexKey, CAmount>> entries;
+    BOOST_REQUIRE(index.FindAddressEntries(type, hash, 1, 0, entries));
+    BOOST_REQUIRE_EQUAL(entries.size(), m_coinbase_txns.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        BOOST_CHECK_EQUAL(entries[i].first.height, static_cast<int>(i) + 1);
+        BOOST_CHECK(entries[i].first.txid == m_coinbase_txns[i]->GetHash());
+        BOOST_CHECK_EQUAL(entries[i].second, m_coinbase_txns[i]->vout[0].nValue);
+    }
+
+    index.Stop();
+    gArgs.ForceSetArg("-indexsyncthreads", "0");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
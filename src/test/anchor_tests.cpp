@@ -162,5 +162,39 @@ BOOST_AUTO_TEST_CASE(best_anchor_activation_logic)
     BOOST_CHECK(top->txHash == uint256S("bd1"));
 }
 
+BOOST_AUTO_TEST_CASE(confirm_sigs)
+{
+    CAnchorConfirmMessage message;
+    message.btcTxHash = uint256S("bd1");
+    message.anchorHeight = 15;
+    message.prevAnchorHeight = 0;
+    message.rewardKeyType = 1;
+
+    CMasternodesView::CTeam team;
+    std::vector<CAnchorConfirmMessage::Signature> sigs;
+    for (int i = 0; i < 3; ++i) {
+        CKey key;
+        key.MakeNewKey(true);
+        team.insert(key.GetPubKey().GetID());
+        CAnchorConfirmMessage::Signature sig;
+        BOOST_REQUIRE(key.SignCompact(message.GetSignHash(), sig));
+        sigs.push_back(sig);
+    }
+    BOOST_CHECK(message.CheckConfirmSigs(sigs, team));
+    BOOST_CHECK(message.CheckConfirmSigs({}, team));
+
+    // A signer outside of the team
+    CKey outsider;
+    outsider.MakeNewKey(false);
+    CAnchorConfirmMessage::Signature sig;
+    BOOST_REQUIRE(outsider.SignCompact(message.GetSignHash(), sig));
+    sigs.push_back(sig);
+    BOOST_CHECK(!message.CheckConfirmSigs(sigs, team));
+
+    // A signature that recovers no key
+    sigs.back().assign(65, 0);
+    BOOST_CHECK(!message.CheckConfirmSigs(sigs, team));
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,7 +3,9 @@
 #include <stdlib.h>
 
 #include <chain.h>
+#include <clientversion.h>
 #include <rpc/blockchain.h>
+#include <streams.h>
 #include <test/setup_common.h>
 
 /* Equality between doubles is imprecise. Comparison should be done
@@ -69,4 +71,53 @@ BOOST_AUTO_TEST_CASE(get_difficulty_for_very_high_target)
     TestDifficulty(0x12345678, 5913134931067755359633408.0);
 }
 
+BOOST_AUTO_TEST_CASE(block_index_arena)
+{
+    CBlockIndexArena arena;
+    std::set<CBlockIndex*> entries;
+    for (size_t i = 0; i < CBlockIndexArena::CHUNK_SIZE + 1; ++i) {
+        CBlockIndex* pindex = arena.Allocate();
+        BOOST_CHECK(pindex->phashBlock == nullptr && pindex->nStatus == 0 && pindex->sig.empty());
+        pindex->nHeight = i;
+        entries.insert(pindex);
+    }
+    BOOST_CHECK_EQUAL(entries.size(), CBlockIndexArena::CHUNK_SIZE + 1);
+    BOOST_CHECK_EQUAL(arena.Size(), CBlockIndexArena::CHUNK_SIZE + 1);
+    BOOST_CHECK_GE(arena.DynamicMemoryUsage(), 2 * CBlockIndexArena::CHUNK_SIZE * sizeof(CBlockIndex));
+    // Entries of a chunk are contiguous
+    BOOST_CHECK_EQUAL(*entries.begin() + 1, *std::next(entries.begin()));
+    arena.Clear();
+    BOOST_CHECK_EQUAL(arena.Size(), 0U);
+    BOOST_CHECK_EQUAL(arena.DynamicMemoryUsage(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(block_index_sig_serialization)
+{
+    // The inline signature serializes like the header's, so that the on-disk format is unchanged.
+    for (size_t sig_size : {size_t{0}, size_t{CPubKey::COMPACT_SIGNATURE_SIZE}, size_t{CPubKey::COMPACT_SIGNATURE_SIZE + 7}}) {
+        CBlockHeader header;
+        header.nVersion = 1;
+        header.height = 7;
+        header.sig.resize(sig_size);
+        for (size_t i = 0; i < sig_size; ++i) header.sig[i] = i;
+
+        CBlockIndex index(header);
+        BOOST_CHECK(index.GetBlockHeader().sig == header.sig);
+
+        CDataStream index_stream(SER_DISK, CLIENT_VERSION);
+        index_stream << index.sig;
+        CDataStream header_stream(SER_DISK, CLIENT_VERSION);
+        header_stream << header.sig;
+        BOOST_CHECK(index_stream.str() == header_stream.str());
+
+        CDiskBlockIndex disk_index(&index);
+        CDataStream stream(SER_DISK, CLIENT_VERSION);
+        stream << disk_index;
+        CDiskBlockIndex read_index;
+        stream >> read_index;
+        BOOST_CHECK(read_index.sig == index.sig);
+        BOOST_CHECK(read_index.GetBlockHash() == header.GetHash());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
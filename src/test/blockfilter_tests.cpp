@@ -39,6 +39,61 @@ BOOST_AUTO_TEST_CASE(gcsfilter_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(gcsfilter_encoding_test)
+{
+    // Large enough for the radix sort path, with parameters covering long unary quotients (P = 0)
+    // and remainders wider than 32 bits.
+    const uint8_t params_P[] = {0, 1, 19, 20, 32, 40};
+    for (uint8_t P : params_P) {
+        GCSFilter::ElementSet elements;
+        for (int i = 0; i < 2000; ++i) {
+            GCSFilter::Element element(32);
+            element[0] = static_cast<unsigned char>(i);
+            element[1] = static_cast<unsigned char>(i >> 8);
+            element[2] = P;
+            elements.insert(std::move(element));
+        }
+
+        const uint32_t M = P == 0 ? 1 : P >= 32 ? std::numeric_limits<uint32_t>::max() : (1U << P) * 3 / 2;
+        GCSFilter filter({P, 0, P, M}, elements);
+
+        // Decode the filter with the generic bit stream reader and re-encode it with the generic
+        // bit stream writer, which must reproduce the encoding exactly.
+        VectorReader stream(SER_NETWORK, 0, filter.GetEncoded(), 0);
+        BOOST_CHECK_EQUAL(ReadCompactSize(stream), elements.size());
+        std::vector<unsigned char> reencoded;
+        CVectorWriter writer(SER_NETWORK, 0, reencoded, 0);
+        WriteCompactSize(writer, elements.size());
+        {
+            BitStreamReader<VectorReader> bitreader(stream);
+            BitStreamWriter<CVectorWriter> bitwriter(writer);
+            for (size_t i = 0; i < elements.size(); ++i) {
+                uint64_t q = 0;
+                while (bitreader.Read(1) == 1) ++q;
+                uint64_t r = P > 0 ? bitreader.Read(P) : 0;
+                for (uint64_t j = 0; j < q; ++j) bitwriter.Write(1, 1);
+                bitwriter.Write(0, 1);
+                if (P > 0) bitwriter.Write(r, P);
+            }
+        }
+        BOOST_CHECK(stream.empty());
+        BOOST_CHECK(reencoded == filter.GetEncoded());
+
+        GCSFilter decoded(filter.GetParams(), filter.GetEncoded());
+        for (const auto& element : elements) {
+            BOOST_CHECK(decoded.Match(element));
+        }
+
+        std::vector<unsigned char> truncated = filter.GetEncoded();
+        truncated.pop_back();
+        BOOST_CHECK_THROW(GCSFilter(filter.GetParams(), truncated), std::ios_base::failure);
+
+        std::vector<unsigned char> excess = filter.GetEncoded();
+        excess.push_back(0);
+        BOOST_CHECK_THROW(GCSFilter(filter.GetParams(), excess), std::ios_base::failure);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(gcsfilter_default_constructor)
 {
     GCSFilter filter;
@@ -13,6 +13,7 @@
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
 #include <crypto/sha512.h>
+#include <hash.h>
 #include <random.h>
 #include <util/strencodings.h>
 #include <test/setup_common.h>
@@ -749,4 +750,26 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+BOOST_AUTO_TEST_CASE(sha256_multi)
+{
+    // Sizes around the padding and block boundaries, and beyond a few blocks.
+    static const size_t SIZES[] = {0, 1, 31, 32, 33, 55, 56, 63, 64, 65, 119, 120, 128, 250, 1000};
+    for (size_t count = 0; count <= 40; ++count) {
+        std::vector<std::vector<unsigned char>> messages(count);
+        std::vector<Span<const unsigned char>> spans;
+        for (auto& message : messages) {
+            message = g_insecure_rand_ctx.randbytes(SIZES[InsecureRandRange(sizeof(SIZES) / sizeof(SIZES[0]))]);
+            spans.push_back(MakeSpan(message));
+        }
+        const std::vector<uint256> hashes = HashBatch(spans);
+        const std::vector<uint160> hashes160 = Hash160Batch(spans);
+        BOOST_REQUIRE_EQUAL(hashes.size(), count);
+        BOOST_REQUIRE_EQUAL(hashes160.size(), count);
+        for (size_t i = 0; i < count; ++i) {
+            BOOST_CHECK(hashes[i] == Hash(messages[i].begin(), messages[i].end()));
+            BOOST_CHECK(hashes160[i] == Hash160(messages[i]));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
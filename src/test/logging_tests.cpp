@@ -0,0 +1,101 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <logging.h>
+
+#include <test/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+namespace {
+/** Lines added to the debug log since the given size. */
+std::vector<std::string> ReadLogLines(uintmax_t since)
+{
+    std::ifstream file(LogInstance().m_file_path.string());
+    file.seekg(since);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) lines.push_back(line);
+    return lines;
+}
+
+size_t CountLines(const std::vector<std::string>& lines, const std::string& text)
+{
+    return std::count_if(lines.begin(), lines.end(), [&text](const std::string& line) { return line.find(text) != std::string::npos; });
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(logging_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(async_logging)
+{
+    const uintmax_t start_size = fs::file_size(LogInstance().m_file_path);
+    LogInstance().StartAsyncWriter();
+    BOOST_CHECK(LogInstance().Async());
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 200; ++i) {
+                LogPrintf("async thread %d line %d %s\n", t, i, std::string("text"));
+            }
+            // A pointer is not kept for deferred formatting, so this one is formatted right away.
+            int value = 0;
+            LogPrintf("async thread %d pointer %p\n", t, (void*)&value);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    LogInstance().StopAsyncWriter();
+    BOOST_CHECK(!LogInstance().Async());
+    LogPrintf("async logging stopped\n");
+
+    const std::vector<std::string> lines = ReadLogLines(start_size);
+    BOOST_CHECK_EQUAL(CountLines(lines, "async thread "), 4U * 201);
+    BOOST_CHECK_EQUAL(CountLines(lines, "Dropped"), 0U);
+    BOOST_CHECK_EQUAL(CountLines(lines, " pointer 0x"), 4U);
+    // The messages of each thread are written in order, and before the ones logged later.
+    std::vector<int> next_line(4, 0);
+    for (const std::string& line : lines) {
+        int t, i;
+        if (sscanf(line.c_str() + line.find("async thread"), "async thread %d line %d text", &t, &i) == 2) {
+            BOOST_CHECK_EQUAL(i, next_line[t]++);
+        }
+    }
+    BOOST_REQUIRE(!lines.empty());
+    BOOST_CHECK(lines.back().find("async logging stopped") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(rate_limit)
+{
+    const uintmax_t start_size = fs::file_size(LogInstance().m_file_path);
+    LogInstance().SetRateLimit(3);
+    for (int i = 0; i < 10; ++i) {
+        LogPrintf("rate limited line %d\n", i);
+    }
+    // Call sites are limited separately, even when they share a format string.
+    for (int i = 0; i < 2; ++i) {
+        LogPrintf("rate limited line %d\n", i);
+    }
+    LogInstance().SetRateLimit(0);
+    LogPrintf("not rate limited\n");
+    LogInstance().LogSuppressed();
+
+    const std::vector<std::string> lines = ReadLogLines(start_size);
+    // Unless a new minute started in between
+    BOOST_CHECK_GE(CountLines(lines, "rate limited line"), 5U);
+    BOOST_CHECK_LE(CountLines(lines, "rate limited line"), 9U);
+    BOOST_CHECK_EQUAL(CountLines(lines, "not rate limited"), 1U);
+    // The summary names the call site, and is only logged once.
+    BOOST_CHECK_GE(CountLines(lines, "logging_tests.cpp:"), 1U);
+    BOOST_CHECK_LE(CountLines(lines, "logging_tests.cpp:"), 2U);
+    LogInstance().LogSuppressed();
+    BOOST_CHECK_EQUAL(CountLines(ReadLogLines(start_size), "Suppressed"), CountLines(lines, "Suppressed"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
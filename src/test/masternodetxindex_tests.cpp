@@ -0,0 +1,150 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/masternodetxindex.h>
+#include <key.h>
+#include <masternodes/masternodes.h>
+#include <script/standard.h>
+#include <streams.h>
+#include <test/setup_common.h>
+#include <validation.h>
+#include <version.h>
+
+#include <boost/test/unit_test.hpp>
+
+struct MasternodeTxIndexTest {
+    static bool WriteBlock(MasternodeTxIndex& index, const CBlock& block, const CBlockIndex* pindex)
+    {
+        return index.WriteBlock(block, pindex);
+    }
+};
+
+static CMutableTransaction DfTx(const CDataStream& metadata, const std::vector<COutPoint>& inputs, const CScript& output)
+{
+    CMutableTransaction tx;
+    for (const auto& input : inputs) {
+        tx.vin.emplace_back(input);
+    }
+    tx.vout.emplace_back(0, CScript() << OP_RETURN << ToByteVector(metadata));
+    tx.vout.emplace_back(COIN, output);
+    return tx;
+}
+
+static CMutableTransaction CreateMasternodeTx(const CKey& owner, const CKey& operator_key)
+{
+    CDataStream metadata(DfTxMarker, SER_NETWORK, PROTOCOL_VERSION);
+    metadata << static_cast<unsigned char>(MasternodesTxType::CreateMasternode)
+             << static_cast<char>(1) << operator_key.GetPubKey().GetID();
+    return DfTx(metadata, {COutPoint(InsecureRand256(), 0)}, GetScriptForDestination(PKHash(owner.GetPubKey())));
+}
+
+static CMutableTransaction ResignMasternodeTx(const uint256& mnid, const std::vector<COutPoint>& inputs)
+{
+    CDataStream metadata(DfTxMarker, SER_NETWORK, PROTOCOL_VERSION);
+    metadata << static_cast<unsigned char>(MasternodesTxType::ResignMasternode) << mnid;
+    return DfTx(metadata, inputs, CScript() << OP_TRUE);
+}
+
+static CBlock MakeBlock(const std::vector<CMutableTransaction>& txs)
+{
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].prevout.SetNull();
+    coinbase.vin[0].scriptSig = CScript() << InsecureRand32();
+    coinbase.vout.emplace_back(COIN, CScript() << OP_TRUE);
+
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    for (const auto& tx : txs) {
+        block.vtx.push_back(MakeTransactionRef(tx));
+    }
+    return block;
+}
+
+static void ApplyCreate(const CTransaction& tx, int height, int txn)
+{
+    std::vector<unsigned char> metadata;
+    BOOST_REQUIRE(GuessMasternodeTxType(tx, metadata) == MasternodesTxType::CreateMasternode);
+    LOCK(cs_main);
+    BOOST_REQUIRE(pmasternodesview->OnMasternodeCreate(tx.GetHash(), CMasternode(tx, height, metadata), txn));
+}
+
+static std::vector<CMasternodeTxIndexEntry> FindTxs(const MasternodeTxIndex& index, const uint256& id)
+{
+    std::vector<CMasternodeTxIndexEntry> entries;
+    BOOST_CHECK(index.FindTxs(id, 0, 0, 100, entries));
+    return entries;
+}
+
+static void CheckEntry(const CMasternodeTxIndexEntry& entry, int height, uint32_t txn, const uint256& txid, MasternodeTxKind kind)
+{
+    BOOST_CHECK_EQUAL(entry.height, height);
+    BOOST_CHECK_EQUAL(entry.txn, txn);
+    BOOST_CHECK(entry.txid == txid);
+    BOOST_CHECK(entry.kind == kind);
+}
+
+BOOST_FIXTURE_TEST_SUITE(masternodetxindex_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(masternodetxindex_applied_txs)
+{
+    MasternodeTxIndex index(1 << 20, true);
+    CKey owner_a, owner_b, owner_c, operator_a, operator_c;
+    for (CKey* key : {&owner_a, &owner_b, &owner_c, &operator_a, &operator_c}) {
+        key->MakeNewKey(true);
+    }
+
+    // Block 10: masternode A is created; B reuses A's operator, so consensus rejects it.
+    const CTransaction create_a(CreateMasternodeTx(owner_a, operator_a));
+    const CTransaction create_b(CreateMasternodeTx(owner_b, operator_a));
+    CBlockIndex index10;
+    index10.nHeight = 10;
+    ApplyCreate(create_a, 10, 1);
+    BOOST_REQUIRE(MasternodeTxIndexTest::WriteBlock(index, MakeBlock({CMutableTransaction(create_a), CMutableTransaction(create_b)}), &index10));
+
+    // Block 11: A resigns spending its own collateral; C is created and its collateral spent.
+    const CTransaction resign_a(ResignMasternodeTx(create_a.GetHash(), {COutPoint(create_a.GetHash(), 1)}));
+    const CTransaction create_c(CreateMasternodeTx(owner_c, operator_c));
+    CMutableTransaction spend_c;
+    spend_c.vin.emplace_back(COutPoint(create_c.GetHash(), 1));
+    spend_c.vout.emplace_back(COIN, CScript() << OP_TRUE);
+    CBlockIndex index11;
+    index11.nHeight = 11;
+    {
+        LOCK(cs_main);
+        BOOST_REQUIRE(pmasternodesview->OnMasternodeResign(create_a.GetHash(), resign_a.GetHash(), 11, 1));
+    }
+    ApplyCreate(create_c, 11, 2);
+    BOOST_REQUIRE(MasternodeTxIndexTest::WriteBlock(index, MakeBlock({CMutableTransaction(resign_a), CMutableTransaction(create_c), spend_c}), &index11));
+
+    // The resignation and the collateral spend of A share (height, txn) and are both kept.
+    auto entries = FindTxs(index, create_a.GetHash());
+    BOOST_REQUIRE_EQUAL(entries.size(), 3U);
+    CheckEntry(entries[0], 10, 1, create_a.GetHash(), MasternodeTxKind::CreateMasternode);
+    CheckEntry(entries[1], 11, 1, resign_a.GetHash(), MasternodeTxKind::ResignMasternode);
+    CheckEntry(entries[2], 11, 1, resign_a.GetHash(), MasternodeTxKind::CollateralSpend);
+
+    // The rejected creation is not indexed, by id or by address.
+    BOOST_CHECK(FindTxs(index, create_b.GetHash()).empty());
+    std::vector<CMasternodeTxIndexEntry> by_address;
+    BOOST_CHECK(index.FindTxs(owner_b.GetPubKey().GetID(), 0, 0, 100, by_address));
+    BOOST_CHECK(by_address.empty());
+    BOOST_CHECK(index.FindTxs(operator_a.GetPubKey().GetID(), 0, 0, 100, by_address));
+    BOOST_REQUIRE_EQUAL(by_address.size(), 1U);
+    CheckEntry(by_address[0], 10, 1, create_a.GetHash(), MasternodeTxKind::CreateMasternode);
+
+    // A collateral spent in the block creating the masternode is recorded.
+    entries = FindTxs(index, create_c.GetHash());
+    BOOST_REQUIRE_EQUAL(entries.size(), 2U);
+    CheckEntry(entries[0], 11, 2, create_c.GetHash(), MasternodeTxKind::CreateMasternode);
+    CheckEntry(entries[1], 11, 3, spend_c.GetHash(), MasternodeTxKind::CollateralSpend);
+
+    // Paging starts at the given position.
+    std::vector<CMasternodeTxIndexEntry> page;
+    BOOST_CHECK(index.FindTxs(create_a.GetHash(), 11, 0, 1, page));
+    BOOST_REQUIRE_EQUAL(page.size(), 1U);
+    CheckEntry(page[0], 11, 1, resign_a.GetHash(), MasternodeTxKind::ResignMasternode);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <policy/policy.h>
+#include <script/interpreter.h>
 #include <txmempool.h>
 #include <util/system.h>
 #include <util/time.h>
@@ -751,4 +752,34 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTests)
     BOOST_CHECK_EQUAL(descendants, 6ULL);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolVerifiedScriptsTest)
+{
+    TestMemPoolEntryHelper entry;
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].scriptSig = CScript() << OP_11;
+    tx.vout.resize(1);
+    tx.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    tx.vout[0].nValue = 10 * COIN;
+
+    CTxMemPoolEntry mempool_entry = entry.FromTx(tx);
+    BOOST_CHECK(!mempool_entry.GetPrecomputedData());
+    BOOST_CHECK(!mempool_entry.ScriptsVerifiedWith(SCRIPT_VERIFY_NONE));
+
+    const size_t usage = mempool_entry.DynamicMemoryUsage();
+    const auto txdata = std::make_shared<const PrecomputedTransactionData>(CTransaction(tx));
+    mempool_entry.SetVerifiedScripts(txdata, SCRIPT_VERIFY_P2SH);
+    BOOST_CHECK(mempool_entry.GetPrecomputedData() == txdata);
+    BOOST_CHECK(mempool_entry.ScriptsVerifiedWith(SCRIPT_VERIFY_P2SH));
+    BOOST_CHECK(!mempool_entry.ScriptsVerifiedWith(SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_WITNESS));
+    BOOST_CHECK(mempool_entry.DynamicMemoryUsage() > usage);
+
+    // The data stays with the entry in the pool.
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+    pool.addUnchecked(mempool_entry);
+    const auto it = pool.mapTx.find(tx.GetHash());
+    BOOST_CHECK(it != pool.mapTx.end() && it->GetPrecomputedData() == txdata);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
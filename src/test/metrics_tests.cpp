@@ -0,0 +1,75 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <metrics.h>
+
+#include <test/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+BOOST_FIXTURE_TEST_SUITE(metrics_tests, BasicTestingSetup)
+
+static bool Contains(const std::string& text, const std::string& part)
+{
+    return text.find(part) != std::string::npos;
+}
+
+BOOST_AUTO_TEST_CASE(render_counter_and_gauges)
+{
+    metrics::Counter counter{"test_requests_total", "Requests served"};
+    counter.Inc();
+    counter.Inc(2);
+    BOOST_CHECK_EQUAL(counter.Value(), 3U);
+
+    metrics::Gauge gauge_a{"test_items", "Items by kind", "kind=\"a\""};
+    metrics::Counter other{"test_other_total", "Registered in between"};
+    metrics::Gauge gauge_b{"test_items", "Items by kind", "kind=\"b\""};
+    gauge_a.Set(5);
+    gauge_b.Set(7);
+    gauge_b.Add(-10);
+
+    const std::string text = metrics::Render();
+    BOOST_CHECK(Contains(text, "# HELP test_requests_total Requests served\n# TYPE test_requests_total counter\ntest_requests_total 3\n"));
+    // Series of the same name are grouped under a single HELP and TYPE header.
+    BOOST_CHECK(Contains(text, "# HELP test_items Items by kind\n# TYPE test_items gauge\ntest_items{kind=\"a\"} 5\ntest_items{kind=\"b\"} -3\n"));
+    BOOST_CHECK(Contains(text, "# TYPE test_other_total counter\ntest_other_total 0\n"));
+
+    // The node's own metrics are always registered.
+    BOOST_CHECK(Contains(text, "# TYPE defi_block_connect_seconds histogram\n"));
+    BOOST_CHECK(Contains(text, "defi_masternodes{state=\"ENABLED\"} "));
+    BOOST_CHECK(Contains(text, "defi_peers{direction=\"inbound\"} "));
+}
+
+BOOST_AUTO_TEST_CASE(unregister_on_destruction)
+{
+    {
+        metrics::Gauge gauge{"test_scoped", "Destroyed at the end of the scope"};
+        BOOST_CHECK(Contains(metrics::Render(), "test_scoped 0\n"));
+    }
+    BOOST_CHECK(!Contains(metrics::Render(), "test_scoped"));
+}
+
+BOOST_AUTO_TEST_CASE(render_histogram)
+{
+    metrics::DurationHistogram histogram{"test_duration_seconds", "Durations", "stage=\"x\""};
+    histogram.Observe(500);       // first bucket
+    histogram.Observe(1000);      // bounds are inclusive
+    histogram.Observe(30000);     // 0.05
+    histogram.Observe(120000000); // +Inf only
+    BOOST_CHECK_EQUAL(histogram.Count(), 4U);
+
+    const std::string text = metrics::Render();
+    BOOST_CHECK(Contains(text, "# TYPE test_duration_seconds histogram\n"));
+    BOOST_CHECK(Contains(text, "test_duration_seconds_bucket{stage=\"x\",le=\"0.001\"} 2\n"));
+    BOOST_CHECK(Contains(text, "test_duration_seconds_bucket{stage=\"x\",le=\"0.025\"} 2\n"));
+    BOOST_CHECK(Contains(text, "test_duration_seconds_bucket{stage=\"x\",le=\"0.05\"} 3\n"));
+    BOOST_CHECK(Contains(text, "test_duration_seconds_bucket{stage=\"x\",le=\"60\"} 3\n"));
+    BOOST_CHECK(Contains(text, "test_duration_seconds_bucket{stage=\"x\",le=\"+Inf\"} 4\n"));
+    BOOST_CHECK(Contains(text, "test_duration_seconds_sum{stage=\"x\"} 120.031500\n"));
+    BOOST_CHECK(Contains(text, "test_duration_seconds_count{stage=\"x\"} 4\n"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 #include <pos.h>
 #include <pos_kernel.h>
 #include <util/system.h>
+#include <validation.h>
 #include <script/signingprovider.h>
 
 #include <test/setup_common.h>
@@ -208,4 +209,55 @@ BOOST_AUTO_TEST_CASE(sign_pos_block)
 //    BOOST_CHECK(pos::CheckProofOfStake(*(CBlockHeader*)correctBlock.get(), ::ChainActive().Tip(), Params().GetConsensus(), pmasternodesview.get()));
 }
 
+BOOST_AUTO_TEST_CASE(minter_key_cache)
+{
+    CKey minterKey = testMasternodeKeys.begin()->second.operatorKey;
+    CKey otherKey;
+    otherKey.MakeNewKey(true);
+
+    std::vector<CBlockHeader> headers;
+    uint256 prevHash = Params().GenesisBlock().GetHash();
+    for (uint64_t height = 1; height <= 10; ++height) {
+        std::shared_ptr<CBlock> block = Block(prevHash, height, height);
+        block->hashMerkleRoot = BlockMerkleRoot(*block);
+        BOOST_CHECK(!pos::SignPosBlock(block, height % 2 ? minterKey : otherKey));
+        headers.push_back(*block);
+        prevHash = block->GetHash();
+    }
+
+    // Cached and freshly recovered keys agree, both for prefetched and for unseen headers.
+    for (bool prefetch : {false, true}) {
+        ClearMinterKeyCache();
+        if (prefetch) {
+            BOOST_CHECK_EQUAL(PrefetchMinterKeys(headers), headers.size());
+        }
+        for (const CBlockHeader& header : headers) {
+            CKeyID cached, recovered;
+            BOOST_CHECK(GetMinterKey(header, cached));
+            BOOST_CHECK(header.ExtractMinterKey(recovered));
+            BOOST_CHECK(cached == recovered);
+            BOOST_CHECK(cached == (header.height % 2 ? minterKey : otherKey).GetPubKey().GetID());
+        }
+    }
+
+    // Only headers connecting to the block index and to each other are prefetched.
+    std::vector<CBlockHeader> unconnected(headers.begin() + 1, headers.end());
+    BOOST_CHECK_EQUAL(PrefetchMinterKeys(unconnected), 0U);
+    std::vector<CBlockHeader> gap(headers);
+    gap.erase(gap.begin() + 4);
+    BOOST_CHECK_EQUAL(PrefetchMinterKeys(gap), 4U);
+    BOOST_CHECK_EQUAL(PrefetchMinterKeys({}), 0U);
+
+    // The cache is keyed by the full header hash, so a changed signature is recovered again.
+    CBlockHeader header = headers.front();
+    BOOST_CHECK(otherKey.SignCompact(header.GetHashToSign(), header.sig));
+    CKeyID minter;
+    BOOST_CHECK(GetMinterKey(header, minter));
+    BOOST_CHECK(minter == otherKey.GetPubKey().GetID());
+
+    header.sig = {};
+    BOOST_CHECK(!GetMinterKey(header, minter));
+    BOOST_CHECK(!pos::CheckHeaderSignature(header));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -10,6 +10,9 @@
 #include <boost/thread.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+#include <map>
+
 BOOST_AUTO_TEST_SUITE(scheduler_tests)
 
 static void microTask(CScheduler& s, boost::mutex& mutex, int& counter, int delta, boost::chrono::system_clock::time_point rescheduleTime)
@@ -155,4 +158,98 @@ BOOST_AUTO_TEST_CASE(singlethreadedscheduler_ordered)
     BOOST_CHECK_EQUAL(counter2, 100);
 }
 
+BOOST_AUTO_TEST_CASE(timer_wheel_order)
+{
+    CScheduler scheduler;
+
+    // Spread over the first two levels of the wheel, and into the second
+    // slot of the first level, with ties run in the order of scheduling.
+    const boost::chrono::system_clock::time_point start = boost::chrono::system_clock::now();
+    const int delays[] = {150, 3, 70, 0, 70, -5, 1, 64, 130, 3};
+    std::vector<int> order;
+    std::vector<boost::chrono::system_clock::time_point> run_times;
+    boost::mutex mutex;
+    for (int i = 0; i < 10; ++i) {
+        scheduler.schedule([i, &order, &run_times, &mutex] {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            order.push_back(i);
+            run_times.push_back(boost::chrono::system_clock::now());
+        }, start + boost::chrono::milliseconds(delays[i]));
+    }
+
+    // Nothing beyond the range of the wheel is ever lost.
+    scheduler.schedule([] {}, start + boost::chrono::hours(24 * 7));
+    boost::chrono::system_clock::time_point first, last;
+    BOOST_CHECK_EQUAL(scheduler.getQueueInfo(first, last), 11U);
+    BOOST_CHECK(first == start + boost::chrono::milliseconds(-5));
+    BOOST_CHECK(last == start + boost::chrono::hours(24 * 7));
+
+    boost::thread service_thread(std::bind(&CScheduler::serviceQueue, &scheduler));
+    for (int i = 0; i < 100; ++i) {
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (order.size() == 10) break;
+        }
+        MicroSleep(10000);
+    }
+    scheduler.stop(false);
+    service_thread.join();
+
+    const std::vector<int> expected{5, 3, 6, 1, 9, 7, 2, 4, 8, 0};
+    BOOST_CHECK(order == expected);
+    for (size_t i = 0; i < order.size(); ++i) {
+        BOOST_CHECK(run_times[i] >= start + boost::chrono::milliseconds(delays[order[i]]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(task_class_concurrency)
+{
+    CScheduler scheduler;
+    scheduler.SetTaskClassConcurrency("slow", 1);
+
+    boost::thread_group threads;
+    for (int i = 0; i < 3; ++i) {
+        threads.create_thread(std::bind(&CScheduler::serviceQueue, &scheduler));
+    }
+
+    // The slow tasks could take every thread, but only one of them runs at
+    // a time and the other tasks are serviced meanwhile.
+    std::atomic<int> slow_running{0};
+    std::atomic<int> slow_running_max{0};
+    std::atomic<int> slow_done{0};
+    std::atomic<int> fast_done{0};
+    std::atomic<int> slow_done_before_fast{-1};
+    for (int i = 0; i < 3; ++i) {
+        scheduler.schedule([&] {
+            const int running = ++slow_running;
+            if (running > slow_running_max) slow_running_max = running;
+            MicroSleep(50000);
+            --slow_running;
+            ++slow_done;
+        }, boost::chrono::system_clock::now(), "slow");
+    }
+    scheduler.schedule([&] {
+        slow_done_before_fast = slow_done.load();
+        ++fast_done;
+    }, boost::chrono::system_clock::now() + boost::chrono::milliseconds(5), "fast");
+
+    scheduler.stop(true);
+    threads.join_all();
+
+    BOOST_CHECK_EQUAL(slow_done, 3);
+    BOOST_CHECK_EQUAL(fast_done, 1);
+    BOOST_CHECK_EQUAL(slow_running_max, 1);
+    BOOST_CHECK(slow_done_before_fast < 3);
+
+    std::map<std::string, CScheduler::TaskClassStats> stats;
+    for (const auto& class_stats : scheduler.GetTaskClassStats()) {
+        stats[class_stats.name] = class_stats;
+    }
+    BOOST_CHECK_EQUAL(stats["slow"].runs, 3U);
+    BOOST_CHECK(stats["slow"].run_micros_max >= 50000);
+    BOOST_CHECK(stats["slow"].run_micros_total >= 150000);
+    BOOST_CHECK(stats["slow"].delay_micros_max >= 100000);
+    BOOST_CHECK_EQUAL(stats["fast"].runs, 1U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
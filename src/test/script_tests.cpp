@@ -6,6 +6,7 @@
 
 #include <core_io.h>
 #include <key.h>
+#include <policy/policy.h>
 #include <script/script.h>
 #include <script/script_error.h>
 #include <script/sign.h>
@@ -1520,6 +1521,105 @@ BOOST_AUTO_TEST_CASE(script_can_append_self)
     BOOST_CHECK(s == d);
 }
 
+/** Counts the signature checks, to make sure no spend has its signature verified twice. */
+class CountingSignatureChecker : public MutableTransactionSignatureChecker
+{
+public:
+    mutable int calls = 0;
+
+    using MutableTransactionSignatureChecker::MutableTransactionSignatureChecker;
+
+    bool CheckSig(const std::vector<unsigned char>& scriptSig, const std::vector<unsigned char>& vchPubKey, const CScript& scriptCode, SigVersion sigversion) const override
+    {
+        ++calls;
+        return MutableTransactionSignatureChecker::CheckSig(scriptSig, vchPubKey, scriptCode, sigversion);
+    }
+};
+
+/* Spends of the single key templates are verified by a fast path, which must
+ * give exactly the interpreter's results and errors. */
+BOOST_AUTO_TEST_CASE(script_keyhash_templates)
+{
+    unsigned int flags = STANDARD_SCRIPT_VERIFY_FLAGS;
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    const CScript keyHashScript = GetScriptForDestination(PKHash(pubkey));
+    const CScript witnessProgram = GetScriptForDestination(WitnessV0KeyHash(pubkey.GetID()));
+    const CScript p2shScript = GetScriptForDestination(ScriptHash(witnessProgram));
+
+    auto verify = [&](const CScript& scriptPubKey, const CScript& scriptSig, const CScriptWitness& witness, ScriptError expected) {
+        const CTransaction txCredit{BuildCreditingTransaction(scriptPubKey, 1)};
+        CMutableTransaction tx = BuildSpendingTransaction(scriptSig, witness, txCredit);
+        ScriptError err;
+        const CountingSignatureChecker checker(&tx, 0, 1);
+        const bool success = VerifyScript(scriptSig, scriptPubKey, &witness, flags, checker, &err);
+        BOOST_CHECK_EQUAL(success, expected == SCRIPT_ERR_OK);
+        BOOST_CHECK_MESSAGE(err == expected, FormatScriptError(err) + std::string(" where ") + FormatScriptError(expected) + " expected");
+        BOOST_CHECK_LE(checker.calls, 1);
+    };
+    auto sign = [&](const CScript& scriptPubKey, const CScript& scriptSig, const CScriptWitness& witness, SigVersion sigversion) {
+        const CTransaction txCredit{BuildCreditingTransaction(scriptPubKey, 1)};
+        CMutableTransaction tx = BuildSpendingTransaction(scriptSig, witness, txCredit);
+        std::vector<unsigned char> sig;
+        BOOST_CHECK(key.Sign(SignatureHash(keyHashScript, tx, 0, SIGHASH_ALL, 1, sigversion), sig));
+        sig.push_back(SIGHASH_ALL);
+        return sig;
+    };
+    const std::vector<unsigned char> pubkeyData = ToByteVector(pubkey);
+    std::vector<unsigned char> otherPubkey = pubkeyData;
+    otherPubkey[1] ^= 1;
+
+    // P2PKH
+    const std::vector<unsigned char> sig = sign(keyHashScript, CScript(), CScriptWitness(), SigVersion::BASE);
+    verify(keyHashScript, CScript() << sig << pubkeyData, CScriptWitness(), SCRIPT_ERR_OK);
+    verify(keyHashScript, CScript() << sig << otherPubkey, CScriptWitness(), SCRIPT_ERR_EQUALVERIFY);
+    verify(keyHashScript, CScript() << std::vector<unsigned char>(sig.begin(), sig.end() - 1) << pubkeyData, CScriptWitness(), SCRIPT_ERR_SIG_DER);
+    verify(keyHashScript, CScript() << OP_0 << pubkeyData, CScriptWitness(), SCRIPT_ERR_EVAL_FALSE);
+    verify(keyHashScript, CScript() << OP_1 << sig << pubkeyData, CScriptWitness(), SCRIPT_ERR_CLEANSTACK);
+    CScriptWitness unexpected;
+    unexpected.stack.push_back({1});
+    verify(keyHashScript, CScript() << sig << pubkeyData, unexpected, SCRIPT_ERR_WITNESS_UNEXPECTED);
+
+    // P2WPKH and P2SH-P2WPKH
+    const std::vector<unsigned char> witnessSig = sign(witnessProgram, CScript(), CScriptWitness(), SigVersion::WITNESS_V0);
+    CScriptWitness witness;
+    witness.stack = {witnessSig, pubkeyData};
+    verify(witnessProgram, CScript(), witness, SCRIPT_ERR_OK);
+    verify(witnessProgram, CScript() << OP_0, witness, SCRIPT_ERR_WITNESS_MALLEATED);
+
+    const CScript redeemPush = CScript() << ToByteVector(witnessProgram);
+    CScriptWitness p2shWitness;
+    p2shWitness.stack = {sign(p2shScript, redeemPush, CScriptWitness(), SigVersion::WITNESS_V0), pubkeyData};
+    verify(p2shScript, redeemPush, p2shWitness, SCRIPT_ERR_OK);
+    verify(p2shScript, CScript() << OP_0 << ToByteVector(witnessProgram), p2shWitness, SCRIPT_ERR_WITNESS_MALLEATED_P2SH);
+
+    CScriptWitness wrongKey = witness;
+    wrongKey.stack[1] = otherPubkey;
+    verify(witnessProgram, CScript(), wrongKey, SCRIPT_ERR_EQUALVERIFY);
+    p2shWitness.stack[1] = otherPubkey;
+    verify(p2shScript, redeemPush, p2shWitness, SCRIPT_ERR_EQUALVERIFY);
+
+    CScriptWitness extraItem = witness;
+    extraItem.stack.push_back({});
+    verify(witnessProgram, CScript(), extraItem, SCRIPT_ERR_WITNESS_PROGRAM_MISMATCH);
+
+    CScriptWitness badSig = witness;
+    badSig.stack[0][10] ^= 1;
+    verify(witnessProgram, CScript(), badSig, SCRIPT_ERR_SIG_NULLFAIL);
+
+    // A witness signature does not satisfy the base script, nor the other way around.
+    verify(keyHashScript, CScript() << witnessSig << pubkeyData, CScriptWitness(), SCRIPT_ERR_SIG_NULLFAIL);
+    witness.stack[0] = sig;
+    verify(witnessProgram, CScript(), witness, SCRIPT_ERR_SIG_NULLFAIL);
+
+    // Without NULLFAIL a failed signature check leaves false on the stack.
+    flags &= ~SCRIPT_VERIFY_NULLFAIL;
+    verify(keyHashScript, CScript() << witnessSig << pubkeyData, CScriptWitness(), SCRIPT_ERR_EVAL_FALSE);
+    verify(witnessProgram, CScript(), witness, SCRIPT_ERR_EVAL_FALSE);
+    verify(witnessProgram, CScript(), badSig, SCRIPT_ERR_EVAL_FALSE);
+}
+
 
 #if defined(HAVE_CONSENSUS_LIB)
 
@@ -267,6 +267,37 @@ BOOST_AUTO_TEST_CASE(vector_bool)
     BOOST_CHECK(SerializeHash(vec1) == SerializeHash(vec2));
 }
 
+BOOST_AUTO_TEST_CASE(vector_raw_elements)
+{
+    // Vectors of raw serializable types are written as a blob, which must
+    // match serializing the elements one by one.
+    std::vector<uint32_t> ints{0, 1, 0x01020304, 0xffffffff};
+    std::vector<uint256> hashes{uint256(), uint256S("0102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f20")};
+    prevector<4, int64_t> longs;
+    longs.push_back(-1);
+    longs.push_back(0x0102030405060708);
+
+    CDataStream raw(SER_DISK, 0, ints, hashes, longs);
+    CDataStream each(SER_DISK, 0);
+    WriteCompactSize(each, ints.size());
+    for (uint32_t i : ints) each << i;
+    WriteCompactSize(each, hashes.size());
+    for (const uint256& hash : hashes) each << hash;
+    WriteCompactSize(each, longs.size());
+    for (int64_t l : longs) each << l;
+    BOOST_CHECK_EQUAL(HexStr(raw), HexStr(each));
+    BOOST_CHECK_EQUAL(raw.size(), GetSerializeSizeMany(0, ints, hashes, longs));
+
+    std::vector<uint32_t> ints2;
+    std::vector<uint256> hashes2;
+    prevector<4, int64_t> longs2;
+    raw >> ints2 >> hashes2 >> longs2;
+    BOOST_CHECK(ints2 == ints);
+    BOOST_CHECK(hashes2 == hashes);
+    BOOST_CHECK(longs2 == longs);
+    BOOST_CHECK(raw.empty());
+}
+
 BOOST_AUTO_TEST_CASE(noncanonical)
 {
     // Write some non-canonical CompactSize encodings, and
@@ -0,0 +1,66 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <key.h>
+#include <pubkey.h>
+#include <script/sigcache.h>
+#include <test/setup_common.h>
+#include <uint256.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(sigcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(sigcache_hit_miss_erase)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    const uint256 sighash = InsecureRand256();
+    std::vector<unsigned char> sig;
+    BOOST_REQUIRE(key.Sign(sighash, sig));
+
+    uint256 entry;
+    ComputeSignatureCacheEntry(entry, sighash, sig, pubkey);
+
+    // Miss before insertion, hit after, and a plain lookup does not consume the entry.
+    BOOST_CHECK(!SignatureCacheContains(entry, false));
+    SignatureCacheInsert(entry);
+    BOOST_CHECK(SignatureCacheContains(entry, false));
+    BOOST_CHECK(SignatureCacheContains(entry, false));
+
+    // Every part of the check goes into the entry.
+    uint256 other;
+    ComputeSignatureCacheEntry(other, InsecureRand256(), sig, pubkey);
+    BOOST_CHECK(!SignatureCacheContains(other, false));
+    CKey other_key;
+    other_key.MakeNewKey(true);
+    ComputeSignatureCacheEntry(other, sighash, sig, other_key.GetPubKey());
+    BOOST_CHECK(!SignatureCacheContains(other, false));
+    std::vector<unsigned char> other_sig;
+    BOOST_REQUIRE(other_key.Sign(sighash, other_sig));
+    ComputeSignatureCacheEntry(other, sighash, other_sig, pubkey);
+    BOOST_CHECK(!SignatureCacheContains(other, false));
+
+    // Erasure only marks the entry as reusable: it is still a hit until its slot is overwritten.
+    BOOST_CHECK(SignatureCacheContains(entry, true));
+    BOOST_CHECK(SignatureCacheContains(entry, false));
+}
+
+BOOST_AUTO_TEST_CASE(sigcache_shards)
+{
+    // Entries spread over all shards; each one is found in its own shard and only there.
+    std::vector<uint256> entries;
+    for (int i = 0; i < 1000; ++i) {
+        entries.push_back(InsecureRand256());
+    }
+    for (size_t i = 0; i < entries.size(); i += 2) {
+        SignatureCacheInsert(entries[i]);
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        BOOST_CHECK_EQUAL(SignatureCacheContains(entries[i], false), i % 2 == 0);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -67,6 +67,21 @@ BOOST_AUTO_TEST_CASE(streams_vector_writer)
     vch.clear();
 }
 
+BOOST_AUTO_TEST_CASE(streams_vector_writer_append)
+{
+    // Appending item by item grows the vector geometrically, not once per append.
+    std::vector<unsigned char> vch;
+    const std::vector<unsigned char> item(100, 0x42);
+    int reallocations = 0;
+    for (int i = 0; i < 2000; ++i) {
+        const size_t capacity = vch.capacity();
+        CVectorWriter(SER_NETWORK, INIT_PROTO_VERSION, vch, vch.size(), item);
+        if (vch.capacity() != capacity) ++reallocations;
+    }
+    BOOST_CHECK_EQUAL(vch.size(), 2000U * 101);
+    BOOST_CHECK_LE(reallocations, 20);
+}
+
 BOOST_AUTO_TEST_CASE(streams_vector_reader)
 {
     std::vector<unsigned char> vch = {1, 255, 3, 4, 5, 6};
@@ -112,6 +127,40 @@ BOOST_AUTO_TEST_CASE(streams_vector_reader)
     BOOST_CHECK_THROW(new_reader >> d, std::ios_base::failure);
 }
 
+BOOST_AUTO_TEST_CASE(streams_span_reader)
+{
+    std::vector<unsigned char> vch = {1, 255, 3, 4, 5, 6};
+
+    SpanReader reader(SER_NETWORK, INIT_PROTO_VERSION, MakeSpan(vch));
+    BOOST_CHECK_EQUAL(reader.size(), 6);
+
+    unsigned char a;
+    signed char b;
+    reader >> a >> b;
+    BOOST_CHECK_EQUAL(a, 1);
+    BOOST_CHECK_EQUAL(b, -1);
+
+    // Reads do not copy the buffer, it may change in between.
+    vch[2] = 7;
+    uint16_t c;
+    reader >> c;
+    BOOST_CHECK_EQUAL(c, 1031); // 7,4 in little-endian base-256
+    BOOST_CHECK_EQUAL(reader.size(), 2);
+
+    // Reading after end of span throws an error, and consumes nothing.
+    unsigned int d;
+    BOOST_CHECK_THROW(reader >> d, std::ios_base::failure);
+    BOOST_CHECK_EQUAL(reader.size(), 2);
+    reader.ignore(2);
+    BOOST_CHECK(reader.empty());
+
+    // The variadic constructor deserializes at once.
+    std::string str{"\x02" "ab", 3};
+    std::string out;
+    SpanReader{SER_NETWORK, INIT_PROTO_VERSION, MakeUCharSpan(str), out};
+    BOOST_CHECK_EQUAL(out, "ab");
+}
+
 BOOST_AUTO_TEST_CASE(bitstream_reader_writer)
 {
     CDataStream data(SER_NETWORK, INIT_PROTO_VERSION);
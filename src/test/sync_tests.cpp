@@ -7,6 +7,10 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 namespace {
 template <typename MutexType>
 void TestPotentialDeadLockDetected(MutexType& mutex1, MutexType& mutex2)
@@ -27,6 +31,14 @@ void TestPotentialDeadLockDetected(MutexType& mutex1, MutexType& mutex2)
     BOOST_CHECK(!error_thrown);
     #endif
 }
+
+const LockSiteStats* FindLockSite(const std::vector<LockSiteStats>& stats, int line)
+{
+    for (const LockSiteStats& site : stats) {
+        if (site.file == __FILE__ && site.line == line) return &site;
+    }
+    return nullptr;
+}
 } // namespace
 
 BOOST_FIXTURE_TEST_SUITE(sync_tests, BasicTestingSetup)
@@ -49,4 +61,71 @@ BOOST_AUTO_TEST_CASE(potential_deadlock_detected)
     #endif
 }
 
+BOOST_AUTO_TEST_CASE(lock_stats)
+{
+    const bool prev = g_lock_stats_enabled;
+    g_lock_stats_enabled = true;
+    ResetLockStats();
+
+    Mutex mutex;
+    int lock_line = 0;
+    for (int i = 0; i < 3; ++i) {
+        lock_line = __LINE__; LOCK(mutex);
+    }
+    int try_line = 0;
+    int contended_line = 0;
+    std::atomic<bool> started{false};
+    std::thread contender;
+    {
+        LOCK(mutex);
+        bool try_locked = true;
+        std::thread([&] { try_line = __LINE__; TRY_LOCK(mutex, locked); try_locked = locked; }).join();
+        BOOST_CHECK(!try_locked);
+        contender = std::thread([&] {
+            started = true;
+            contended_line = __LINE__; LOCK(mutex);
+        });
+        while (!started) std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    contender.join();
+
+    std::vector<LockSiteStats> stats = GetLockStats();
+    const LockSiteStats* site = FindLockSite(stats, lock_line);
+    BOOST_REQUIRE(site);
+    BOOST_CHECK_EQUAL(site->name, "mutex");
+    BOOST_CHECK_EQUAL(site->acquired, 3U);
+    BOOST_CHECK_EQUAL(site->contended, 0U);
+    BOOST_CHECK_EQUAL(site->wait_total_micros, 0U);
+    BOOST_CHECK_EQUAL(site->wait_histogram[0], 3U);
+    uint64_t holds = 0;
+    for (uint64_t count : site->hold_histogram) holds += count;
+    BOOST_CHECK_EQUAL(holds, 3U);
+
+    site = FindLockSite(stats, try_line);
+    BOOST_REQUIRE(site);
+    BOOST_CHECK_EQUAL(site->acquired, 0U);
+    BOOST_CHECK_EQUAL(site->try_failed, 1U);
+
+    site = FindLockSite(stats, contended_line);
+    BOOST_REQUIRE(site);
+    BOOST_CHECK_EQUAL(site->acquired, 1U);
+    BOOST_CHECK_EQUAL(site->contended, 1U);
+    BOOST_CHECK_GE(site->wait_max_micros, 10000U);
+    BOOST_CHECK_EQUAL(site->wait_max_micros, site->wait_total_micros);
+
+    ResetLockStats();
+    BOOST_CHECK(!FindLockSite(GetLockStats(), lock_line));
+
+    // Nothing is recorded while disabled.
+    g_lock_stats_enabled = false;
+    int disabled_line = 0;
+    {
+        disabled_line = __LINE__; LOCK(mutex);
+    }
+    BOOST_CHECK(!FindLockSite(GetLockStats(), disabled_line));
+
+    g_lock_stats_enabled = prev;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,130 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/tracing.h>
+
+#include <test/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string.h>
+#include <thread>
+
+namespace {
+/** Enables tracing with empty buffers for the duration of a test. */
+struct TracingSetup : public BasicTestingSetup {
+    const bool m_prev_enabled;
+
+    TracingSetup() : m_prev_enabled(tracing::g_enabled)
+    {
+        tracing::Reset();
+        tracing::g_enabled = true;
+    }
+
+    ~TracingSetup()
+    {
+        tracing::g_enabled = m_prev_enabled;
+        tracing::Reset();
+    }
+};
+
+std::vector<tracing::SpanRecord> CollectSpans()
+{
+    std::vector<tracing::SpanRecord> spans;
+    for (const tracing::ThreadTrace& trace : tracing::Collect()) {
+        spans.insert(spans.end(), trace.spans.begin(), trace.spans.end());
+    }
+    return spans;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(tracing_tests, TracingSetup)
+
+BOOST_AUTO_TEST_CASE(span_records)
+{
+    {
+        TRACE_SPAN(outer, "outer", "test");
+        outer.Tag("height", 42);
+        outer.Label("command", "averylongmessagetype");
+        {
+            TRACE_SPAN(inner, "inner", "test");
+            inner.Tag("a", 1);
+            inner.Tag("b", 2);
+            inner.Tag("c", 3);
+        }
+    }
+    const std::vector<tracing::SpanRecord> spans = CollectSpans();
+    BOOST_REQUIRE_EQUAL(spans.size(), 2U);
+
+    // Spans are recorded when they end, so the inner one comes first.
+    const tracing::SpanRecord& inner = spans[0];
+    BOOST_CHECK_EQUAL(inner.name, "inner");
+    BOOST_CHECK_EQUAL(inner.category, "test");
+    BOOST_CHECK_EQUAL(inner.tag_keys[0], "a");
+    BOOST_CHECK_EQUAL(inner.tag_values[1], 2);
+    BOOST_CHECK(!inner.label_key);
+
+    const tracing::SpanRecord& outer = spans[1];
+    BOOST_CHECK_EQUAL(outer.name, "outer");
+    BOOST_CHECK_EQUAL(outer.tag_keys[0], "height");
+    BOOST_CHECK_EQUAL(outer.tag_values[0], 42);
+    BOOST_CHECK(!outer.tag_keys[1]);
+    BOOST_CHECK_EQUAL(outer.label_key, "command");
+    BOOST_CHECK_EQUAL(std::string(outer.label), "averylongmessag");
+    BOOST_CHECK_LE(outer.start_micros, inner.start_micros);
+    BOOST_CHECK_GE(outer.duration_micros, inner.duration_micros);
+
+    tracing::Reset();
+    BOOST_CHECK(CollectSpans().empty());
+
+    tracing::g_enabled = false;
+    {
+        TRACE_SPAN(span, "disabled", "test");
+    }
+    BOOST_CHECK(CollectSpans().empty());
+}
+
+BOOST_AUTO_TEST_CASE(ring_buffer)
+{
+    // A new thread, so that its buffer holds no spans of earlier tests.
+    std::thread([] {
+        for (size_t i = 0; i < tracing::TRACE_BUFFER_SPANS + 10; ++i) {
+            TRACE_SPAN(span, "span", "test");
+            span.Tag("i", i);
+        }
+    }).join();
+    const std::vector<tracing::SpanRecord> spans = CollectSpans();
+    BOOST_REQUIRE_EQUAL(spans.size(), tracing::TRACE_BUFFER_SPANS);
+    BOOST_CHECK_EQUAL(spans.front().tag_values[0], 10);
+    BOOST_CHECK_EQUAL(spans.back().tag_values[0], (int64_t)tracing::TRACE_BUFFER_SPANS + 9);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_collect)
+{
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&stop, t] {
+            while (!stop) {
+                TRACE_SPAN(span, "span", "test");
+                span.Tag("thread", t);
+            }
+        });
+    }
+    // Buffers are overwritten while being read, which must never yield a torn span.
+    for (int i = 0; i < 20; ++i) {
+        for (const tracing::ThreadTrace& trace : tracing::Collect()) {
+            for (const tracing::SpanRecord& span : trace.spans) {
+                BOOST_REQUIRE_EQUAL(span.name, "span");
+                BOOST_REQUIRE_EQUAL(span.tag_keys[0], "thread");
+                BOOST_REQUIRE(span.tag_values[0] >= 0 && span.tag_values[0] < 4);
+                BOOST_REQUIRE_GE(span.duration_micros, 0);
+            }
+        }
+    }
+    stop = true;
+    for (std::thread& thread : threads) thread.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -770,4 +770,50 @@ BOOST_AUTO_TEST_CASE(test_IsStandard)
     BOOST_CHECK(!IsStandardTx(CTransaction(t), reason));
 }
 
+BOOST_AUTO_TEST_CASE(make_transaction_refs)
+{
+    std::vector<CMutableTransaction> txs(20);
+    for (size_t i = 0; i < txs.size(); ++i) {
+        CMutableTransaction& mtx = txs[i];
+        mtx.nLockTime = i;
+        mtx.vin.resize(1 + i % 3);
+        for (CTxIn& in : mtx.vin) {
+            in.prevout = COutPoint(InsecureRand256(), InsecureRand32());
+            in.scriptSig = CScript() << g_insecure_rand_ctx.randbytes(InsecureRandRange(100));
+            if (i % 2) {
+                in.scriptWitness.stack.push_back(g_insecure_rand_ctx.randbytes(72));
+            }
+        }
+        mtx.vout.resize(1 + i % 4);
+        for (CTxOut& out : mtx.vout) {
+            out.nValue = InsecureRandRange(MAX_MONEY);
+            out.scriptPubKey = CScript() << OP_DUP << OP_HASH160 << g_insecure_rand_ctx.randbytes(20) << OP_EQUALVERIFY << OP_CHECKSIG;
+        }
+    }
+    std::vector<CTransactionRef> expected;
+    for (const CMutableTransaction& mtx : txs) {
+        expected.push_back(MakeTransactionRef(mtx));
+    }
+
+    const std::vector<CTransactionRef> refs = MakeTransactionRefs(std::vector<CMutableTransaction>(txs));
+    BOOST_REQUIRE_EQUAL(refs.size(), expected.size());
+    for (size_t i = 0; i < refs.size(); ++i) {
+        BOOST_CHECK(refs[i]->GetHash() == expected[i]->GetHash());
+        BOOST_CHECK(refs[i]->GetWitnessHash() == expected[i]->GetWitnessHash());
+        BOOST_CHECK_EQUAL(refs[i]->HasWitness(), i % 2 == 1);
+    }
+
+    // Deserialized blocks get their transaction hashes through it.
+    CBlock block;
+    block.vtx = expected;
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION, block);
+    CBlock read;
+    stream >> read;
+    BOOST_REQUIRE_EQUAL(read.vtx.size(), expected.size());
+    for (size_t i = 0; i < read.vtx.size(); ++i) {
+        BOOST_CHECK(read.vtx[i]->GetHash() == expected[i]->GetHash());
+        BOOST_CHECK(read.vtx[i]->GetWitnessHash() == expected[i]->GetWitnessHash());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,104 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <chainparams.h>
+#include <key.h>
+#include <txdb.h>
+#include <validation.h>
+
+#include <test/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+
+BOOST_FIXTURE_TEST_SUITE(txdb_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(blocktree_stored_minters)
+{
+    CBlockTreeDB blocktree(1 << 20, true /* fMemory */, true /* fWipe */);
+
+    CKey signer, stored;
+    signer.MakeNewKey(true);
+    stored.MakeNewKey(true);
+
+    // A short chain whose headers are all signed by signer. The minters of blocks 1 and 2 are
+    // written as someone else's, so that loading them proves they were read, not recovered.
+    // Block 3 is written without a minter, as by older versions.
+    static const int NUM_BLOCKS = 5;
+    std::vector<CBlockIndex> indexes(NUM_BLOCKS);
+    std::vector<uint256> hashes(NUM_BLOCKS);
+    std::vector<const CBlockIndex*> batch;
+    const CBlock& genesis = Params().GenesisBlock();
+    for (int height = 0; height < NUM_BLOCKS; ++height) {
+        CBlockIndex& index = indexes[height];
+        index.pprev = height > 0 ? &indexes[height - 1] : nullptr;
+        index.nHeight = index.height = height;
+        index.nVersion = genesis.nVersion;
+        index.nTime = genesis.nTime + height;
+        index.nBits = genesis.nBits;
+        index.nStatus = BLOCK_VALID_TREE;
+        if (height > 0) {
+            index.hashMerkleRoot = InsecureRand256();
+            std::vector<unsigned char> sig;
+            BOOST_REQUIRE(signer.SignCompact(index.GetBlockHeader().GetHashToSign(), sig));
+            index.sig.assign(sig.begin(), sig.end());
+            if (height != 3) {
+                index.minter = (height <= 2 ? stored : signer).GetPubKey().GetID();
+            }
+        }
+        hashes[height] = index.GetBlockHeader().GetHash();
+        index.phashBlock = &hashes[height];
+        batch.push_back(&index);
+    }
+    BOOST_REQUIRE(blocktree.WriteBatchSync({}, 0, batch));
+
+    std::map<uint256, std::unique_ptr<CBlockIndex>> block_index;
+    auto insert_block_index = [&block_index](const uint256& hash) -> CBlockIndex* {
+        if (hash.IsNull()) return nullptr;
+        std::unique_ptr<CBlockIndex>& pindex = block_index[hash];
+        if (!pindex) {
+            pindex = MakeUnique<CBlockIndex>();
+            pindex->phashBlock = &block_index.find(hash)->first;
+        }
+        return pindex.get();
+    };
+    auto loaded_minter = [&](int height) {
+        return block_index.at(hashes[height])->minter;
+    };
+
+    std::vector<CBlockIndex*> unknown_minters;
+    BOOST_REQUIRE(blocktree.LoadBlockIndexGuts(Params().GetConsensus(), insert_block_index, false /* skipSigCheck */, unknown_minters));
+    BOOST_CHECK_EQUAL(block_index.size(), (size_t)NUM_BLOCKS);
+    BOOST_CHECK(loaded_minter(0).IsNull());
+    BOOST_CHECK(loaded_minter(1) == stored.GetPubKey().GetID());
+    BOOST_CHECK(loaded_minter(2) == stored.GetPubKey().GetID());
+    BOOST_CHECK(loaded_minter(4) == signer.GetPubKey().GetID());
+    BOOST_REQUIRE_EQUAL(unknown_minters.size(), 1U);
+    BOOST_CHECK(unknown_minters[0]->GetBlockHash() == hashes[3]);
+    BOOST_CHECK(loaded_minter(3).IsNull());
+
+    // The missing minter is recovered from the signature and persisted for the next load.
+    BOOST_REQUIRE(RecoverMinterKeys(unknown_minters));
+    BOOST_CHECK(loaded_minter(3) == signer.GetPubKey().GetID());
+    BOOST_REQUIRE(blocktree.WriteMinters(unknown_minters));
+
+    block_index.clear();
+    unknown_minters.clear();
+    BOOST_REQUIRE(blocktree.LoadBlockIndexGuts(Params().GetConsensus(), insert_block_index, false /* skipSigCheck */, unknown_minters));
+    BOOST_CHECK(unknown_minters.empty());
+    BOOST_CHECK(loaded_minter(1) == stored.GetPubKey().GetID());
+    BOOST_CHECK(loaded_minter(3) == signer.GetPubKey().GetID());
+
+    // Without signature checks no minter is loaded at all.
+    block_index.clear();
+    BOOST_REQUIRE(blocktree.LoadBlockIndexGuts(Params().GetConsensus(), insert_block_index, true /* skipSigCheck */, unknown_minters));
+    BOOST_CHECK(unknown_minters.empty());
+    for (int height = 0; height < NUM_BLOCKS; ++height) {
+        BOOST_CHECK(loaded_minter(height).IsNull());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
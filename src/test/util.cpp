@@ -6,6 +6,7 @@
 
 #include <chainparams.h>
 #include <consensus/merkle.h>
+#include <key.h>
 #include <miner.h>
 #include <outputtype.h>
 #include <pos.h>
@@ -40,6 +41,34 @@ void importaddress(CWallet& wallet, const std::string& address)
     if (!wallet.AddWatchOnly(script, 0 /* nCreateTime */)) assert(false);
     wallet.SetAddressBook(dest, /* label */ "", "receive");
 }
+
+CAmount AddWalletHistory(CWallet& wallet, size_t num_txs, size_t chain_length)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript script = GetScriptForDestination(PKHash(key.GetPubKey()));
+    const uint256 block_hash = WITH_LOCK(cs_main, return ::ChainActive().Genesis()->GetBlockHash());
+
+    LOCK(wallet.cs_wallet);
+    if (!wallet.AddKeyPubKey(key, key.GetPubKey())) assert(false);
+    CAmount unspent = 0;
+    COutPoint prevout;
+    for (size_t i = 0; i < num_txs; ++i) {
+        CMutableTransaction mtx;
+        // The first transaction of each chain is funded from outside the wallet.
+        mtx.vin.emplace_back(i % chain_length == 0 ? COutPoint(uint256(), i) : prevout);
+        mtx.vout.emplace_back(COIN, script);
+        CWalletTx wtx(&wallet, MakeTransactionRef(std::move(mtx)));
+        wtx.SetMerkleBranch(block_hash, i);
+        prevout = COutPoint(wtx.GetHash(), 0);
+        wallet.LoadToWallet(std::move(wtx));
+        if ((i + 1) % chain_length == 0 || i + 1 == num_txs) {
+            unspent += COIN;
+        }
+    }
+    wallet.LinkLoadedTransactions();
+    return unspent;
+}
 #endif // ENABLE_WALLET
 
 CTxIn generatetoaddress(const std::string& address)
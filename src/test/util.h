@@ -5,6 +5,8 @@
 #ifndef DEFI_TEST_UTIL_H
 #define DEFI_TEST_UTIL_H
 
+#include <amount.h>
+
 #include <memory>
 #include <string>
 
@@ -23,6 +25,12 @@ extern const std::string ADDRESS_BCRT1_UNSPENDABLE;
 CTxIn MineBlock(const CScript& coinbase_scriptPubKey);
 /** Prepare a block to be mined */
 std::shared_ptr<CBlock> PrepareBlock(const CScript& coinbase_scriptPubKey);
+/**
+ * Load num_txs transactions confirmed in the genesis block into the wallet, each paying 1 coin to
+ * a new key of the wallet and, except for every chain_length'th one, spending the output of the
+ * previous one. Returns the value left unspent.
+ */
+CAmount AddWalletHistory(CWallet& wallet, size_t num_txs, size_t chain_length);
 
 
 // RPC-like //
@@ -13,6 +13,7 @@
 #include <util/string.h>
 #include <util/time.h>
 
+#include <atomic>
 #include <stdint.h>
 #include <thread>
 #include <utility>
@@ -1572,4 +1573,51 @@ BOOST_AUTO_TEST_CASE(test_Capitalize)
     BOOST_CHECK_EQUAL(Capitalize("\x00\xfe\xff"), "\x00\xfe\xff");
 }
 
+BOOST_AUTO_TEST_CASE(util_ParallelFor)
+{
+    // Every index runs exactly once, for any thread count and size, including empty ranges.
+    for (int n_threads : {1, 2, 8}) {
+        for (size_t n : {0, 1, 3, 1000}) {
+            std::vector<std::atomic<int>> calls(n);
+            for (auto& count : calls) count = 0;
+            ParallelFor(n, n_threads, [&](size_t i) { ++calls[i]; });
+            for (const auto& count : calls) {
+                BOOST_CHECK_EQUAL(count.load(), 1);
+            }
+        }
+    }
+
+    // Concurrent callers share the pool and each completes its own range, also when nested.
+    std::atomic<size_t> sum{0};
+    std::vector<std::thread> callers;
+    for (int c = 0; c < 4; ++c) {
+        callers.emplace_back([&sum] {
+            ParallelFor(50, 4, [&sum](size_t i) {
+                ParallelFor(10, 2, [&sum, i](size_t j) { sum += i * 10 + j; });
+            });
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    BOOST_CHECK_EQUAL(sum.load(), 4U * (500U * 499U / 2));
+
+    // An exception from any thread reaches the caller, only after every thread left fn.
+    for (int n_threads : {1, 4}) {
+        std::atomic<int> in_fn{0};
+        std::atomic<int> left_fn{0};
+        BOOST_CHECK_THROW(ParallelFor(1000, n_threads, [&](size_t i) {
+            ++in_fn;
+            if (i == 500) {
+                ++left_fn;
+                throw std::runtime_error("index 500");
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+            ++left_fn;
+        }), std::runtime_error);
+        BOOST_CHECK_EQUAL(in_fn.load(), left_fn.load());
+        BOOST_CHECK_LE(in_fn.load(), 1000);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
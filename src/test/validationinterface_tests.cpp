@@ -0,0 +1,160 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+
+#include <primitives/block.h>
+#include <sync.h>
+#include <test/setup_common.h>
+#include <util/time.h>
+#include <validationinterface.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <thread>
+
+BOOST_FIXTURE_TEST_SUITE(validationinterface_tests, TestingSetup)
+
+/** Counts ChainStateFlushed calls, blocking in them until released if blocked is set. */
+class FlushCounter : public CValidationInterface
+{
+public:
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    int m_count GUARDED_BY(m_mutex) = 0;
+    bool m_blocked GUARDED_BY(m_mutex) = false;
+
+    int Count() { return WITH_LOCK(m_mutex, return m_count); }
+
+    bool WaitForCount(int count)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        WAIT_LOCK(m_mutex, lock);
+        while (m_count < count) {
+            if (m_cond.wait_until(lock, deadline) == std::cv_status::timeout) return false;
+        }
+        return true;
+    }
+
+    void Block() { WITH_LOCK(m_mutex, m_blocked = true); }
+
+    void Release()
+    {
+        WITH_LOCK(m_mutex, m_blocked = false);
+        m_cond.notify_all();
+    }
+
+protected:
+    void ChainStateFlushed(const CBlockLocator& locator) override
+    {
+        WAIT_LOCK(m_mutex, lock);
+        ++m_count;
+        m_cond.notify_all();
+        while (m_blocked) {
+            m_cond.wait(lock);
+        }
+    }
+};
+
+static ValidationInterfaceQueueStats GetStats(const std::string& name)
+{
+    for (const ValidationInterfaceQueueStats& stats : GetMainSignals().GetQueueStats()) {
+        if (stats.name == name) return stats;
+    }
+    BOOST_ERROR("no queue named " + name);
+    return {};
+}
+
+BOOST_AUTO_TEST_CASE(slow_subscriber_queue)
+{
+    FlushCounter slow, shared;
+    ValidationInterfaceQueueOptions options;
+    options.name = "slow";
+    RegisterValidationInterface(&slow, options);
+    RegisterValidationInterface(&shared);
+
+    // A subscriber stuck in a callback does not hold back the others.
+    slow.Block();
+    GetMainSignals().ChainStateFlushed(CBlockLocator());
+    GetMainSignals().ChainStateFlushed(CBlockLocator());
+    BOOST_CHECK(shared.WaitForCount(2));
+    BOOST_CHECK(slow.WaitForCount(1));
+    BOOST_CHECK_EQUAL(GetStats("slow").pending, 1U);
+
+    // Syncing waits for every queue.
+    std::future<void> synced = std::async(std::launch::async, SyncWithValidationInterfaceQueue);
+    BOOST_CHECK(synced.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout);
+    slow.Release();
+    synced.wait();
+    BOOST_CHECK_EQUAL(slow.Count(), 2);
+
+    const ValidationInterfaceQueueStats stats = GetStats("slow");
+    BOOST_CHECK_EQUAL(stats.pending, 0U);
+    BOOST_CHECK_EQUAL(stats.processed, 2U);
+    BOOST_CHECK_EQUAL(stats.dropped, 0U);
+
+    UnregisterValidationInterface(&shared);
+    UnregisterValidationInterface(&slow);
+}
+
+BOOST_AUTO_TEST_CASE(lossy_subscriber_queue)
+{
+    FlushCounter lossy;
+    ValidationInterfaceQueueOptions options;
+    options.name = "lossy";
+    options.max_size = 2;
+    options.lossy = true;
+    RegisterValidationInterface(&lossy, options);
+
+    lossy.Block();
+    GetMainSignals().ChainStateFlushed(CBlockLocator());
+    BOOST_CHECK(lossy.WaitForCount(1));
+    for (int i = 0; i < 5; ++i) {
+        GetMainSignals().ChainStateFlushed(CBlockLocator());
+    }
+    // A full lossy queue does not hold back block connection.
+    GetMainSignals().LimitCallbacksPending(0);
+    ValidationInterfaceQueueStats stats = GetStats("lossy");
+    BOOST_CHECK_EQUAL(stats.pending, 2U);
+    BOOST_CHECK_EQUAL(stats.peak, 2U);
+    BOOST_CHECK_EQUAL(stats.dropped, 3U);
+
+    lossy.Release();
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(lossy.Count(), 3);
+
+    UnregisterValidationInterface(&lossy);
+}
+
+BOOST_AUTO_TEST_CASE(unregister_subscriber_queue)
+{
+    FlushCounter subscriber;
+    ValidationInterfaceQueueOptions options;
+    options.name = "unregistered";
+    RegisterValidationInterface(&subscriber, options);
+
+    subscriber.Block();
+    GetMainSignals().ChainStateFlushed(CBlockLocator());
+    GetMainSignals().ChainStateFlushed(CBlockLocator());
+    BOOST_CHECK(subscriber.WaitForCount(1));
+
+    // A sync queued behind the pending callback completes once the subscriber is gone.
+    std::future<void> synced = std::async(std::launch::async, SyncWithValidationInterfaceQueue);
+    std::thread release([&subscriber] {
+        MilliSleep(100);
+        subscriber.Release();
+    });
+    UnregisterValidationInterface(&subscriber);
+    release.join();
+    synced.wait();
+    BOOST_CHECK_EQUAL(subscriber.Count(), 1);
+
+    // No more callbacks after unregistering.
+    GetMainSignals().ChainStateFlushed(CBlockLocator());
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(subscriber.Count(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
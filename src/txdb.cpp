@@ -28,6 +28,7 @@ static const char DB_HEAD_BLOCKS = 'H';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
+static const char DB_BLOCK_MINTER = 'k';
 
 namespace {
 
@@ -230,6 +231,21 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockF
     batch.Write(DB_LAST_BLOCK, nLastFile);
     for (std::vector<const CBlockIndex*>::const_iterator it=blockinfo.begin(); it != blockinfo.end(); it++) {
         batch.Write(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), CDiskBlockIndex(*it));
+        if (!(*it)->minter.IsNull()) {
+            batch.Write(std::make_pair(DB_BLOCK_MINTER, (*it)->GetBlockHash()), (*it)->minter);
+        }
+    }
+    return WriteBatch(batch, true);
+}
+
+bool CBlockTreeDB::WriteMinters(const std::vector<CBlockIndex*>& blockinfo) {
+    CDBBatch batch(*this);
+    for (const CBlockIndex* pindex : blockinfo) {
+        batch.Write(std::make_pair(DB_BLOCK_MINTER, pindex->GetBlockHash()), pindex->minter);
+        if (batch.SizeEstimate() > (size_t)gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize)) {
+            if (!WriteBatch(batch)) return false;
+            batch.Clear();
+        }
     }
     return WriteBatch(batch, true);
 }
@@ -246,12 +262,19 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
-bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, bool skipSigCheck)
+bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, bool skipSigCheck, std::vector<CBlockIndex*>& unknownMinters)
 {
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
     pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
 
+    // Minter records are keyed by block hash too, so a second cursor walks
+    // them in step with the block index entries.
+    std::unique_ptr<CDBIterator> pminter(NewIterator());
+    pminter->Seek(std::make_pair(DB_BLOCK_MINTER, uint256()));
+    std::pair<char, uint256> minterKey;
+    bool haveMinterKey = pminter->Valid() && pminter->GetKey(minterKey) && minterKey.first == DB_BLOCK_MINTER;
+
     // Load m_block_index
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
@@ -279,14 +302,17 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->height = diskindex.height;
                 pindexNew->mintedBlocks = diskindex.mintedBlocks;
                 pindexNew->sig = diskindex.sig;
+                pindexNew->minter = CKeyID();
                 if (pindexNew->nHeight && !skipSigCheck) {
-                    CPubKey recoveredPubKey{};
-                    if (!recoveredPubKey.RecoverCompact(pindexNew->GetBlockHeader().GetHashToSign(), pindexNew->sig)) {
-                        return error("%s: The block index #%d (%s) wasn't saved on disk correctly. Index content: %s", __func__, pindexNew->nHeight, pindexNew->GetBlockHash().ToString(), pindexNew->ToString());
+                    while (haveMinterKey && minterKey.second < key.second) {
+                        pminter->Next();
+                        haveMinterKey = pminter->Valid() && pminter->GetKey(minterKey) && minterKey.first == DB_BLOCK_MINTER;
+                    }
+                    // Entries written before minters were stored, or by older
+                    // versions, are left to the caller to recover.
+                    if (!haveMinterKey || minterKey.second != key.second || !pminter->GetValue(pindexNew->minter)) {
+                        unknownMinters.push_back(pindexNew);
                     }
-                    pindexNew->minter = recoveredPubKey.GetID();
-                } else {
-                    pindexNew->minter = CKeyID();
                 }
 //                if (pindexNew->nHeight > 0 && pindexNew->stakeModifier != pos::ComputeStakeModifier(pindexNew->pprev->stakeModifier, pindexNew->minter)) { // TODO: SS disable check stake modifier
 //                    return error("%s: The block index #%d (%s) wasn't saved on disk correctly. Stake modifier is incorrect (%s != %s). Index content: %s",
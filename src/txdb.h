@@ -37,6 +37,10 @@ static const int64_t nMaxBlockDBCache = 2;
 // Unlike for the UTXO database, for the txindex scenario the leveldb cache make
 // a meaningful difference: https://github.com/bitcoin/bitcoin/pull/8273#issuecomment-229601991
 static const int64_t nMaxTxIndexCache = 1024;
+//! Max memory allocated to address index DB specific cache (MiB)
+static const int64_t nMaxAddressIndexCache = 1024;
+//! Max memory allocated to masternode tx index DB specific cache (MiB)
+static const int64_t nMaxMasternodeTxIndexCache = 64;
 //! Max memory allocated to all block filter index caches combined in MiB.
 static const int64_t max_filter_index_cache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
@@ -100,7 +104,15 @@ public:
     void ReadReindexing(bool &fReindexing);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
-    bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, bool skipSigCheck);
+    /** Persist the minters of block index entries loaded without one, see LoadBlockIndexGuts. */
+    bool WriteMinters(const std::vector<CBlockIndex*>& blockinfo);
+    /**
+     * Load all block index entries. Their minters are read from the records written along with
+     * them; entries without one (written by older versions) are appended to unknownMinters with
+     * a null minter, for the caller to recover from the signature. Minters are not loaded at all
+     * if skipSigCheck is set.
+     */
+    bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, bool skipSigCheck, std::vector<CBlockIndex*>& unknownMinters);
 };
 
 #endif // DEFI_TXDB_H
@@ -9,11 +9,13 @@
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
 #include <masternodes/mn_checks.h>
+#include <metrics.h>
 #include <validation.h>
 #include <policy/policy.h>
 #include <policy/fees.h>
 #include <policy/settings.h>
 #include <reverse_iterator.h>
+#include <script/interpreter.h>
 #include <util/system.h>
 #include <util/moneystr.h>
 #include <util/time.h>
@@ -22,7 +24,7 @@ CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFe
                                  int64_t _nTime, unsigned int _entryHeight,
                                  bool _spendsCoinbase, int64_t _sigOpsCost, LockPoints lp)
     : tx(_tx), nFee(_nFee), nTxWeight(GetTransactionWeight(*tx)), nUsageSize(RecursiveDynamicUsage(tx)), nTime(_nTime), entryHeight(_entryHeight),
-    spendsCoinbase(_spendsCoinbase), sigOpCost(_sigOpsCost), lockPoints(lp)
+    spendsCoinbase(_spendsCoinbase), sigOpCost(_sigOpsCost), lockPoints(lp), scriptVerifyFlags(0), scriptsVerified(false)
 {
     nCountWithDescendants = 1;
     nSizeWithDescendants = GetTxSize();
@@ -36,6 +38,15 @@ CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFe
     nSigOpCostWithAncestors = sigOpCost;
 }
 
+void CTxMemPoolEntry::SetVerifiedScripts(std::shared_ptr<const PrecomputedTransactionData> txdataIn, unsigned int flags)
+{
+    nUsageSize -= memusage::DynamicUsage(txdata);
+    txdata = std::move(txdataIn);
+    nUsageSize += memusage::DynamicUsage(txdata);
+    scriptVerifyFlags = flags;
+    scriptsVerified = true;
+}
+
 void CTxMemPoolEntry::UpdateFeeDelta(int64_t newFeeDelta)
 {
     nModFeesWithDescendants += newFeeDelta - feeDelta;
@@ -399,6 +410,7 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
 
     vTxHashes.emplace_back(tx.GetWitnessHash(), newit);
     newit->vTxHashesIdx = vTxHashes.size() - 1;
+    UpdateMetrics();
 }
 
 void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
@@ -424,6 +436,15 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     mapTx.erase(it);
     nTransactionsUpdated++;
     if (minerPolicyEstimator) {minerPolicyEstimator->removeTx(hash, false);}
+    UpdateMetrics();
+}
+
+void CTxMemPool::UpdateMetrics() const
+{
+    // Pools other than the node's, e.g. in tests, must not overwrite its gauges.
+    if (this != &::mempool) return;
+    metrics::mempool_transactions.Set(mapTx.size());
+    metrics::mempool_bytes.Set(totalTxSize);
 }
 
 // Calculates descendants of entry that are not already in setDescendants, and adds to
@@ -592,6 +613,7 @@ void CTxMemPool::_clear()
     blockSinceLastRollingFeeBump = false;
     rollingMinimumFeeRate = 0;
     ++nTransactionsUpdated;
+    UpdateMetrics();
 }
 
 void CTxMemPool::clear()
@@ -30,6 +30,7 @@
 #include <boost/signals2/signal.hpp>
 
 class CBlockIndex;
+struct PrecomputedTransactionData;
 class CMasternodesView;
 extern CCriticalSection cs_main;
 
@@ -71,13 +72,16 @@ private:
     const CTransactionRef tx;
     const CAmount nFee;             //!< Cached to avoid expensive parent-transaction lookups
     const size_t nTxWeight;         //!< ... and avoid recomputing tx weight (also used for GetTxSize())
-    const size_t nUsageSize;        //!< ... and total memory usage
+    size_t nUsageSize;              //!< ... and total memory usage
     const int64_t nTime;            //!< Local time when entering the mempool
     const unsigned int entryHeight; //!< Chain height when entering the mempool
     const bool spendsCoinbase;      //!< keep track of transactions that spend a coinbase
     const int64_t sigOpCost;        //!< Total sigop cost
     int64_t feeDelta;          //!< Used for determining the priority of the transaction for mining in a block
     LockPoints lockPoints;     //!< Track the height and time at which tx was final
+    std::shared_ptr<const PrecomputedTransactionData> txdata; //!< Sighash midstates, reused when the tx is connected in a block
+    unsigned int scriptVerifyFlags; //!< Script flags all inputs were successfully verified with, if scriptsVerified
+    bool scriptsVerified;
 
     // Information about descendants of this transaction that are in the
     // mempool; if we remove this transaction we must remove all of these
@@ -109,6 +113,12 @@ public:
     int64_t GetModifiedFee() const { return nFee + feeDelta; }
     size_t DynamicMemoryUsage() const { return nUsageSize; }
     const LockPoints& GetLockPoints() const { return lockPoints; }
+    const std::shared_ptr<const PrecomputedTransactionData>& GetPrecomputedData() const { return txdata; }
+    bool ScriptsVerifiedWith(unsigned int flags) const { return scriptsVerified && scriptVerifyFlags == flags; }
+
+    // Records the sighash data and the script flags the inputs were verified with, so that block
+    // validation can skip both for this tx. Must be called before the entry is added to the mempool.
+    void SetVerifiedScripts(std::shared_ptr<const PrecomputedTransactionData> txdataIn, unsigned int flags);
 
     // Adjusts the descendant state.
     void UpdateDescendantState(int64_t modifySize, CAmount modifyFee, int64_t modifyCount);
@@ -736,6 +746,8 @@ private:
      *  removal.
      */
     void removeUnchecked(txiter entry, MemPoolRemovalReason reason) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Publish the size of the node's mempool, see metrics.h. */
+    void UpdateMetrics() const EXCLUSIVE_LOCKS_REQUIRED(cs);
 };
 
 /**
@@ -11,6 +11,7 @@
 #include <stdexcept>
 #include <stdint.h>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 /** Template base class for fixed-sized opaque blobs. */
@@ -124,6 +125,12 @@ public:
     explicit uint256(const std::vector<unsigned char>& vch) : base_blob<256>(vch) {}
 };
 
+/** Blobs are serialized as their bytes, see serialize.h. */
+template<typename T> struct is_raw_serializable;
+template<> struct is_raw_serializable<uint160> : std::true_type {};
+template<> struct is_raw_serializable<uint256> : std::true_type {};
+static_assert(sizeof(uint160) == 20 && sizeof(uint256) == 32, "blobs must not be padded");
+
 /* uint256 from const char *.
  * This is a separate function because the constructor uint256(const char*) can result
  * in dangerously catching uint256(0).
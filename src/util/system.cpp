@@ -63,6 +63,12 @@
 #include <malloc.h>
 #endif
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <thread>
 
 // Application startup time (used for uptime calculation)
@@ -680,6 +686,8 @@ void PrintExceptionContinue(const std::exception* pex, const char* pszThread)
 {
     std::string message = FormatException(pex, pszThread);
     LogPrintf("\n\n************************\n%s\n", message);
+    // The process is likely about to terminate.
+    LogInstance().Flush();
     tfm::format(std::cerr, "\n\n************************\n%s\n", message.c_str());
 }
 
@@ -1192,6 +1200,150 @@ int GetNumCores()
     return std::thread::hardware_concurrency();
 }
 
+namespace {
+
+/** One ParallelFor call, shared with the pool workers that help with it. */
+struct ParallelForJob {
+    const std::function<void(size_t)>* fn;
+    size_t n;
+    std::atomic<size_t> next{0};
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    int running{0};     //!< workers currently calling fn
+    bool closed{false}; //!< set by the caller once it stops waiting for help
+    std::exception_ptr error; //!< the first exception thrown by fn, rethrown by the caller
+
+    /** Call fn for the indexes not handed out yet. An exception stops the job instead of escaping. */
+    void Work()
+    {
+        for (size_t i = next++; i < n; i = next++) {
+            try {
+                (*fn)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) error = std::current_exception();
+                next = n;
+                return;
+            }
+        }
+    }
+
+    /** Run by the caller: stop accepting help and wait for the workers still calling fn. */
+    void Close()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        closed = true;
+        cond.wait(lock, [this] { return running == 0; });
+    }
+
+    /** Run by a pool worker. A job whose caller already returned is skipped. */
+    void Help()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closed) return;
+            ++running;
+        }
+        Work();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--running == 0) cond.notify_all();
+    }
+};
+
+/**
+ * Worker threads kept alive between ParallelFor calls, so that batch loops do not pay for thread
+ * creation on every batch. Workers are started on demand, up to the largest number any call asked
+ * for, and are shared by concurrent callers.
+ */
+class ParallelForPool
+{
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<std::shared_ptr<ParallelForJob>> m_queue;
+    std::vector<std::thread> m_threads;
+    bool m_stop{false};
+
+    void Loop()
+    {
+        while (true) {
+            std::shared_ptr<ParallelForJob> job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cond.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+                if (m_queue.empty()) return;
+                job = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            job->Help();
+        }
+    }
+
+public:
+    ~ParallelForPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    /** Ask n_helpers workers to join job. */
+    void Submit(const std::shared_ptr<ParallelForJob>& job, int n_helpers)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            while (m_threads.size() < static_cast<size_t>(n_helpers)) {
+                const size_t index = m_threads.size();
+                m_threads.emplace_back([this, index] {
+                    util::ThreadRename(strprintf("parallel.%d", index));
+                    Loop();
+                });
+            }
+            for (int i = 0; i < n_helpers; ++i) {
+                m_queue.push_back(job);
+            }
+        }
+        m_cond.notify_all();
+    }
+};
+
+} // namespace
+
+void ParallelFor(size_t n, int n_threads, const std::function<void(size_t)>& fn)
+{
+    const int n_helpers = static_cast<int>(std::min<size_t>(std::max(n_threads, 1) - 1, n > 0 ? n - 1 : 0));
+    if (n_helpers == 0) {
+        for (size_t i = 0; i < n; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    static ParallelForPool pool;
+    auto job = std::make_shared<ParallelForJob>();
+    job->fn = &fn;
+    job->n = n;
+    pool.Submit(job, n_helpers);
+
+    // The caller works too, so the job completes even if every worker is busy with other callers.
+    // Workers that have not picked the job up by then skip it; those already in fn are waited for,
+    // also when this thread unwinds, as fn and its captures must outlive them.
+    struct JobCloser {
+        ParallelForJob& job;
+        ~JobCloser() { job.Close(); }
+    };
+    {
+        JobCloser closer{*job};
+        job->Work();
+    }
+    if (job->error) std::rethrow_exception(job->error);
+}
+
 std::string CopyrightHolders(const std::string& strPrefix)
 {
     const auto copyright_devs = strprintf(_(COPYRIGHT_HOLDERS).translated, COPYRIGHT_HOLDERS_SUBSTITUTION);
@@ -26,6 +26,7 @@
 #include <util/time.h>
 
 #include <exception>
+#include <functional>
 #include <map>
 #include <set>
 #include <stdint.h>
@@ -44,9 +45,9 @@ void SetupEnvironment();
 bool SetupNetworking();
 
 template<typename... Args>
-bool error(const char* fmt, const Args&... args)
+bool error(const CallerLogFormat& fmt, const Args&... args)
 {
-    LogPrintf("ERROR: %s\n", tfm::format(fmt, args...));
+    LogPrintfAt(fmt.file, fmt.line, "ERROR: %s\n", tfm::format(fmt.fmt, args...));
     return false;
 }
 
@@ -334,6 +335,13 @@ std::string HelpMessageOpt(const std::string& option, const std::string& message
  */
 int GetNumCores();
 
+/**
+ * Run fn(0) .. fn(n - 1) on up to n_threads threads, including the calling one. The other threads
+ * come from a pool that is kept alive between calls. If fn throws, the remaining indexes may be
+ * skipped and the first exception is rethrown once no thread is calling fn any more.
+ */
+void ParallelFor(size_t n, int n_threads, const std::function<void(size_t)>& fn);
+
 /**
  * .. and a wrapper that just calls func once
  */
@@ -22,6 +22,8 @@ int64_t GetTimeMillis();
 int64_t GetTimeMicros();
 /** Returns the system time (not mockable) */
 int64_t GetSystemTimeInSeconds(); // Like GetTime(), but not mockable
+/** Returns a monotonic time for measuring durations, unrelated to the system time (not mockable) */
+int64_t GetSteadyMicros();
 
 /** For testing. Set e.g. with the setmocktime rpc, or -mocktime argument */
 void SetMockTime(int64_t nMockTimeIn);
@@ -0,0 +1,177 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/tracing.h>
+
+#include <util/threadnames.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace tracing {
+
+std::atomic<bool> g_enabled{DEFAULT_TRACING};
+
+namespace {
+
+static const size_t SPAN_WORDS = (sizeof(SpanRecord) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+/** Number of exited threads whose spans are kept after their buffer was reused. */
+static const size_t MAX_FINISHED_TRACES = 64;
+
+/**
+ * Ring buffer of the spans of one thread. Only the owning thread writes, any
+ * thread may read. Each slot is a seqlock over relaxed atomic words, so that a
+ * reader racing with the writer detects and skips a slot being overwritten.
+ */
+class ThreadBuffer
+{
+public:
+    ThreadBuffer(uint32_t id, std::string thread_name) : m_id(id), m_thread_name(std::move(thread_name)), m_slots(new Slot[TRACE_BUFFER_SPANS]) {}
+
+    //! Guarded by the registry mutex, like the ownership of the buffer. A new id per owning thread.
+    uint32_t m_id;
+    std::string m_thread_name;
+    bool m_in_use{true};
+
+    void Push(const SpanRecord& span)
+    {
+        uint64_t words[SPAN_WORDS] = {};
+        memcpy(words, &span, sizeof(span));
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[head % TRACE_BUFFER_SPANS];
+        slot.seq.store(2 * head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < SPAN_WORDS; ++i) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.seq.store(2 * head + 2, std::memory_order_release);
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    void Read(std::vector<SpanRecord>& spans) const
+    {
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        const uint64_t begin = std::max(m_begin.load(std::memory_order_acquire), head > TRACE_BUFFER_SPANS ? head - TRACE_BUFFER_SPANS : 0);
+        for (uint64_t i = begin; i < head; ++i) {
+            const Slot& slot = m_slots[i % TRACE_BUFFER_SPANS];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq != 2 * i + 2) continue;
+            uint64_t words[SPAN_WORDS];
+            for (size_t j = 0; j < SPAN_WORDS; ++j) {
+                words[j] = slot.words[j].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+            SpanRecord span;
+            memcpy(&span, words, sizeof(span));
+            spans.push_back(span);
+        }
+    }
+
+    void Clear()
+    {
+        m_begin.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<uint64_t> words[SPAN_WORDS];
+    };
+
+    //! Number of spans ever pushed.
+    std::atomic<uint64_t> m_head{0};
+    //! Spans pushed before the last Clear() are no longer returned.
+    std::atomic<uint64_t> m_begin{0};
+    std::unique_ptr<Slot[]> m_slots;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    uint32_t next_id{0};
+    //! Spans of exited threads, moved out of their buffer when it was handed to a new thread.
+    std::deque<ThreadTrace> finished;
+};
+
+Registry& GetRegistry()
+{
+    // Never destroyed, threads may still record while static objects are torn down.
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+/** Hands the buffer of an exited thread over to the next thread that starts tracing. */
+struct ThreadBufferOwner {
+    ThreadBuffer* buffer{nullptr};
+
+    ~ThreadBufferOwner()
+    {
+        if (!buffer) return;
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        buffer->m_in_use = false;
+    }
+};
+
+thread_local ThreadBufferOwner g_thread_buffer;
+
+ThreadBuffer& AcquireThreadBuffer()
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& buffer : registry.buffers) {
+        if (!buffer->m_in_use) {
+            ThreadTrace trace{buffer->m_id, buffer->m_thread_name, {}};
+            buffer->Read(trace.spans);
+            if (!trace.spans.empty()) {
+                if (registry.finished.size() == MAX_FINISHED_TRACES) registry.finished.pop_front();
+                registry.finished.push_back(std::move(trace));
+            }
+            buffer->Clear();
+            buffer->m_id = registry.next_id++;
+            buffer->m_in_use = true;
+            buffer->m_thread_name = util::ThreadGetInternalName();
+            return *buffer;
+        }
+    }
+    registry.buffers.emplace_back(new ThreadBuffer(registry.next_id++, util::ThreadGetInternalName()));
+    return *registry.buffers.back();
+}
+
+} // namespace
+
+void Record(const SpanRecord& span)
+{
+    if (!g_thread_buffer.buffer) {
+        g_thread_buffer.buffer = &AcquireThreadBuffer();
+    }
+    g_thread_buffer.buffer->Push(span);
+}
+
+std::vector<ThreadTrace> Collect()
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::vector<ThreadTrace> traces(registry.finished.begin(), registry.finished.end());
+    for (const auto& buffer : registry.buffers) {
+        ThreadTrace trace{buffer->m_id, buffer->m_thread_name, {}};
+        buffer->Read(trace.spans);
+        if (!trace.spans.empty()) traces.push_back(std::move(trace));
+    }
+    return traces;
+}
+
+void Reset()
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.finished.clear();
+    for (const auto& buffer : registry.buffers) {
+        buffer->Clear();
+    }
+}
+
+} // namespace tracing
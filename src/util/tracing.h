@@ -0,0 +1,115 @@
+// Copyright (c) 2020 DeFi Blockchain Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DEFI_UTIL_TRACING_H
+#define DEFI_UTIL_TRACING_H
+
+#include <util/time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/**
+ * Timing spans of hot code paths, for offline analysis of where a block,
+ * message or transaction spends its time.
+ *
+ * A span is recorded when it goes out of scope, into a ring buffer owned by
+ * the recording thread, so that tracing takes no lock and never allocates
+ * after the first span of a thread. Spans are only recorded while tracing is
+ * enabled (-tracing or the dumptrace RPC), otherwise a span costs one relaxed
+ * load.
+ */
+namespace tracing {
+
+static const bool DEFAULT_TRACING = false;
+/** Number of spans kept per thread, the oldest ones are overwritten first. */
+static const size_t TRACE_BUFFER_SPANS = 16384;
+static const int MAX_SPAN_TAGS = 2;
+static const size_t MAX_SPAN_LABEL_SIZE = 16;
+
+extern std::atomic<bool> g_enabled;
+
+/** A finished span. The name, category and keys must be string literals. */
+struct SpanRecord {
+    const char* name;
+    const char* category;
+    int64_t start_micros;
+    int64_t duration_micros;
+    const char* tag_keys[MAX_SPAN_TAGS];
+    int64_t tag_values[MAX_SPAN_TAGS];
+    //! A short string tag, e.g. a message type. Truncated and NUL terminated.
+    const char* label_key;
+    char label[MAX_SPAN_LABEL_SIZE];
+};
+
+/** The spans still buffered for one thread, oldest first. An exited thread's spans are kept after its buffer is reused. */
+struct ThreadTrace {
+    uint32_t thread_id;
+    std::string thread_name;
+    std::vector<SpanRecord> spans;
+};
+
+void Record(const SpanRecord& span);
+std::vector<ThreadTrace> Collect();
+/** Discard all buffered spans. */
+void Reset();
+
+class Span
+{
+public:
+    Span(const char* name, const char* category) : m_active(g_enabled.load(std::memory_order_relaxed))
+    {
+        if (!m_active) return;
+        m_record = SpanRecord{};
+        m_record.name = name;
+        m_record.category = category;
+        m_record.start_micros = GetSteadyMicros();
+    }
+
+    ~Span()
+    {
+        if (!m_active) return;
+        m_record.duration_micros = GetSteadyMicros() - m_record.start_micros;
+        Record(m_record);
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    /** Attach a numeric tag, tags beyond MAX_SPAN_TAGS are ignored. */
+    void Tag(const char* key, int64_t value)
+    {
+        if (!m_active) return;
+        for (int i = 0; i < MAX_SPAN_TAGS; ++i) {
+            if (!m_record.tag_keys[i]) {
+                m_record.tag_keys[i] = key;
+                m_record.tag_values[i] = value;
+                return;
+            }
+        }
+    }
+
+    void Label(const char* key, const std::string& value)
+    {
+        if (!m_active) return;
+        const size_t size = std::min(value.size(), MAX_SPAN_LABEL_SIZE - 1);
+        m_record.label_key = key;
+        memcpy(m_record.label, value.data(), size);
+        m_record.label[size] = '\0';
+    }
+
+private:
+    bool m_active;
+    SpanRecord m_record;
+};
+
+} // namespace tracing
+
+#define TRACE_SPAN(span, name, category) tracing::Span span(name, category)
+
+#endif // DEFI_UTIL_TRACING_H
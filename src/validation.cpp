@@ -21,6 +21,8 @@
 #include <masternodes/masternodes.h>
 #include <masternodes/anchors.h>
 #include <masternodes/mn_checks.h>
+#include <memusage.h>
+#include <metrics.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
@@ -45,6 +47,7 @@
 #include <util/rbf.h>
 #include <util/strencodings.h>
 #include <util/system.h>
+#include <util/tracing.h>
 #include <util/translation.h>
 #include <util/validation.h>
 #include <validationinterface.h>
@@ -194,7 +197,7 @@ std::unique_ptr<CBlockTreeDB> pblocktree;
 // See definition for documentation
 static void FindFilesToPruneManual(std::set<int>& setFilesToPrune, int nManualPruneHeight);
 static void FindFilesToPrune(std::set<int>& setFilesToPrune, uint64_t nPruneAfterHeight);
-bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, PrecomputedTransactionData& txdata, std::vector<CScriptCheck> *pvChecks = nullptr);
+bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, const PrecomputedTransactionData& txdata, std::vector<CScriptCheck> *pvChecks = nullptr);
 static FILE* OpenUndoFile(const FlatFilePos &pos, bool fReadOnly = false);
 static FlatFileSeq BlockFileSeq();
 static FlatFileSeq UndoFileSeq();
@@ -406,7 +409,7 @@ static void UpdateMempoolForReorg(DisconnectedBlockTransactions& disconnectpool,
 // Used to avoid mempool polluting consensus critical paths if CCoinsViewMempool
 // were somehow broken and returning the wrong scriptPubKeys
 static bool CheckInputsFromMempoolAndCache(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& view, const CTxMemPool& pool,
-                 unsigned int flags, bool cacheSigStore, PrecomputedTransactionData& txdata) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+                 unsigned int flags, bool cacheSigStore, const PrecomputedTransactionData& txdata) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
     AssertLockHeld(cs_main);
 
     // pool.cs should be locked already, but go ahead and re-take the lock here
@@ -791,14 +794,14 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
 
         // Check against previous transactions
         // This is done last to help prevent CPU exhaustion denial-of-service attacks.
-        PrecomputedTransactionData txdata(tx);
-        if (!CheckInputs(tx, state, view, true, scriptVerifyFlags, true, false, txdata)) {
+        const auto txdata = std::make_shared<const PrecomputedTransactionData>(tx);
+        if (!CheckInputs(tx, state, view, true, scriptVerifyFlags, true, false, *txdata)) {
             // SCRIPT_VERIFY_CLEANSTACK requires SCRIPT_VERIFY_WITNESS, so we
             // need to turn both off, and compare against just turning off CLEANSTACK
             // to see if the failure is specifically due to witness validation.
             CValidationState stateDummy; // Want reported failures to be from first CheckInputs
-            if (!tx.HasWitness() && CheckInputs(tx, stateDummy, view, true, scriptVerifyFlags & ~(SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_CLEANSTACK), true, false, txdata) &&
-                !CheckInputs(tx, stateDummy, view, true, scriptVerifyFlags & ~SCRIPT_VERIFY_CLEANSTACK, true, false, txdata)) {
+            if (!tx.HasWitness() && CheckInputs(tx, stateDummy, view, true, scriptVerifyFlags & ~(SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_CLEANSTACK), true, false, *txdata) &&
+                !CheckInputs(tx, stateDummy, view, true, scriptVerifyFlags & ~SCRIPT_VERIFY_CLEANSTACK, true, false, *txdata)) {
                 // Only the witness is missing, so the transaction itself may be fine.
                 state.Invalid(ValidationInvalidReason::TX_WITNESS_MUTATED, false,
                         state.GetRejectCode(), state.GetRejectReason(), state.GetDebugMessage());
@@ -823,10 +826,13 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
         // invalid blocks (using TestBlockValidity), however allowing such
         // transactions into the mempool can be exploited as a DoS attack.
         unsigned int currentBlockScriptVerifyFlags = GetBlockScriptFlags(::ChainActive().Tip(), chainparams.GetConsensus());
-        if (!CheckInputsFromMempoolAndCache(tx, state, view, pool, currentBlockScriptVerifyFlags, true, txdata)) {
+        if (!CheckInputsFromMempoolAndCache(tx, state, view, pool, currentBlockScriptVerifyFlags, true, *txdata)) {
             return error("%s: BUG! PLEASE REPORT THIS! CheckInputs failed against latest-block but not STANDARD flags %s, %s",
                     __func__, hash.ToString(), FormatStateMessage(state));
         }
+        // Keep the sighash data and the verified flags with the entry, so that connecting a block
+        // with this tx needs neither to recompute the former nor to look up the script cache.
+        entry.SetVerifiedScripts(txdata, currentBlockScriptVerifyFlags);
 
         if (test_accept) {
             // Tx was accepted, but not added
@@ -874,6 +880,7 @@ static bool AcceptToMemoryPoolWithTime(const CChainParams& chainparams, CTxMemPo
                         bool* pfMissingInputs, int64_t nAcceptTime, std::list<CTransactionRef>* plTxnReplaced,
                         bool bypass_limits, const CAmount nAbsurdFee, bool test_accept) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
+    TRACE_SPAN(span, "AcceptToMemoryPool", "mempool");
     std::vector<COutPoint> coins_to_uncache;
     bool res = AcceptToMemoryPoolWorker(chainparams, pool, state, tx, pfMissingInputs, nAcceptTime, plTxnReplaced, bypass_limits, nAbsurdFee, coins_to_uncache, test_accept);
     if (!res) {
@@ -1159,6 +1166,11 @@ BlockMap& BlockIndex()
     return g_blockman.m_block_index;
 }
 
+size_t BlockIndexMemoryUsage()
+{
+    return g_blockman.DynamicMemoryUsage();
+}
+
 static void AlertNotify(const std::string& strMessage)
 {
     uiInterface.NotifyAlertChanged();
@@ -1343,7 +1355,7 @@ void InitScriptExecutionCache() {
  *
  * Non-static (and re-declared) in src/test/txvalidationcache_tests.cpp
  */
-bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, PrecomputedTransactionData& txdata, std::vector<CScriptCheck> *pvChecks) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, const PrecomputedTransactionData& txdata, std::vector<CScriptCheck> *pvChecks) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
     if (!tx.IsCoinBase())
     {
@@ -1706,6 +1718,212 @@ void ThreadScriptCheck(int worker_num) {
     scriptcheckqueue.Thread();
 }
 
+namespace {
+
+/**
+ * Minter keys recovered from header signatures, keyed by header hash. The same header is checked
+ * when its HEADERS message is processed, when its block index entry is created and again when the
+ * block itself arrives, and public key recovery dominates all of these. Entries live in two
+ * generations: when the current one is full it replaces the previous one, so memory stays bounded
+ * and recently used keys survive one rotation.
+ */
+class MinterKeyCache
+{
+    static constexpr size_t GENERATION_SIZE = 32768;
+
+    struct HeaderHasher {
+        size_t operator()(const uint256& hash) const { return ReadLE64(hash.begin()); }
+    };
+    using Map = std::unordered_map<uint256, CKeyID, HeaderHasher>;
+
+    std::mutex m_mutex;
+    Map m_current;
+    Map m_previous;
+
+    void InsertLocked(const uint256& hash, const CKeyID& key)
+    {
+        if (m_current.size() >= GENERATION_SIZE) {
+            m_previous.swap(m_current);
+            m_current.clear();
+        }
+        m_current.emplace(hash, key);
+    }
+
+public:
+    bool Get(const uint256& hash, CKeyID& key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_current.find(hash);
+        if (it != m_current.end()) {
+            key = it->second;
+            return true;
+        }
+        it = m_previous.find(hash);
+        if (it == m_previous.end()) {
+            return false;
+        }
+        key = it->second;
+        InsertLocked(hash, key);
+        return true;
+    }
+
+    void Insert(const uint256& hash, const CKeyID& key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        InsertLocked(hash, key);
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_current.clear();
+        m_previous.clear();
+    }
+};
+
+MinterKeyCache g_minter_key_cache;
+
+} // namespace
+
+bool GetMinterKey(const CBlockHeader& header, CKeyID& key)
+{
+    if (header.sig.empty()) {
+        return false;
+    }
+
+    // The header hash commits to the signature, so each signature is only recovered once.
+    const uint256 hash = header.GetHash();
+    if (g_minter_key_cache.Get(hash, key)) {
+        return true;
+    }
+    if (!header.ExtractMinterKey(key)) {
+        return false;
+    }
+    g_minter_key_cache.Insert(hash, key);
+    return true;
+}
+
+void ClearMinterKeyCache()
+{
+    g_minter_key_cache.Clear();
+}
+
+/**
+ * Closure recovering the minter key of one header into the minter key cache, and into *minter if
+ * given. An invalid signature fails the check, which stops the remaining checks of the queue.
+ */
+class CMinterKeyCheck
+{
+private:
+    const CBlockHeader* m_header;
+    CKeyID* m_minter;
+
+public:
+    CMinterKeyCheck() : m_header(nullptr), m_minter(nullptr) {}
+    explicit CMinterKeyCheck(const CBlockHeader& header, CKeyID* minter = nullptr) : m_header(&header), m_minter(minter) {}
+
+    bool operator()()
+    {
+        CKeyID minter;
+        const bool recovered = GetMinterKey(*m_header, minter);
+        if (m_minter) {
+            *m_minter = minter;
+        }
+        return recovered;
+    }
+
+    void swap(CMinterKeyCheck& check)
+    {
+        std::swap(m_header, check.m_header);
+        std::swap(m_minter, check.m_minter);
+    }
+};
+
+static CCheckQueue<CMinterKeyCheck> headersigcheckqueue(128);
+
+void ThreadHeaderSigCheck(int worker_num) {
+    util::ThreadRename(strprintf("headersig.%i", worker_num));
+    headersigcheckqueue.Thread();
+}
+
+size_t PrefetchMinterKeys(const std::vector<CBlockHeader>& headers)
+{
+    // Recovery is the expensive part of header checks, so it is only spent on headers that could
+    // be accepted: a batch that does not connect to the block index, or the part of it past a gap,
+    // is rejected by the sequential checks before any signature is looked at.
+    if (headers.empty()) {
+        return 0;
+    }
+    {
+        LOCK(cs_main);
+        if (!LookupBlockIndex(headers[0].hashPrevBlock)) {
+            return 0;
+        }
+    }
+    size_t count = 1;
+    for (; count < headers.size(); ++count) {
+        if (headers[count].hashPrevBlock != headers[count - 1].GetHash()) {
+            break;
+        }
+    }
+
+    std::vector<CMinterKeyCheck> checks;
+    checks.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        checks.emplace_back(headers[i]);
+    }
+    if (!nScriptCheckThreads) {
+        for (CMinterKeyCheck& check : checks) {
+            if (!check()) break;
+        }
+        return count;
+    }
+    CCheckQueueControl<CMinterKeyCheck> control(&headersigcheckqueue);
+    control.Add(checks);
+    control.Wait();
+    return count;
+}
+
+bool RecoverMinterKeys(const std::vector<CBlockIndex*>& indexes)
+{
+    // Bound the memory used by the header copies the checks point to.
+    static const size_t BATCH_SIZE = 4096;
+    std::vector<CBlockHeader> headers;
+    std::vector<CMinterKeyCheck> checks;
+    for (size_t begin = 0; begin < indexes.size(); begin += BATCH_SIZE) {
+        if (ShutdownRequested()) return false;
+        const size_t end = std::min(begin + BATCH_SIZE, indexes.size());
+        headers.clear();
+        for (size_t i = begin; i < end; ++i) {
+            headers.push_back(indexes[i]->GetBlockHeader());
+        }
+        for (size_t i = begin; i < end; ++i) {
+            checks.emplace_back(headers[i - begin], &indexes[i]->minter);
+        }
+
+        bool recovered = true;
+        if (!nScriptCheckThreads) {
+            for (CMinterKeyCheck& check : checks) {
+                recovered = check() && recovered;
+            }
+        } else {
+            CCheckQueueControl<CMinterKeyCheck> control(&headersigcheckqueue);
+            control.Add(checks);
+            recovered = control.Wait();
+        }
+        checks.clear();
+        if (!recovered) {
+            for (size_t i = begin; i < end; ++i) {
+                if (indexes[i]->minter.IsNull()) {
+                    return error("%s: The block index #%d (%s) wasn't saved on disk correctly. Index content: %s", __func__,
+                                 indexes[i]->nHeight, indexes[i]->GetBlockHash().ToString(), indexes[i]->ToString());
+                }
+            }
+        }
+    }
+    return true;
+}
+
 VersionBitsCache versionbitscache GUARDED_BY(cs_main);
 
 int32_t ComputeBlockVersion(const CBlockIndex* pindexPrev, const Consensus::Params& params)
@@ -1825,6 +2043,9 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     assert(pindex);
     assert(*pindex->phashBlock == block.GetHash());
     int64_t nTimeStart = GetTimeMicros();
+    TRACE_SPAN(span, "ConnectBlock", "validation");
+    span.Tag("height", pindex->nHeight);
+    span.Tag("just_check", fJustCheck);
 
     // Check it again in case a previous version let a bad block in
     // NOTE: We don't currently (re-)invoke ContextualCheckBlock() or
@@ -2037,8 +2258,21 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     int nInputs = 0;
     int64_t nSigOpsCost = 0;
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
-    std::vector<PrecomputedTransactionData> txdata;
-    txdata.reserve(block.vtx.size()); // Required so that pointers to individual PrecomputedTransactionData don't get invalidated
+    // Transactions we accepted to the mempool already have their sighash data, and need no script
+    // checks at all if they were verified with the script flags of this block.
+    std::vector<std::shared_ptr<const PrecomputedTransactionData>> txdata(block.vtx.size());
+    std::vector<bool> scripts_verified(block.vtx.size(), false);
+    if (fScriptChecks) {
+        LOCK(mempool.cs);
+        for (unsigned int i = 1; i < block.vtx.size() && mempool.size() > 0; i++) {
+            const CTransaction& tx = *block.vtx[i];
+            const auto it = mempool.mapTx.find(tx.GetHash());
+            if (it != mempool.mapTx.end() && it->GetTx().GetWitnessHash() == tx.GetWitnessHash()) {
+                txdata[i] = it->GetPrecomputedData();
+                scripts_verified[i] = it->ScriptsVerifiedWith(flags);
+            }
+        }
+    }
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
         const CTransaction &tx = *(block.vtx[i]);
@@ -2088,12 +2322,14 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
             return state.Invalid(ValidationInvalidReason::CONSENSUS, error("ConnectBlock(): too many sigops"),
                              REJECT_INVALID, "bad-blk-sigops");
 
-        txdata.emplace_back(tx);
         if (!tx.IsCoinBase())
         {
+            if (!txdata[i]) {
+                txdata[i] = std::make_shared<const PrecomputedTransactionData>(tx);
+            }
             std::vector<CScriptCheck> vChecks;
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
-            if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata[i], nScriptCheckThreads ? &vChecks : nullptr)) {
+            if (!scripts_verified[i] && !CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, *txdata[i], nScriptCheckThreads ? &vChecks : nullptr)) {
                 if (state.GetReason() == ValidationInvalidReason::TX_NOT_STANDARD) {
                     // CheckInputs may return NOT_STANDARD for extra flags we passed,
                     // but we can't return that, as it's not defined for a block, so
@@ -2304,6 +2540,7 @@ bool CChainState::FlushStateToDisk(
         }
         int64_t nMempoolSizeMax = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
         int64_t cacheSize = CoinsTip().DynamicMemoryUsage();
+        metrics::coins_cache_usage.Set(cacheSize);
         int64_t nTotalSpace = nCoinCacheUsage + std::max<int64_t>(nMempoolSizeMax - nMempoolUsage, 0);
         // The cache is large and we're within 10% and 10 MiB of the limit, but we have time now (not in the middle of a block processing).
         bool fCacheLarge = mode == FlushStateMode::PERIODIC && cacheSize > std::max((9 * nTotalSpace) / 10, nTotalSpace - MAX_BLOCK_COINSDB_USAGE * 1024 * 1024);
@@ -2410,6 +2647,20 @@ static void AppendWarning(std::string& res, const std::string& warn)
     res += warn;
 }
 
+/** Publish the tip height and, while the metrics are served, the masternode counts at the tip. */
+static void UpdateTipMetrics(const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+{
+    metrics::tip_height.Set(pindex->nHeight);
+    // Counting scans every masternode under cs_main, so it is skipped unless the metrics are served.
+    if (pmasternodesview && metrics::g_enabled.load(std::memory_order_relaxed)) {
+        static_assert(CMasternode::UNKNOWN == metrics::MASTERNODE_STATES, "one masternodes gauge per state");
+        const std::vector<size_t> counts = pmasternodesview->CountMasternodesByState(pindex->nHeight);
+        for (size_t state = 0; state < counts.size(); ++state) {
+            metrics::masternodes[state].Set(counts[state]);
+        }
+    }
+}
+
 /** Check warning conditions and do some notifications on new chain tip set. */
 void static UpdateTip(const CBlockIndex* pindexNew, const CChainParams& chainParams)
     EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
@@ -2423,6 +2674,8 @@ void static UpdateTip(const CBlockIndex* pindexNew, const CChainParams& chainPar
         g_best_block_cv.notify_all();
     }
 
+    UpdateTipMetrics(pindexNew);
+
     std::string warningMessages;
     if (!::ChainstateActive().IsInitialBlockDownload())
     {
@@ -2542,6 +2795,7 @@ struct PerBlockConnectTrace {
     CBlockIndex* pindex = nullptr;
     std::shared_ptr<const CBlock> pblock;
     std::shared_ptr<std::vector<CTransactionRef>> conflictedTxs;
+    std::shared_ptr<const std::vector<CMasternodeEvent>> masternodeEvents;
     PerBlockConnectTrace() : conflictedTxs(std::make_shared<std::vector<CTransactionRef>>()) {}
 };
 /**
@@ -2571,12 +2825,13 @@ public:
         m_connNotifyEntryRemoved = pool.NotifyEntryRemoved.connect(std::bind(&ConnectTrace::NotifyEntryRemoved, this, std::placeholders::_1, std::placeholders::_2));
     }
 
-    void BlockConnected(CBlockIndex* pindex, std::shared_ptr<const CBlock> pblock) {
+    void BlockConnected(CBlockIndex* pindex, std::shared_ptr<const CBlock> pblock, std::shared_ptr<const std::vector<CMasternodeEvent>> masternodeEvents) {
         assert(!blocksConnected.back().pindex);
         assert(pindex);
         assert(pblock);
         blocksConnected.back().pindex = pindex;
         blocksConnected.back().pblock = std::move(pblock);
+        blocksConnected.back().masternodeEvents = std::move(masternodeEvents);
         blocksConnected.emplace_back();
     }
 
@@ -2600,6 +2855,39 @@ public:
     }
 };
 
+/**
+ * The masternodes created, resigned or banned by a block just connected on mnview. The block also
+ * carries the masternode transactions that failed their checks, so each one is confirmed against
+ * the view.
+ */
+static std::vector<CMasternodeEvent> GetMasternodeEvents(const CBlock& block, int height, const CMasternodesView& mnview, const std::vector<uint256>& bannedCriminals)
+{
+    std::vector<CMasternodeEvent> events;
+    for (const CTransactionRef& ptx : block.vtx) {
+        if (ptx->IsCoinBase()) continue;
+        std::vector<unsigned char> metadata;
+        const MasternodesTxType type = GuessMasternodeTxType(*ptx, metadata);
+        if (type == MasternodesTxType::CreateMasternode) {
+            const CMasternode* node = mnview.ExistMasternode(ptx->GetHash());
+            if (node && node->creationHeight == height) {
+                events.push_back({CMasternodeEvent::CREATED, ptx->GetHash(), ptx->GetHash(), *node});
+            }
+        } else if (type == MasternodesTxType::ResignMasternode && metadata.size() == sizeof(uint256)) {
+            const uint256 nodeId(metadata);
+            const CMasternode* node = mnview.ExistMasternode(nodeId);
+            if (node && node->resignTx == ptx->GetHash()) {
+                events.push_back({CMasternodeEvent::RESIGNED, nodeId, ptx->GetHash(), *node});
+            }
+        }
+    }
+    for (const uint256& nodeId : bannedCriminals) {
+        if (const CMasternode* node = mnview.ExistMasternode(nodeId)) {
+            events.push_back({CMasternodeEvent::BANNED, nodeId, node->banTx, *node});
+        }
+    }
+    return events;
+}
+
 /**
  * Connect a new block to m_chain. pblock is either nullptr or a pointer to a CBlock
  * corresponding to pindexNew, to bypass loading it again from disk.
@@ -2625,6 +2913,7 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     int64_t nTime2 = GetTimeMicros(); nTimeReadFromDisk += nTime2 - nTime1;
     int64_t nTime3;
     LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * MILLI, nTimeReadFromDisk * MICRO);
+    std::shared_ptr<const std::vector<CMasternodeEvent>> masternodeEvents;
     {
         CCoinsViewCache view(&CoinsTip());
         CMasternodesViewCache mnview(pmasternodesview.get());
@@ -2639,6 +2928,10 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
         }
         nTime3 = GetTimeMicros(); nTimeConnectTotal += nTime3 - nTime2;
         LogPrint(BCLog::BENCH, "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime3 - nTime2) * MILLI, nTimeConnectTotal * MICRO, nTimeConnectTotal * MILLI / nBlocksTotal);
+        std::vector<CMasternodeEvent> events = GetMasternodeEvents(blockConnecting, pindexNew->nHeight, mnview, bannedCriminals);
+        if (!events.empty()) {
+            masternodeEvents = std::make_shared<const std::vector<CMasternodeEvent>>(std::move(events));
+        }
         bool flushed = view.Flush() && mnview.Flush();
         assert(flushed);
 
@@ -2671,8 +2964,9 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     int64_t nTime6 = GetTimeMicros(); nTimePostConnect += nTime6 - nTime5; nTimeTotal += nTime6 - nTime1;
     LogPrint(BCLog::BENCH, "  - Connect postprocess: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime6 - nTime5) * MILLI, nTimePostConnect * MICRO, nTimePostConnect * MILLI / nBlocksTotal);
     LogPrint(BCLog::BENCH, "- Connect block: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime6 - nTime1) * MILLI, nTimeTotal * MICRO, nTimeTotal * MILLI / nBlocksTotal);
+    metrics::block_connect.Observe(nTime6 - nTime1);
 
-    connectTrace.BlockConnected(pindexNew, std::move(pthisBlock));
+    connectTrace.BlockConnected(pindexNew, std::move(pthisBlock), std::move(masternodeEvents));
     return true;
 }
 
@@ -2924,9 +3218,9 @@ static void NotifyHeaderTip() LOCKS_EXCLUDED(cs_main) {
 static void LimitValidationInterfaceQueue() LOCKS_EXCLUDED(cs_main) {
     AssertLockNotHeld(cs_main);
 
-    if (GetMainSignals().CallbacksPending() > 10) {
-        SyncWithValidationInterfaceQueue();
-    }
+    // Subscribers with their own queue only hold this back once their queue
+    // is full, and lossy ones never do.
+    GetMainSignals().LimitCallbacksPending(10);
 }
 
 void CChainState::RefillCandidates() {
@@ -3022,6 +3316,7 @@ bool CChainState::ActivateBestChain(CValidationState &state, const CChainParams&
     // us in the middle of ProcessNewBlock - do not assume pblock is set
     // sanely for performance or correctness!
     AssertLockNotHeld(cs_main);
+    TRACE_SPAN(span, "ActivateBestChain", "validation");
 
     // ABC maintains a fair degree of expensive-to-calculate internal state
     // because this function periodically releases cs_main so that it does not lock up other threads for too long
@@ -3081,6 +3376,9 @@ bool CChainState::ActivateBestChain(CValidationState &state, const CChainParams&
                 for (const PerBlockConnectTrace& trace : connectTrace.GetBlocksConnected()) {
                     assert(trace.pblock && trace.pindex);
                     GetMainSignals().BlockConnected(trace.pblock, trace.pindex, trace.conflictedTxs);
+                    if (trace.masternodeEvents) {
+                        GetMainSignals().MasternodesUpdated(trace.pindex, trace.masternodeEvents);
+                    }
                 }
             } while (!m_chain.Tip() || (starting_tip && CBlockIndexWorkComparator()(m_chain.Tip(), starting_tip)));
             if (!blocks_connected) return true;
@@ -3294,7 +3592,10 @@ CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block)
         return it->second;
 
     // Construct new block index object
-    CBlockIndex* pindexNew = new CBlockIndex(block);
+    CKeyID minter;
+    GetMinterKey(block, minter);
+    CBlockIndex* pindexNew = m_block_index_arena.Allocate();
+    *pindexNew = CBlockIndex(block, minter);
     // We assign the sequence id to blocks only when the full data is available,
     // to avoid miners withholding blocks but broadcasting headers, to get a
     // competitive advantage.
@@ -3754,7 +4055,7 @@ bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, CValidationState
         // Add MintedBlockHeader entity to DB and check for criminal (limited application for now due to possible "far future" of the header)
         if (fCriminals) {
             CKeyID minterKey;
-            assert(block.ExtractMinterKey(minterKey));
+            assert(GetMinterKey(block, minterKey));
             auto it = pmasternodesview->ExistMasternode(CMasternodesView::AuthIndex::ByOperator, minterKey);
             if (it) {
                 auto const & nodeId = (*it)->second;
@@ -3844,6 +4145,10 @@ bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, CValidationState
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, CBlockHeader *first_invalid)
 {
     if (first_invalid != nullptr) first_invalid->SetNull();
+
+    // Recover the header signatures on the header check threads before taking cs_main, so that the
+    // sequential checks below only hit the minter key cache.
+    PrefetchMinterKeys(headers);
     {
         LOCK(cs_main);
 
@@ -4359,7 +4664,7 @@ CBlockIndex * BlockManager::InsertBlockIndex(const uint256& hash)
         return (*mi).second;
 
     // Create new
-    CBlockIndex* pindexNew = new CBlockIndex();
+    CBlockIndex* pindexNew = m_block_index_arena.Allocate();
     mi = m_block_index.insert(std::make_pair(hash, pindexNew)).first;
     pindexNew->phashBlock = &((*mi).first);
 
@@ -4371,9 +4676,22 @@ bool BlockManager::LoadBlockIndex(
     CBlockTreeDB& blocktree,
     std::set<CBlockIndex*, CBlockIndexWorkComparator>& block_index_candidates)
 {
-    if (!blocktree.LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }, fIsFakeNet))
+    std::vector<CBlockIndex*> unknown_minters;
+    if (!blocktree.LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }, fIsFakeNet, unknown_minters))
          return false;
 
+    // Block index entries written before minters were stored with them have
+    // theirs recovered once, on the header signature threads.
+    if (!unknown_minters.empty()) {
+        LogPrintf("Recovering the minters of %u block index entries...\n", unknown_minters.size());
+        if (!RecoverMinterKeys(unknown_minters)) {
+            return false;
+        }
+        if (!blocktree.WriteMinters(unknown_minters)) {
+            return error("%s: failed to write the recovered minters", __func__);
+        }
+    }
+
     // Calculate nChainWork
     std::vector<std::pair<int, CBlockIndex*> > vSortedByHeight;
     vSortedByHeight.reserve(m_block_index.size());
@@ -4425,11 +4743,14 @@ void BlockManager::Unload() {
     m_failed_blocks.clear();
     m_blocks_unlinked.clear();
 
-    for (const BlockMap::value_type& entry : m_block_index) {
-        delete entry.second;
-    }
-
     m_block_index.clear();
+    m_block_index_arena.Clear();
+}
+
+size_t BlockManager::DynamicMemoryUsage() const
+{
+    AssertLockHeld(cs_main);
+    return memusage::DynamicUsage(m_block_index) + m_block_index_arena.DynamicMemoryUsage();
 }
 
 bool static LoadBlockIndexDB(const CChainParams& chainparams) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
@@ -4501,6 +4822,7 @@ bool LoadChainTip(const CChainParams& chainparams)
         return false;
     }
     ::ChainActive().SetTip(pindex);
+    UpdateTipMetrics(pindex);
 
     ::ChainstateActive().PruneBlockIndexCandidates();
 
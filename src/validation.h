@@ -119,6 +119,8 @@ static const int64_t MAX_FEE_ESTIMATION_TIP_AGE = 3 * 60 * 60;
 
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
 static const bool DEFAULT_TXINDEX = false;
+static const bool DEFAULT_ADDRESSINDEX = false;
+static const bool DEFAULT_MASTERNODETXINDEX = false;
 static const char* const DEFAULT_BLOCKFILTERINDEX = "0";
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 /** Default for -persistmempool */
@@ -259,6 +261,20 @@ bool LoadChainTip(const CChainParams& chainparams) EXCLUSIVE_LOCKS_REQUIRED(cs_m
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck(int worker_num);
+/** Run an instance of the header signature recovery thread */
+void ThreadHeaderSigCheck(int worker_num);
+/** Recover the key id of the minter of a header, through a cache of recently recovered keys */
+bool GetMinterKey(const CBlockHeader& header, CKeyID& key);
+/** Drop all minter keys cached by GetMinterKey */
+void ClearMinterKeyCache();
+/**
+ * Recover the minter keys of a batch of headers in parallel and cache them for the header checks.
+ * Only the leading headers that connect to an indexed block and to each other are recovered, and
+ * recovery stops at the first bad signature. Returns the number of connecting headers.
+ */
+size_t PrefetchMinterKeys(const std::vector<CBlockHeader>& headers) LOCKS_EXCLUDED(cs_main);
+/** Recover the minter keys of block index entries from their signatures, in parallel. Fails on an invalid signature. */
+bool RecoverMinterKeys(const std::vector<CBlockIndex*>& indexes);
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
 bool GetTransaction(const uint256& hash, CTransactionRef& tx, const Consensus::Params& params, uint256& hashBlock, const CBlockIndex* const blockIndex = nullptr);
 /**
@@ -351,11 +367,11 @@ private:
     unsigned int nFlags;
     bool cacheStore;
     ScriptError error;
-    PrecomputedTransactionData *txdata;
+    const PrecomputedTransactionData *txdata;
 
 public:
     CScriptCheck(): ptxTo(nullptr), nIn(0), nFlags(0), cacheStore(false), error(SCRIPT_ERR_UNKNOWN_ERROR) {}
-    CScriptCheck(const CTxOut& outIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn, PrecomputedTransactionData* txdataIn) :
+    CScriptCheck(const CTxOut& outIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn, const PrecomputedTransactionData* txdataIn) :
         m_tx_out(outIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(txdataIn) { }
 
     bool operator()();
@@ -455,6 +471,9 @@ class BlockManager {
 public:
     BlockMap m_block_index GUARDED_BY(cs_main);
 
+    /** Owns the entries of m_block_index. */
+    CBlockIndexArena m_block_index_arena GUARDED_BY(cs_main);
+
     /** In order to efficiently track invalidity of headers, we keep the set of
       * blocks which we tried to connect and found to be invalid here (ie which
       * were set to BLOCK_FAILED_VALID since the last restart). We can then
@@ -498,6 +517,9 @@ public:
     /** Clear all data members. */
     void Unload() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /** Memory used by m_block_index and its entries. */
+    size_t DynamicMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     CBlockIndex* AddToBlockIndex(const CBlockHeader& block) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     /** Create a new block index entry for a given block hash */
     CBlockIndex* InsertBlockIndex(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -756,6 +778,9 @@ CChain& ChainActive();
 /** @returns the global block index map. */
 BlockMap& BlockIndex();
 
+/** @returns the memory used by the global block index map and its entries. */
+size_t BlockIndexMemoryUsage() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 // Most often ::ChainstateActive() should be used instead of this, but some code
 // may not be able to assume that this has been initialized yet and so must use it
 // directly, e.g. init.cpp.
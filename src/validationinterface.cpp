@@ -5,13 +5,20 @@
 
 #include <validationinterface.h>
 
+#include <masternodes/masternodes.h>
 #include <primitives/block.h>
 #include <scheduler.h>
 #include <txmempool.h>
+#include <util/system.h>
+#include <util/time.h>
 
+#include <algorithm>
 #include <list>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <future>
+#include <thread>
 #include <utility>
 
 #include <boost/signals2/signal.hpp>
@@ -21,17 +28,172 @@ struct ValidationInterfaceConnections {
     boost::signals2::scoped_connection TransactionAddedToMempool;
     boost::signals2::scoped_connection BlockConnected;
     boost::signals2::scoped_connection BlockDisconnected;
+    boost::signals2::scoped_connection MasternodesUpdated;
     boost::signals2::scoped_connection TransactionRemovedFromMempool;
     boost::signals2::scoped_connection ChainStateFlushed;
     boost::signals2::scoped_connection BlockChecked;
     boost::signals2::scoped_connection NewPoWValidBlock;
 };
 
+/**
+ * The notification queue and thread of a subscriber registered with
+ * ValidationInterfaceQueueOptions. Callbacks are run in the order they were
+ * added, one at a time.
+ */
+class ValidationInterfaceQueue : public std::enable_shared_from_this<ValidationInterfaceQueue> {
+public:
+    const ValidationInterfaceQueueOptions m_options;
+
+    // The subscriber's background callbacks
+    std::function<void (const CBlockIndex *, const CBlockIndex *, bool fInitialDownload)> UpdatedBlockTip;
+    std::function<void (const CTransactionRef &)> TransactionAddedToMempool;
+    std::function<void (const std::shared_ptr<const CBlock> &, const CBlockIndex *pindex, const std::vector<CTransactionRef>&)> BlockConnected;
+    std::function<void (const std::shared_ptr<const CBlock> &)> BlockDisconnected;
+    std::function<void (const CBlockIndex *, const std::vector<CMasternodeEvent> &)> MasternodesUpdated;
+    std::function<void (const CTransactionRef &)> TransactionRemovedFromMempool;
+    std::function<void (const CBlockLocator &)> ChainStateFlushed;
+
+    explicit ValidationInterfaceQueue(const ValidationInterfaceQueueOptions& options) : m_options(options) {}
+
+    void Start()
+    {
+        // The thread keeps the queue alive, in case it is unregistered from one of its own callbacks.
+        m_thread = std::thread(&TraceThread<std::function<void ()>>, m_options.name.c_str(),
+                               std::bind(&ValidationInterfaceQueue::ThreadProcess, shared_from_this()));
+    }
+
+    /** Add a notification, or drop it if the queue is lossy and full. */
+    void Add(std::function<void ()> func)
+    {
+        {
+            LOCK(m_mutex);
+            if (m_stopped) return;
+            if (m_options.lossy && m_items.size() >= m_options.max_size) {
+                ++m_dropped;
+                return;
+            }
+            m_items.push_back({std::move(func), false});
+            m_peak = std::max(m_peak, m_items.size());
+        }
+        m_cond.notify_all();
+    }
+
+    /** Add a function queued by CallFunctionInValidationInterfaceQueue, which is never dropped. */
+    void AddBarrier(std::function<void ()> func)
+    {
+        {
+            LOCK(m_mutex);
+            if (!m_stopped) {
+                m_items.push_back({std::move(func), true});
+                m_peak = std::max(m_peak, m_items.size());
+                func = nullptr;
+            }
+        }
+        if (func) {
+            func();
+        } else {
+            m_cond.notify_all();
+        }
+    }
+
+    /** Block until the queue is below its maximum size, unless it is lossy. */
+    void WaitForCapacity()
+    {
+        if (m_options.lossy) return;
+        WAIT_LOCK(m_mutex, lock);
+        if (m_items.size() < m_options.max_size) return;
+        const int64_t start = GetTimeMicros();
+        while (!m_stopped && m_items.size() >= m_options.max_size) {
+            m_cond.wait(lock);
+        }
+        m_wait_micros += GetTimeMicros() - start;
+    }
+
+    /**
+     * Stop the thread, waiting for a callback in progress to return. The
+     * pending callbacks are then run on the calling thread if flush is set,
+     * and dropped otherwise, except for the functions added by AddBarrier,
+     * which are always run.
+     */
+    void Stop(bool flush)
+    {
+        {
+            LOCK(m_mutex);
+            m_stopped = true;
+        }
+        m_cond.notify_all();
+        if (m_thread.joinable()) {
+            if (m_thread.get_id() == std::this_thread::get_id()) {
+                m_thread.detach();
+            } else {
+                m_thread.join();
+            }
+        }
+        std::deque<Item> items;
+        WITH_LOCK(m_mutex, items.swap(m_items));
+        for (Item& item : items) {
+            if (flush || item.barrier) item.func();
+        }
+    }
+
+    ValidationInterfaceQueueStats GetStats()
+    {
+        LOCK(m_mutex);
+        ValidationInterfaceQueueStats stats;
+        stats.name = m_options.name;
+        stats.lossy = m_options.lossy;
+        stats.max_size = m_options.max_size;
+        stats.pending = m_items.size();
+        stats.peak = m_peak;
+        stats.processed = m_processed;
+        stats.dropped = m_dropped;
+        stats.wait_micros = m_wait_micros;
+        return stats;
+    }
+
+private:
+    struct Item {
+        std::function<void ()> func;
+        bool barrier;
+    };
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Item> m_items GUARDED_BY(m_mutex);
+    bool m_stopped GUARDED_BY(m_mutex) = false;
+    size_t m_peak GUARDED_BY(m_mutex) = 0;
+    uint64_t m_processed GUARDED_BY(m_mutex) = 0;
+    uint64_t m_dropped GUARDED_BY(m_mutex) = 0;
+    int64_t m_wait_micros GUARDED_BY(m_mutex) = 0;
+    std::thread m_thread;
+
+    void ThreadProcess()
+    {
+        while (true) {
+            Item item;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                while (!m_stopped && m_items.empty()) {
+                    m_cond.wait(lock);
+                }
+                if (m_stopped) return;
+                item = std::move(m_items.front());
+                m_items.pop_front();
+            }
+            item.func();
+            if (!item.barrier) WITH_LOCK(m_mutex, ++m_processed);
+            // Wake up WaitForCapacity
+            m_cond.notify_all();
+        }
+    }
+};
+
 struct MainSignalsInstance {
     boost::signals2::signal<void (const CBlockIndex *, const CBlockIndex *, bool fInitialDownload)> UpdatedBlockTip;
     boost::signals2::signal<void (const CTransactionRef &)> TransactionAddedToMempool;
     boost::signals2::signal<void (const std::shared_ptr<const CBlock> &, const CBlockIndex *pindex, const std::vector<CTransactionRef>&)> BlockConnected;
     boost::signals2::signal<void (const std::shared_ptr<const CBlock> &)> BlockDisconnected;
+    boost::signals2::signal<void (const CBlockIndex *, const std::vector<CMasternodeEvent> &)> MasternodesUpdated;
     boost::signals2::signal<void (const CTransactionRef &)> TransactionRemovedFromMempool;
     boost::signals2::signal<void (const CBlockLocator &)> ChainStateFlushed;
     boost::signals2::signal<void (const CBlock&, const CValidationState&)> BlockChecked;
@@ -43,7 +205,39 @@ struct MainSignalsInstance {
     SingleThreadedSchedulerClient m_schedulerClient;
     std::unordered_map<CValidationInterface*, ValidationInterfaceConnections> m_connMainSignals;
 
-    explicit MainSignalsInstance(CScheduler *pscheduler) : m_schedulerClient(pscheduler) {}
+    Mutex m_queues_mutex;
+    std::unordered_map<CValidationInterface*, std::shared_ptr<ValidationInterfaceQueue>> m_queues GUARDED_BY(m_queues_mutex);
+
+    explicit MainSignalsInstance(CScheduler *pscheduler) : m_schedulerClient(pscheduler, "validation") {}
+
+    ~MainSignalsInstance()
+    {
+        for (const auto& queue : GetQueues()) {
+            queue->Stop(false);
+        }
+    }
+
+    /** The subscriber queues, to be used without holding m_queues_mutex. */
+    std::vector<std::shared_ptr<ValidationInterfaceQueue>> GetQueues()
+    {
+        LOCK(m_queues_mutex);
+        std::vector<std::shared_ptr<ValidationInterfaceQueue>> queues;
+        for (const auto& entry : m_queues) {
+            queues.push_back(entry.second);
+        }
+        return queues;
+    }
+
+    /** Add a notification to every subscriber queue, calling func with the queue's callbacks. */
+    template <typename Func>
+    void AddToQueues(Func func)
+    {
+        LOCK(m_queues_mutex);
+        for (const auto& entry : m_queues) {
+            ValidationInterfaceQueue* queue = entry.second.get();
+            queue->Add([queue, func] { func(*queue); });
+        }
+    }
 };
 
 static CMainSignals g_signals;
@@ -65,6 +259,9 @@ void CMainSignals::UnregisterBackgroundSignalScheduler() {
 void CMainSignals::FlushBackgroundCallbacks() {
     if (m_internals) {
         m_internals->m_schedulerClient.EmptyQueue();
+        for (const auto& queue : m_internals->GetQueues()) {
+            queue->Stop(true);
+        }
     }
 }
 
@@ -73,6 +270,31 @@ size_t CMainSignals::CallbacksPending() {
     return m_internals->m_schedulerClient.CallbacksPending();
 }
 
+void CMainSignals::LimitCallbacksPending(size_t max_pending) {
+    AssertLockNotHeld(cs_main);
+    if (CallbacksPending() > max_pending) {
+        std::promise<void> promise;
+        m_internals->m_schedulerClient.AddToProcessQueue([&promise] {
+            promise.set_value();
+        });
+        promise.get_future().wait();
+    }
+    for (const auto& queue : m_internals->GetQueues()) {
+        queue->WaitForCapacity();
+    }
+}
+
+std::vector<ValidationInterfaceQueueStats> CMainSignals::GetQueueStats() {
+    std::vector<ValidationInterfaceQueueStats> stats(1);
+    stats[0].name = "shared";
+    if (!m_internals) return stats;
+    stats[0].pending = CallbacksPending();
+    for (const auto& queue : m_internals->GetQueues()) {
+        stats.push_back(queue->GetStats());
+    }
+    return stats;
+}
+
 void CMainSignals::RegisterWithMempoolSignals(CTxMemPool& pool) {
     g_connNotifyEntryRemoved.emplace(std::piecewise_construct,
         std::forward_as_tuple(&pool),
@@ -89,21 +311,55 @@ CMainSignals& GetMainSignals()
     return g_signals;
 }
 
+size_t GetValidationQueueSize() {
+    return std::max<int64_t>(1, gArgs.GetArg("-validationqueuesize", DEFAULT_VALIDATION_QUEUE_SIZE));
+}
+
 void RegisterValidationInterface(CValidationInterface* pwalletIn) {
     ValidationInterfaceConnections& conns = g_signals.m_internals->m_connMainSignals[pwalletIn];
     conns.UpdatedBlockTip = g_signals.m_internals->UpdatedBlockTip.connect(std::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
     conns.TransactionAddedToMempool = g_signals.m_internals->TransactionAddedToMempool.connect(std::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, std::placeholders::_1));
     conns.BlockConnected = g_signals.m_internals->BlockConnected.connect(std::bind(&CValidationInterface::BlockConnected, pwalletIn, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
     conns.BlockDisconnected = g_signals.m_internals->BlockDisconnected.connect(std::bind(&CValidationInterface::BlockDisconnected, pwalletIn, std::placeholders::_1));
+    conns.MasternodesUpdated = g_signals.m_internals->MasternodesUpdated.connect(std::bind(&CValidationInterface::MasternodesUpdated, pwalletIn, std::placeholders::_1, std::placeholders::_2));
     conns.TransactionRemovedFromMempool = g_signals.m_internals->TransactionRemovedFromMempool.connect(std::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, std::placeholders::_1));
     conns.ChainStateFlushed = g_signals.m_internals->ChainStateFlushed.connect(std::bind(&CValidationInterface::ChainStateFlushed, pwalletIn, std::placeholders::_1));
     conns.BlockChecked = g_signals.m_internals->BlockChecked.connect(std::bind(&CValidationInterface::BlockChecked, pwalletIn, std::placeholders::_1, std::placeholders::_2));
     conns.NewPoWValidBlock = g_signals.m_internals->NewPoWValidBlock.connect(std::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, std::placeholders::_1, std::placeholders::_2));
 }
 
+void RegisterValidationInterface(CValidationInterface* pwalletIn, const ValidationInterfaceQueueOptions& options) {
+    auto queue = std::make_shared<ValidationInterfaceQueue>(options);
+    queue->UpdatedBlockTip = std::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+    queue->TransactionAddedToMempool = std::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, std::placeholders::_1);
+    queue->BlockConnected = std::bind(&CValidationInterface::BlockConnected, pwalletIn, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+    queue->BlockDisconnected = std::bind(&CValidationInterface::BlockDisconnected, pwalletIn, std::placeholders::_1);
+    queue->MasternodesUpdated = std::bind(&CValidationInterface::MasternodesUpdated, pwalletIn, std::placeholders::_1, std::placeholders::_2);
+    queue->TransactionRemovedFromMempool = std::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, std::placeholders::_1);
+    queue->ChainStateFlushed = std::bind(&CValidationInterface::ChainStateFlushed, pwalletIn, std::placeholders::_1);
+    queue->Start();
+
+    ValidationInterfaceConnections& conns = g_signals.m_internals->m_connMainSignals[pwalletIn];
+    conns.BlockChecked = g_signals.m_internals->BlockChecked.connect(std::bind(&CValidationInterface::BlockChecked, pwalletIn, std::placeholders::_1, std::placeholders::_2));
+    conns.NewPoWValidBlock = g_signals.m_internals->NewPoWValidBlock.connect(std::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, std::placeholders::_1, std::placeholders::_2));
+
+    LOCK(g_signals.m_internals->m_queues_mutex);
+    g_signals.m_internals->m_queues[pwalletIn] = std::move(queue);
+}
+
 void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
     if (g_signals.m_internals) {
         g_signals.m_internals->m_connMainSignals.erase(pwalletIn);
+        std::shared_ptr<ValidationInterfaceQueue> queue;
+        {
+            LOCK(g_signals.m_internals->m_queues_mutex);
+            auto it = g_signals.m_internals->m_queues.find(pwalletIn);
+            if (it != g_signals.m_internals->m_queues.end()) {
+                queue = std::move(it->second);
+                g_signals.m_internals->m_queues.erase(it);
+            }
+        }
+        if (queue) queue->Stop(false);
     }
 }
 
@@ -112,10 +368,29 @@ void UnregisterAllValidationInterfaces() {
         return;
     }
     g_signals.m_internals->m_connMainSignals.clear();
+    for (const auto& queue : g_signals.m_internals->GetQueues()) {
+        queue->Stop(false);
+    }
+    WITH_LOCK(g_signals.m_internals->m_queues_mutex, g_signals.m_internals->m_queues.clear());
 }
 
 void CallFunctionInValidationInterfaceQueue(std::function<void ()> func) {
-    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+    // func has to wait for the shared queue and every subscriber queue, so it
+    // is added to all of them and called by the last one to get to it.
+    const auto queues = g_signals.m_internals->GetQueues();
+    if (queues.empty()) {
+        g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+        return;
+    }
+    auto remaining = std::make_shared<std::atomic<size_t>>(queues.size() + 1);
+    auto shared_func = std::make_shared<std::function<void ()>>(std::move(func));
+    auto arrive = [remaining, shared_func] {
+        if (--*remaining == 0) (*shared_func)();
+    };
+    for (const auto& queue : queues) {
+        queue->AddBarrier(arrive);
+    }
+    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(arrive);
 }
 
 void SyncWithValidationInterfaceQueue() {
@@ -133,6 +408,9 @@ void CMainSignals::MempoolEntryRemoved(CTransactionRef ptx, MemPoolRemovalReason
         m_internals->m_schedulerClient.AddToProcessQueue([ptx, this] {
             m_internals->TransactionRemovedFromMempool(ptx);
         });
+        m_internals->AddToQueues([ptx](ValidationInterfaceQueue& queue) {
+            queue.TransactionRemovedFromMempool(ptx);
+        });
     }
 }
 
@@ -144,30 +422,54 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockInd
     m_internals->m_schedulerClient.AddToProcessQueue([pindexNew, pindexFork, fInitialDownload, this] {
         m_internals->UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
     });
+    m_internals->AddToQueues([pindexNew, pindexFork, fInitialDownload](ValidationInterfaceQueue& queue) {
+        queue.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
+    });
 }
 
 void CMainSignals::TransactionAddedToMempool(const CTransactionRef &ptx) {
     m_internals->m_schedulerClient.AddToProcessQueue([ptx, this] {
         m_internals->TransactionAddedToMempool(ptx);
     });
+    m_internals->AddToQueues([ptx](ValidationInterfaceQueue& queue) {
+        queue.TransactionAddedToMempool(ptx);
+    });
 }
 
 void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex *pindex, const std::shared_ptr<const std::vector<CTransactionRef>>& pvtxConflicted) {
     m_internals->m_schedulerClient.AddToProcessQueue([pblock, pindex, pvtxConflicted, this] {
         m_internals->BlockConnected(pblock, pindex, *pvtxConflicted);
     });
+    m_internals->AddToQueues([pblock, pindex, pvtxConflicted](ValidationInterfaceQueue& queue) {
+        queue.BlockConnected(pblock, pindex, *pvtxConflicted);
+    });
 }
 
 void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock> &pblock) {
     m_internals->m_schedulerClient.AddToProcessQueue([pblock, this] {
         m_internals->BlockDisconnected(pblock);
     });
+    m_internals->AddToQueues([pblock](ValidationInterfaceQueue& queue) {
+        queue.BlockDisconnected(pblock);
+    });
+}
+
+void CMainSignals::MasternodesUpdated(const CBlockIndex *pindex, const std::shared_ptr<const std::vector<CMasternodeEvent>> &pevents) {
+    m_internals->m_schedulerClient.AddToProcessQueue([pindex, pevents, this] {
+        m_internals->MasternodesUpdated(pindex, *pevents);
+    });
+    m_internals->AddToQueues([pindex, pevents](ValidationInterfaceQueue& queue) {
+        queue.MasternodesUpdated(pindex, *pevents);
+    });
 }
 
 void CMainSignals::ChainStateFlushed(const CBlockLocator &locator) {
     m_internals->m_schedulerClient.AddToProcessQueue([locator, this] {
         m_internals->ChainStateFlushed(locator);
     });
+    m_internals->AddToQueues([locator](ValidationInterfaceQueue& queue) {
+        queue.ChainStateFlushed(locator);
+    });
 }
 
 void CMainSignals::BlockChecked(const CBlock& block, const CValidationState& state) {
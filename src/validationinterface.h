@@ -11,6 +11,8 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 extern CCriticalSection cs_main;
 class CBlock;
@@ -22,19 +24,68 @@ class CValidationState;
 class uint256;
 class CScheduler;
 class CTxMemPool;
+struct CMasternodeEvent;
 enum class MemPoolRemovalReason;
 
+/**
+ * Default maximum number of callbacks pending in a subscriber queue. Pending
+ * block notifications keep their blocks in memory, so this is the limit the
+ * shared queue had before subscribers got queues of their own.
+ */
+static const size_t DEFAULT_VALIDATION_QUEUE_SIZE = 10;
+
+/** Options of a subscriber with a notification queue and thread of its own */
+struct ValidationInterfaceQueueOptions {
+    //! Name of the queue, also used for its thread
+    std::string name;
+    //! Callbacks pending above which the queue is considered full
+    size_t max_size = DEFAULT_VALIDATION_QUEUE_SIZE;
+    //! Whether notifications are dropped when the queue is full, rather than
+    //! holding back block connection until the subscriber catches up
+    bool lossy = false;
+};
+
+/** Backpressure metrics of a notification queue */
+struct ValidationInterfaceQueueStats {
+    std::string name;
+    bool lossy = false;
+    size_t max_size = 0;
+    //! Callbacks currently pending, and the most ever pending at once
+    size_t pending = 0;
+    size_t peak = 0;
+    //! Notifications processed and dropped
+    uint64_t processed = 0;
+    uint64_t dropped = 0;
+    //! Total time block connection waited for the queue to drain
+    int64_t wait_micros = 0;
+};
+
 // These functions dispatch to one or all registered wallets
 
+/** The -validationqueuesize of the wallet and index queues, which hold back block connection when full */
+size_t GetValidationQueueSize();
+
 /** Register a wallet to receive updates from core */
 void RegisterValidationInterface(CValidationInterface* pwalletIn);
-/** Unregister a wallet from core */
+/**
+ * Register a subscriber whose background callbacks are run from a queue and
+ * thread of its own, so that it neither waits for nor delays the other
+ * subscribers. BlockChecked and NewPoWValidBlock are still called
+ * synchronously.
+ */
+void RegisterValidationInterface(CValidationInterface* pwalletIn, const ValidationInterfaceQueueOptions& options);
+/**
+ * Unregister a wallet from core. For a subscriber with its own queue, this
+ * waits for a callback in progress to return and drops the pending ones.
+ */
 void UnregisterValidationInterface(CValidationInterface* pwalletIn);
 /** Unregister all wallets from core */
 void UnregisterAllValidationInterfaces();
 /**
  * Pushes a function to callback onto the notification queue, guaranteeing any
  * callbacks generated prior to now are finished when the function is called.
+ * With subscribers that have their own queue, the function is called on
+ * the thread of whichever queue gets to it last.
  *
  * Be very careful blocking on func to be called if any locks are held -
  * validation interface clients may not be able to make progress as they often
@@ -115,6 +166,14 @@ protected:
      * Called on a background thread.
      */
     virtual void BlockDisconnected(const std::shared_ptr<const CBlock> &block) {}
+    /**
+     * Notifies listeners of the masternodes created, resigned or banned by a
+     * connected block, right after its BlockConnected. Only called for blocks
+     * with such changes.
+     *
+     * Called on a background thread.
+     */
+    virtual void MasternodesUpdated(const CBlockIndex *pindex, const std::vector<CMasternodeEvent> &events) {}
     /**
      * Notifies listeners of the new active block chain on-disk.
      *
@@ -144,6 +203,7 @@ protected:
      * has been received and connected to the headers tree, though not validated yet */
     virtual void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) {};
     friend void ::RegisterValidationInterface(CValidationInterface*);
+    friend void ::RegisterValidationInterface(CValidationInterface*, const ValidationInterfaceQueueOptions&);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
 };
@@ -154,6 +214,7 @@ private:
     std::unique_ptr<MainSignalsInstance> m_internals;
 
     friend void ::RegisterValidationInterface(CValidationInterface*);
+    friend void ::RegisterValidationInterface(CValidationInterface*, const ValidationInterfaceQueueOptions&);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
     friend void ::CallFunctionInValidationInterfaceQueue(std::function<void ()> func);
@@ -165,11 +226,22 @@ public:
     void RegisterBackgroundSignalScheduler(CScheduler& scheduler);
     /** Unregister a CScheduler to give callbacks which should run in the background - these callbacks will now be dropped! */
     void UnregisterBackgroundSignalScheduler();
-    /** Call any remaining callbacks on the calling thread */
+    /** Call any remaining callbacks on the calling thread, stopping the threads of subscriber queues */
     void FlushBackgroundCallbacks();
 
+    /** Number of callbacks pending for the subscribers sharing the background scheduler */
     size_t CallbacksPending();
 
+    /**
+     * Block until at most max_pending callbacks are pending for the subscribers
+     * sharing the background scheduler, and every subscriber queue that is not
+     * lossy is below its maximum size.
+     */
+    void LimitCallbacksPending(size_t max_pending) LOCKS_EXCLUDED(cs_main);
+
+    /** Metrics of the shared queue, named "shared", followed by those of the subscriber queues */
+    std::vector<ValidationInterfaceQueueStats> GetQueueStats();
+
     /** Register with mempool to call TransactionRemovedFromMempool callbacks */
     void RegisterWithMempoolSignals(CTxMemPool& pool);
     /** Unregister with mempool */
@@ -179,6 +251,7 @@ public:
     void TransactionAddedToMempool(const CTransactionRef &);
     void BlockConnected(const std::shared_ptr<const CBlock> &, const CBlockIndex *pindex, const std::shared_ptr<const std::vector<CTransactionRef>> &);
     void BlockDisconnected(const std::shared_ptr<const CBlock> &);
+    void MasternodesUpdated(const CBlockIndex *, const std::shared_ptr<const std::vector<CMasternodeEvent>> &);
     void ChainStateFlushed(const CBlockLocator &);
     void BlockChecked(const CBlock&, const CValidationState&);
     void NewPoWValidBlock(const CBlockIndex *, const std::shared_ptr<const CBlock>&);
@@ -4,6 +4,7 @@
 
 #include <wallet/coinselection.h>
 
+#include <crypto/common.h>
 #include <util/system.h>
 #include <util/moneystr.h>
 
@@ -327,3 +328,69 @@ bool OutputGroup::EligibleForSpending(const CoinEligibilityFilter& eligibility_f
         && m_ancestors <= eligibility_filter.max_ancestors
         && m_descendants <= eligibility_filter.max_descendants;
 }
+
+/******************************************************************************
+
+ OutputGroupIndex
+
+ ******************************************************************************/
+
+int OutputGroupIndex::GetBucket(CAmount value)
+{
+    return value > 0 ? CountBits(value) - 1 : 0;
+}
+
+OutputGroupIndex::OutputGroupIndex(std::vector<OutputGroup> groups) : m_groups(std::move(groups))
+{
+    for (size_t i = 0; i < m_groups.size(); ++i) {
+        m_buckets[GetBucket(m_groups[i].m_value)].push_back(i);
+    }
+    for (std::vector<size_t>& bucket : m_buckets) {
+        std::stable_sort(bucket.begin(), bucket.end(), [this](size_t a, size_t b) {
+            return m_groups[a].m_value > m_groups[b].m_value;
+        });
+    }
+}
+
+std::vector<OutputGroup> OutputGroupIndex::GetCandidates(const CoinEligibilityFilter& filter, CAmount target_value) const
+{
+    std::vector<OutputGroup> candidates;
+    size_t eligible = 0;
+    for (const OutputGroup& group : m_groups) {
+        eligible += group.EligibleForSpending(filter);
+    }
+    if (eligible <= MAX_SELECTION_CANDIDATES) {
+        for (const OutputGroup& group : m_groups) {
+            if (group.EligibleForSpending(filter)) candidates.push_back(group);
+        }
+        return candidates;
+    }
+
+    const int target_bucket = GetBucket(target_value);
+
+    // The smallest groups worth at least the target, walking the buckets up from the target's
+    size_t above = 0;
+    for (int b = target_bucket; b < BUCKETS && above < MAX_SELECTION_CANDIDATES_ABOVE; ++b) {
+        for (auto it = m_buckets[b].rbegin(); it != m_buckets[b].rend() && above < MAX_SELECTION_CANDIDATES_ABOVE; ++it) {
+            const OutputGroup& group = m_groups[*it];
+            if (group.m_value < target_value || !group.EligibleForSpending(filter)) continue;
+            candidates.push_back(group);
+            ++above;
+        }
+    }
+
+    // The largest groups worth less than the target, walking the buckets down from the target's
+    size_t below = 0;
+    CAmount below_value = 0;
+    auto enough = [&] { return below >= MAX_SELECTION_CANDIDATES && below_value >= 2 * target_value; };
+    for (int b = target_bucket; b >= 0 && !enough(); --b) {
+        for (auto it = m_buckets[b].begin(); it != m_buckets[b].end() && !enough(); ++it) {
+            const OutputGroup& group = m_groups[*it];
+            if (group.m_value >= target_value || !group.EligibleForSpending(filter)) continue;
+            candidates.push_back(group);
+            ++below;
+            below_value += group.m_value;
+        }
+    }
+    return candidates;
+}
@@ -93,6 +93,43 @@ struct OutputGroup
     bool EligibleForSpending(const CoinEligibilityFilter& eligibility_filter) const;
 };
 
+//! Above this many eligible output groups, coin selection only looks at those an OutputGroupIndex picks for the target
+static const size_t MAX_SELECTION_CANDIDATES = 1000;
+//! Number of the smallest output groups worth at least the target that coin selection looks at, above MAX_SELECTION_CANDIDATES
+static const size_t MAX_SELECTION_CANDIDATES_ABOVE = 10;
+
+/**
+ * The output groups coin selection chooses from, bucketed by the highest bit of their value.
+ *
+ * Selecting from every group costs the solvers time in the number of groups, for each
+ * eligibility filter tried, which wallets with many small outputs (rewards) cannot afford.
+ * GetCandidates() only hands them the groups near the target instead.
+ */
+class OutputGroupIndex
+{
+public:
+    explicit OutputGroupIndex(std::vector<OutputGroup> groups);
+
+    /**
+     * The groups eligible under filter to select target_value from. With more than
+     * MAX_SELECTION_CANDIDATES of them, only the MAX_SELECTION_CANDIDATES_ABOVE smallest ones
+     * worth at least target_value, which holds any exact match and the smallest larger group,
+     * and the largest ones worth less, until there are MAX_SELECTION_CANDIDATES of those and
+     * they are worth twice target_value. The knapsack solver finds a selection among these
+     * whenever it finds one among all the groups.
+     */
+    std::vector<OutputGroup> GetCandidates(const CoinEligibilityFilter& filter, CAmount target_value) const;
+
+private:
+    static const int BUCKETS = 64;
+
+    std::vector<OutputGroup> m_groups;
+    //! Indexes in m_groups of the groups of each bucket, from the largest value to the smallest
+    std::vector<size_t> m_buckets[BUCKETS];
+
+    static int GetBucket(CAmount value);
+};
+
 bool SelectCoinsBnB(std::vector<OutputGroup>& utxo_pool, const CAmount& target_value, const CAmount& cost_of_change, std::set<CInputCoin>& out_set, CAmount& value_ret, CAmount not_input_fees);
 
 // Original coin selection algorithm as a fallback
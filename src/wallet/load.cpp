@@ -83,8 +83,8 @@ void StartWallets(CScheduler& scheduler)
     }
 
     // Schedule periodic wallet flushes and tx rebroadcasts
-    scheduler.scheduleEvery(MaybeCompactWalletDB, 500);
-    scheduler.scheduleEvery(MaybeResendWalletTxs, 1000);
+    scheduler.scheduleEvery(MaybeCompactWalletDB, 500, "maintenance");
+    scheduler.scheduleEvery(MaybeResendWalletTxs, 1000, "wallet");
 }
 
 void FlushWallets()
@@ -564,6 +564,59 @@ BOOST_AUTO_TEST_CASE(ApproximateBestSubset)
     empty_wallet();
 }
 
+BOOST_AUTO_TEST_CASE(output_group_index_test)
+{
+    std::vector<OutputGroup> groups;
+    auto add_group = [&](CAmount value, int depth) {
+        CMutableTransaction tx;
+        tx.nLockTime = groups.size(); // so all transactions get different hashes
+        tx.vout.emplace_back(value, CScript());
+        groups.emplace_back(CInputCoin(MakeTransactionRef(std::move(tx)), 0), depth, false, 0, 0);
+    };
+
+    // Few enough groups are all candidates
+    for (int i = 1; i <= 10; ++i) add_group(i * COIN, 6);
+    BOOST_CHECK_EQUAL(OutputGroupIndex(groups).GetCandidates(filter_standard, 5 * COIN).size(), 10U);
+
+    // Groups worth 0.01 to 50 coins, and unconfirmed exact matches
+    groups.clear();
+    for (int i = 1; i <= 5000; ++i) add_group(i * COIN / 100, 6);
+    for (int i = 0; i < 100; ++i) add_group(20 * COIN, 0);
+    const OutputGroupIndex index(groups);
+
+    // The smallest ones worth the target or more, and the largest worth less
+    std::vector<OutputGroup> candidates = index.GetCandidates(filter_standard, 20 * COIN);
+    BOOST_CHECK_EQUAL(candidates.size(), MAX_SELECTION_CANDIDATES_ABOVE + MAX_SELECTION_CANDIDATES);
+    std::set<CAmount> values;
+    for (const OutputGroup& group : candidates) {
+        BOOST_CHECK(group.EligibleForSpending(filter_standard));
+        values.insert(group.m_value);
+    }
+    BOOST_CHECK_EQUAL(values.size(), candidates.size());
+    BOOST_CHECK_EQUAL(*values.begin(), 10 * COIN);
+    BOOST_CHECK_EQUAL(*values.rbegin(), 2009 * COIN / 100);
+
+    CoinSet selection;
+    CAmount value_ret;
+    BOOST_CHECK(KnapsackSolver(20 * COIN, candidates, selection, value_ret));
+    BOOST_CHECK_EQUAL(value_ret, 20 * COIN);
+    BOOST_CHECK_EQUAL(selection.size(), 1U);
+
+    // Above the largest group, enough to be worth twice the target
+    candidates = index.GetCandidates(filter_standard, 100 * COIN);
+    BOOST_CHECK_EQUAL(candidates.size(), MAX_SELECTION_CANDIDATES);
+    BOOST_CHECK(KnapsackSolver(100 * COIN, candidates, selection, value_ret));
+    BOOST_CHECK_GE(value_ret, 100 * COIN);
+
+    // Many small groups, as many as needed to be worth twice the target
+    groups.clear();
+    for (int i = 0; i < 3000; ++i) add_group(COIN / 100, 6);
+    candidates = OutputGroupIndex(groups).GetCandidates(filter_standard, 10 * COIN);
+    BOOST_CHECK_EQUAL(candidates.size(), 2000U);
+    BOOST_CHECK(KnapsackSolver(10 * COIN, candidates, selection, value_ret));
+    BOOST_CHECK_EQUAL(value_ret, 10 * COIN);
+}
+
 // Tests that with the ideal conditions, the coin selector will always be able to find a solution that can pay the target value
 BOOST_AUTO_TEST_CASE(SelectCoins_test)
 {
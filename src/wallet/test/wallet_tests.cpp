@@ -4,6 +4,7 @@
 
 #include <wallet/wallet.h>
 
+#include <list>
 #include <memory>
 #include <stdint.h>
 #include <vector>
@@ -16,6 +17,7 @@
 #include <validation.h>
 #include <wallet/coincontrol.h>
 #include <wallet/test/wallet_test_fixture.h>
+#include <wallet/walletdb.h>
 
 #include <boost/test/unit_test.hpp>
 #include <univalue.h>
@@ -112,6 +114,61 @@ BOOST_FIXTURE_TEST_CASE(scan_for_wallet_transactions, TestChain100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(scan_for_wallet_transactions_batches, TestChain100Setup)
+{
+    auto chain = interfaces::MakeChain();
+    auto locked_chain = chain->lock();
+    LockAssertion lock(::cs_main);
+
+    const uint256 genesis_hash = ::ChainActive().Genesis()->GetBlockHash();
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    auto scan = [&](CWallet& wallet, const uint256& stop_block, const std::string& threads) {
+        gArgs.ForceSetArg("-rescanthreads", threads);
+        WalletRescanReserver reserver(&wallet);
+        reserver.reserve();
+        CWallet::ScanResult result = wallet.ScanForWalletTransactions(genesis_hash, stop_block, reserver, false /* update */);
+        gArgs.ForceSetArg("-rescanthreads", std::to_string(DEFAULT_RESCAN_THREADS));
+        BOOST_CHECK_EQUAL(result.status, CWallet::ScanResult::SUCCESS);
+        BOOST_CHECK(result.last_failed_block.IsNull());
+        return result;
+    };
+
+    // Every block pays the coinbase key, whatever the number of threads and blocks per batch.
+    for (const std::string threads : {"1", "3", "16"}) {
+        CWallet wallet(chain.get(), WalletLocation(), WalletDatabase::CreateDummy());
+        AddKey(wallet, coinbaseKey);
+        CWallet::ScanResult result = scan(wallet, {} /* stop_block */, threads);
+        BOOST_CHECK_EQUAL(result.last_scanned_block, ::ChainActive().Tip()->GetBlockHash());
+        BOOST_CHECK_EQUAL(*result.last_scanned_height, ::ChainActive().Height());
+        LOCK(wallet.cs_wallet);
+        BOOST_CHECK_EQUAL(wallet.mapWallet.size(), (size_t)::ChainActive().Height());
+    }
+
+    // A stop block in the middle of a batch ends the scan there.
+    {
+        CWallet wallet(chain.get(), WalletLocation(), WalletDatabase::CreateDummy());
+        AddKey(wallet, coinbaseKey);
+        CWallet::ScanResult result = scan(wallet, ::ChainActive()[50]->GetBlockHash(), "4");
+        BOOST_CHECK_EQUAL(result.last_scanned_block, ::ChainActive()[50]->GetBlockHash());
+        BOOST_CHECK_EQUAL(*result.last_scanned_height, 50);
+        LOCK(wallet.cs_wallet);
+        BOOST_CHECK_EQUAL(wallet.mapWallet.size(), 50U);
+    }
+
+    // Watch-only scripts are matched without any key.
+    {
+        CWallet wallet(chain.get(), WalletLocation(), WalletDatabase::CreateDummy());
+        {
+            LOCK(wallet.cs_wallet);
+            BOOST_CHECK(wallet.AddWatchOnly(coinbase_script, 0 /* nCreateTime */));
+        }
+        scan(wallet, {} /* stop_block */, "4");
+        LOCK(wallet.cs_wallet);
+        BOOST_CHECK_EQUAL(wallet.mapWallet.size(), (size_t)::ChainActive().Height());
+        BOOST_CHECK(wallet.GetBalance().m_watchonly_immature > 0);
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE(importmulti_rescan, TestChain100Setup)
 {
     uint256 masternodesID = testMasternodeKeys.begin()->first;
@@ -266,6 +323,10 @@ BOOST_FIXTURE_TEST_CASE(coin_mark_dirty_immature_credit, TestChain100Setup)
     BOOST_CHECK_EQUAL(wtx.GetImmatureCredit(*locked_chain), 50*COIN);
 }
 
+// Block index entries are owned by the block index arena, which does not know
+// about the ones added here, so they are kept alive until the end of the test.
+static std::list<CBlockIndex> g_added_block_indexes;
+
 static int64_t AddTx(CWallet& wallet, uint32_t lockTime, int64_t mockTime, int64_t blockTime)
 {
     CMutableTransaction tx;
@@ -275,7 +336,7 @@ static int64_t AddTx(CWallet& wallet, uint32_t lockTime, int64_t mockTime, int64
     if (blockTime > 0) {
         auto locked_chain = wallet.chain().lock();
         LockAssertion lock(::cs_main);
-        auto inserted = ::BlockIndex().emplace(GetRandHash(), new CBlockIndex);
+        auto inserted = ::BlockIndex().emplace(GetRandHash(), &*g_added_block_indexes.emplace(g_added_block_indexes.end()));
         assert(inserted.second);
         const uint256& hash = inserted.first->first;
         block = inserted.first->second;
@@ -337,6 +398,86 @@ BOOST_AUTO_TEST_CASE(LoadReceiveRequests)
     BOOST_CHECK_EQUAL(values[1], "val_rr1");
 }
 
+BOOST_AUTO_TEST_CASE(load_wallet_links_transactions)
+{
+    // A chain of transactions over more than one batch of records and a second
+    // spend of the first output, written straight to the database. Records are
+    // read in key order, so spends are mostly read before what they spend.
+    std::vector<CMutableTransaction> txs;
+    COutPoint prevout(InsecureRand256(), 0);
+    for (size_t i = 0; i <= LOAD_WALLET_BATCH_RECORDS; ++i) {
+        CMutableTransaction mtx;
+        mtx.vin.emplace_back(prevout);
+        mtx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+        prevout = COutPoint(mtx.GetHash(), 0);
+        txs.push_back(std::move(mtx));
+    }
+    CMutableTransaction respend;
+    respend.vin.emplace_back(COutPoint(txs[0].GetHash(), 0));
+    respend.vout.emplace_back(2 * COIN, CScript() << OP_TRUE);
+    {
+        WalletBatch batch{m_wallet.GetDBHandle()};
+        for (const CMutableTransaction& mtx : txs) {
+            BOOST_CHECK(batch.WriteTx(CWalletTx(&m_wallet, MakeTransactionRef(mtx))));
+        }
+        BOOST_CHECK(batch.WriteTx(CWalletTx(&m_wallet, MakeTransactionRef(respend))));
+    }
+
+    BOOST_CHECK(WalletBatch{m_wallet.GetDBHandle()}.LoadWallet(&m_wallet) == DBErrors::LOAD_OK);
+
+    auto locked_chain = m_chain->lock();
+    LOCK(m_wallet.cs_wallet);
+    BOOST_CHECK_EQUAL(m_wallet.mapWallet.size(), txs.size() + 1);
+    size_t spent = 0;
+    for (const CMutableTransaction& mtx : txs) {
+        spent += m_wallet.IsSpent(*locked_chain, mtx.GetHash(), 0);
+    }
+    BOOST_CHECK_EQUAL(spent, txs.size() - 1);
+    BOOST_CHECK(!m_wallet.IsSpent(*locked_chain, txs.back().GetHash(), 0));
+    const std::set<uint256> conflicts = m_wallet.GetConflicts(respend.GetHash());
+    BOOST_CHECK_EQUAL(conflicts.size(), 2U);
+    BOOST_CHECK(conflicts.count(txs[1].GetHash()));
+    BOOST_CHECK(conflicts.count(respend.GetHash()));
+}
+
+BOOST_AUTO_TEST_CASE(keypool_topup_batch)
+{
+    auto chain = interfaces::MakeChain();
+    CWallet wallet(chain.get(), WalletLocation(), WalletDatabase::CreateMock());
+    bool first_run;
+    BOOST_CHECK(wallet.LoadWallet(first_run) == DBErrors::LOAD_OK);
+    LOCK(wallet.cs_wallet);
+    wallet.SetMinVersion(FEATURE_LATEST);
+    CKey seed_key;
+    seed_key.MakeNewKey(true);
+    wallet.SetHDSeed(wallet.DeriveNewSeed(seed_key));
+
+    // The external chain at m/0'/0', one key of which the wallet already knows.
+    const uint32_t hardened = 0x80000000;
+    CExtKey master, account, external, known;
+    master.SetSeed(seed_key.begin(), seed_key.size());
+    master.Derive(account, hardened);
+    account.Derive(external, hardened);
+    external.Derive(known, 2 | hardened);
+    BOOST_CHECK(wallet.AddKeyPubKey(known.key, known.key.GetPubKey()));
+
+    BOOST_CHECK(wallet.TopUpKeyPool(100));
+    BOOST_CHECK_EQUAL(wallet.GetKeyPoolSize(), 200U);
+    BOOST_CHECK_EQUAL(wallet.GetHDChain().nExternalChainCounter, 101U);
+    BOOST_CHECK_EQUAL(wallet.GetHDChain().nInternalChainCounter, 100U);
+    BOOST_CHECK(wallet.mapKeyMetadata[known.key.GetPubKey().GetID()].hdKeypath.empty());
+    for (uint32_t index : {0, 1, 3, 100}) {
+        CExtKey child;
+        external.Derive(child, index | hardened);
+        const CPubKey pubkey = child.key.GetPubKey();
+        BOOST_CHECK(wallet.HaveKey(pubkey.GetID()));
+        const CKeyMetadata& metadata = wallet.mapKeyMetadata[pubkey.GetID()];
+        BOOST_CHECK_EQUAL(metadata.hdKeypath, "m/0'/0'/" + std::to_string(index) + "'");
+        BOOST_CHECK_EQUAL(metadata.key_origin.path.size(), 3U);
+        BOOST_CHECK_EQUAL(metadata.key_origin.path[2], index | hardened);
+    }
+}
+
 class ListCoinsTestingSetup : public TestChain100Setup
 {
 public:
@@ -461,6 +602,60 @@ BOOST_FIXTURE_TEST_CASE(ListCoins, ListCoinsTestingSetup)
     BOOST_CHECK_EQUAL(list.begin()->second.size(), 2U);
 }
 
+static std::vector<COutPoint> AvailableOutPoints(interfaces::Chain& chain, CWallet& wallet)
+{
+    auto locked_chain = chain.lock();
+    LOCK(wallet.cs_wallet);
+    std::vector<COutput> available;
+    wallet.AvailableCoins(*locked_chain, available);
+    std::vector<COutPoint> outpoints;
+    for (const COutput& out : available) {
+        outpoints.emplace_back(out.tx->GetHash(), out.i);
+    }
+    return outpoints;
+}
+
+BOOST_FIXTURE_TEST_CASE(unspent_output_index, ListCoinsTestingSetup)
+{
+    AddTx(CRecipient{GetScriptForRawPubKey({}), 1 * COIN, false /* subtract fee */});
+    const std::vector<COutPoint> confirmed = AvailableOutPoints(*m_chain, *wallet);
+    BOOST_CHECK_EQUAL(confirmed.size(), 2U);
+    const CWallet::Balance balance = wallet->GetBalance();
+    BOOST_CHECK_EQUAL(balance.m_mine_trusted, wallet->GetAvailableBalance());
+    BOOST_CHECK(balance.m_mine_immature > 0);
+
+    // Spend the coins in an unconfirmed transaction: they leave the index and
+    // the cached balance is recomputed.
+    CTransactionRef tx;
+    {
+        CAmount fee;
+        int change_pos = -1;
+        std::string error;
+        CCoinControl coin_control;
+        auto locked_chain = m_chain->lock();
+        BOOST_CHECK(wallet->CreateTransaction(*locked_chain, {CRecipient{GetScriptForRawPubKey({}), balance.m_mine_trusted, true /* subtract fee */}}, tx, fee, change_pos, error, coin_control));
+    }
+    CValidationState state;
+    BOOST_CHECK(wallet->CommitTransaction(tx, {}, {}, state));
+    BOOST_CHECK(AvailableOutPoints(*m_chain, *wallet).empty());
+    BOOST_CHECK_EQUAL(wallet->GetBalance().m_mine_trusted, 0);
+    BOOST_CHECK_EQUAL(wallet->GetBalance().m_mine_immature, balance.m_mine_immature);
+
+    // Once the spend is abandoned, its inputs are available again.
+    wallet->TransactionRemovedFromMempool(tx);
+    {
+        auto locked_chain = m_chain->lock();
+        BOOST_CHECK(wallet->AbandonTransaction(*locked_chain, tx->GetHash()));
+    }
+    BOOST_CHECK(AvailableOutPoints(*m_chain, *wallet) == confirmed);
+    BOOST_CHECK_EQUAL(wallet->GetBalance().m_mine_trusted, balance.m_mine_trusted);
+
+    // A full rebuild, as after an import, gives the same result.
+    wallet->MarkDirty();
+    BOOST_CHECK(AvailableOutPoints(*m_chain, *wallet) == confirmed);
+    BOOST_CHECK_EQUAL(wallet->GetBalance().m_mine_trusted, balance.m_mine_trusted);
+}
+
 BOOST_FIXTURE_TEST_CASE(wallet_disableprivkeys, TestChain100Setup)
 {
     auto chain = interfaces::MakeChain();
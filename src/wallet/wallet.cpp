@@ -35,6 +35,7 @@
 #include <algorithm>
 #include <assert.h>
 #include <future>
+#include <unordered_set>
 
 #include <boost/algorithm/string/replace.hpp>
 
@@ -264,50 +265,67 @@ const CWalletTx* CWallet::GetWalletTx(const uint256& hash) const
 }
 
 CPubKey CWallet::GenerateNewKey(WalletBatch &batch, bool internal)
+{
+    return GenerateNewKeys(batch, 1, internal).front();
+}
+
+std::vector<CPubKey> CWallet::GenerateNewKeys(WalletBatch& batch, size_t count, bool internal)
 {
     assert(!IsWalletFlagSet(WALLET_FLAG_DISABLE_PRIVATE_KEYS));
     assert(!IsWalletFlagSet(WALLET_FLAG_BLANK_WALLET));
     AssertLockHeld(cs_wallet);
+    if (count == 0) return {};
     bool fCompressed = CanSupportFeature(FEATURE_COMPRPUBKEY); // default to compressed public keys if we want 0.6.0 wallets
 
-    CKey secret;
-
     // Create new metadata
     int64_t nCreationTime = GetTime();
-    CKeyMetadata metadata(nCreationTime);
+    std::vector<NewKey> keys;
 
     // use HD key derivation if HD was enabled during wallet creation and a seed is present
     if (IsHDEnabled()) {
-        DeriveNewChildKey(batch, metadata, secret, (CanSupportFeature(FEATURE_HD_SPLIT) ? internal : false));
+        DeriveNewChildKeys(batch, (CanSupportFeature(FEATURE_HD_SPLIT) ? internal : false), count, nCreationTime, keys);
     } else {
-        secret.MakeNewKey(fCompressed);
+        keys.resize(count);
+        for (NewKey& key : keys) {
+            key.secret.MakeNewKey(fCompressed);
+            key.metadata = CKeyMetadata(nCreationTime);
+        }
     }
 
     // Compressed public keys were introduced in version 0.6.0
     if (fCompressed) {
-        SetMinVersion(FEATURE_COMPRPUBKEY);
+        SetMinVersion(FEATURE_COMPRPUBKEY, &batch);
     }
 
-    CPubKey pubkey = secret.GetPubKey();
-    assert(secret.VerifyPubKey(pubkey));
+    ParallelFor(keys.size(), std::max(1, std::min(GetNumCores(), MAX_KEYPOOL_THREADS)), [&](size_t i) {
+        NewKey& key = keys[i];
+        if (!key.pubkey.IsValid()) {
+            key.pubkey = key.secret.GetPubKey();
+        }
+        assert(key.secret.VerifyPubKey(key.pubkey));
+    });
 
-    mapKeyMetadata[pubkey.GetID()] = metadata;
     UpdateTimeFirstKey(nCreationTime);
 
-    if (!AddKeyPubKeyWithDB(batch, secret, pubkey)) {
-        throw std::runtime_error(std::string(__func__) + ": AddKey failed");
+    std::vector<CPubKey> pubkeys;
+    pubkeys.reserve(keys.size());
+    for (const NewKey& key : keys) {
+        mapKeyMetadata[key.pubkey.GetID()] = key.metadata;
+        if (!AddKeyPubKeyWithDB(batch, key.secret, key.pubkey)) {
+            throw std::runtime_error(std::string(__func__) + ": AddKey failed");
+        }
+        pubkeys.push_back(key.pubkey);
     }
-    return pubkey;
+    return pubkeys;
 }
 
-void CWallet::DeriveNewChildKey(WalletBatch &batch, CKeyMetadata& metadata, CKey& secret, bool internal)
+void CWallet::DeriveNewChildKeys(WalletBatch& batch, bool internal, size_t count, int64_t nCreationTime, std::vector<NewKey>& keys)
 {
     // for now we use a fixed keypath scheme of m/0'/0'/k
     CKey seed;                     //seed (256bit)
     CExtKey masterKey;             //hd master key
     CExtKey accountKey;            //key at m/0'
     CExtKey chainChildKey;         //key at m/0'/0' (external) or m/0'/1' (internal)
-    CExtKey childKey;              //key at m/0'/0'/<n>'
 
     // try to get the seed
     if (!GetKey(hdChain.seed_id, seed))
@@ -323,33 +341,44 @@ void CWallet::DeriveNewChildKey(WalletBatch &batch, CKeyMetadata& metadata, CKey
     assert(internal ? CanSupportFeature(FEATURE_HD_SPLIT) : true);
     accountKey.Derive(chainChildKey, BIP32_HARDENED_KEY_LIMIT+(internal ? 1 : 0));
 
-    // derive child key at next index, skip keys already known to the wallet
-    do {
-        // always derive hardened keys
-        // childIndex | BIP32_HARDENED_KEY_LIMIT = derive childIndex in hardened child-index-range
-        // example: 1 | BIP32_HARDENED_KEY_LIMIT == 0x80000001 == 2147483649
-        if (internal) {
-            chainChildKey.Derive(childKey, hdChain.nInternalChainCounter | BIP32_HARDENED_KEY_LIMIT);
-            metadata.hdKeypath = "m/0'/1'/" + std::to_string(hdChain.nInternalChainCounter) + "'";
+    const CKeyID master_id = masterKey.key.GetPubKey().GetID();
+    uint32_t& counter = internal ? hdChain.nInternalChainCounter : hdChain.nExternalChainCounter;
+    const int n_threads = std::max(1, std::min(GetNumCores(), MAX_KEYPOOL_THREADS));
+
+    // derive the child keys at the next indexes, skip keys already known to the wallet
+    keys.clear();
+    while (keys.size() < count) {
+        const size_t first = keys.size();
+        const uint32_t first_index = counter;
+        keys.resize(count);
+        // The parent is the same for all of them, so each child costs one
+        // private key tweak, and one point multiplication for its public key.
+        ParallelFor(count - first, n_threads, [&](size_t i) {
+            NewKey& key = keys[first + i];
+            const uint32_t index = first_index + i;
+            // always derive hardened keys
+            // childIndex | BIP32_HARDENED_KEY_LIMIT = derive childIndex in hardened child-index-range
+            // example: 1 | BIP32_HARDENED_KEY_LIMIT == 0x80000001 == 2147483649
+            ChainCode chaincode;
+            chainChildKey.key.Derive(key.secret, chaincode, index | BIP32_HARDENED_KEY_LIMIT, chainChildKey.chaincode);
+            key.pubkey = key.secret.GetPubKey();
+
+            CKeyMetadata& metadata = key.metadata;
+            metadata = CKeyMetadata(nCreationTime);
+            metadata.hdKeypath = "m/0'/" + std::string(internal ? "1" : "0") + "'/" + std::to_string(index) + "'";
             metadata.key_origin.path.push_back(0 | BIP32_HARDENED_KEY_LIMIT);
-            metadata.key_origin.path.push_back(1 | BIP32_HARDENED_KEY_LIMIT);
-            metadata.key_origin.path.push_back(hdChain.nInternalChainCounter | BIP32_HARDENED_KEY_LIMIT);
-            hdChain.nInternalChainCounter++;
-        }
-        else {
-            chainChildKey.Derive(childKey, hdChain.nExternalChainCounter | BIP32_HARDENED_KEY_LIMIT);
-            metadata.hdKeypath = "m/0'/0'/" + std::to_string(hdChain.nExternalChainCounter) + "'";
-            metadata.key_origin.path.push_back(0 | BIP32_HARDENED_KEY_LIMIT);
-            metadata.key_origin.path.push_back(0 | BIP32_HARDENED_KEY_LIMIT);
-            metadata.key_origin.path.push_back(hdChain.nExternalChainCounter | BIP32_HARDENED_KEY_LIMIT);
-            hdChain.nExternalChainCounter++;
-        }
-    } while (HaveKey(childKey.key.GetPubKey().GetID()));
-    secret = childKey.key;
-    metadata.hd_seed_id = hdChain.seed_id;
-    CKeyID master_id = masterKey.key.GetPubKey().GetID();
-    std::copy(master_id.begin(), master_id.begin() + 4, metadata.key_origin.fingerprint);
-    metadata.has_key_origin = true;
+            metadata.key_origin.path.push_back((internal ? 1 : 0) | BIP32_HARDENED_KEY_LIMIT);
+            metadata.key_origin.path.push_back(index | BIP32_HARDENED_KEY_LIMIT);
+            metadata.hd_seed_id = hdChain.seed_id;
+            std::copy(master_id.begin(), master_id.begin() + 4, metadata.key_origin.fingerprint);
+            metadata.has_key_origin = true;
+        });
+        counter += count - first;
+        keys.erase(std::remove_if(keys.begin() + first, keys.end(), [&](const NewKey& key) {
+            return HaveKey(key.pubkey.GetID());
+        }), keys.end());
+    }
+
     // update the chain model in the database
     if (!batch.WriteHDChain(hdChain))
         throw std::runtime_error(std::string(__func__) + ": Writing HD chain model failed");
@@ -379,11 +408,11 @@ bool CWallet::AddKeyPubKeyWithDB(WalletBatch& batch, const CKey& secret, const C
     CScript script;
     script = GetScriptForDestination(PKHash(pubkey));
     if (HaveWatchOnly(script)) {
-        RemoveWatchOnly(script);
+        RemoveWatchOnlyWithDB(batch, script);
     }
     script = GetScriptForRawPubKey(pubkey);
     if (HaveWatchOnly(script)) {
-        RemoveWatchOnly(script);
+        RemoveWatchOnlyWithDB(batch, script);
     }
 
     if (!IsCrypted()) {
@@ -575,6 +604,12 @@ bool CWallet::AddWatchOnly(const CScript& dest, int64_t nCreateTime)
 }
 
 bool CWallet::RemoveWatchOnly(const CScript &dest)
+{
+    WalletBatch batch(*database);
+    return RemoveWatchOnlyWithDB(batch, dest);
+}
+
+bool CWallet::RemoveWatchOnlyWithDB(WalletBatch& batch, const CScript& dest)
 {
     AssertLockHeld(cs_wallet);
     {
@@ -590,7 +625,7 @@ bool CWallet::RemoveWatchOnly(const CScript &dest)
 
     if (!HaveWatchOnly())
         NotifyWatchonlyChanged(false);
-    if (!WalletBatch(*database).EraseWatchOnly(dest))
+    if (!batch.EraseWatchOnly(dest))
         return false;
 
     return true;
@@ -830,6 +865,20 @@ void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid)
     std::pair<TxSpends::iterator, TxSpends::iterator> range;
     range = mapTxSpends.equal_range(outpoint);
     SyncMetaData(range);
+
+    // Drop the outpoint from the unspent output index. Coinbase outputs are
+    // left to AvailableCoins, which knows whether they are mature.
+    auto unspent = m_unspent_outputs.find(outpoint.hash);
+    if (!m_unspent_outputs_dirty && unspent != m_unspent_outputs.end() && IsSpentByUnconflictedTx(outpoint)) {
+        const CWalletTx* prev = GetWalletTx(outpoint.hash);
+        if (prev && !prev->IsCoinBase()) {
+            std::vector<unsigned int>& outputs = unspent->second;
+            outputs.erase(std::remove(outputs.begin(), outputs.end(), outpoint.n), outputs.end());
+            if (outputs.empty()) {
+                m_unspent_outputs.erase(unspent);
+            }
+        }
+    }
 }
 
 
@@ -845,6 +894,55 @@ void CWallet::AddToSpends(const uint256& wtxid)
         AddToSpends(txin.prevout, wtxid);
 }
 
+bool CWallet::IsSpentByUnconflictedTx(const COutPoint& outpoint) const
+{
+    std::pair<TxSpends::const_iterator, TxSpends::const_iterator> range = mapTxSpends.equal_range(outpoint);
+    for (TxSpends::const_iterator it = range.first; it != range.second; ++it) {
+        const CWalletTx* wtx = GetWalletTx(it->second);
+        // Unconfirmed or in a block: IsSpent holds whatever the chain looks like,
+        // until the spender is abandoned or conflicted.
+        if (wtx && !wtx->isAbandoned() && (wtx->hashUnset() || wtx->nIndex != -1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CWallet::IndexUnspentOutput(const CWalletTx& wtx, unsigned int n) const
+{
+    if (m_unspent_outputs_dirty || IsMine(wtx.tx->vout[n]) == ISMINE_NO) {
+        return;
+    }
+    if (!wtx.IsCoinBase() && IsSpentByUnconflictedTx(COutPoint(wtx.GetHash(), n))) {
+        return;
+    }
+    std::vector<unsigned int>& outputs = m_unspent_outputs[wtx.GetHash()];
+    auto pos = std::lower_bound(outputs.begin(), outputs.end(), n);
+    if (pos == outputs.end() || *pos != n) {
+        outputs.insert(pos, n);
+    }
+}
+
+void CWallet::IndexUnspentOutputs(const CWalletTx& wtx) const
+{
+    for (unsigned int n = 0; n < wtx.tx->vout.size(); ++n) {
+        IndexUnspentOutput(wtx, n);
+    }
+}
+
+std::map<uint256, std::vector<unsigned int>>& CWallet::GetUnspentOutputs() const
+{
+    AssertLockHeld(cs_wallet);
+    if (m_unspent_outputs_dirty) {
+        m_unspent_outputs.clear();
+        m_unspent_outputs_dirty = false;
+        for (const auto& entry : mapWallet) {
+            IndexUnspentOutputs(entry.second);
+        }
+    }
+    return m_unspent_outputs;
+}
+
 bool CWallet::EncryptWallet(const SecureString& strWalletPassphrase)
 {
     if (IsCrypted())
@@ -1016,6 +1114,9 @@ void CWallet::MarkDirty()
         LOCK(cs_wallet);
         for (std::pair<const uint256, CWalletTx>& item : mapWallet)
             item.second.MarkDirty();
+        // Outputs may have become ours, e.g. after an import.
+        m_unspent_outputs_dirty = true;
+        MarkBalancesDirty();
     }
 }
 
@@ -1062,6 +1163,7 @@ void CWallet::SetUsedDestinationState(const uint256& hash, unsigned int n, bool
             } else if (!used && GetDestData(dst, "used", nullptr)) {
                 EraseDestData(dst, "used");
             }
+            MarkBalancesDirty();
         }
     }
 }
@@ -1154,6 +1256,8 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
 
     // Break debit/credit balance caches:
     wtx.MarkDirty();
+    IndexUnspentOutputs(wtx);
+    MarkBalancesDirty();
 
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(this, hash, fInsertedNew ? CT_NEW : CT_UPDATED);
@@ -1173,25 +1277,58 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
     return true;
 }
 
-void CWallet::LoadToWallet(const CWalletTx& wtxIn)
+void CWallet::LoadToWallet(CWalletTx wtxIn)
 {
     uint256 hash = wtxIn.GetHash();
-    const auto& ins = mapWallet.emplace(hash, wtxIn);
+    const auto& ins = mapWallet.emplace(hash, std::move(wtxIn));
     CWalletTx& wtx = ins.first->second;
     wtx.BindWallet(this);
     if (/* insertion took place */ ins.second) {
         wtx.m_it_wtxOrdered = wtxOrdered.insert(std::make_pair(wtx.nOrderPos, &wtx));
     }
-    AddToSpends(hash);
-    for (const CTxIn& txin : wtx.tx->vin) {
-        auto it = mapWallet.find(txin.prevout.hash);
-        if (it != mapWallet.end()) {
-            CWalletTx& prevtx = it->second;
-            if (prevtx.nIndex == -1 && !prevtx.hashUnset()) {
-                MarkConflicted(prevtx.hashBlock, wtx.GetHash());
+    m_unlinked_txs.push_back(hash);
+}
+
+void CWallet::LinkLoadedTransactions()
+{
+    // Watch-only scripts may be loaded after the transactions that pay to
+    // them, so the unspent output index is built on first use.
+    m_unspent_outputs_dirty = true;
+    MarkBalancesDirty();
+
+    // Record all the spends first, so that the metadata of each outpoint spent
+    // more than once is synced only once, and conflicts are found whatever
+    // the order in which the transactions were loaded.
+    std::vector<COutPoint> respent;
+    for (const uint256& hash : m_unlinked_txs) {
+        const CWalletTx& wtx = mapWallet.at(hash);
+        if (wtx.IsCoinBase()) continue;
+        for (const CTxIn& txin : wtx.tx->vin) {
+            mapTxSpends.emplace(txin.prevout, hash);
+            setLockedCoins.erase(txin.prevout);
+            if (mapTxSpends.count(txin.prevout) > 1) {
+                respent.push_back(txin.prevout);
+            }
+        }
+    }
+    std::sort(respent.begin(), respent.end());
+    respent.erase(std::unique(respent.begin(), respent.end()), respent.end());
+    for (const COutPoint& outpoint : respent) {
+        SyncMetaData(mapTxSpends.equal_range(outpoint));
+    }
+
+    for (const uint256& hash : m_unlinked_txs) {
+        for (const CTxIn& txin : mapWallet.at(hash).tx->vin) {
+            auto it = mapWallet.find(txin.prevout.hash);
+            if (it != mapWallet.end()) {
+                CWalletTx& prevtx = it->second;
+                if (prevtx.nIndex == -1 && !prevtx.hashUnset()) {
+                    MarkConflicted(prevtx.hashBlock, hash);
+                }
             }
         }
     }
+    m_unlinked_txs.clear();
 }
 
 bool CWallet::AddToWalletIfInvolvingMe(const CTransactionRef& ptx, const uint256& block_hash, int posInBlock, bool fUpdate)
@@ -1265,8 +1402,10 @@ void CWallet::MarkInputsDirty(const CTransactionRef& tx)
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
             it->second.MarkDirty();
+            IndexUnspentOutput(it->second, txin.prevout.n);
         }
     }
+    MarkBalancesDirty();
 }
 
 bool CWallet::AbandonTransaction(interfaces::Chain::Lock& locked_chain, const uint256& hashTx)
@@ -1394,6 +1533,7 @@ void CWallet::TransactionAddedToMempool(const CTransactionRef& ptx) {
     auto it = mapWallet.find(ptx->GetHash());
     if (it != mapWallet.end()) {
         it->second.fInMempool = true;
+        MarkBalancesDirty();
     }
 }
 
@@ -1402,6 +1542,7 @@ void CWallet::TransactionRemovedFromMempool(const CTransactionRef &ptx) {
     auto it = mapWallet.find(ptx->GetHash());
     if (it != mapWallet.end()) {
         it->second.fInMempool = false;
+        MarkBalancesDirty();
     }
 }
 
@@ -1427,6 +1568,7 @@ void CWallet::BlockConnected(const CBlock& block, const std::vector<CTransaction
     }
 
     m_last_block_processed = block_hash;
+    MarkBalancesDirty();
 }
 
 void CWallet::BlockDisconnected(const CBlock& block) {
@@ -1436,6 +1578,7 @@ void CWallet::BlockDisconnected(const CBlock& block) {
     for (const CTransactionRef& ptx : block.vtx) {
         SyncTransaction(ptx, {} /* block hash */, 0 /* position in block */);
     }
+    MarkBalancesDirty();
 }
 
 void CWallet::UpdatedBlockTip()
@@ -1696,6 +1839,7 @@ void CWallet::SetWalletFlag(uint64_t flags)
 {
     LOCK(cs_wallet);
     m_wallet_flags |= flags;
+    MarkBalancesDirty();
     if (!WalletBatch(*database).WriteWalletFlags(m_wallet_flags))
         throw std::runtime_error(std::string(__func__) + ": writing wallet flags failed");
 }
@@ -1710,6 +1854,7 @@ void CWallet::UnsetWalletFlagWithDB(WalletBatch& batch, uint64_t flag)
 {
     LOCK(cs_wallet);
     m_wallet_flags &= ~flag;
+    MarkBalancesDirty();
     if (!batch.WriteWalletFlags(m_wallet_flags))
         throw std::runtime_error(std::string(__func__) + ": writing wallet flags failed");
 }
@@ -2018,6 +2163,92 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver& r
  * the main chain after to the addition of any new keys you want to detect
  * transactions for.
  */
+namespace {
+
+struct KeyIdHasher
+{
+    size_t operator()(const uint160& id) const { return ReadLE64(id.begin()); }
+};
+
+int GetRescanThreadCount()
+{
+    int n_threads = gArgs.GetArg("-rescanthreads", DEFAULT_RESCAN_THREADS);
+    if (n_threads <= 0) {
+        n_threads += GetNumCores();
+    }
+    return std::max(1, std::min(n_threads, MAX_RESCAN_THREADS));
+}
+
+} // namespace
+
+class CWallet::ScanFilter
+{
+public:
+    explicit ScanFilter(const CWallet& wallet)
+    {
+        LOCK(wallet.cs_KeyStore);
+        m_key_store_size = wallet.GetKeyStoreSize();
+        m_ids.reserve(m_key_store_size);
+        for (const auto& entry : wallet.mapKeys) {
+            m_ids.insert(entry.first);
+        }
+        for (const auto& entry : wallet.mapCryptedKeys) {
+            m_ids.insert(entry.first);
+        }
+        for (const auto& entry : wallet.mapScripts) {
+            m_ids.insert(entry.first);
+        }
+        m_watch_only = wallet.setWatchOnly;
+    }
+
+    //! The GetKeyStoreSize() of the wallet the filter was built from.
+    size_t KeyStoreSize() const { return m_key_store_size; }
+
+    //! False only for an output script that IsMine is certain to reject (see IsMineInner).
+    bool MayBeMine(const CScript& script) const
+    {
+        std::vector<std::vector<unsigned char>> solutions;
+        switch (Solver(script, solutions)) {
+        case TX_PUBKEY:
+            if (m_ids.count(CPubKey(solutions[0]).GetID())) return true;
+            break;
+        case TX_PUBKEYHASH:
+        case TX_SCRIPTHASH:
+        case TX_WITNESS_V0_KEYHASH:
+            if (m_ids.count(uint160(solutions[0]))) return true;
+            break;
+        case TX_WITNESS_V0_SCRIPTHASH: {
+            uint160 id;
+            CRIPEMD160().Write(solutions[0].data(), solutions[0].size()).Finalize(id.begin());
+            if (m_ids.count(id)) return true;
+            break;
+        }
+        case TX_NONSTANDARD:
+        case TX_MULTISIG:
+        case TX_NULL_DATA:
+        case TX_WITNESS_UNKNOWN:
+            break;
+        }
+        return m_watch_only.count(script) > 0;
+    }
+
+    bool MayBeMine(const CTransaction& tx) const
+    {
+        return std::any_of(tx.vout.begin(), tx.vout.end(), [this](const CTxOut& txout) { return MayBeMine(txout.scriptPubKey); });
+    }
+
+private:
+    size_t m_key_store_size;
+    std::unordered_set<uint160, KeyIdHasher> m_ids;
+    WatchOnlySet m_watch_only;
+};
+
+size_t CWallet::GetKeyStoreSize() const
+{
+    LOCK(cs_KeyStore);
+    return mapKeys.size() + mapCryptedKeys.size() + mapScripts.size() + setWatchOnly.size();
+}
+
 CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_block, const uint256& stop_block, const WalletRescanReserver& reserver, bool fUpdate)
 {
     int64_t nNow = GetTime();
@@ -2047,41 +2278,135 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
         progress_end = chain().guessVerificationProgress(stop_block.IsNull() ? tip_hash : stop_block);
     }
     double progress_current = progress_begin;
-    while (block_height && !fAbortRescan && !chain().shutdownRequested()) {
-        m_scanning_progress = (progress_current - progress_begin) / (progress_end - progress_begin);
-        if (*block_height % 100 == 0 && progress_end - progress_begin > 0.0) {
-            ShowProgress(strprintf("%s " + _("Rescanning...").translated, GetDisplayName()), std::max(1, std::min(99, (int)(m_scanning_progress * 100))));
-        }
-        if (GetTime() >= nNow + 60) {
-            nNow = GetTime();
-            WalletLogPrintf("Still rescanning. At block %d. Progress=%f\n", *block_height, progress_current);
-        }
 
+    // Blocks are scanned in batches: worker threads read each block of the batch and match
+    // its outputs against the scan filter, then the transactions that may involve the wallet
+    // are synced in block order on this thread.
+    const int n_threads = GetRescanThreadCount();
+    const size_t batch_size = n_threads * RESCAN_BLOCKS_PER_THREAD;
+    struct ScanItem {
+        uint256 hash;
+        int height;
+        double progress;
+        bool read_ok{false};
         CBlock block;
-        if (chain().findBlock(block_hash, &block) && !block.IsNull()) {
+        //! Per transaction, whether the filter matched one of its outputs.
+        std::vector<bool> may_be_mine;
+        //! KeyStoreSize() of the filter may_be_mine comes from.
+        size_t filter_size{0};
+    };
+    std::vector<ScanItem> batch;
+    std::shared_ptr<const ScanFilter> filter = std::make_shared<const ScanFilter>(*this);
+
+    // Keys added while syncing (by keypool top-ups) are matched from the next transaction on.
+    auto refresh_filter = [&](ScanItem& item, size_t from_pos) {
+        if (GetKeyStoreSize() == item.filter_size) return;
+        if (GetKeyStoreSize() != filter->KeyStoreSize()) {
+            filter = std::make_shared<const ScanFilter>(*this);
+        }
+        for (size_t pos = from_pos; pos < item.block.vtx.size(); ++pos) {
+            item.may_be_mine[pos] = filter->MayBeMine(*item.block.vtx[pos]);
+        }
+        item.filter_size = filter->KeyStoreSize();
+    };
+
+    // Apart from its outputs, a transaction involves the wallet if it is already in it, spends
+    // from it (IsFromMe) or conflicts with one of its transactions (AddToWalletIfInvolvingMe).
+    auto involves_wallet = [&](const CTransaction& tx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet) {
+        if (mapWallet.count(tx.GetHash())) return true;
+        for (const CTxIn& txin : tx.vin) {
+            if (mapWallet.count(txin.prevout.hash) || mapTxSpends.count(txin.prevout)) return true;
+        }
+        return false;
+    };
+
+    bool stopped = false;
+    while (block_height && !stopped && !fAbortRescan && !chain().shutdownRequested()) {
+        batch.clear();
+        {
             auto locked_chain = chain().lock();
-            LOCK(cs_wallet);
-            if (!locked_chain->getBlockHeight(block_hash)) {
-                // Abort scan if current block is no longer active, to prevent
-                // marking transactions as coming from the wrong block.
-                // TODO: This should return success instead of failure, see
-                // https://github.com/bitcoin/bitcoin/pull/14711#issuecomment-458342518
+            const Optional<int> tip_height = locked_chain->getHeight();
+            uint256 hash = block_hash;
+            for (int height = *block_height; ; hash = locked_chain->getBlockHash(++height)) {
+                batch.emplace_back();
+                batch.back().hash = hash;
+                batch.back().height = height;
+                batch.back().progress = chain().guessVerificationProgress(hash);
+                if (hash == stop_block || batch.size() >= batch_size || !tip_height || *tip_height <= height) break;
+            }
+        }
+
+        std::vector<uint256> hashes;
+        for (const ScanItem& item : batch) {
+            hashes.push_back(item.hash);
+        }
+        std::vector<CBlock> blocks;
+        chain().findBlocks(hashes, blocks, n_threads);
+        const std::shared_ptr<const ScanFilter> batch_filter = filter;
+        ParallelFor(batch.size(), n_threads, [&](size_t i) {
+            ScanItem& item = batch[i];
+            item.block = std::move(blocks[i]);
+            item.read_ok = !item.block.IsNull();
+            if (item.read_ok) {
+                item.may_be_mine.reserve(item.block.vtx.size());
+                for (const CTransactionRef& tx : item.block.vtx) {
+                    item.may_be_mine.push_back(batch_filter->MayBeMine(*tx));
+                }
+                item.filter_size = batch_filter->KeyStoreSize();
+            }
+        });
+
+        for (ScanItem& item : batch) {
+            if (fAbortRescan || chain().shutdownRequested()) {
+                stopped = true;
+                break;
+            }
+            block_hash = item.hash;
+            block_height = item.height;
+            progress_current = item.progress;
+            m_scanning_progress = (progress_current - progress_begin) / (progress_end - progress_begin);
+            if (*block_height % 100 == 0 && progress_end - progress_begin > 0.0) {
+                ShowProgress(strprintf("%s " + _("Rescanning...").translated, GetDisplayName()), std::max(1, std::min(99, (int)(m_scanning_progress * 100))));
+            }
+            if (GetTime() >= nNow + 60) {
+                nNow = GetTime();
+                WalletLogPrintf("Still rescanning. At block %d. Progress=%f\n", *block_height, progress_current);
+            }
+
+            if (item.read_ok) {
+                auto locked_chain = chain().lock();
+                LOCK(cs_wallet);
+                if (!locked_chain->getBlockHeight(block_hash)) {
+                    // Abort scan if current block is no longer active, to prevent
+                    // marking transactions as coming from the wrong block.
+                    // TODO: This should return success instead of failure, see
+                    // https://github.com/bitcoin/bitcoin/pull/14711#issuecomment-458342518
+                    result.last_failed_block = block_hash;
+                    result.status = ScanResult::FAILURE;
+                    stopped = true;
+                    break;
+                }
+                refresh_filter(item, 0);
+                for (size_t posInBlock = 0; posInBlock < item.block.vtx.size(); ++posInBlock) {
+                    if (item.may_be_mine[posInBlock] || involves_wallet(*item.block.vtx[posInBlock])) {
+                        SyncTransaction(item.block.vtx[posInBlock], block_hash, posInBlock, fUpdate);
+                        refresh_filter(item, posInBlock + 1);
+                    }
+                }
+                // scan succeeded, record block as most recent successfully scanned
+                result.last_scanned_block = block_hash;
+                result.last_scanned_height = *block_height;
+            } else {
+                // could not scan block, keep scanning but record this block as the most recent failure
                 result.last_failed_block = block_hash;
                 result.status = ScanResult::FAILURE;
-                break;
             }
-            for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
-                SyncTransaction(block.vtx[posInBlock], block_hash, posInBlock, fUpdate);
+            if (block_hash == stop_block) {
+                stopped = true;
+                break;
             }
-            // scan succeeded, record block as most recent successfully scanned
-            result.last_scanned_block = block_hash;
-            result.last_scanned_height = *block_height;
-        } else {
-            // could not scan block, keep scanning but record this block as the most recent failure
-            result.last_failed_block = block_hash;
-            result.status = ScanResult::FAILURE;
         }
-        if (block_hash == stop_block) {
+        if (stopped || fAbortRescan || chain().shutdownRequested()) {
             break;
         }
         {
@@ -2417,9 +2742,24 @@ CWallet::Balance CWallet::GetBalance(const int min_depth, bool avoid_reuse) cons
     {
         auto locked_chain = chain().lock();
         LOCK(cs_wallet);
-        for (const auto& entry : mapWallet)
+
+        const Optional<int> tip_height = locked_chain->getHeight();
+        const uint256 tip_hash = tip_height ? locked_chain->getBlockHash(*tip_height) : uint256();
+        if (tip_hash != m_balance_cache_tip) {
+            m_balance_cache.clear();
+            m_balance_cache_tip = tip_hash;
+        }
+        const auto cached = m_balance_cache.find(std::make_pair(min_depth, avoid_reuse));
+        if (cached != m_balance_cache.end()) {
+            return cached->second;
+        }
+
+        // Transactions without unspent outputs of ours and that are not immature
+        // coinbases have no available or immature credit, so only the indexed
+        // ones are visited.
+        for (const auto& entry : GetUnspentOutputs())
         {
-            const CWalletTx& wtx = entry.second;
+            const CWalletTx& wtx = mapWallet.at(entry.first);
             const bool is_trusted{wtx.IsTrusted(*locked_chain)};
             const int tx_depth{wtx.GetDepthInMainChain(*locked_chain)};
             const CAmount tx_credit_mine{wtx.GetAvailableCredit(*locked_chain, /* fUseCache */ true, ISMINE_SPENDABLE | reuse_filter)};
@@ -2435,6 +2775,7 @@ CWallet::Balance CWallet::GetBalance(const int min_depth, bool avoid_reuse) cons
             ret.m_mine_immature += wtx.GetImmatureCredit(*locked_chain);
             ret.m_watchonly_immature += wtx.GetImmatureWatchOnlyCredit(*locked_chain);
         }
+        m_balance_cache.emplace(std::make_pair(min_depth, avoid_reuse), ret);
     }
     return ret;
 }
@@ -2467,10 +2808,16 @@ void CWallet::AvailableCoins(interfaces::Chain::Lock& locked_chain, std::vector<
     const int min_depth = {coinControl ? coinControl->m_min_depth : DEFAULT_MIN_DEPTH};
     const int max_depth = {coinControl ? coinControl->m_max_depth : DEFAULT_MAX_DEPTH};
 
-    for (const auto& entry : mapWallet)
+    // Walk the unspent output index, which is in mapWallet order and holds
+    // every output of ours that is not known to be spent. Outputs found to be
+    // spent on the way are dropped from it.
+    auto& unspent_outputs = GetUnspentOutputs();
+    for (auto unspent = unspent_outputs.begin(); unspent != unspent_outputs.end();
+         unspent = unspent->second.empty() ? unspent_outputs.erase(unspent) : std::next(unspent))
     {
-        const uint256& wtxid = entry.first;
-        const CWalletTx& wtx = entry.second;
+        const uint256& wtxid = unspent->first;
+        const CWalletTx& wtx = mapWallet.at(wtxid);
+        std::vector<unsigned int>& outputs = unspent->second;
 
         if (!locked_chain.checkFinalTx(*wtx.tx)) {
             continue;
@@ -2532,18 +2879,25 @@ void CWallet::AvailableCoins(interfaces::Chain::Lock& locked_chain, std::vector<
         auto optHeight = locked_chain.getHeight();
         bool const lockedCollateral = optHeight && !chain().mnCanSpend(wtx.tx->GetHash(), *optHeight);
 
-        for (unsigned int i = 0; i < wtx.tx->vout.size(); i++) {
+        for (size_t k = 0; k < outputs.size(); k++) {
+            const unsigned int i = outputs[k];
             if (wtx.tx->vout[i].nValue < nMinimumAmount || wtx.tx->vout[i].nValue > nMaximumAmount)
                 continue;
 
-            if (coinControl && coinControl->HasSelected() && !coinControl->fAllowOtherInputs && !coinControl->IsSelected(COutPoint(entry.first, i)))
+            if (coinControl && coinControl->HasSelected() && !coinControl->fAllowOtherInputs && !coinControl->IsSelected(COutPoint(wtxid, i)))
                 continue;
 
-            if (IsLockedCoin(entry.first, i))
+            if (IsLockedCoin(wtxid, i))
                 continue;
 
-            if (IsSpent(locked_chain, wtxid, i))
+            if (IsSpent(locked_chain, wtxid, i)) {
+                // Immature coinbases were skipped above, so this output is
+                // not needed by GetBalance either.
+                if (IsSpentByUnconflictedTx(COutPoint(wtxid, i))) {
+                    outputs.erase(outputs.begin() + k--);
+                }
                 continue;
+            }
 
             isminetype mine = IsMine(wtx.tx->vout[i]);
 
@@ -2761,20 +3115,26 @@ bool CWallet::SelectCoins(const std::vector<COutput>& vAvailableCoins, const CAm
         // explicitly shuffling the outputs before processing
         Shuffle(vCoins.begin(), vCoins.end(), FastRandomContext());
     }
-    std::vector<OutputGroup> groups = GroupOutputs(vCoins, !coin_control.m_avoid_partial_spends);
+    // Selection is tried with up to seven eligibility filters, each on the groups the index
+    // picks for the target rather than on all of them.
+    const OutputGroupIndex groups(GroupOutputs(vCoins, !coin_control.m_avoid_partial_spends));
+    const CAmount nTargetToSelect = nTargetValue - nValueFromPresetInputs;
 
     size_t max_ancestors = (size_t)std::max<int64_t>(1, gArgs.GetArg("-limitancestorcount", DEFAULT_ANCESTOR_LIMIT));
     size_t max_descendants = (size_t)std::max<int64_t>(1, gArgs.GetArg("-limitdescendantcount", DEFAULT_DESCENDANT_LIMIT));
     bool fRejectLongChains = gArgs.GetBoolArg("-walletrejectlongchains", DEFAULT_WALLET_REJECT_LONG_CHAINS);
 
+    auto select_coins = [&](const CoinEligibilityFilter& filter) {
+        return SelectCoinsMinConf(nTargetToSelect, filter, groups.GetCandidates(filter, nTargetToSelect), setCoinsRet, nValueRet, coin_selection_params, bnb_used);
+    };
     bool res = nTargetValue <= nValueFromPresetInputs ||
-        SelectCoinsMinConf(nTargetValue - nValueFromPresetInputs, CoinEligibilityFilter(1, 6, 0), groups, setCoinsRet, nValueRet, coin_selection_params, bnb_used) ||
-        SelectCoinsMinConf(nTargetValue - nValueFromPresetInputs, CoinEligibilityFilter(1, 1, 0), groups, setCoinsRet, nValueRet, coin_selection_params, bnb_used) ||
-        (m_spend_zero_conf_change && SelectCoinsMinConf(nTargetValue - nValueFromPresetInputs, CoinEligibilityFilter(0, 1, 2), groups, setCoinsRet, nValueRet, coin_selection_params, bnb_used)) ||
-        (m_spend_zero_conf_change && SelectCoinsMinConf(nTargetValue - nValueFromPresetInputs, CoinEligibilityFilter(0, 1, std::min((size_t)4, max_ancestors/3), std::min((size_t)4, max_descendants/3)), groups, setCoinsRet, nValueRet, coin_selection_params, bnb_used)) ||
-        (m_spend_zero_conf_change && SelectCoinsMinConf(nTargetValue - nValueFromPresetInputs, CoinEligibilityFilter(0, 1, max_ancestors/2, max_descendants/2), groups, setCoinsRet, nValueRet, coin_selection_params, bnb_used)) ||
-        (m_spend_zero_conf_change && SelectCoinsMinConf(nTargetValue - nValueFromPresetInputs, CoinEligibilityFilter(0, 1, max_ancestors-1, max_descendants-1), groups, setCoinsRet, nValueRet, coin_selection_params, bnb_used)) ||
-        (m_spend_zero_conf_change && !fRejectLongChains && SelectCoinsMinConf(nTargetValue - nValueFromPresetInputs, CoinEligibilityFilter(0, 1, std::numeric_limits<uint64_t>::max()), groups, setCoinsRet, nValueRet, coin_selection_params, bnb_used));
+        select_coins(CoinEligibilityFilter(1, 6, 0)) ||
+        select_coins(CoinEligibilityFilter(1, 1, 0)) ||
+        (m_spend_zero_conf_change && select_coins(CoinEligibilityFilter(0, 1, 2))) ||
+        (m_spend_zero_conf_change && select_coins(CoinEligibilityFilter(0, 1, std::min((size_t)4, max_ancestors/3), std::min((size_t)4, max_descendants/3)))) ||
+        (m_spend_zero_conf_change && select_coins(CoinEligibilityFilter(0, 1, max_ancestors/2, max_descendants/2))) ||
+        (m_spend_zero_conf_change && select_coins(CoinEligibilityFilter(0, 1, max_ancestors-1, max_descendants-1))) ||
+        (m_spend_zero_conf_change && !fRejectLongChains && select_coins(CoinEligibilityFilter(0, 1, std::numeric_limits<uint64_t>::max())));
 
     // because SelectCoinsMinConf clears the setCoinsRet, we now add the possible inputs to the coinset
     util::insert(setCoinsRet, setPresetCoins);
@@ -3396,6 +3756,9 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256
         wtxOrdered.erase(it->second.m_it_wtxOrdered);
         mapWallet.erase(it);
     }
+    // Outputs spent by the removed transactions are unspent again.
+    m_unspent_outputs_dirty = true;
+    MarkBalancesDirty();
 
     if (nZapSelectTxRet == DBErrors::NEED_REWRITE)
     {
@@ -3592,16 +3955,17 @@ bool CWallet::TopUpKeyPool(unsigned int kpSize)
             // don't create extra internal keys
             missingInternal = 0;
         }
-        bool internal = false;
+        // Derive the keys of each chain at once and commit them together.
         WalletBatch batch(*database);
-        for (int64_t i = missingInternal + missingExternal; i--;)
-        {
-            if (i < missingInternal) {
-                internal = true;
-            }
-
-            CPubKey pubkey(GenerateNewKey(batch, internal));
-            AddKeypoolPubkeyWithDB(pubkey, internal, batch);
+        const bool txn = batch.TxnBegin();
+        for (const CPubKey& pubkey : GenerateNewKeys(batch, missingExternal, false)) {
+            AddKeypoolPubkeyWithDB(pubkey, false, batch);
+        }
+        for (const CPubKey& pubkey : GenerateNewKeys(batch, missingInternal, true)) {
+            AddKeypoolPubkeyWithDB(pubkey, true, batch);
+        }
+        if (txn && !batch.TxnCommit()) {
+            throw std::runtime_error(std::string(__func__) + ": committing new keypool keys failed");
         }
         if (missingInternal + missingExternal > 0) {
             WalletLogPrintf("keypool added %d keys (%d internal), size=%u (%u internal)\n", missingInternal + missingExternal, missingInternal, setInternalKeyPool.size() + setExternalKeyPool.size() + set_pre_split_keypool.size(), setInternalKeyPool.size());
@@ -62,6 +62,14 @@ WalletCreationStatus CreateWallet(interfaces::Chain& chain, const SecureString&
 
 //! Default for -keypool
 static const unsigned int DEFAULT_KEYPOOL_SIZE = 1000;
+//! Maximum number of threads deriving keys for the keypool
+static const int MAX_KEYPOOL_THREADS = 8;
+//! Default for -rescanthreads (0 = auto, one per core)
+static const int DEFAULT_RESCAN_THREADS = 0;
+//! Maximum number of threads reading and matching blocks during a rescan
+static const int MAX_RESCAN_THREADS = 16;
+//! Number of blocks handed to each rescan thread per batch
+static const int RESCAN_BLOCKS_PER_THREAD = 8;
 //! -paytxfee default
 constexpr CAmount DEFAULT_PAY_TX_FEE = 0;
 //! -fallbackfee default
@@ -715,6 +723,15 @@ private:
     std::mutex mutexScanning;
     friend class WalletRescanReserver;
 
+    /**
+     * The key and script ids that an output has to involve for IsMine to hold, and the
+     * watch-only scripts. Lets a rescan skip the transactions that cannot be ours on
+     * worker threads, without cs_wallet.
+     */
+    class ScanFilter;
+    //! Number of keys, scripts and watch-only scripts, which grows with every one added.
+    size_t GetKeyStoreSize() const;
+
     WalletBatch *encrypted_batch GUARDED_BY(cs_wallet) = nullptr;
 
     //! the current wallet version: clients below this version are not able to load the wallet
@@ -738,6 +755,30 @@ private:
     TxSpends mapTxSpends GUARDED_BY(cs_wallet);
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void AddToSpends(const uint256& wtxid) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    //! Transactions added by LoadToWallet that LinkLoadedTransactions has not linked yet.
+    std::vector<uint256> m_unlinked_txs GUARDED_BY(cs_wallet);
+
+    /**
+     * Outputs of wallet transactions that were ours when the transaction was
+     * added and are not known to be spent, by txid. AvailableCoins and
+     * GetBalance walk this instead of all of mapWallet. It is a superset of
+     * the unspent outputs: an output is dropped once a transaction that is
+     * neither conflicted nor abandoned spends it (IsSpentByUnconflictedTx),
+     * and added back by MarkInputsDirty when that spender changes state.
+     * Coinbase outputs stay until AvailableCoins finds them mature and spent,
+     * so that GetBalance still sees every immature coinbase. The index is
+     * rebuilt from mapWallet when m_unspent_outputs_dirty is set, i.e. after
+     * loading, zapping, and key imports (see MarkDirty()).
+     */
+    mutable std::map<uint256, std::vector<unsigned int>> m_unspent_outputs GUARDED_BY(cs_wallet);
+    mutable bool m_unspent_outputs_dirty GUARDED_BY(cs_wallet) = true;
+    /** Whether a transaction that is neither conflicted nor abandoned spends outpoint. Does not depend on the chain. */
+    bool IsSpentByUnconflictedTx(const COutPoint& outpoint) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Add output n of wtx to m_unspent_outputs if it is ours and may be unspent. */
+    void IndexUnspentOutput(const CWalletTx& wtx, unsigned int n) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    void IndexUnspentOutputs(const CWalletTx& wtx) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Return m_unspent_outputs, rebuilding it first if it is dirty. */
+    std::map<uint256, std::vector<unsigned int>>& GetUnspentOutputs() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
     /**
      * Add a transaction to the wallet, or update it.  pIndex and posInBlock should
@@ -769,8 +810,15 @@ private:
     /* the HD chain data model (external chain counters) */
     CHDChain hdChain;
 
-    /* HD derive new child key (on internal or external chain) */
-    void DeriveNewChildKey(WalletBatch& batch, CKeyMetadata& metadata, CKey& secret, bool internal = false) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** A key generated for the wallet, with its metadata. */
+    struct NewKey {
+        CKey secret;
+        CPubKey pubkey;
+        CKeyMetadata metadata;
+    };
+
+    /* HD derive count new child keys (on internal or external chain), skipping keys already known to the wallet */
+    void DeriveNewChildKeys(WalletBatch& batch, bool internal, size_t count, int64_t nCreationTime, std::vector<NewKey>& keys) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
     std::set<int64_t> setInternalKeyPool GUARDED_BY(cs_wallet);
     std::set<int64_t> setExternalKeyPool GUARDED_BY(cs_wallet);
@@ -793,6 +841,7 @@ private:
     bool AddWatchOnly(const CScript& dest) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     bool AddWatchOnlyWithDB(WalletBatch &batch, const CScript& dest) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     bool AddWatchOnlyInMem(const CScript &dest);
+    bool RemoveWatchOnlyWithDB(WalletBatch& batch, const CScript& dest) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
     /** Add a KeyOriginInfo to the wallet */
     bool AddKeyOriginWithDB(WalletBatch& batch, const CPubKey& pubkey, const KeyOriginInfo& info);
@@ -978,6 +1027,8 @@ public:
      * Generate a new key
      */
     CPubKey GenerateNewKey(WalletBatch& batch, bool internal = false) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Generate count new keys at once, computing their public keys in parallel */
+    std::vector<CPubKey> GenerateNewKeys(WalletBatch& batch, size_t count, bool internal = false) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     //! Adds a key to the store, and saves it to disk.
     bool AddKeyPubKey(const CKey& key, const CPubKey &pubkey) override EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     //! Adds a key to the store, without saving it to disk (used by LoadWallet)
@@ -1044,7 +1095,10 @@ public:
 
     void MarkDirty();
     bool AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose=true);
-    void LoadToWallet(const CWalletTx& wtxIn) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Add a transaction read from the database. Its spends and conflicts are only linked by LinkLoadedTransactions. */
+    void LoadToWallet(CWalletTx wtxIn) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Link the transactions added by LoadToWallet since the last call, all at once. */
+    void LinkLoadedTransactions() EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void TransactionAddedToMempool(const CTransactionRef& tx) override;
     void BlockConnected(const CBlock& block, const std::vector<CTransactionRef>& vtxConflicted) override;
     void BlockDisconnected(const CBlock& block) override;
@@ -1081,6 +1135,18 @@ public:
     Balance GetBalance(int min_depth = 0, bool avoid_reuse = true) const;
     CAmount GetAvailableBalance(const CCoinControl* coinControl = nullptr) const;
 
+private:
+    /**
+     * Results of GetBalance by (min_depth, avoid_reuse), valid for the chain tip
+     * m_balance_cache_tip. Cleared by MarkBalancesDirty whenever a wallet
+     * transaction, its mempool state or the wallet flags change.
+     */
+    mutable std::map<std::pair<int, bool>, Balance> m_balance_cache GUARDED_BY(cs_wallet);
+    mutable uint256 m_balance_cache_tip GUARDED_BY(cs_wallet);
+    void MarkBalancesDirty() EXCLUSIVE_LOCKS_REQUIRED(cs_wallet) { m_balance_cache.clear(); }
+
+public:
+
     OutputType TransactionChangeType(OutputType change_type, const std::vector<CRecipient>& vecSend);
 
     /**
@@ -1352,8 +1418,9 @@ public:
 
     /** Prepends the wallet name in logging output to ease debugging in multi-wallet use cases */
     template<typename... Params>
-    void WalletLogPrintf(std::string fmt, Params... parameters) const {
-        LogPrintf(("%s " + fmt).c_str(), GetDisplayName(), parameters...);
+    void WalletLogPrintf(const CallerLogFormat& fmt, Params... parameters) const {
+        // LogPrintf() needs a literal format string, as it may format after returning.
+        LogPrintfAt(fmt.file, fmt.line, "%s %s", GetDisplayName(), logging_detail::FormatLogMessage(fmt.fmt, parameters...));
     };
 
     /** Implement lookup of key origin information through wallet key metadata. */
@@ -11,13 +11,17 @@
 #include <key_io.h>
 #include <protocol.h>
 #include <serialize.h>
+#include <streams.h>
 #include <sync.h>
+#include <util/memory.h>
 #include <util/system.h>
 #include <util/time.h>
 #include <wallet/wallet.h>
 
 #include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <boost/thread.hpp>
 
@@ -196,6 +200,133 @@ public:
     }
 };
 
+namespace {
+
+/** The value of a tx record, decoded without touching the wallet. */
+struct TxRecord {
+    uint256 hash;
+    CWalletTx wtx{nullptr /* pwallet */, MakeTransactionRef()};
+    //! Whether the record was written by 0.3.16 and must be rewritten
+    bool upgrade{false};
+};
+
+/** The value of a key record, decoded without touching the wallet. */
+struct KeyRecord {
+    CPubKey pubkey;
+    CKey key;
+};
+
+/** Decode the rest of a tx record, its type already read from ssKey. Throws on malformed records. */
+void DecodeTx(CDataStream& ssKey, CDataStream& ssValue, TxRecord& record, std::string& strErr)
+{
+    ssKey >> record.hash;
+    CWalletTx& wtx = record.wtx;
+    ssValue >> wtx;
+    CValidationState state;
+    /// @todo temporary disabled due to genesis mn txs. RESOLVE!
+    /// we can't get genesis hash at wallet's load time
+//    if (!(CheckTransaction(*wtx.tx, state) && (wtx.GetHash() == hash) && state.IsValid()))
+//        return false;
+
+    // Undo serialize changes in 31600
+    if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703)
+    {
+        if (!ssValue.empty())
+        {
+            char fTmp;
+            char fUnused;
+            std::string unused_string;
+            ssValue >> fTmp >> fUnused >> unused_string;
+            strErr = strprintf("LoadWallet() upgrading tx ver=%d %d %s",
+                               wtx.fTimeReceivedIsTxTime, fTmp, record.hash.ToString());
+            wtx.fTimeReceivedIsTxTime = fTmp;
+        }
+        else
+        {
+            strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, record.hash.ToString());
+            wtx.fTimeReceivedIsTxTime = 0;
+        }
+        record.upgrade = true;
+    }
+}
+
+/** Decode and check the rest of a key record, its type already read from ssKey. */
+bool DecodeKey(CDataStream& ssKey, CDataStream& ssValue, KeyRecord& record, std::string& strErr)
+{
+    CPubKey& vchPubKey = record.pubkey;
+    ssKey >> vchPubKey;
+    if (!vchPubKey.IsValid())
+    {
+        strErr = "Error reading wallet database: CPubKey corrupt";
+        return false;
+    }
+    CPrivKey pkey;
+    uint256 hash;
+
+    ssValue >> pkey;
+
+    // Old wallets store keys as DBKeys::KEY [pubkey] => [privkey]
+    // ... which was slow for wallets with lots of keys, because the public key is re-derived from the private key
+    // using EC operations as a checksum.
+    // Newer wallets store keys as DBKeys::KEY [pubkey] => [privkey][hash(pubkey,privkey)], which is much faster while
+    // remaining backwards-compatible.
+    try
+    {
+        ssValue >> hash;
+    }
+    catch (...) {}
+
+    bool fSkipCheck = false;
+
+    if (!hash.IsNull())
+    {
+        // hash pubkey/privkey to accelerate wallet load
+        std::vector<unsigned char> vchKey;
+        vchKey.reserve(vchPubKey.size() + pkey.size());
+        vchKey.insert(vchKey.end(), vchPubKey.begin(), vchPubKey.end());
+        vchKey.insert(vchKey.end(), pkey.begin(), pkey.end());
+
+        if (Hash(vchKey.begin(), vchKey.end()) != hash)
+        {
+            strErr = "Error reading wallet database: CPubKey/CPrivKey corrupt";
+            return false;
+        }
+
+        fSkipCheck = true;
+    }
+
+    if (!record.key.Load(pkey, vchPubKey, fSkipCheck))
+    {
+        strErr = "Error reading wallet database: CPrivKey corrupt";
+        return false;
+    }
+    return true;
+}
+
+void LoadTx(CWallet* pwallet, CWalletScanState& wss, TxRecord& record) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
+{
+    if (record.upgrade)
+        wss.vWalletUpgrade.push_back(record.hash);
+
+    if (record.wtx.nOrderPos == -1)
+        wss.fAnyUnordered = true;
+
+    pwallet->LoadToWallet(std::move(record.wtx));
+}
+
+bool LoadKey(CWallet* pwallet, CWalletScanState& wss, const KeyRecord& record, std::string& strErr) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
+{
+    wss.nKeys++;
+    if (!pwallet->LoadKey(record.key, record.pubkey))
+    {
+        strErr = "Error reading wallet database: LoadKey failed";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
 static bool
 ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
              CWalletScanState &wss, std::string& strType, std::string& strErr) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
@@ -214,41 +345,9 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
             ssKey >> strAddress;
             ssValue >> pwallet->mapAddressBook[DecodeDestination(strAddress)].purpose;
         } else if (strType == DBKeys::TX) {
-            uint256 hash;
-            ssKey >> hash;
-            CWalletTx wtx(nullptr /* pwallet */, MakeTransactionRef());
-            ssValue >> wtx;
-            CValidationState state;
-            /// @todo temporary disabled due to genesis mn txs. RESOLVE!
-            /// we can't get genesis hash at wallet's load time
-//            if (!(CheckTransaction(*wtx.tx, state) && (wtx.GetHash() == hash) && state.IsValid()))
-//                return false;
-
-            // Undo serialize changes in 31600
-            if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703)
-            {
-                if (!ssValue.empty())
-                {
-                    char fTmp;
-                    char fUnused;
-                    std::string unused_string;
-                    ssValue >> fTmp >> fUnused >> unused_string;
-                    strErr = strprintf("LoadWallet() upgrading tx ver=%d %d %s",
-                                       wtx.fTimeReceivedIsTxTime, fTmp, hash.ToString());
-                    wtx.fTimeReceivedIsTxTime = fTmp;
-                }
-                else
-                {
-                    strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, hash.ToString());
-                    wtx.fTimeReceivedIsTxTime = 0;
-                }
-                wss.vWalletUpgrade.push_back(hash);
-            }
-
-            if (wtx.nOrderPos == -1)
-                wss.fAnyUnordered = true;
-
-            pwallet->LoadToWallet(wtx);
+            TxRecord record;
+            DecodeTx(ssKey, ssValue, record, strErr);
+            LoadTx(pwallet, wss, record);
         } else if (strType == DBKeys::WATCHS) {
             wss.nWatchKeys++;
             CScript script;
@@ -258,58 +357,8 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
             if (fYes == '1')
                 pwallet->LoadWatchOnly(script);
         } else if (strType == DBKeys::KEY) {
-            CPubKey vchPubKey;
-            ssKey >> vchPubKey;
-            if (!vchPubKey.IsValid())
-            {
-                strErr = "Error reading wallet database: CPubKey corrupt";
-                return false;
-            }
-            CKey key;
-            CPrivKey pkey;
-            uint256 hash;
-
-            wss.nKeys++;
-            ssValue >> pkey;
-
-            // Old wallets store keys as DBKeys::KEY [pubkey] => [privkey]
-            // ... which was slow for wallets with lots of keys, because the public key is re-derived from the private key
-            // using EC operations as a checksum.
-            // Newer wallets store keys as DBKeys::KEY [pubkey] => [privkey][hash(pubkey,privkey)], which is much faster while
-            // remaining backwards-compatible.
-            try
-            {
-                ssValue >> hash;
-            }
-            catch (...) {}
-
-            bool fSkipCheck = false;
-
-            if (!hash.IsNull())
-            {
-                // hash pubkey/privkey to accelerate wallet load
-                std::vector<unsigned char> vchKey;
-                vchKey.reserve(vchPubKey.size() + pkey.size());
-                vchKey.insert(vchKey.end(), vchPubKey.begin(), vchPubKey.end());
-                vchKey.insert(vchKey.end(), pkey.begin(), pkey.end());
-
-                if (Hash(vchKey.begin(), vchKey.end()) != hash)
-                {
-                    strErr = "Error reading wallet database: CPubKey/CPrivKey corrupt";
-                    return false;
-                }
-
-                fSkipCheck = true;
-            }
-
-            if (!key.Load(pkey, vchPubKey, fSkipCheck))
-            {
-                strErr = "Error reading wallet database: CPrivKey corrupt";
-                return false;
-            }
-            if (!pwallet->LoadKey(key, vchPubKey))
-            {
-                strErr = "Error reading wallet database: LoadKey failed";
+            KeyRecord record;
+            if (!DecodeKey(ssKey, ssValue, record, strErr) || !LoadKey(pwallet, wss, record, strErr)) {
                 return false;
             }
         } else if (strType == DBKeys::MASTER_KEY) {
@@ -453,23 +502,9 @@ DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
             return DBErrors::CORRUPT;
         }
 
-        while (true)
-        {
-            // Read next record
-            CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-            CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-            int ret = m_batch.ReadAtCursor(pcursor, ssKey, ssValue);
-            if (ret == DB_NOTFOUND)
-                break;
-            else if (ret != 0)
-            {
-                pwallet->WalletLogPrintf("Error reading next record from wallet database\n");
-                return DBErrors::CORRUPT;
-            }
-
-            // Try to be tolerant of single corrupt records:
-            std::string strType, strErr;
-            if (!ReadKeyValue(pwallet, ssKey, ssValue, wss, strType, strErr))
+        // Try to be tolerant of single corrupt records:
+        auto check_record = [&](bool ok, const std::string& strType, const std::string& strErr) {
+            if (!ok)
             {
                 // losing keys is considered a catastrophic error, anything else
                 // we assume the user can live with:
@@ -488,7 +523,96 @@ DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
             }
             if (!strErr.empty())
                 pwallet->WalletLogPrintf("%s\n", strErr);
+        };
+
+        // The records are read in batches. Transactions and keys, which make up
+        // most of a wallet and are the costly ones to decode, are decoded in
+        // parallel. All the records are then loaded into the wallet in order.
+        struct Record {
+            CDataStream ssKey{SER_DISK, CLIENT_VERSION};
+            CDataStream ssValue{SER_DISK, CLIENT_VERSION};
+            std::string strType;
+            bool decoded{false};
+            bool decode_ok{false};
+            std::string strErr;
+            std::unique_ptr<TxRecord> tx;
+            std::unique_ptr<KeyRecord> key;
+        };
+        const int n_threads = std::max(1, std::min(GetNumCores(), MAX_LOAD_WALLET_THREADS));
+        std::vector<Record> records;
+        records.reserve(LOAD_WALLET_BATCH_RECORDS);
+        bool done = false;
+        bool read_failed = false;
+        while (!done)
+        {
+            records.clear();
+            while (records.size() < LOAD_WALLET_BATCH_RECORDS)
+            {
+                // Read next record
+                records.emplace_back();
+                Record& record = records.back();
+                int ret = m_batch.ReadAtCursor(pcursor, record.ssKey, record.ssValue);
+                if (ret == DB_NOTFOUND) {
+                    records.pop_back();
+                    done = true;
+                    break;
+                } else if (ret != 0)
+                {
+                    pwallet->WalletLogPrintf("Error reading next record from wallet database\n");
+                    records.pop_back();
+                    read_failed = done = true;
+                    break;
+                }
+            }
+
+            ParallelFor(records.size(), n_threads, [&](size_t i) {
+                Record& record = records[i];
+                try {
+                    // Peek at the type, ReadKeyValue reads it again for the other records.
+                    SpanReader{SER_DISK, CLIENT_VERSION, MakeUCharSpan(record.ssKey), record.strType};
+                    if (record.strType == DBKeys::TX) {
+                        record.decoded = true;
+                        record.ssKey >> record.strType;
+                        record.tx = MakeUnique<TxRecord>();
+                        DecodeTx(record.ssKey, record.ssValue, *record.tx, record.strErr);
+                        record.decode_ok = true;
+                    } else if (record.strType == DBKeys::KEY) {
+                        record.decoded = true;
+                        record.ssKey >> record.strType;
+                        record.key = MakeUnique<KeyRecord>();
+                        record.decode_ok = DecodeKey(record.ssKey, record.ssValue, *record.key, record.strErr);
+                    }
+                } catch (const std::exception& e) {
+                    if (record.strErr.empty()) {
+                        record.strErr = e.what();
+                    }
+                    record.decode_ok = false;
+                } catch (...) {
+                    if (record.strErr.empty()) {
+                        record.strErr = "Caught unknown exception decoding wallet record";
+                    }
+                    record.decode_ok = false;
+                }
+            });
+
+            for (Record& record : records) {
+                bool ok;
+                if (!record.decoded) {
+                    record.strType.clear();
+                    ok = ReadKeyValue(pwallet, record.ssKey, record.ssValue, wss, record.strType, record.strErr);
+                } else if (!record.decode_ok) {
+                    ok = false;
+                } else if (record.tx) {
+                    LoadTx(pwallet, wss, *record.tx);
+                    ok = true;
+                } else {
+                    ok = LoadKey(pwallet, wss, *record.key, record.strErr);
+                }
+                check_record(ok, record.strType, record.strErr);
+            }
         }
+        if (read_failed)
+            result = DBErrors::CORRUPT;
         pcursor->close();
     }
     catch (const boost::thread_interrupted&) {
@@ -497,6 +621,8 @@ DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
     catch (...) {
         result = DBErrors::CORRUPT;
     }
+    // Spends and conflicts are linked once all the transactions are loaded.
+    pwallet->LinkLoadedTransactions();
 
     if (fNoncriticalErrors && result == DBErrors::LOAD_OK)
         result = DBErrors::NONCRITICAL_ERROR;
@@ -31,6 +31,10 @@
  */
 
 static const bool DEFAULT_FLUSHWALLET = true;
+//! Records read from the database at a time while loading a wallet, to be decoded in parallel
+static const size_t LOAD_WALLET_BATCH_RECORDS = 10000;
+//! Maximum number of threads decoding the records of a wallet while loading it
+static const int MAX_LOAD_WALLET_THREADS = 8;
 
 struct CBlockLocator;
 class CKeyPool;
@@ -11,7 +11,7 @@ CZMQAbstractNotifier::~CZMQAbstractNotifier()
     assert(!psocket);
 }
 
-bool CZMQAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/)
+bool CZMQAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/, const CBlock * /*CBlock*/)
 {
     return true;
 }
@@ -20,3 +20,23 @@ bool CZMQAbstractNotifier::NotifyTransaction(const CTransaction &/*transaction*/
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyBlockTransactions(const std::vector<CTransactionRef> &transactions)
+{
+    for (const CTransactionRef& ptx : transactions) {
+        if (!NotifyTransaction(*ptx)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CZMQAbstractNotifier::NotifyBlockConnected(const CBlock &/*block*/, const CBlockIndex * /*pindex*/)
+{
+    return true;
+}
+
+bool CZMQAbstractNotifier::NotifyMasternodeEvents(const CBlockIndex * /*pindex*/, const std::vector<CMasternodeEvent> &/*events*/)
+{
+    return true;
+}
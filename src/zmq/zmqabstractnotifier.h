@@ -7,8 +7,11 @@
 
 #include <zmq/zmqconfig.h>
 
+#include <vector>
+
 class CBlockIndex;
 class CZMQAbstractNotifier;
+struct CMasternodeEvent;
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
 
@@ -40,8 +43,15 @@ public:
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
 
-    virtual bool NotifyBlock(const CBlockIndex *pindex);
+    //! Notify of a new tip. pblock is the block if it is still in memory, or null.
+    virtual bool NotifyBlock(const CBlockIndex *pindex, const CBlock *pblock);
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    //! Notify of the transactions of a connected or disconnected block, one message each
+    virtual bool NotifyBlockTransactions(const std::vector<CTransactionRef> &transactions);
+    //! Notify of every block connected, whether or not it is the new tip
+    virtual bool NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex);
+    //! Notify of the masternode changes made by a connected block
+    virtual bool NotifyMasternodeEvents(const CBlockIndex *pindex, const std::vector<CMasternodeEvent> &events);
 
 protected:
     void *psocket;
@@ -47,6 +47,9 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubhashtx"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
+    factories["pubmasternode"] = CZMQAbstractNotifier::Create<CZMQPublishMasternodeNotifier>;
+    factories["pubanchor"] = CZMQAbstractNotifier::Create<CZMQPublishAnchorNotifier>;
+    factories["pubteamchange"] = CZMQAbstractNotifier::Create<CZMQPublishTeamChangeNotifier>;
 
     for (const auto& entry : factories)
     {
@@ -137,15 +140,16 @@ void CZMQNotificationInterface::Shutdown()
     }
 }
 
-void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
-{
-    if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
-        return;
+namespace {
 
+// Call func on every notifier, shutting down and removing the ones that fail.
+template <typename Function>
+void TryForEachAndRemoveFailed(std::list<CZMQAbstractNotifier*>& notifiers, const Function& func)
+{
     for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
     {
         CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyBlock(pindexNew))
+        if (func(notifier))
         {
             i++;
         }
@@ -157,41 +161,55 @@ void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, co
     }
 }
 
+} // anonymous namespace
+
+void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+{
+    if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
+        return;
+
+    // BlockConnected for the new tip came just before, unless it was dropped from the queue.
+    const CBlock* pblock = nullptr;
+    if (m_last_block_connected && m_last_block_connected->GetHash() == pindexNew->GetBlockHash()) {
+        pblock = m_last_block_connected.get();
+    }
+    TryForEachAndRemoveFailed(notifiers, [pindexNew, pblock](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlock(pindexNew, pblock);
+    });
+}
+
 void CZMQNotificationInterface::TransactionAddedToMempool(const CTransactionRef& ptx)
 {
-    // Used by BlockConnected and BlockDisconnected as well, because they're
-    // all the same external callback.
     const CTransaction& tx = *ptx;
 
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
-    {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyTransaction(tx))
-        {
-            i++;
-        }
-        else
-        {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
-        }
-    }
+    TryForEachAndRemoveFailed(notifiers, [&tx](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyTransaction(tx);
+    });
 }
 
 void CZMQNotificationInterface::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected, const std::vector<CTransactionRef>& vtxConflicted)
 {
-    for (const CTransactionRef& ptx : pblock->vtx) {
-        // Do a normal notify for each transaction added in the block
-        TransactionAddedToMempool(ptx);
-    }
+    m_last_block_connected = pblock;
+
+    // Do a normal notify for each transaction added in the block
+    TryForEachAndRemoveFailed(notifiers, [&pblock, pindexConnected](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlockTransactions(pblock->vtx) && notifier->NotifyBlockConnected(*pblock, pindexConnected);
+    });
 }
 
 void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock)
 {
-    for (const CTransactionRef& ptx : pblock->vtx) {
-        // Do a normal notify for each transaction removed in block disconnection
-        TransactionAddedToMempool(ptx);
-    }
+    // Do a normal notify for each transaction removed in block disconnection
+    TryForEachAndRemoveFailed(notifiers, [&pblock](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlockTransactions(pblock->vtx);
+    });
+}
+
+void CZMQNotificationInterface::MasternodesUpdated(const CBlockIndex* pindex, const std::vector<CMasternodeEvent>& events)
+{
+    TryForEachAndRemoveFailed(notifiers, [pindex, &events](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyMasternodeEvents(pindex, events);
+    });
 }
 
 CZMQNotificationInterface* g_zmq_notification_interface = nullptr;
@@ -30,6 +30,7 @@ protected:
     void TransactionAddedToMempool(const CTransactionRef& tx) override;
     void BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected, const std::vector<CTransactionRef>& vtxConflicted) override;
     void BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) override;
+    void MasternodesUpdated(const CBlockIndex* pindex, const std::vector<CMasternodeEvent>& events) override;
     void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
 
 private:
@@ -37,6 +38,10 @@ private:
 
     void *pcontext;
     std::list<CZMQAbstractNotifier*> notifiers;
+
+    //! The last block connected, published by rawblock without reading it back
+    //! from disk if it becomes the tip. Only used from the notification thread.
+    std::shared_ptr<const CBlock> m_last_block_connected;
 };
 
 extern CZMQNotificationInterface* g_zmq_notification_interface;
@@ -4,6 +4,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <masternodes/masternodes.h>
 #include <streams.h>
 #include <zmq/zmqpublishnotifier.h>
 #include <validation.h>
@@ -12,10 +13,15 @@
 
 static std::multimap<std::string, CZMQAbstractPublishNotifier*> mapPublishNotifiers;
 
-static const char *MSG_HASHBLOCK = "hashblock";
-static const char *MSG_HASHTX    = "hashtx";
-static const char *MSG_RAWBLOCK  = "rawblock";
-static const char *MSG_RAWTX     = "rawtx";
+static const char *MSG_HASHBLOCK  = "hashblock";
+static const char *MSG_HASHTX     = "hashtx";
+static const char *MSG_RAWBLOCK   = "rawblock";
+static const char *MSG_RAWTX      = "rawtx";
+static const char *MSG_MNCREATE   = "mncreate";
+static const char *MSG_MNRESIGN   = "mnresign";
+static const char *MSG_MNBAN      = "mnban";
+static const char *MSG_ANCHOR     = "anchor";
+static const char *MSG_TEAMCHANGE = "teamchange";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -157,7 +163,7 @@ bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const void* d
     return true;
 }
 
-bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const CBlock * /*pblock*/)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashblock %s\n", hash.GetHex());
@@ -177,13 +183,15 @@ bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &t
     return SendMessage(MSG_HASHTX, data, 32);
 }
 
-bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const CBlock *pblock)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
 
     const Consensus::Params& consensusParams = Params().GetConsensus();
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    {
+    if (pblock) {
+        ss << *pblock;
+    } else {
         LOCK(cs_main);
         CBlock block;
         if(!ReadBlockFromDisk(block, pindex, consensusParams))
@@ -206,3 +214,111 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &tr
     ss << transaction;
     return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
 }
+
+bool CZMQPublishRawTransactionNotifier::NotifyBlockTransactions(const std::vector<CTransactionRef> &transactions)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish rawtx for %u block transactions\n", transactions.size());
+    // Subscribers still get one message per transaction, only the serialization buffer is shared
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
+    for (const CTransactionRef& ptx : transactions) {
+        ss.clear();
+        ss << *ptx;
+        if (!SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace {
+
+/** The published fields of an anchor reward transaction */
+struct AnchorReward {
+    uint256 btcTxHash;
+    uint32_t anchorHeight;
+    uint32_t prevAnchorHeight;
+    CMasternodesView::CTeam nextTeam;
+};
+
+bool ExtractAnchorReward(const CTransaction& tx, AnchorReward& reward)
+{
+    std::vector<unsigned char> metadata;
+    if (!tx.IsCoinBase() || !CMasternodesView::ExtractAnchorRewardFromTx(tx, metadata)) {
+        return false;
+    }
+    try {
+        CDataStream ss(metadata, SER_NETWORK, PROTOCOL_VERSION);
+        CKeyID rewardKeyID;
+        char rewardKeyType;
+        ss >> reward.btcTxHash >> reward.anchorHeight >> reward.prevAnchorHeight >> rewardKeyID >> rewardKeyType >> reward.nextTeam;
+    } catch (const std::ios_base::failure&) {
+        return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+bool CZMQPublishMasternodeNotifier::NotifyMasternodeEvents(const CBlockIndex *pindex, const std::vector<CMasternodeEvent> &events)
+{
+    const uint256 hash = pindex->GetBlockHash();
+    const int32_t height = pindex->nHeight;
+    for (const CMasternodeEvent& event : events) {
+        const char* command;
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << hash << height << event.nodeId;
+        switch (event.type) {
+            case CMasternodeEvent::CREATED:
+                command = MSG_MNCREATE;
+                ss << event.node.ownerType << event.node.ownerAuthAddress << event.node.operatorType << event.node.operatorAuthAddress;
+                break;
+            case CMasternodeEvent::RESIGNED:
+                command = MSG_MNRESIGN;
+                ss << event.txid;
+                break;
+            case CMasternodeEvent::BANNED:
+                command = MSG_MNBAN;
+                ss << event.txid;
+                break;
+            default:
+                continue;
+        }
+        LogPrint(BCLog::ZMQ, "zmq: Publish %s at block %s\n", command, hash.GetHex());
+        if (!SendMessage(command, ss.data(), ss.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CZMQPublishAnchorNotifier::NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex)
+{
+    // Anchor rewards are in the coinbase position, and a block is only connected if they are valid.
+    for (const CTransactionRef& ptx : block.vtx) {
+        AnchorReward reward;
+        if (!ExtractAnchorReward(*ptx, reward)) continue;
+        LogPrint(BCLog::ZMQ, "zmq: Publish anchor %s\n", reward.btcTxHash.GetHex());
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << block.GetHash() << (int32_t)pindex->nHeight << reward.btcTxHash << reward.anchorHeight << reward.prevAnchorHeight << ptx->GetHash();
+        if (!SendMessage(MSG_ANCHOR, ss.data(), ss.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CZMQPublishTeamChangeNotifier::NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex)
+{
+    // Each anchor reward sets the team to the one it carries.
+    for (const CTransactionRef& ptx : block.vtx) {
+        AnchorReward reward;
+        if (!ExtractAnchorReward(*ptx, reward)) continue;
+        LogPrint(BCLog::ZMQ, "zmq: Publish teamchange at block %s\n", block.GetHash().GetHex());
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << block.GetHash() << (int32_t)pindex->nHeight << reward.nextTeam;
+        if (!SendMessage(MSG_TEAMCHANGE, ss.data(), ss.size())) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -31,7 +31,7 @@ public:
 class CZMQPublishHashBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CBlockIndex *pindex, const CBlock *pblock) override;
 };
 
 class CZMQPublishHashTransactionNotifier : public CZMQAbstractPublishNotifier
@@ -43,13 +43,35 @@ public:
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CBlockIndex *pindex, const CBlock *pblock) override;
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier
 {
 public:
     bool NotifyTransaction(const CTransaction &transaction) override;
+    bool NotifyBlockTransactions(const std::vector<CTransactionRef> &transactions) override;
+};
+
+/** Publishes the masternodes created, resigned and banned by connected blocks */
+class CZMQPublishMasternodeNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyMasternodeEvents(const CBlockIndex *pindex, const std::vector<CMasternodeEvent> &events) override;
+};
+
+/** Publishes the anchors finalized by connected blocks */
+class CZMQPublishAnchorNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex) override;
+};
+
+/** Publishes the anchor team set by connected blocks */
+class CZMQPublishTeamChangeNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockConnected(const CBlock &block, const CBlockIndex *pindex) override;
 };
 
 #endif // DEFI_ZMQ_ZMQPUBLISHNOTIFIER_H
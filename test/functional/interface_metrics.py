@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+# Copyright (c) DeFi Blockchain Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the /metrics endpoint.
+
+- served only with -metrics, without authentication
+- reports the tip, connected blocks, mempool, peers and masternodes
+"""
+
+from test_framework.test_framework import DefiTestFramework
+from test_framework.util import assert_equal, connect_nodes_bi, wait_until
+
+import http.client
+import urllib.parse
+
+class MetricsTest (DefiTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.setup_clean_chain = True
+        self.extra_args = [["-metrics"], []]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def get_metrics(self, node, method='GET'):
+        url = urllib.parse.urlparse(self.nodes[node].url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request(method, '/metrics')
+        resp = conn.getresponse()
+        body = resp.read().decode('utf-8')
+        conn.close()
+        return resp, body
+
+    def get_samples(self):
+        resp, body = self.get_metrics(0)
+        assert_equal(resp.status, 200)
+        assert resp.getheader('Content-Type').startswith('text/plain; version=0.0.4')
+        samples = {}
+        for line in body.splitlines():
+            if line.startswith('#'):
+                continue
+            name, value = line.rsplit(' ', 1)
+            samples[name] = float(value)
+        return samples
+
+    def run_test(self):
+        self.log.info("Metrics are not served by default")
+        resp, _ = self.get_metrics(1)
+        assert_equal(resp.status, 404)
+
+        self.log.info("Only GET is supported")
+        resp, _ = self.get_metrics(0, 'POST')
+        assert_equal(resp.status, 405)
+
+        self.log.info("Tip and masternodes")
+        connected = self.get_samples()['defi_block_connect_seconds_count']
+        self.nodes[0].generate(101)
+        samples = self.get_samples()
+        assert_equal(samples['defi_tip_height'], 101)
+        assert_equal(samples['defi_block_connect_seconds_count'], connected + 101)
+        assert_equal(samples['defi_block_connect_seconds_bucket{le="+Inf"}'], connected + 101)
+        assert_equal(samples['defi_masternodes{state="ENABLED"}'], len(self.nodes[0].listmasternodes()))
+        assert_equal(samples['defi_masternodes{state="RESIGNED"}'], 0)
+        assert samples['defi_coins_cache_usage_bytes'] > 0
+
+        self.log.info("Mempool")
+        assert_equal(samples['defi_mempool_transactions'], 0)
+        self.nodes[0].sendtoaddress(self.nodes[0].getnewaddress(), 1)
+        samples = self.get_samples()
+        mempool = self.nodes[0].getmempoolinfo()
+        assert_equal(samples['defi_mempool_transactions'], mempool['size'])
+        assert_equal(samples['defi_mempool_bytes'], mempool['bytes'])
+        self.nodes[0].generate(1)
+        samples = self.get_samples()
+        assert_equal(samples['defi_mempool_transactions'], 0)
+        assert_equal(samples['defi_tip_height'], 102)
+
+        self.log.info("Peers")
+        connect_nodes_bi(self.nodes, 0, 1)
+        wait_until(lambda: self.get_samples()['defi_peers{direction="inbound"}'] == 1)
+        wait_until(lambda: self.get_samples()['defi_peers{direction="outbound"}'] == 1)
+
+if __name__ == '__main__':
+    MetricsTest().main()
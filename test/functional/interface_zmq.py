@@ -8,7 +8,7 @@ import struct
 from test_framework.address import ADDRESS_BCRT1_UNSPENDABLE
 from test_framework.test_framework import DefiTestFramework
 from test_framework.messages import CTransaction, hash256, BLOCK_HEADER_SIZE
-from test_framework.util import assert_equal, connect_nodes
+from test_framework.util import assert_equal, connect_nodes, connect_nodes_bi, wait_until
 from io import BytesIO
 from time import sleep
 
@@ -48,6 +48,10 @@ class ZMQTest (DefiTestFramework):
         try:
             self.test_basic()
             self.test_reorg()
+            if self.is_wallet_compiled():
+                self.test_masternode()
+                self.test_anchor()
+                self.test_ban()
         finally:
             # Destroy the ZMQ context.
             self.log.debug("Destroying ZMQ context")
@@ -151,5 +155,134 @@ class ZMQTest (DefiTestFramework):
         # Should receive nodes[1] tip
         assert_equal(self.nodes[1].getbestblockhash(), hashblock.receive().hex())
 
+    def subscribe(self, address, topics):
+        """A socket subscribed to the given topics, to connect once the publisher is up."""
+        import zmq
+        socket = self.ctx.socket(zmq.SUB)
+        socket.set(zmq.RCVTIMEO, 60000)
+        return socket, [ZMQSubscriber(socket, topic) for topic in topics]
+
+    def test_masternode(self):
+        address = 'tcp://127.0.0.1:28556'
+        socket, (mncreate,) = self.subscribe(address, [b'mncreate'])
+
+        self.restart_node(0, ['-zmqpubmasternode=%s' % address])
+        socket.connect(address)
+        # Relax so that the subscriber is ready before publishing zmq messages
+        sleep(0.2)
+
+        self.log.info("Create a masternode and receive its creation")
+        collateral = self.nodes[0].getnewaddress("", "legacy")
+        idnode = self.nodes[0].createmasternode([], {"collateralAddress": collateral})
+        blockhash = self.nodes[0].generate(1)[0]
+
+        body = mncreate.receive()
+        assert_equal(body[:32][::-1].hex(), blockhash)
+        assert_equal(struct.unpack('<i', body[32:36])[0], self.nodes[0].getblockcount())
+        assert_equal(body[36:68][::-1].hex(), idnode)
+
+        self.log.info("Resign the masternode and receive its resignation")
+        # The publisher restarts its sequence numbers along with the node
+        socket.close()
+        address = 'tcp://127.0.0.1:28557'
+        socket, (mnresign,) = self.subscribe(address, [b'mnresign'])
+        self.restart_node(0, ['-zmqpubmasternode=%s' % address, '-masternode_owner=' + collateral])
+        socket.connect(address)
+        sleep(0.2)
+
+        self.nodes[0].generate(1)
+        self.nodes[0].sendtoaddress(collateral, 1)
+        self.nodes[0].generate(1)
+        resignTx = self.nodes[0].resignmasternode([], idnode)
+        blockhash = self.nodes[0].generate(1)[0]
+
+        body = mnresign.receive()
+        assert_equal(body[:32][::-1].hex(), blockhash)
+        assert_equal(struct.unpack('<i', body[32:36])[0], self.nodes[0].getblockcount())
+        assert_equal(body[36:68][::-1].hex(), idnode)
+        assert_equal(body[68:100][::-1].hex(), resignTx)
+        socket.close()
+
+    def test_anchor(self):
+        address = 'tcp://127.0.0.1:28558'
+        socket, (anchor, teamchange) = self.subscribe(address, [b'anchor', b'teamchange'])
+
+        spv_args = ['-spv=1', '-fakespv=1', '-anchorquorum=2']
+        self.restart_node(0, spv_args + ['-zmqpubanchor=%s' % address, '-zmqpubteamchange=%s' % address])
+        self.restart_node(1, spv_args)
+        connect_nodes_bi(self.nodes, 0, 1)
+        socket.connect(address)
+        sleep(0.2)
+
+        self.log.info("Anchor the chain and receive the anchor reward and the new team")
+        self.nodes[0].generate(30)
+        self.sync_blocks()
+        self.nodes[0].spv_setlastheight(1)
+        wait_until(lambda: any(auth['signers'] >= 2 for auth in self.nodes[0].spv_listanchorauths()), timeout=10)
+        txAnc = self.nodes[0].spv_createanchor([{
+            'txid': "a0d5a294be3cde6a8bddab5815b8c4cb1b2ebf2c2b8a4018205d6f8c576e8963",
+            'vout': 3,
+            'amount': 2262303,
+            'privkey': "cStbpreCo2P4nbehPXZAAM3gXXY1sAphRfEhj7ADaLx8i2BmxvEP"}],
+            self.nodes[0].getnewaddress("", "legacy"))
+        # just for triggering activation in regtest
+        self.nodes[0].spv_setlastheight(1)
+        self.nodes[1].spv_setlastheight(1)
+        self.nodes[1].spv_sendrawtx(txAnc['txHex'])
+        self.nodes[0].spv_setlastheight(6)
+        self.nodes[1].spv_setlastheight(6)
+        wait_until(lambda: len(self.nodes[0].spv_listanchorrewardconfirms()) == 1 and self.nodes[0].spv_listanchorrewardconfirms()[0]['signers'] == 2, timeout=10)
+
+        blockhash = self.nodes[0].generate(1)[0]
+        height = self.nodes[0].getblockcount()
+        rewards = self.nodes[0].spv_listanchorrewards()
+        assert_equal(len(rewards), 1)
+
+        # block hash, height, BTC txid, anchor height, previous anchor height, reward txid
+        body = anchor.receive()
+        assert_equal(len(body), 108)
+        assert_equal(body[:32][::-1].hex(), blockhash)
+        assert_equal(struct.unpack('<i', body[32:36])[0], height)
+        assert_equal(body[36:68][::-1].hex(), txAnc['txHash'])
+        assert_equal(body[76:108][::-1].hex(), rewards[0]['RewardTxHash'])
+
+        # block hash, height, then the team as a count followed by the key ids
+        body = teamchange.receive()
+        assert_equal(body[:32][::-1].hex(), blockhash)
+        assert_equal(struct.unpack('<i', body[32:36])[0], height)
+        assert body[36] > 0
+        assert_equal(len(body), 37 + 20 * body[36])
+        socket.close()
+
+    def test_ban(self):
+        address = 'tcp://127.0.0.1:28559'
+        socket, (mnban,) = self.subscribe(address, [b'mnban'])
+
+        self.restart_node(0, ['-dummypos=0'])
+        self.restart_node(1, ['-dummypos=0', '-criminals=1', '-zmqpubmasternode=%s' % address])
+        socket.connect(address)
+        sleep(0.2)
+
+        self.log.info("Double sign on two forks and receive the ban of the criminal")
+        node0id = self.nodes[0].get_node_id()
+        self.nodes[0].generate(1)
+        self.nodes[1].generate(2)
+        connect_nodes_bi(self.nodes, 0, 1)
+        self.sync_blocks()
+        # node 0 generates block in a fork:
+        self.nodes[0].generate(1)
+        self.sync_blocks()
+        assert_equal(len(self.nodes[1].listcriminalproofs()), 1)
+
+        blockhash = self.nodes[1].generate(1)[0]
+        assert_equal(self.nodes[1].listmasternodes()[node0id]['state'], "PRE_BANNED")
+
+        body = mnban.receive()
+        assert_equal(body[:32][::-1].hex(), blockhash)
+        assert_equal(struct.unpack('<i', body[32:36])[0], self.nodes[1].getblockcount())
+        assert_equal(body[36:68][::-1].hex(), node0id)
+        assert body[68:100][::-1].hex() in self.nodes[1].getblock(blockhash)['tx']
+        socket.close()
+
 if __name__ == '__main__':
     ZMQTest().main()
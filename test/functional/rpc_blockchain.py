@@ -62,6 +62,7 @@ class BlockchainTest(DefiTestFramework):
         self._test_getnetworkhashps()
         self._test_stopatheight()
         self._test_waitforblockheight()
+        self._test_getvalidationqueueinfo()
         assert self.nodes[0].verifychain(4, 0)
 
     def mine_chain(self):
@@ -295,6 +296,19 @@ class BlockchainTest(DefiTestFramework):
         self.start_node(0)
         assert_equal(self.nodes[0].getblockcount(), 207)
 
+    def _test_getvalidationqueueinfo(self):
+        self.log.info("Test getvalidationqueueinfo")
+        node = self.nodes[0]
+        node.syncwithvalidationinterfacequeue()
+        queues = {queue['name']: queue for queue in node.getvalidationqueueinfo()}
+        assert_equal(queues['shared']['pending'], 0)
+        if self.is_wallet_compiled():
+            wallet = queues['wallet']
+            assert_equal(wallet['lossy'], False)
+            assert_equal(wallet['max_size'], 10)
+            assert_equal(wallet['pending'], 0)
+            assert_equal(wallet['dropped'], 0)
+
     def _test_waitforblockheight(self):
         self.log.info("Test waitforblockheight")
         node = self.nodes[0]
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+# Copyright (c) DeFi Blockchain Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the listmasternodetxs RPC.
+
+- verify creation, resignation and collateral spend are listed by id and by address
+- verify paging and the error without -masternodetxindex
+"""
+
+from test_framework.test_framework import DefiTestFramework
+
+from test_framework.util import assert_equal, assert_raises_rpc_error
+
+class ListMasternodeTxsTest (DefiTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.setup_clean_chain = True
+        self.extra_args = [['-masternodetxindex'], []]
+
+    def types(self, key, pagination=None):
+        result = self.nodes[0].listmasternodetxs(key, pagination) if pagination else self.nodes[0].listmasternodetxs(key)
+        return [tx['type'] for tx in result['txs']]
+
+    def run_test(self):
+        assert_raises_rpc_error(-1, "Masternode tx index is not enabled", self.nodes[1].listmasternodetxs, "00" * 32)
+
+        self.nodes[0].generate(101)
+        collateral0 = self.nodes[0].getnewaddress("", "legacy")
+        idnode0 = self.nodes[0].createmasternode([], {
+            "collateralAddress": collateral0
+        })
+        self.nodes[0].generate(1)
+
+        result = self.nodes[0].listmasternodetxs(idnode0)
+        assert_equal(len(result['txs']), 1)
+        assert_equal(result['txs'][0]['txid'], idnode0)
+        assert_equal(result['txs'][0]['type'], "CreateMasternode")
+        assert_equal(result['txs'][0]['height'], self.nodes[0].getblockcount())
+        assert_equal(self.types(collateral0), ["CreateMasternode"])
+
+        # Resign, wait until the collateral is unlocked and spend it
+        self.restart_node(0, extra_args=['-masternodetxindex', '-masternode_owner=' + collateral0])
+        self.nodes[0].generate(1)
+        self.nodes[0].sendtoaddress(collateral0, 1)
+        self.nodes[0].generate(1)
+        resignTx = self.nodes[0].resignmasternode([], idnode0)
+        self.nodes[0].generate(11)
+        assert_equal(self.nodes[0].listmasternodes()[idnode0]['state'], "RESIGNED")
+
+        spendTx = self.nodes[0].createrawtransaction([{'txid': idnode0, 'vout': 1}], [{collateral0: 9.999}])
+        signedTx = self.nodes[0].signrawtransactionwithwallet(spendTx)
+        assert_equal(signedTx['complete'], True)
+        spendTxid = self.nodes[0].sendrawtransaction(signedTx['hex'])
+        self.nodes[0].generate(1)
+
+        result = self.nodes[0].listmasternodetxs(idnode0)
+        assert_equal([tx['txid'] for tx in result['txs']], [idnode0, resignTx, spendTxid])
+        assert_equal(self.types(idnode0), ["CreateMasternode", "ResignMasternode", "CollateralSpend"])
+        assert 'next' not in result
+
+        # Paging
+        page = self.nodes[0].listmasternodetxs(idnode0, {"limit": 2})
+        assert_equal(len(page['txs']), 2)
+        assert_equal(self.types(idnode0, page['next']), ["CollateralSpend"])
+
+        # Disconnecting the spending block removes its record
+        self.nodes[0].invalidateblock(self.nodes[0].getbestblockhash())
+        assert_equal(self.types(idnode0), ["CreateMasternode", "ResignMasternode"])
+
+if __name__ == '__main__':
+    ListMasternodeTxsTest ().main ()
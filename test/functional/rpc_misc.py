@@ -34,6 +34,10 @@ class RpcMiscTest(DefiTestFramework):
         assert_greater_than(memory['chunks_free'], 0)
         assert_equal(memory['used'] + memory['free'], memory['total'])
 
+        blockindex = node.getmemoryinfo()['blockindex']
+        assert_equal(blockindex['entries'], node.getblockcount() + 1)
+        assert_greater_than(blockindex['usage'], 0)
+
         self.log.info("test mallocinfo")
         try:
             mallocinfo = node.getmemoryinfo(mode="mallocinfo")
@@ -46,6 +50,41 @@ class RpcMiscTest(DefiTestFramework):
 
         assert_raises_rpc_error(-8, "unknown mode foobar", node.getmemoryinfo, mode="foobar")
 
+        self.log.info("test getlockstats")
+        assert_equal(node.getlockstats()['enabled'], False)
+        node.getlockstats(enable=True)
+        node.getblockchaininfo()
+        lockstats = node.getlockstats(count=0, reset=True)
+        assert_equal(lockstats['enabled'], True)
+        assert any('cs_main' in site['lock'] for site in lockstats['sites'])
+        for site in lockstats['sites']:
+            assert_equal(len(site['wait']['histogram']), 20)
+            assert_greater_than_or_equal(site['wait']['total'], site['wait']['max'])
+            assert_greater_than_or_equal(site['acquired'], site['contended'])
+        assert_equal(len(node.getlockstats(count=1)['sites']), 1)
+        assert_raises_rpc_error(-8, "count must not be negative", node.getlockstats, count=-1)
+        node.getlockstats(enable=False)
+        assert_equal(node.getlockstats()['enabled'], False)
+
+        self.log.info("test dumptrace")
+        assert_equal(node.dumptrace()['enabled'], False)
+        node.dumptrace(reset=True, enable=True)
+        node.generate(1)
+        trace = node.dumptrace(reset=True)
+        assert_equal(trace['enabled'], True)
+        spans = [event for event in trace['traceEvents'] if event['ph'] == 'X']
+        # Block assembly also runs ConnectBlock to check the new block
+        connect_block = [event for event in spans if event['name'] == 'ConnectBlock' and event['args']['just_check'] == 0]
+        assert_equal(len(connect_block), 1)
+        assert_equal(connect_block[0]['cat'], 'validation')
+        assert_equal(connect_block[0]['args']['height'], node.getblockcount())
+        assert_greater_than_or_equal(connect_block[0]['dur'], 0)
+        assert any(event['name'] == 'ActivateBestChain' for event in spans)
+        thread_ids = set(event['tid'] for event in trace['traceEvents'] if event['ph'] == 'M')
+        assert all(event['tid'] in thread_ids for event in spans)
+        node.dumptrace(enable=False)
+        assert_equal(node.dumptrace()['enabled'], False)
+
         self.log.info("test logging")
         assert_equal(node.logging()['qt'], True)
         node.logging(exclude=['qt'])
@@ -129,6 +129,7 @@ BASE_SCRIPTS = [
     'rpc_getchaintips.py',
     'rpc_misc.py',
     'rpc_mn_basic.py',
+    'rpc_listmasternodetxs.py',
     'feature_initdist.py',
     'interface_rest.py',
     'mempool_spend_coinbase.py',
@@ -142,6 +143,7 @@ BASE_SCRIPTS = [
     'wallet_watchonly.py',
     'wallet_watchonly.py --usecli',
     'interface_http.py',
+    'interface_metrics.py',
     'interface_rpc.py',
     'rpc_psbt.py',
     'rpc_users.py',
@@ -169,6 +171,7 @@ BASE_SCRIPTS = [
     'wallet_txn_clone.py --mineblock',
     'feature_notifications.py',
     'rpc_getblockfilter.py',
+    'p2p_blockfilters.py',
     'rpc_invalidateblock.py',
     'feature_rbf.py',
     'mempool_packages.py',